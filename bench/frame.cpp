@@ -0,0 +1,157 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <webgpu/webgpu_cpp_print.h>
+#include "absl/log/log.h"
+#include "../source/engine/engine.hpp"
+#include "../source/engine/options.hpp"
+
+//Renders a scene for a fixed number of frames and prints a JSON report to stdout, logs go to stderr
+//Usage: DawnEngineBench [--scene=<path/to/scene.gltf>] [--resolution=<width>x<height>] [--frames=<count>] [engine options]
+namespace {
+	constexpr uint32_t DEFAULT_FRAME_COUNT = 300;
+
+	std::string escapeJson(const std::string& text) {
+		std::string escaped;
+		for (const char c : text) {
+			switch (c) {
+			case '"': escaped += "\\\""; break;
+			case '\\': escaped += "\\\\"; break;
+			case '\n': escaped += "\\n"; break;
+			case '\r': escaped += "\\r"; break;
+			case '\t': escaped += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) {
+					escaped += std::format("\\u{:04x}", static_cast<unsigned char>(c));
+				}
+				else {
+					escaped += c;
+				}
+			}
+		}
+		return escaped;
+	}
+
+	template <typename T>
+	std::string toString(const T& value) {
+		std::ostringstream stream;
+		stream << value;
+		return stream.str();
+	}
+
+	//Nearest rank percentile of an already sorted vector
+	double percentile(const std::vector<double>& sorted, const double p) {
+		if (sorted.empty()) {
+			return 0.0;
+		}
+		const size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+		return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+	}
+
+	std::string summarize(std::vector<double> milliseconds) {
+		std::sort(milliseconds.begin(), milliseconds.end());
+		const double mean = milliseconds.empty() ? 0.0 : std::accumulate(milliseconds.begin(), milliseconds.end(), 0.0) / static_cast<double>(milliseconds.size());
+		return std::format(
+			"{{ \"mean\": {:.4f}, \"p50\": {:.4f}, \"p95\": {:.4f}, \"p99\": {:.4f}, \"max\": {:.4f} }}",
+			mean,
+			percentile(milliseconds, 50.0),
+			percentile(milliseconds, 95.0),
+			percentile(milliseconds, 99.0),
+			milliseconds.empty() ? 0.0 : milliseconds.back()
+		);
+	}
+
+	void writeReport(std::ostream& out, const engine::Options& options, const Engine& engine) {
+		const FrameStats* frameStats = engine.getFrameStats();
+		const GpuProfiler* gpuProfiler = engine.getGpuProfiler();
+		wgpu::AdapterInfo adapterInfo{};
+		engine.getWGPUContext()->adapter.GetInfo(&adapterInfo);
+
+		out << "{\n";
+		out << std::format("  \"scene\": \"{}\",\n", escapeJson(options.gltfDirectory + options.gltfFileName));
+		out << std::format("  \"width\": {},\n", options.context.screenDimensions.width);
+		out << std::format("  \"height\": {},\n", options.context.screenDimensions.height);
+		out << std::format("  \"frames\": {},\n", frameStats->getFrameCount());
+		out << std::format("  \"headless\": {},\n", options.context.headless);
+		out << std::format("  \"adapter\": \"{}\",\n", escapeJson(std::string(std::string_view(adapterInfo.device))));
+		out << std::format("  \"backend\": \"{}\",\n", escapeJson(toString(adapterInfo.backendType)));
+		out << std::format("  \"adapterType\": \"{}\",\n", escapeJson(toString(adapterInfo.adapterType)));
+		//Run twice against the same --pipeline-cache directory to compare a cold start with a warm one
+		out << std::format("  \"startupMs\": {:.4f},\n", engine.getStartupMilliseconds());
+		const PipelineCache* pipelineCache = engine.getWGPUContext()->getPipelineCache();
+		out << std::format(
+			"  \"pipelineCache\": {{ \"enabled\": {}, \"hits\": {}, \"misses\": {}, \"stores\": {} }},\n",
+			pipelineCache != nullptr,
+			pipelineCache != nullptr ? pipelineCache->getHitCount() : 0,
+			pipelineCache != nullptr ? pipelineCache->getMissCount() : 0,
+			pipelineCache != nullptr ? pipelineCache->getStoreCount() : 0
+		);
+		//Computed from descriptor sizes, run at --resolution=3840x2160 for what a scene needs at 4K
+		const MemoryRegistry& memoryRegistry = engine.getWGPUContext()->getMemoryRegistry();
+		out << std::format(
+			"  \"gpuMemoryBytes\": {{ \"total\": {}, \"peak\": {}, \"gBuffer\": {}, \"shadow\": {}, \"scene\": {}, \"staging\": {}, \"other\": {} }},\n",
+			memoryRegistry.getTotal(),
+			memoryRegistry.getPeak(),
+			memoryRegistry.getTotal(enums::MemoryCategory::GBUFFER),
+			memoryRegistry.getTotal(enums::MemoryCategory::SHADOW),
+			memoryRegistry.getTotal(enums::MemoryCategory::SCENE),
+			memoryRegistry.getTotal(enums::MemoryCategory::STAGING),
+			memoryRegistry.getTotal(enums::MemoryCategory::OTHER)
+		);
+		out << std::format("  \"frameIntervalMs\": {},\n", summarize(frameStats->getFrameIntervalMilliseconds()));
+		out << std::format("  \"cpuFrameMs\": {},\n", summarize(frameStats->getCpuFrameMilliseconds()));
+		out << std::format("  \"submitLatencyMs\": {},\n", summarize(frameStats->getSubmitLatencyMilliseconds()));
+
+		out << "  \"cpuPhaseMs\": {\n";
+		const std::vector<std::string>& phaseNames = frameStats->getPhaseNames();
+		for (uint32_t i = 0; i < phaseNames.size(); ++i) {
+			out << std::format("    \"{}\": {}{}\n", escapeJson(phaseNames[i]), summarize(frameStats->getPhaseMilliseconds(i)), i + 1 < phaseNames.size() ? "," : "");
+		}
+		out << "  },\n";
+
+		//Smoothed rather than per frame, see GpuProfiler
+		out << "  \"gpuPassMs\": {";
+		if (gpuProfiler->isEnabled()) {
+			out << "\n";
+			const std::vector<std::string>& passNames = gpuProfiler->getPassNames();
+			for (uint32_t i = 0; i < passNames.size(); ++i) {
+				out << std::format("    \"{}\": {:.4f}{}\n", escapeJson(passNames[i]), gpuProfiler->getPassMilliseconds(i), i + 1 < passNames.size() ? "," : "");
+			}
+			out << "  ";
+		}
+		out << "},\n";
+
+		out << std::format("  \"peakEstimatedGpuMemoryBytes\": {},\n", frameStats->getPeakEstimatedMemory());
+		out << std::format("  \"peakAllocatedGpuMemoryBytes\": {}\n", frameStats->getPeakAllocatedMemory());
+		out << "}\n";
+	}
+}
+
+int main(int argc, char* argv[]) {
+	try {
+		engine::Options options = engine::parseOptions(argc, argv);
+		options.collectFrameStats = true;
+		if (options.frameCount == 0) {
+			options.frameCount = DEFAULT_FRAME_COUNT;
+		}
+
+		Engine engine = Engine(options);
+		engine.run();
+		writeReport(std::cout, options, engine);
+	}
+	catch (std::exception& err) {
+		LOG(FATAL) << err.what();
+	}
+	catch (...) {
+		LOG(FATAL) << "unknown error";
+	}
+
+	return 0;
+}
@@ -0,0 +1,242 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "absl/log/log.h"
+#include "../source/engine/engine.hpp"
+#include "../source/engine/options.hpp"
+#include "../source/host/host.hpp"
+
+//Generates a glTF with one multi-million triangle heightfield and a small instanced prop, checks that the loader keeps every
+//index of the heightfield in the 32 bit index run and the prop in the 16 bit one, then renders it and prints a JSON report
+//Usage: DawnEngineLargeMeshBench [--triangles=<count>] [engine options]
+namespace {
+	constexpr uint64_t DEFAULT_TRIANGLE_COUNT = 4'000'000;
+	constexpr uint32_t DEFAULT_FRAME_COUNT = 60;
+	constexpr uint32_t PROP_QUADS_PER_SIDE = 8;
+	constexpr uint32_t PROP_INSTANCE_COUNT = 16;
+	constexpr float GRID_SIZE = 100.0f;
+	const std::string GLTF_FILE_NAME = "largeMesh.gltf";
+	const std::string BIN_FILE_NAME = "largeMesh.bin";
+
+	struct Grid {
+		std::vector<float> positions;
+		std::vector<float> normals;
+		std::vector<float> texcoords;
+		std::vector<uint32_t> indices;
+		std::array<float, 3> min;
+		std::array<float, 3> max;
+		uint32_t vertexCount;
+	};
+
+	//quadsPerSide^2 quads over [-size / 2, size / 2] in XZ with a gentle wave in Y so the lighting has something to show
+	Grid createGrid(const uint32_t quadsPerSide, const float size, const float amplitude) {
+		constexpr float FREQUENCY = 0.2f;
+		const uint32_t verticesPerSide = quadsPerSide + 1;
+		Grid grid = {
+			.min = { -size / 2.0f, -amplitude, -size / 2.0f },
+			.max = { size / 2.0f, amplitude, size / 2.0f },
+			.vertexCount = verticesPerSide * verticesPerSide,
+		};
+		grid.positions.reserve(grid.vertexCount * 3);
+		grid.normals.reserve(grid.vertexCount * 3);
+		grid.texcoords.reserve(grid.vertexCount * 2);
+		for (uint32_t z = 0; z < verticesPerSide; ++z) {
+			for (uint32_t x = 0; x < verticesPerSide; ++x) {
+				const float u = static_cast<float>(x) / static_cast<float>(quadsPerSide);
+				const float v = static_cast<float>(z) / static_cast<float>(quadsPerSide);
+				const float px = (u - 0.5f) * size;
+				const float pz = (v - 0.5f) * size;
+				const float py = amplitude * std::sin(px * FREQUENCY) * std::cos(pz * FREQUENCY);
+				const float dx = amplitude * FREQUENCY * std::cos(px * FREQUENCY) * std::cos(pz * FREQUENCY);
+				const float dz = -amplitude * FREQUENCY * std::sin(px * FREQUENCY) * std::sin(pz * FREQUENCY);
+				const float normalLength = std::sqrt(dx * dx + 1.0f + dz * dz);
+				grid.positions.insert(grid.positions.end(), { px, py, pz });
+				grid.normals.insert(grid.normals.end(), { -dx / normalLength, 1.0f / normalLength, -dz / normalLength });
+				grid.texcoords.insert(grid.texcoords.end(), { u, v });
+			}
+		}
+		grid.indices.reserve(size_t{ quadsPerSide } * quadsPerSide * 6);
+		for (uint32_t z = 0; z < quadsPerSide; ++z) {
+			for (uint32_t x = 0; x < quadsPerSide; ++x) {
+				const uint32_t i = z * verticesPerSide + x;
+				grid.indices.insert(grid.indices.end(), { i, i + verticesPerSide, i + 1, i + 1, i + verticesPerSide, i + verticesPerSide + 1 });
+			}
+		}
+		return grid;
+	}
+
+	template <typename T>
+	void append(std::vector<char>& bin, const std::vector<T>& data) {
+		const char* bytes = reinterpret_cast<const char*>(data.data());
+		bin.insert(bin.end(), bytes, bytes + data.size() * sizeof(T));
+		bin.resize((bin.size() + 3) / 4 * 4); //bufferViews of floats stay 4 byte aligned
+	}
+
+	//One mesh per grid, attributes in the order POSITION, NORMAL, TEXCOORD_0, indices
+	void writeGltf(const std::filesystem::path& directory, const Grid& terrain, const Grid& prop) {
+		std::vector<char> bin;
+		std::ostringstream bufferViews;
+		std::ostringstream accessors;
+		uint32_t viewIndex = 0;
+		const auto addView = [&](const auto& data, const std::string& accessorType, const uint32_t componentType, const size_t count, const std::string& bounds) {
+			const size_t offset = bin.size();
+			append(bin, data);
+			bufferViews << std::format("{}{{ \"buffer\": 0, \"byteOffset\": {}, \"byteLength\": {} }}", viewIndex == 0 ? "" : ", ", offset, data.size() * sizeof(data[0]));
+			accessors << std::format("{}{{ \"bufferView\": {}, \"componentType\": {}, \"count\": {}, \"type\": \"{}\"{} }}", viewIndex == 0 ? "" : ", ", viewIndex, componentType, count, accessorType, bounds);
+			++viewIndex;
+		};
+		const auto addGrid = [&](const Grid& grid, const bool uint16Indices) {
+			addView(grid.positions, "VEC3", 5126, grid.vertexCount, std::format(
+				", \"min\": [{}, {}, {}], \"max\": [{}, {}, {}]", grid.min[0], grid.min[1], grid.min[2], grid.max[0], grid.max[1], grid.max[2]
+			));
+			addView(grid.normals, "VEC3", 5126, grid.vertexCount, "");
+			addView(grid.texcoords, "VEC2", 5126, grid.vertexCount, "");
+			if (uint16Indices) {
+				addView(std::vector<uint16_t>(grid.indices.begin(), grid.indices.end()), "SCALAR", 5123, grid.indices.size(), "");
+			}
+			else {
+				addView(grid.indices, "SCALAR", 5125, grid.indices.size(), "");
+			}
+		};
+		addGrid(terrain, false);
+		addGrid(prop, true);
+
+		std::ostringstream nodes;
+		nodes << "{ \"mesh\": 0 }";
+		for (uint32_t i = 0; i < PROP_INSTANCE_COUNT; ++i) {
+			const float angle = 6.2831853f * static_cast<float>(i) / static_cast<float>(PROP_INSTANCE_COUNT);
+			nodes << std::format(", {{ \"mesh\": 1, \"translation\": [{}, {}, {}] }}", std::cos(angle) * GRID_SIZE / 4.0f, 4.0f, std::sin(angle) * GRID_SIZE / 4.0f);
+		}
+		//Looks down at the middle of the terrain from above its near edge
+		const float pitch = -std::atan2(GRID_SIZE * 0.6f, GRID_SIZE * 0.9f);
+		nodes << std::format(", {{ \"camera\": 0, \"translation\": [0, {}, {}], \"rotation\": [{}, 0, 0, {}] }}", GRID_SIZE * 0.6f, GRID_SIZE * 0.9f, std::sin(pitch / 2.0f), std::cos(pitch / 2.0f));
+
+		std::ostringstream sceneNodes;
+		for (uint32_t i = 0; i < PROP_INSTANCE_COUNT + 2; ++i) {
+			sceneNodes << (i == 0 ? "" : ", ") << i;
+		}
+
+		std::ofstream binFile(directory / BIN_FILE_NAME, std::ios::binary | std::ios::trunc);
+		binFile.write(bin.data(), static_cast<std::streamsize>(bin.size()));
+		std::ofstream gltfFile(directory / GLTF_FILE_NAME, std::ios::trunc);
+		gltfFile << "{\n";
+		gltfFile << "  \"asset\": { \"version\": \"2.0\" },\n";
+		gltfFile << "  \"scene\": 0,\n";
+		gltfFile << std::format("  \"scenes\": [{{ \"nodes\": [{}] }}],\n", sceneNodes.str());
+		gltfFile << std::format("  \"nodes\": [{}],\n", nodes.str());
+		gltfFile << "  \"cameras\": [{ \"type\": \"perspective\", \"perspective\": { \"yfov\": 0.8, \"znear\": 0.1, \"zfar\": 1000 } }],\n";
+		gltfFile << "  \"materials\": [{ \"pbrMetallicRoughness\": { \"baseColorFactor\": [0.6, 0.7, 0.5, 1], \"metallicFactor\": 0, \"roughnessFactor\": 0.8 } }],\n";
+		gltfFile << "  \"meshes\": [\n";
+		gltfFile << "    { \"primitives\": [{ \"attributes\": { \"POSITION\": 0, \"NORMAL\": 1, \"TEXCOORD_0\": 2 }, \"indices\": 3, \"material\": 0 }] },\n";
+		gltfFile << "    { \"primitives\": [{ \"attributes\": { \"POSITION\": 4, \"NORMAL\": 5, \"TEXCOORD_0\": 6 }, \"indices\": 7, \"material\": 0 }] }\n";
+		gltfFile << "  ],\n";
+		gltfFile << std::format("  \"accessors\": [{}],\n", accessors.str());
+		gltfFile << std::format("  \"bufferViews\": [{}],\n", bufferViews.str());
+		gltfFile << std::format("  \"buffers\": [{{ \"uri\": \"{}\", \"byteLength\": {} }}]\n", BIN_FILE_NAME, bin.size());
+		gltfFile << "}\n";
+		if (!binFile || !gltfFile) {
+			throw std::runtime_error("failed to write " + (directory / GLTF_FILE_NAME).string());
+		}
+	}
+
+	//A terrain past 65536 vertices must be the only 32 bit indexed draw and keep every index intact
+	void checkIndices(const HostSceneResources& host, const Grid& terrain) {
+		if (terrain.vertexCount <= size_t{ UINT16_MAX } + 1) {
+			if (host.uint16DrawCount != host.drawCalls.size()) {
+				throw std::runtime_error("a terrain this small should use 16 bit indices");
+			}
+			return;
+		}
+		if (host.uint16DrawCount + 1 != host.drawCalls.size()) {
+			throw std::runtime_error(std::format("expected 1 draw with 32 bit indices, got {}", host.drawCalls.size() - host.uint16DrawCount));
+		}
+		if (host.indices32 != terrain.indices) {
+			throw std::runtime_error("32 bit indices do not match the generated terrain");
+		}
+		const structs::host::DrawCall& drawCall = host.drawCalls.back();
+		if (drawCall.indexCount != terrain.indices.size() || drawCall.baseVertex + terrain.vertexCount > host.vbo.size()) {
+			throw std::runtime_error("terrain draw call does not cover the generated terrain");
+		}
+	}
+}
+
+int main(int argc, char* argv[]) {
+	try {
+		uint64_t triangleCount = DEFAULT_TRIANGLE_COUNT;
+		std::vector<char*> engineArguments = { argv[0] };
+		for (int i = 1; i < argc; ++i) {
+			const std::string_view argument = argv[i];
+			if (argument.starts_with("--triangles=")) {
+				triangleCount = std::stoull(std::string(argument.substr(std::string_view("--triangles=").size())));
+			}
+			else {
+				engineArguments.push_back(argv[i]);
+			}
+		}
+		engine::Options options = engine::parseOptions(static_cast<int>(engineArguments.size()), engineArguments.data());
+		options.collectFrameStats = true;
+		if (options.frameCount == 0) {
+			options.frameCount = DEFAULT_FRAME_COUNT;
+		}
+
+		const uint32_t quadsPerSide = std::max(static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(triangleCount) / 2.0))), 1u);
+		const Grid terrain = createGrid(quadsPerSide, GRID_SIZE, 2.0f);
+		const Grid prop = createGrid(PROP_QUADS_PER_SIDE, 4.0f, 0.5f);
+		const std::filesystem::path directory = std::filesystem::temp_directory_path() / "DawnEngineLargeMesh";
+		std::filesystem::create_directories(directory);
+		writeGltf(directory, terrain, prop);
+		options.gltfDirectory = directory.generic_string() + "/";
+		options.gltfFileName = GLTF_FILE_NAME;
+
+		const auto loadStart = std::chrono::steady_clock::now();
+		ThreadPool threadPool;
+		const HostSceneResources host = HostSceneResources(
+			options.gltfDirectory,
+			options.gltfFileName,
+			std::array<uint32_t, 2>{options.context.screenDimensions.width, options.context.screenDimensions.height},
+			threadPool
+		);
+		const double loadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+		checkIndices(host, terrain);
+
+		Engine engine = Engine(options);
+		engine.run();
+
+		std::vector<double> cpuFrameMilliseconds = engine.getFrameStats()->getCpuFrameMilliseconds();
+		std::sort(cpuFrameMilliseconds.begin(), cpuFrameMilliseconds.end());
+		const double meanCpuFrameMilliseconds = cpuFrameMilliseconds.empty()
+			? 0.0
+			: std::accumulate(cpuFrameMilliseconds.begin(), cpuFrameMilliseconds.end(), 0.0) / static_cast<double>(cpuFrameMilliseconds.size());
+
+		std::cout << "{\n";
+		std::cout << std::format("  \"triangles\": {},\n", terrain.indices.size() / 3 + PROP_INSTANCE_COUNT * prop.indices.size() / 3);
+		std::cout << std::format("  \"vertices\": {},\n", host.vbo.size());
+		std::cout << std::format("  \"indexBytes\": {},\n", host.indices16.size() * sizeof(uint16_t) + host.indices32.size() * sizeof(uint32_t));
+		std::cout << std::format("  \"hostLoadMs\": {:.4f},\n", loadMilliseconds);
+		std::cout << std::format("  \"startupMs\": {:.4f},\n", engine.getStartupMilliseconds());
+		std::cout << std::format("  \"frames\": {},\n", engine.getFrameStats()->getFrameCount());
+		std::cout << std::format("  \"cpuFrameMs\": {{ \"mean\": {:.4f}, \"max\": {:.4f} }}\n", meanCpuFrameMilliseconds, cpuFrameMilliseconds.empty() ? 0.0 : cpuFrameMilliseconds.back());
+		std::cout << "}\n";
+	}
+	catch (std::exception& err) {
+		LOG(FATAL) << err.what();
+	}
+	catch (...) {
+		LOG(FATAL) << "unknown error";
+	}
+
+	return 0;
+}
@@ -0,0 +1,211 @@
+#pragma once
+#include <cfloat>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "absl/log/log.h"
+#include "../source/wgpuContext/wgpuContext.hpp"
+#include "../source/host/host.hpp"
+#include "../source/device/resources.hpp"
+#include "../source/device/stagingBelt.hpp"
+#include "../source/device/pipelineBatch.hpp"
+#include "../source/render/culling.hpp"
+#include "../source/render/frameGraph.hpp"
+#include "../source/render/initial.hpp"
+#include "../source/render/lightCulling.hpp"
+#include "../source/render/lighting.hpp"
+
+//Sweeps the point light count from 1 to 4096 and times the light culling and lighting passes. Also reports the tiles that
+//were reached by more than MAX_LIGHTS_PER_TILE lights and how many lights they dropped
+//Usage: DawnEngineLightCullingBench [iterations]
+namespace {
+	const std::string gltfDirectory = "models/monoBox/"; //must end with "/"
+	const std::string gltfFileName = "cornellbox.gltf";
+
+	constexpr uint32_t MAX_LIGHT_COUNT = 4096;
+	constexpr uint32_t WARMUP_ITERATIONS = 4;
+	constexpr uint32_t DEFAULT_ITERATIONS = 64;
+	constexpr uint32_t LIGHT_SEED = 1234;
+
+	//Point lights scattered through the bounds of the scene so the tiles see a realistic mix of near and far lights
+	std::vector<structs::Light> createPointLights(const std::vector<structs::VBO>& vbo, const uint32_t count) {
+		glm::f32vec3 boundsMin = glm::f32vec3(FLT_MAX);
+		glm::f32vec3 boundsMax = glm::f32vec3(-FLT_MAX);
+		for (const structs::VBO& v : vbo) {
+			boundsMin = glm::min(boundsMin, v.vertex);
+			boundsMax = glm::max(boundsMax, v.vertex);
+		}
+		const glm::f32 sceneSize = glm::length(boundsMax - boundsMin);
+
+		std::mt19937 generator(LIGHT_SEED);
+		std::uniform_real_distribution<float> x(boundsMin.x, boundsMax.x);
+		std::uniform_real_distribution<float> y(boundsMin.y, boundsMax.y);
+		std::uniform_real_distribution<float> z(boundsMin.z, boundsMax.z);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		std::vector<structs::Light> lights;
+		lights.reserve(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			lights.push_back(structs::Light{
+				.position = { x(generator), y(generator), z(generator) },
+				.color = { unit(generator), unit(generator), unit(generator) },
+				.type = 2, //Point
+				.intensity = 1.0f,
+				.range = sceneSize * (0.05f + 0.15f * unit(generator)),
+			});
+		}
+		return lights;
+	}
+
+	void waitForQueue(WGPUContext& wgpuContext) {
+		wgpuContext.instance.WaitAny(
+			wgpuContext.queue.OnSubmittedWorkDone(wgpu::CallbackMode::WaitAnyOnly, [](wgpu::QueueWorkDoneStatus) {}),
+			UINT64_MAX
+		);
+	}
+
+	structs::TileLightOverflow readTileLightOverflow(WGPUContext& wgpuContext, const wgpu::Buffer& tileLightOverflow) {
+		const wgpu::BufferDescriptor readbackBufferDescriptor = {
+			.label = "tile light overflow readback buffer",
+			.usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst,
+			.size = sizeof(structs::TileLightOverflow),
+		};
+		const wgpu::Buffer readbackBuffer = wgpuContext.device.CreateBuffer(&readbackBufferDescriptor);
+		wgpu::CommandEncoder commandEncoder = wgpuContext.device.CreateCommandEncoder();
+		commandEncoder.CopyBufferToBuffer(tileLightOverflow, 0, readbackBuffer, 0, sizeof(structs::TileLightOverflow));
+		wgpu::CommandBuffer commandBuffer = commandEncoder.Finish();
+		wgpuContext.queue.Submit(1, &commandBuffer);
+		wgpuContext.instance.WaitAny(
+			readbackBuffer.MapAsync(wgpu::MapMode::Read, 0, sizeof(structs::TileLightOverflow), wgpu::CallbackMode::WaitAnyOnly, [](wgpu::MapAsyncStatus, wgpu::StringView) {}),
+			UINT64_MAX
+		);
+		const structs::TileLightOverflow* mapped = static_cast<const structs::TileLightOverflow*>(readbackBuffer.GetConstMappedRange(0, sizeof(structs::TileLightOverflow)));
+		if (mapped == nullptr) {
+			throw std::runtime_error("failed to read back the tile light overflow");
+		}
+		const structs::TileLightOverflow overflow = *mapped;
+		readbackBuffer.Unmap();
+		return overflow;
+	}
+
+	//Average wall clock milliseconds of submitting the encoded passes and waiting for the queue to drain
+	template <typename Encode>
+	double timeSubmits(WGPUContext& wgpuContext, const uint32_t iterations, Encode encode) {
+		double totalMilliseconds = 0.0;
+		for (uint32_t i = 0; i < WARMUP_ITERATIONS + iterations; ++i) {
+			wgpu::CommandEncoder commandEncoder = wgpuContext.device.CreateCommandEncoder();
+			encode(commandEncoder);
+			wgpu::CommandBuffer commandBuffer = commandEncoder.Finish();
+
+			const auto start = std::chrono::steady_clock::now();
+			wgpuContext.queue.Submit(1, &commandBuffer);
+			waitForQueue(wgpuContext);
+			const auto end = std::chrono::steady_clock::now();
+			if (i >= WARMUP_ITERATIONS) {
+				totalMilliseconds += std::chrono::duration<double, std::milli>(end - start).count();
+			}
+		}
+		return totalMilliseconds / iterations;
+	}
+}
+
+int main(int argc, char* argv[]) {
+	try {
+		const uint32_t iterations = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : DEFAULT_ITERATIONS;
+		WGPUContext wgpuContext;
+		ThreadPool threadPool;
+
+		std::cout << "lights,culling_ms,lighting_ms,total_ms,overflowed_tiles,dropped_lights\n";
+		for (uint32_t lightCount = 1; lightCount <= MAX_LIGHT_COUNT; lightCount *= 2) {
+			HostSceneResources host = HostSceneResources(
+				gltfDirectory,
+				gltfFileName,
+				std::array<uint32_t, 2>{wgpuContext.getScreenDimensions().width, wgpuContext.getScreenDimensions().height},
+				threadPool
+			);
+			host.lights = createPointLights(host.vbo, lightCount);
+
+			render::Culling cullingRender = render::Culling(&wgpuContext, false);
+			render::Initial initialRender = render::Initial(&wgpuContext, false);
+			render::LightCulling lightCullingRender = render::LightCulling(&wgpuContext);
+			render::Lighting lightingRender = render::Lighting(&wgpuContext);
+			//Only the passes timed here and what they read, the other render targets get textures of their own
+			render::FrameGraph frameGraph = render::FrameGraph(&wgpuContext, {});
+			cullingRender.declareResources(frameGraph);
+			initialRender.declareResources(frameGraph);
+			lightCullingRender.declareResources(frameGraph);
+			lightingRender.declareResources(frameGraph);
+
+			RenderResources renderResources = RenderResources(&wgpuContext, frameGraph);
+			StagingBelt stagingBelt = StagingBelt(&wgpuContext, "bench");
+			SceneResources sceneResources = SceneResources(&wgpuContext, stagingBelt, host, threadPool);
+			DeviceResources deviceResources = {
+				.render = &renderResources,
+				.scene = &sceneResources,
+			};
+
+			PipelineBatch pipelineBatch = PipelineBatch(&wgpuContext);
+			cullingRender.createPipelineAsync(pipelineBatch);
+			initialRender.createPipelineAsync(pipelineBatch, &renderResources);
+			lightCullingRender.createPipelineAsync(pipelineBatch);
+			lightingRender.createPipelineAsync(pipelineBatch, &renderResources);
+			pipelineBatch.waitForAll();
+
+			cullingRender.generateGpuObjects(&deviceResources);
+			initialRender.generateGpuObjects(&deviceResources);
+			lightCullingRender.generateGpuObjects(&deviceResources);
+			lightingRender.generateGpuObjects(&deviceResources);
+
+			//The depth and gbuffer only need to be written once, every timed pass reads the same inputs
+			timeSubmits(wgpuContext, 1, [&](wgpu::CommandEncoder& commandEncoder) {
+				const render::culling::descriptor::DoCommands doCullingCommandsDescriptor = {
+					.commandEncoder = commandEncoder,
+				};
+				cullingRender.doCommands(&doCullingCommandsDescriptor);
+				const render::initial::descriptor::DoCommands doInitialRenderCommandsDescriptor = {
+					.commandEncoder = commandEncoder,
+					.depthTextureView = renderResources.depthTextureView,
+				};
+				initialRender.doCommands(&doInitialRenderCommandsDescriptor);
+			});
+
+			const double cullingMilliseconds = timeSubmits(wgpuContext, iterations, [&](wgpu::CommandEncoder& commandEncoder) {
+				const render::lightCulling::descriptor::DoCommands doLightCullingRenderCommandsDescriptor = {
+					.commandEncoder = commandEncoder,
+				};
+				lightCullingRender.doCommands(&doLightCullingRenderCommandsDescriptor);
+			});
+			const double lightingMilliseconds = timeSubmits(wgpuContext, iterations, [&](wgpu::CommandEncoder& commandEncoder) {
+				const render::lighting::descriptor::DoCommands doLightingRenderCommandsDescriptor = {
+					.commandEncoder = commandEncoder,
+				};
+				lightingRender.doCommands(&doLightingRenderCommandsDescriptor);
+			});
+
+			const structs::TileLightOverflow overflow = readTileLightOverflow(wgpuContext, renderResources.tileLightOverflow);
+
+			std::cout << std::format(
+				"{},{:.4f},{:.4f},{:.4f},{},{}\n",
+				lightCount,
+				cullingMilliseconds,
+				lightingMilliseconds,
+				cullingMilliseconds + lightingMilliseconds,
+				overflow.tileCount,
+				overflow.droppedLightCount
+			);
+		}
+	}
+	catch (std::exception& err) {
+		LOG(FATAL) << err.what();
+	}
+	catch (...) {
+		LOG(FATAL) << "unknown error";
+	}
+
+	return 0;
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <iterator>
+#include <numbers>
+#include <numeric>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include "absl/log/log.h"
+#include "../source/constants.hpp"
+#include "../source/engine/engine.hpp"
+#include "../source/engine/options.hpp"
+
+//Renders the scene once with nothing changing, once with the first light moving every frame, once with a light that starts
+//without a shadow map moved into the view of one that has it, and once with the geometry marked changed every frame, and
+//prints the shadow map pass time of each as CSV. The moving lights also allocate the shadow atlas again every frame, see
+//SceneResources::updateLight
+//Usage: DawnEngineShadowCacheBench [--scene=<path/to/scene.gltf>] [--frames=<count>] [engine options]
+namespace {
+	constexpr uint32_t DEFAULT_FRAME_COUNT = 300;
+	constexpr float LIGHT_PERIOD_FRAMES = 120.0f;
+	constexpr float LIGHT_AMPLITUDE = 0.1f; //of the light's range, or of a unit for lights without one
+
+	enum class Change {
+		NONE,
+		LIGHT,
+		UNSHADOWED_LIGHT, //the last light without a square, which may come after every light the culling pass covers
+		GEOMETRY,
+	};
+
+	struct Mode {
+		std::string name;
+		Change change;
+	};
+
+	//Moving a light by offset moves the world by -offset in its view, so the projection and orientation stay as imported
+	structs::Light getMovedLight(const structs::Light& light, const uint32_t frame) {
+		const float phase = 2.0f * std::numbers::pi_v<float> * static_cast<float>(frame) / LIGHT_PERIOD_FRAMES;
+		const glm::f32vec3 offset = glm::f32vec3(std::sin(phase), 0.0f, 0.0f) * (LIGHT_AMPLITUDE * std::max(light.range, 1.0f));
+		structs::Light moved = light;
+		moved.position += offset;
+		moved.lightSpaceMatrix = light.lightSpaceMatrix * glm::translate(glm::f32mat4x4(1.0f), -offset);
+		return moved;
+	}
+
+	double mean(const std::vector<double>& milliseconds) {
+		return milliseconds.empty() ? 0.0 : std::accumulate(milliseconds.begin(), milliseconds.end(), 0.0) / static_cast<double>(milliseconds.size());
+	}
+}
+
+int main(int argc, char* argv[]) {
+	try {
+		engine::Options options = engine::parseOptions(argc, argv);
+		options.collectFrameStats = true;
+		if (options.frameCount == 0) {
+			options.frameCount = DEFAULT_FRAME_COUNT;
+		}
+
+		const std::vector<Mode> modes = {
+			{ .name = "static", .change = Change::NONE },
+			{ .name = "moving_light", .change = Change::LIGHT },
+			{ .name = "unshadowed_light", .change = Change::UNSHADOWED_LIGHT },
+			{ .name = "geometry_changed", .change = Change::GEOMETRY },
+		};
+		std::cout << "mode,frames,shadow_map_ms,frame_interval_ms,shadowed_lights\n";
+		for (const Mode& mode : modes) {
+			Engine engine = Engine(options);
+			const std::vector<structs::Light>& lights = engine.getLights();
+			uint32_t movedLightIndex = 0;
+			structs::Light movedLight = lights.front();
+			if (mode.change == Change::UNSHADOWED_LIGHT) {
+				const auto unshadowed = std::find_if(lights.rbegin(), lights.rend(), [](const structs::Light& light) {
+					return light.shadowViewIndex == constants::NO_SHADOW_VIEW;
+				});
+				const auto shadowed = std::find_if(lights.begin(), lights.end(), [](const structs::Light& light) {
+					return light.shadowViewIndex != constants::NO_SHADOW_VIEW;
+				});
+				if (unshadowed == lights.rend() || shadowed == lights.end()) {
+					LOG(WARNING) << "Skipping " << mode.name << ", it needs a light with a shadow map and one without";
+					continue;
+				}
+				//Sharing the view of a light that has a square gives it one of its own
+				movedLightIndex = static_cast<uint32_t>(std::distance(unshadowed, lights.rend()) - 1);
+				movedLight = *unshadowed;
+				movedLight.position = shadowed->position;
+				movedLight.lightSpaceMatrix = shadowed->lightSpaceMatrix;
+			}
+			engine.run([&engine, &mode, movedLightIndex, &movedLight](const uint32_t frame) {
+				if (mode.change == Change::LIGHT || mode.change == Change::UNSHADOWED_LIGHT) {
+					engine.updateLight(movedLightIndex, getMovedLight(movedLight, frame));
+				}
+				else if (mode.change == Change::GEOMETRY) {
+					engine.markGeometryChanged();
+				}
+			});
+
+			const size_t shadowedLights = std::count_if(lights.begin(), lights.end(), [](const structs::Light& light) {
+				return light.shadowViewIndex != constants::NO_SHADOW_VIEW;
+			});
+			const GpuProfiler* gpuProfiler = engine.getGpuProfiler();
+			std::cout << std::format(
+				"{},{},{:.4f},{:.4f},{}\n",
+				mode.name,
+				engine.getFrameStats()->getFrameCount(),
+				gpuProfiler->isEnabled() ? gpuProfiler->getPassMilliseconds(enums::GpuPass::SHADOW_MAP) : 0.0,
+				mean(engine.getFrameStats()->getFrameIntervalMilliseconds()),
+				shadowedLights
+			);
+		}
+	}
+	catch (std::exception& err) {
+		LOG(FATAL) << err.what();
+	}
+	catch (...) {
+		LOG(FATAL) << "unknown error";
+	}
+
+	return 0;
+}
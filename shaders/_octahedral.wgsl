@@ -0,0 +1,19 @@
+//Included by every shader that packs or unpacks a normal, must match octahedralEncode in source/host/packing.cpp
+
+//Maps the unit sphere onto the [-1, 1] square so a normal fits in two snorm16s
+fn octahedralEncode(n : vec3<f32>) -> vec2<f32> {
+    let octahedron : vec3<f32> = n / (abs(n.x) + abs(n.y) + abs(n.z));
+    if (octahedron.z >= 0.0) {
+        return octahedron.xy;
+    }
+    let signs : vec2<f32> = select(vec2<f32>(-1.0), vec2<f32>(1.0), octahedron.xy >= vec2<f32>(0.0));
+    return (1.0 - abs(octahedron.yx)) * signs;
+}
+
+fn octahedralDecode(e : vec2<f32>) -> vec3<f32> {
+    var n : vec3<f32> = vec3<f32>(e, 1.0 - abs(e.x) - abs(e.y));
+    let t : f32 = max(-n.z, 0.0);
+    n.x = n.x + select(t, -t, n.x >= 0.0);
+    n.y = n.y + select(t, -t, n.y >= 0.0);
+    return normalize(n);
+}
@@ -0,0 +1,47 @@
+//Included by the accumulators, SceneResources::textureArrays in group 1 after the lookups and samplers
+
+//Must match structs::TextureArrayLookup
+struct TextureArrayLookup {
+    layer: u32,
+    useNearestFilter: u32,
+    useMipmaps: u32,
+    arrayIndex: u32,
+};
+
+const NO_LAYER : u32 = 0xffffffffu;
+
+//Must match constants::MAX_TEXTURE_ARRAYS, the slots past the scene's arrays repeat the first one
+@group(1) @binding(3) var textureArray0: texture_2d_array<f32>;
+@group(1) @binding(4) var textureArray1: texture_2d_array<f32>;
+@group(1) @binding(5) var textureArray2: texture_2d_array<f32>;
+@group(1) @binding(6) var textureArray3: texture_2d_array<f32>;
+@group(1) @binding(7) var textureArray4: texture_2d_array<f32>;
+@group(1) @binding(8) var textureArray5: texture_2d_array<f32>;
+@group(1) @binding(9) var textureArray6: texture_2d_array<f32>;
+@group(1) @binding(10) var textureArray7: texture_2d_array<f32>;
+
+fn textureArraySize(arrayIndex : u32) -> vec2<u32> {
+    switch arrayIndex {
+        case 1u: { return textureDimensions(textureArray1); }
+        case 2u: { return textureDimensions(textureArray2); }
+        case 3u: { return textureDimensions(textureArray3); }
+        case 4u: { return textureDimensions(textureArray4); }
+        case 5u: { return textureDimensions(textureArray5); }
+        case 6u: { return textureDimensions(textureArray6); }
+        case 7u: { return textureDimensions(textureArray7); }
+        default: { return textureDimensions(textureArray0); }
+    }
+}
+
+fn sampleTextureArray(arrayIndex : u32, samplerState : sampler, texCoord : vec2<f32>, layer : u32, lod : f32) -> vec4<f32> {
+    switch arrayIndex {
+        case 1u: { return textureSampleLevel(textureArray1, samplerState, texCoord, layer, lod); }
+        case 2u: { return textureSampleLevel(textureArray2, samplerState, texCoord, layer, lod); }
+        case 3u: { return textureSampleLevel(textureArray3, samplerState, texCoord, layer, lod); }
+        case 4u: { return textureSampleLevel(textureArray4, samplerState, texCoord, layer, lod); }
+        case 5u: { return textureSampleLevel(textureArray5, samplerState, texCoord, layer, lod); }
+        case 6u: { return textureSampleLevel(textureArray6, samplerState, texCoord, layer, lod); }
+        case 7u: { return textureSampleLevel(textureArray7, samplerState, texCoord, layer, lod); }
+        default: { return textureSampleLevel(textureArray0, samplerState, texCoord, layer, lod); }
+    }
+}
@@ -0,0 +1,42 @@
+//Included by the accumulators, which declare screenDimensions, texCoordTexture and textureIdTexture
+
+//Which of the ids Initial packed into textureIdTexture this accumulator reads, see constants::TEXTURE_ID_BITS
+override TEXTURE_ID_SHIFT : u32 = 0u;
+const NO_TEXTURE_ID : u32 = 0xffffu;
+
+fn loadTextureId(pixel : vec2<i32>) -> u32 {
+    return (textureLoad(textureIdTexture, pixel).x >> TEXTURE_ID_SHIFT) & NO_TEXTURE_ID;
+}
+
+//Texcoord change towards the neighbour on one axis, the smaller of the forward and backward difference so
+//silhouettes and texcoord seams do not blow up the footprint. Neighbours showing another texture do not count
+fn texCoordDelta(pixel : vec2<i32>, offset : vec2<i32>, textureId : u32, texCoord : vec2<f32>) -> vec2<f32> {
+    var delta : vec2<f32> = vec2<f32>(0.0);
+    var deltaLength : f32 = -1.0;
+    for (var side : i32 = -1; side <= 1; side += 2) {
+        let neighbour : vec2<i32> = pixel + offset * side;
+        if (any(neighbour < vec2<i32>(0)) || any(neighbour >= vec2<i32>(screenDimensions))) {
+            continue;
+        }
+        if (loadTextureId(neighbour) != textureId) {
+            continue;
+        }
+        let neighbourDelta : vec2<f32> = unpack2x16unorm(textureLoad(texCoordTexture, neighbour).x) - texCoord;
+        let neighbourLength : f32 = dot(neighbourDelta, neighbourDelta);
+        if (deltaLength < 0.0 || neighbourLength < deltaLength) {
+            delta = neighbourDelta;
+            deltaLength = neighbourLength;
+        }
+    }
+    return delta;
+}
+
+//Screen space derivatives are not available in compute, so the footprint of the pixel in texels is taken from its neighbours.
+//size is that of the sampled texture's level 0 in texels
+fn computeLod(pixel : vec2<i32>, textureId : u32, texCoord : vec2<f32>, size : vec2<f32>) -> f32 {
+    let dx : vec2<f32> = texCoordDelta(pixel, vec2<i32>(1, 0), textureId, texCoord) * size;
+    let dy : vec2<f32> = texCoordDelta(pixel, vec2<i32>(0, 1), textureId, texCoord) * size;
+    let footprint : f32 = max(dot(dx, dx), dot(dy, dy));
+    //log2 of the squared length halved is log2 of the length
+    return max(0.5 * log2(max(footprint, 1e-8)), 0.0);
+}
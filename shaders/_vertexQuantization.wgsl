@@ -0,0 +1,20 @@
+//Included by the vertex shaders that read structs::QuantizedVBO
+
+//Must match structs::VertexQuantization
+struct VertexQuantization {
+    positionMin : vec3<f32>,
+    PAD0 : u32,
+    positionScale : vec3<f32>,
+    PAD1 : u32,
+    texCoordMin : vec2<f32>,
+    texCoordScale : vec2<f32>,
+};
+
+//position is the unorm16x4 attribute, its w is unused
+fn dequantizePosition(quantization : VertexQuantization, position : vec4<f32>) -> vec3<f32> {
+    return quantization.positionMin + position.xyz * quantization.positionScale;
+}
+
+fn dequantizeTexCoord(quantization : VertexQuantization, texCoord : vec2<f32>) -> vec2<f32> {
+    return quantization.texCoordMin + texCoord * quantization.texCoordScale;
+}
@@ -0,0 +1,149 @@
+//Tests every primitive against every view, view 0 is the camera and view 1 + i is light i. A visible primitive appends its
+//DrawCall to the list of the view, which Initial and ShadowMap draw indirectly. Uint16 and Uint32 indexed draws are drawn
+//apart, so each keeps its own run of the list and its own count. The camera view is also tested against the
+//Hi-Z of the previous frame's depth when occlusion culling is on
+override WORKGROUP_SIZE : u32 = 64u;
+
+//Must match constants::INDEX_FORMAT_COUNT
+const INDEX_FORMAT_COUNT = 2u;
+
+struct CullingParams {
+    drawCount : u32,
+    viewCount : u32,
+    occlusionCulling : u32,
+    hiZMipCount : u32,
+    uint16DrawCount : u32,
+    PAD0 : u32,
+    PAD1 : u32,
+    PAD2 : u32,
+};
+
+struct DrawCall {
+    indexCount : u32,
+    instanceCount : u32,
+    firstIndex : u32,
+    baseVertex : u32,
+    firstInstance : u32,
+};
+
+struct DrawBounds {
+    center : vec3<f32>,
+    PAD0 : u32,
+    extent : vec3<f32>,
+    PAD1 : u32,
+};
+
+struct Light {
+    lightSpaceMatrix : mat4x4<f32>,
+    position : vec3<f32>,
+    PAD0 : u32,
+    rotation : vec3<f32>,
+    PAD1 : u32,
+    color : vec3<f32>,
+    lightType : u32,
+    intensity : f32,
+    range : f32,
+    innerConeAngle : f32,
+    outerConeAngle : f32,
+};
+
+@group(0) @binding(0) var<uniform> params : CullingParams;
+@group(0) @binding(1) var<storage, read> drawCalls : array<DrawCall>;
+@group(0) @binding(2) var<storage, read> drawBounds : array<DrawBounds>;
+@group(0) @binding(3) var<uniform> camera : mat4x4<f32>;
+@group(0) @binding(4) var<storage, read> lights : array<Light>;
+@group(0) @binding(5) var<uniform> previousCamera : mat4x4<f32>;
+@group(0) @binding(6) var hiZTexture : texture_2d<f32>;
+@group(0) @binding(7) var<storage, read_write> culledDrawCalls : array<DrawCall>;
+@group(0) @binding(8) var<storage, read_write> culledDrawCounts : array<atomic<u32>>;
+
+fn getCorner(bounds : DrawBounds, corner : u32) -> vec4<f32> {
+    let signs : vec3<f32> = select(
+        vec3<f32>(-1.0),
+        vec3<f32>(1.0),
+        (vec3<u32>(corner) & vec3<u32>(1u, 2u, 4u)) != vec3<u32>(0u)
+    );
+    return vec4<f32>(bounds.center + bounds.extent * signs, 1.0);
+}
+
+//One bit per clip plane the point is outside of
+fn getOutsideMask(clip : vec4<f32>) -> u32 {
+    var mask : u32 = 0u;
+    mask |= select(0u, 1u, clip.x < -clip.w);
+    mask |= select(0u, 2u, clip.x > clip.w);
+    mask |= select(0u, 4u, clip.y < -clip.w);
+    mask |= select(0u, 8u, clip.y > clip.w);
+    mask |= select(0u, 16u, clip.z < 0.0);
+    mask |= select(0u, 32u, clip.z > clip.w);
+    return mask;
+}
+
+//The box is outside only when all of its corners are outside the same plane
+fn isInFrustum(viewProjection : mat4x4<f32>, bounds : DrawBounds) -> bool {
+    var mask : u32 = 63u;
+    for (var corner : u32 = 0u; corner < 8u; corner++) {
+        mask &= getOutsideMask(viewProjection * getCorner(bounds, corner));
+    }
+    return mask == 0u;
+}
+
+//Projects the box with the camera the Hi-Z was built with and compares its nearest depth against the farthest depth of the
+//Hi-Z texels under it, read from the level where the projected rectangle spans at most 2x2 texels
+fn isOccluded(bounds : DrawBounds) -> bool {
+    var uvMin : vec2<f32> = vec2<f32>(1.0);
+    var uvMax : vec2<f32> = vec2<f32>(0.0);
+    var nearestDepth : f32 = 1.0;
+    for (var corner : u32 = 0u; corner < 8u; corner++) {
+        let clip : vec4<f32> = previousCamera * getCorner(bounds, corner);
+        //Reaches behind the camera, the projected rectangle is unbounded
+        if (clip.w <= 0.0) {
+            return false;
+        }
+        let ndc : vec3<f32> = clip.xyz / clip.w;
+        let uv : vec2<f32> = vec2<f32>(ndc.x * 0.5 + 0.5, 0.5 - ndc.y * 0.5);
+        uvMin = min(uvMin, uv);
+        uvMax = max(uvMax, uv);
+        nearestDepth = min(nearestDepth, ndc.z);
+    }
+
+    let hiZSize : vec2<f32> = vec2<f32>(textureDimensions(hiZTexture, 0));
+    let pixelMin : vec2<f32> = clamp(uvMin, vec2<f32>(0.0), vec2<f32>(1.0)) * hiZSize;
+    let pixelMax : vec2<f32> = clamp(uvMax, vec2<f32>(0.0), vec2<f32>(1.0)) * hiZSize;
+    let pixelExtent : vec2<f32> = max(pixelMax - pixelMin, vec2<f32>(1.0));
+    let level : u32 = min(u32(ceil(log2(max(pixelExtent.x, pixelExtent.y)))), params.hiZMipCount - 1u);
+
+    let levelMax : vec2<u32> = textureDimensions(hiZTexture, level) - vec2<u32>(1u);
+    let texelMin : vec2<u32> = min(vec2<u32>(pixelMin) >> vec2<u32>(level), levelMax);
+    let texelMax : vec2<u32> = min(vec2<u32>(pixelMax) >> vec2<u32>(level), levelMax);
+    let farthestDepth : f32 = max(
+        max(textureLoad(hiZTexture, texelMin, level).r, textureLoad(hiZTexture, vec2<u32>(texelMax.x, texelMin.y), level).r),
+        max(textureLoad(hiZTexture, vec2<u32>(texelMin.x, texelMax.y), level).r, textureLoad(hiZTexture, texelMax, level).r)
+    );
+    return nearestDepth > farthestDepth;
+}
+
+@compute @workgroup_size(WORKGROUP_SIZE, 1, 1)
+fn cs_main(@builtin(global_invocation_id) global_id : vec3<u32>) {
+    let drawIndex : u32 = global_id.x;
+    let view : u32 = global_id.y;
+    if (drawIndex >= params.drawCount || view >= params.viewCount) {
+        return;
+    }
+
+    let bounds : DrawBounds = drawBounds[drawIndex];
+    var viewProjection : mat4x4<f32> = camera;
+    if (view > 0u) {
+        viewProjection = lights[view - 1u].lightSpaceMatrix;
+    }
+    if (!isInFrustum(viewProjection, bounds)) {
+        return;
+    }
+    if (view == 0u && params.occlusionCulling != 0u && isOccluded(bounds)) {
+        return;
+    }
+
+    let isUint32 : bool = drawIndex >= params.uint16DrawCount;
+    let runStart : u32 = select(0u, params.uint16DrawCount, isUint32);
+    let slot : u32 = atomicAdd(&culledDrawCounts[view * INDEX_FORMAT_COUNT + select(0u, 1u, isUint32)], 1u);
+    culledDrawCalls[view * params.drawCount + runStart + slot] = drawCalls[drawIndex];
+}
@@ -1,38 +1,50 @@
-struct InputInfo {
-    stpIndex: u32,
-    PAD0: u32,
-    PAD1: u32,
-    PAD2: u32,
-};
-
-@group(0) @binding(0) var accumulatorTexture: texture_storage_2d<rgba32float, write>;
+#include "_textureArrays.wgsl"
+#include "_textureLod.wgsl"
+
+@group(0) @binding(0) var accumulatorTexture: texture_storage_2d<rgba8unorm, write>;
 @group(0) @binding(1) var texCoordTexture: texture_storage_2d<r32uint, read>;
 @group(0) @binding(2) var textureIdTexture : texture_storage_2d<r32uint, read>;
 @group(0) @binding(3) var<uniform> screenDimensions : vec2<u32>;
 
-@group(1) @binding(0) var<uniform> inputInfo: InputInfo;
-@group(1) @binding(1) var inputTexture: texture_2d<f32>;
-@group(1) @binding(2) var inputSamplerState: sampler;
+@group(1) @binding(0) var<storage, read> lookups: array<TextureArrayLookup>;
+@group(1) @binding(1) var linearSamplerState: sampler;
+@group(1) @binding(2) var nearestSamplerState: sampler;
+
+override WORKGROUP_SIZE_X : u32 = 8u;
+override WORKGROUP_SIZE_Y : u32 = 8u;
 
-@compute @workgroup_size(1, 1, 1)
+@compute @workgroup_size(WORKGROUP_SIZE_X, WORKGROUP_SIZE_Y, 1)
 fn cs_main(@builtin(global_invocation_id) global_id: vec3<u32>) {
-    let textureId : u32 = textureLoad(textureIdTexture, global_id.xy).x;
-
-    if (textureId == inputInfo.stpIndex) {
-        let packedTexCoord : u32 = textureLoad(texCoordTexture, global_id.xy).x;
-        let texCoord : vec2<f32> = unpack2x16unorm(packedTexCoord);
-
-        let sampledColor = textureSampleLevel(
-            inputTexture,
-            inputSamplerState,
-            texCoord,
-            0.0
-        );
-
-        textureStore(
-            accumulatorTexture,
-            global_id.xy,
-            sampledColor
-        );
+    if (any(global_id.xy >= screenDimensions)) {
+        return;
+    }
+    let textureId : u32 = loadTextureId(vec2<i32>(global_id.xy));
+    if (textureId == NO_TEXTURE_ID || textureId >= arrayLength(&lookups)) {
+        return;
+    }
+    let lookup : TextureArrayLookup = lookups[textureId];
+    if (lookup.layer == NO_LAYER) {
+        return;
+    }
+
+    let packedTexCoord : u32 = textureLoad(texCoordTexture, global_id.xy).x;
+    let texCoord : vec2<f32> = unpack2x16unorm(packedTexCoord);
+
+    var lod : f32 = 0.0;
+    if (lookup.useMipmaps != 0u) {
+        lod = computeLod(vec2<i32>(global_id.xy), textureId, texCoord, vec2<f32>(textureArraySize(lookup.arrayIndex)));
     }
+
+    var sampledColor : vec4<f32>;
+    if (lookup.useNearestFilter != 0u) {
+        sampledColor = sampleTextureArray(lookup.arrayIndex, nearestSamplerState, texCoord, lookup.layer, lod);
+    } else {
+        sampledColor = sampleTextureArray(lookup.arrayIndex, linearSamplerState, texCoord, lookup.layer, lod);
+    }
+
+    textureStore(
+        accumulatorTexture,
+        global_id.xy,
+        sampledColor
+    );
 }
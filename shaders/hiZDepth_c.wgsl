@@ -0,0 +1,15 @@
+//Copies the depth of the frame into level 0 of the Hi-Z
+@group(0) @binding(0) var depthTexture : texture_depth_2d;
+@group(0) @binding(1) var hiZTexture : texture_storage_2d<r32float, write>;
+
+override WORKGROUP_SIZE_X : u32 = 8u;
+override WORKGROUP_SIZE_Y : u32 = 8u;
+
+@compute @workgroup_size(WORKGROUP_SIZE_X, WORKGROUP_SIZE_Y, 1)
+fn cs_main(@builtin(global_invocation_id) global_id : vec3<u32>) {
+    if (any(global_id.xy >= textureDimensions(hiZTexture))) {
+        return;
+    }
+    let depth : f32 = textureLoad(depthTexture, global_id.xy, 0);
+    textureStore(hiZTexture, global_id.xy, vec4<f32>(depth, 0.0, 0.0, 0.0));
+}
@@ -0,0 +1,26 @@
+//Builds one Hi-Z level from the level above it, each texel keeps the farthest depth it covers
+@group(0) @binding(0) var sourceTexture : texture_2d<f32>;
+@group(0) @binding(1) var destinationTexture : texture_storage_2d<r32float, write>;
+
+override WORKGROUP_SIZE_X : u32 = 8u;
+override WORKGROUP_SIZE_Y : u32 = 8u;
+
+@compute @workgroup_size(WORKGROUP_SIZE_X, WORKGROUP_SIZE_Y, 1)
+fn cs_main(@builtin(global_invocation_id) global_id : vec3<u32>) {
+    let destinationSize : vec2<u32> = textureDimensions(destinationTexture);
+    if (any(global_id.xy >= destinationSize)) {
+        return;
+    }
+    //The last row and column also take the odd row and column of an odd sized source, so no depth is left out
+    let sourceSize : vec2<u32> = textureDimensions(sourceTexture);
+    let first : vec2<u32> = global_id.xy * 2u;
+    let last : vec2<u32> = select(first + vec2<u32>(1u), sourceSize - vec2<u32>(1u), global_id.xy == destinationSize - vec2<u32>(1u));
+
+    var farthestDepth : f32 = 0.0;
+    for (var y : u32 = first.y; y <= last.y; y++) {
+        for (var x : u32 = first.x; x <= last.x; x++) {
+            farthestDepth = max(farthestDepth, textureLoad(sourceTexture, vec2<u32>(x, y), 0).r);
+        }
+    }
+    textureStore(destinationTexture, global_id.xy, vec4<f32>(farthestDepth, 0.0, 0.0, 0.0));
+}
@@ -0,0 +1,49 @@
+#include "_octahedral.wgsl"
+#include "_vertexQuantization.wgsl"
+
+//initialRender_v.wgsl for a vbo of structs::QuantizedVBO
+
+//Must match structs::Instance
+struct Instance {
+	transformIndex : u32,
+	materialIndex : u32,
+};
+
+@group(0) @binding(1) var<uniform> camera: mat4x4<f32>;
+@group(0) @binding(2) var<storage, read> transforms: array<mat4x4<f32>>;
+@group(0) @binding(3) var<storage, read> instances: array<Instance>;
+@group(0) @binding(5) var<storage, read> vertexQuantizations: array<VertexQuantization>;
+@group(0) @binding(6) var<storage, read> vertexQuantizationIndices: array<u32>;
+
+struct VSInput {
+	@location(0) position : vec4<f32>, //unorm16x4
+	@location(1) normal : vec2<f32>, //snorm16x2 octahedral
+	@location(2) texCoord : vec2<f32>, //unorm16x2
+};
+
+struct VSOutput {
+	@builtin(position) cameraPosition : vec4<f32>,
+	@location(0) worldPosition : vec4<f32>,
+	@location(1) normal : vec3<f32>,
+	@location(2) texCoord : vec2<f32>,
+	@location(3) @interpolate(flat) materialIndex : u32,
+};
+
+@vertex
+fn vs_main(
+	input : VSInput,
+	@builtin(instance_index) instanceIndex : u32
+) -> VSOutput {
+	let instance : Instance = instances[instanceIndex];
+	let transform : mat4x4<f32> = transforms[instance.transformIndex];
+	let quantization : VertexQuantization = vertexQuantizations[vertexQuantizationIndices[instance.transformIndex]];
+	let position : vec3<f32> = dequantizePosition(quantization, input.position);
+
+	var output : VSOutput;
+	output.worldPosition = transform * vec4<f32>(position, 1.0);
+	output.cameraPosition = camera * output.worldPosition;
+	output.texCoord = dequantizeTexCoord(quantization, input.texCoord);
+	output.normal = normalize((transform * vec4<f32>(octahedralDecode(input.normal), 0.0)).xyz);
+	output.materialIndex = instance.materialIndex;
+	return output;
+}
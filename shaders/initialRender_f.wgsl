@@ -1,3 +1,5 @@
+#include "_octahedral.wgsl"
+
 struct TextureInfo {
 	index : u32,
 	texCoord : u32,
@@ -25,32 +27,32 @@ struct VSOutput {
 	@location(0) worldPosition : vec4<f32>,
 	@location(1) normal : vec3<f32>,
 	@location(2) texCoord : vec2<f32>,
-	@location(3) @interpolate(flat) instanceIndex : u32,
+	@location(3) @interpolate(flat) materialIndex : u32,
 };
 
 struct FSOutput { //THIS IS LIMITED TO 4 OR DX12 TRIANGLE BUG WILL OCCUR
-	@location(0) worldPosition : vec4<f32>,
-	@location(1) normal : vec4<f32>,
-	@location(2) texCoord : u32,
-	@location(3) baseColor : vec4<f32>,
-//	@location(4) baseColorId : u32,
-//	@location(5) normalId : u32,
+	@location(0) normal : u32,
+	@location(1) texCoord : u32,
+	@location(2) baseColor : vec4<f32>,
+	@location(3) textureIds : u32,
 }
 
-@group(0) @binding(3) var<storage, read> materialIds: array<u32>;
+//Must match constants::TEXTURE_ID_BITS, ids of UINT32_MAX become the all ones NO_TEXTURE_ID
+const TEXTURE_ID_MASK : u32 = 0xffffu;
+const NORMAL_TEXTURE_ID_SHIFT : u32 = 16u;
+
 @group(0) @binding(4) var<storage, read> materials: array<Material>;
 
 @fragment
 fn fs_main(input : VSOutput) -> FSOutput {
     var output : FSOutput;
-	output.worldPosition = input.worldPosition;
-	output.normal = vec4<f32>(input.normal, 1.0 ); 
+	output.normal = pack2x16snorm(octahedralEncode(normalize(input.normal)));
 	output.texCoord = pack2x16unorm(input.texCoord);
 
-	let material : Material = materials[materialIds[input.instanceIndex]];
+	let material : Material = materials[input.materialIndex];
 	output.baseColor = material.pbrMetallicRoughness.baseColor;
-//	output.baseColorId = material.pbrMetallicRoughness.baseColorTextureInfo.index;
-//	output.normalId = material.normalTextureInfo.index;
+	output.textureIds = (material.pbrMetallicRoughness.baseColorTextureInfo.index & TEXTURE_ID_MASK) |
+		((material.normalTextureInfo.index & TEXTURE_ID_MASK) << NORMAL_TEXTURE_ID_SHIFT);
 
 	return output;
 }
\ No newline at end of file
@@ -22,8 +22,14 @@ struct Material {
 
 @group(0) @binding(0) var<uniform> screenDimensions: vec2<u32>;
 @group(0) @binding(1) var<uniform> camera: mat4x4<f32>;
+//Must match structs::Instance
+struct Instance {
+	transformIndex : u32,
+	materialIndex : u32,
+};
+
 @group(0) @binding(2) var<storage, read> transforms: array<mat4x4<f32>>;
-@group(0) @binding(3) var<storage, read> materialIds: array<u32>;
+@group(0) @binding(3) var<storage, read> instances: array<Instance>;
 @group(0) @binding(4) var<storage, read> materials: array<Material>;
 
 struct VSInput {
@@ -37,7 +43,7 @@ struct VSOutput {
 	@location(0) worldPosition : vec4<f32>,
 	@location(1) normal : vec3<f32>,
 	@location(2) texCoord : vec2<f32>,
-	@location(3) @interpolate(flat) instanceIndex : u32,
+	@location(3) @interpolate(flat) materialIndex : u32,
 };
 
 @vertex
@@ -46,12 +52,15 @@ fn vs_main(
 	@builtin(vertex_index) vertexIndex : u32, 
 	@builtin(instance_index) instanceIndex : u32
 ) -> VSOutput {
+	let instance : Instance = instances[instanceIndex];
+	let transform : mat4x4<f32> = transforms[instance.transformIndex];
+
 	var output : VSOutput;
-	output.worldPosition = transforms[instanceIndex] * vec4<f32>(input.position, 1.0);
+	output.worldPosition = transform * vec4<f32>(input.position, 1.0);
 	output.cameraPosition = camera * output.worldPosition;
 	output.texCoord = input.texCoord;
-    output.normal = normalize((transforms[instanceIndex] * vec4<f32>(input.normal, 0.0)).xyz);
-	output.instanceIndex = instanceIndex;
+    output.normal = normalize((transform * vec4<f32>(input.normal, 0.0)).xyz);
+	output.materialIndex = instance.materialIndex;
 	return output;
 }
 
@@ -83,7 +92,7 @@ fn fs_main(input : VSOutput) {
 	let packedTexCoords: u32 = pack2x16unorm(input.texCoord);
 	textureStore(texCoords, coords, copyFour(packedTexCoords));
 
-	let material : Material = materials[materialIds[input.instanceIndex]];
+	let material : Material = materials[input.materialIndex];
 	textureStore(baseColor, coords, material.pbrMetallicRoughness.baseColor);
 	textureStore(baseColorId, coords, copyFour(material.pbrMetallicRoughness.baseColorTextureInfo.index));
 	textureStore(normalId, coords, copyFour(material.normalTextureInfo.index));
@@ -0,0 +1,133 @@
+const LIGHTTYPE_DIRECTIONAL = 0u;
+
+//Must match constants::LIGHT_TILE_SIZE and constants::MAX_LIGHTS_PER_TILE
+const LIGHT_TILE_SIZE = 16u;
+const MAX_LIGHTS_PER_TILE = 255u;
+
+const FLOAT_MAX_BITS = 0x7f7fffffu;
+
+struct Light {
+    lightSpaceMatrix : mat4x4<f32>,
+    position : vec3<f32>,
+    PAD0 : u32,
+    rotation : vec3<f32>,
+    PAD1 : u32,
+    color : vec3<f32>,
+    lightType : u32,
+    intensity : f32,
+    range : f32,
+    innerConeAngle : f32,
+    outerConeAngle : f32,
+};
+
+struct TileLights {
+    count : u32,
+    indices : array<u32, MAX_LIGHTS_PER_TILE>,
+};
+
+//Must match structs::TileLightOverflow, cleared before every dispatch
+struct TileLightOverflow {
+    tileCount : atomic<u32>,
+    droppedLightCount : atomic<u32>,
+};
+
+@group(0) @binding(0) var depthTexture : texture_depth_2d;
+@group(0) @binding(1) var<uniform> inverseCamera : mat4x4<f32>;
+@group(0) @binding(2) var<storage, read> lights : array<Light>;
+@group(0) @binding(3) var<storage, read_write> tileLights : array<TileLights>;
+@group(0) @binding(4) var<storage, read_write> tileLightOverflow : TileLightOverflow;
+
+//depth is always positive so its bits sort the same way as the float does
+var<workgroup> minDepthBits : atomic<u32>;
+var<workgroup> maxDepthBits : atomic<u32>;
+var<workgroup> tileLightCount : atomic<u32>;
+var<workgroup> tileLightIndices : array<u32, MAX_LIGHTS_PER_TILE>;
+
+fn unproject(ndc : vec3<f32>) -> vec3<f32> {
+    let world : vec4<f32> = inverseCamera * vec4<f32>(ndc, 1.0);
+    return world.xyz / world.w;
+}
+
+//A light without a range reaches everything, otherwise test its range sphere against the tile's box
+fn lightReachesTile(light : Light, tileMin : vec3<f32>, tileMax : vec3<f32>) -> bool {
+    if (light.lightType == LIGHTTYPE_DIRECTIONAL || !(light.range > 0.0)) {
+        return true;
+    }
+    let closestPoint : vec3<f32> = clamp(light.position, tileMin, tileMax);
+    let toLight : vec3<f32> = light.position - closestPoint;
+    return dot(toLight, toLight) <= light.range * light.range;
+}
+
+@compute @workgroup_size(LIGHT_TILE_SIZE, LIGHT_TILE_SIZE, 1)
+fn cs_main(
+    @builtin(global_invocation_id) GlobalInvocationID : vec3<u32>,
+    @builtin(local_invocation_index) localIndex : u32,
+    @builtin(workgroup_id) workgroupId : vec3<u32>,
+    @builtin(num_workgroups) workgroupCount : vec3<u32>
+) {
+    if (localIndex == 0u) {
+        atomicStore(&minDepthBits, FLOAT_MAX_BITS);
+        atomicStore(&maxDepthBits, 0u);
+        atomicStore(&tileLightCount, 0u);
+    }
+    workgroupBarrier();
+
+    let screenDimensions : vec2<u32> = textureDimensions(depthTexture);
+    if (all(GlobalInvocationID.xy < screenDimensions)) {
+        let depth : f32 = textureLoad(depthTexture, GlobalInvocationID.xy, 0);
+        if (depth < 1.0) { //1.0 is the clear value, nothing was drawn here
+            atomicMin(&minDepthBits, bitcast<u32>(depth));
+            atomicMax(&maxDepthBits, bitcast<u32>(depth));
+        }
+    }
+    workgroupBarrier();
+
+    let minDepth : f32 = bitcast<f32>(atomicLoad(&minDepthBits));
+    let maxDepth : f32 = bitcast<f32>(atomicLoad(&maxDepthBits));
+    if (minDepth <= maxDepth) {
+        //texel rows grow downwards while ndc y grows upwards
+        let screenSize : vec2<f32> = vec2<f32>(screenDimensions);
+        let tileMinPixel : vec2<f32> = vec2<f32>(workgroupId.xy * LIGHT_TILE_SIZE);
+        let tileMaxPixel : vec2<f32> = min(vec2<f32>((workgroupId.xy + 1u) * LIGHT_TILE_SIZE), screenSize);
+        let ndcMin : vec2<f32> = vec2<f32>(tileMinPixel.x / screenSize.x * 2.0 - 1.0, 1.0 - tileMaxPixel.y / screenSize.y * 2.0);
+        let ndcMax : vec2<f32> = vec2<f32>(tileMaxPixel.x / screenSize.x * 2.0 - 1.0, 1.0 - tileMinPixel.y / screenSize.y * 2.0);
+
+        var tileMin : vec3<f32> = vec3<f32>(3.4e38);
+        var tileMax : vec3<f32> = vec3<f32>(-3.4e38);
+        for (var corner : u32 = 0u; corner < 8u; corner++) {
+            let ndc : vec3<f32> = vec3<f32>(
+                select(ndcMin.x, ndcMax.x, (corner & 1u) != 0u),
+                select(ndcMin.y, ndcMax.y, (corner & 2u) != 0u),
+                select(minDepth, maxDepth, (corner & 4u) != 0u)
+            );
+            let world : vec3<f32> = unproject(ndc);
+            tileMin = min(tileMin, world);
+            tileMax = max(tileMax, world);
+        }
+
+        let lightCount : u32 = arrayLength(&lights);
+        for (var i : u32 = localIndex; i < lightCount; i += LIGHT_TILE_SIZE * LIGHT_TILE_SIZE) {
+            if (lightReachesTile(lights[i], tileMin, tileMax)) {
+                let slot : u32 = atomicAdd(&tileLightCount, 1u);
+                if (slot < MAX_LIGHTS_PER_TILE) {
+                    tileLightIndices[slot] = i;
+                }
+            }
+        }
+    }
+    workgroupBarrier();
+
+    let tileIndex : u32 = workgroupId.y * workgroupCount.x + workgroupId.x;
+    let reachingCount : u32 = atomicLoad(&tileLightCount);
+    let count : u32 = min(reachingCount, MAX_LIGHTS_PER_TILE);
+    if (localIndex == 0u) {
+        tileLights[tileIndex].count = count;
+        if (reachingCount > MAX_LIGHTS_PER_TILE) {
+            atomicAdd(&tileLightOverflow.tileCount, 1u);
+            atomicAdd(&tileLightOverflow.droppedLightCount, reachingCount - MAX_LIGHTS_PER_TILE);
+        }
+    }
+    for (var i : u32 = localIndex; i < count; i += LIGHT_TILE_SIZE * LIGHT_TILE_SIZE) {
+        tileLights[tileIndex].indices[i] = tileLightIndices[i];
+    }
+}
@@ -1,11 +1,18 @@
+#include "_octahedral.wgsl"
+
 const LIGHTTYPE_DIRECTIONAL = 0u;
 const LIGHTTYPE_SPOT = 1u;
 const LIGHTTYPE_POINT = 2u;
 
+//Must match constants::LIGHT_TILE_SIZE, constants::MAX_LIGHTS_PER_TILE and constants::NO_SHADOW_VIEW
+const LIGHT_TILE_SIZE = 16u;
+const MAX_LIGHTS_PER_TILE = 255u;
+const NO_SHADOW_VIEW = 0xffffffffu;
+
 struct Light {
     lightSpaceMatrix : mat4x4<f32>,
     position : vec3<f32>,
-    PAD0 : u32,
+    shadowViewIndex : u32,
     rotation : vec3<f32>,
     PAD1 : u32,
     color : vec3<f32>,
@@ -16,12 +23,66 @@ struct Light {
     outerConeAngle : f32,
 };
 
-@group(0) @binding(0) var accumulatorTexture: texture_storage_2d<r32uint, read_write>;
-@group(0) @binding(1) var worldPositionTexture: texture_storage_2d<rgba32float, read>;
-@group(0) @binding(2) var normalTexture: texture_storage_2d<rgba32float, read>;
+//Must match structs::ShadowView
+struct ShadowView {
+    lightSpaceMatrix : mat4x4<f32>,
+    atlasRect : vec4<f32>, //uv offset in xy and uv scale in zw of the shadow map
+};
+
+struct TileLights {
+    count : u32,
+    indices : array<u32, MAX_LIGHTS_PER_TILE>,
+};
+
+@group(0) @binding(0) var accumulatorTexture: texture_storage_2d<r32uint, write>;
+@group(0) @binding(1) var depthTexture: texture_depth_2d;
+@group(0) @binding(2) var normalTexture: texture_storage_2d<r32uint, read>;
+@group(0) @binding(3) var<uniform> inverseCamera: mat4x4<f32>;
+
+@group(1) @binding(0) var<storage, read> lights: array<Light>;
+@group(1) @binding(1) var<storage, read> tileLights: array<TileLights>; //written by lightCulling_c.wgsl
+@group(1) @binding(2) var<storage, read> shadowViews: array<ShadowView>;
+@group(1) @binding(3) var shadowAtlasTexture: texture_depth_2d;
+@group(1) @binding(4) var shadowSampler: sampler_comparison;
+
+const AMBIENT_LIGHT : f32 = 0.1;
+
+override WORKGROUP_SIZE_X : u32 = 8u;
+override WORKGROUP_SIZE_Y : u32 = 8u;
 
-@group(1) @binding(0) var<uniform> light: Light;
+fn reconstructWorldPosition(coords : vec2<u32>, depth : f32, screenDimensions : vec2<u32>) -> vec3<f32> {
+    let uv : vec2<f32> = (vec2<f32>(coords) + 0.5) / vec2<f32>(screenDimensions);
+    let ndc : vec4<f32> = vec4<f32>(uv.x * 2.0 - 1.0, 1.0 - uv.y * 2.0, depth, 1.0);
+    let world : vec4<f32> = inverseCamera * ndc;
+    return world.xyz / world.w;
+}
+
+//How much of the light reaches the point, 1 without a shadow map or outside of it
+fn shadowVisibility(light:Light, worldPosition:vec3<f32>, normal:vec3<f32>) -> f32 {
+    if (light.shadowViewIndex == NO_SHADOW_VIEW) {
+        return 1.0;
+    }
+    let view : ShadowView = shadowViews[light.shadowViewIndex];
+    let lightPos : vec4<f32> = view.lightSpaceMatrix * vec4<f32>(worldPosition, 1.0);
+    if (lightPos.w <= 0.0) {
+        return 1.0;
+    }
+    let projCoords : vec3<f32> = lightPos.xyz / lightPos.w;
+    if (projCoords.z > 1.0) {
+        return 1.0;
+    }
+    var uv : vec2<f32> = projCoords.xy * 0.5 + 0.5;
+    uv.y = 1.0 - uv.y;
 
+    let oneOverShadowMapSize : f32 = 1.0 / (view.atlasRect.z * f32(textureDimensions(shadowAtlasTexture).x));
+    uv = uv + normal.xz * oneOverShadowMapSize;
+    if (0.0 > uv.x || uv.x > 1.0 || 0.0 > uv.y || uv.y > 1.0) {
+        return 1.0;
+    }
+    //Keeps the nearest texel inside the square, past its edge is another light's shadow map
+    uv = clamp(uv, vec2<f32>(0.5 * oneOverShadowMapSize), vec2<f32>(1.0 - 0.5 * oneOverShadowMapSize));
+    return textureSampleCompareLevel(shadowAtlasTexture, shadowSampler, view.atlasRect.xy + uv * view.atlasRect.zw, projCoords.z);
+}
 
 fn directionalLight(light:Light, normal:vec3<f32>) -> vec3<f32> {
     let lightDir:vec3<f32> = computeLightDirection(light.rotation);
@@ -50,23 +111,45 @@ fn spotLight(light:Light, normal:vec3<f32>, worldPosition:vec3<f32>) -> vec3<f32
     return pointLight(light, normal, worldPosition) * intensity;
 }
 
-@compute @workgroup_size(1, 1, 1)
+@compute @workgroup_size(WORKGROUP_SIZE_X, WORKGROUP_SIZE_Y, 1)
 fn cs_main(@builtin(global_invocation_id) GlobalInvocationID: vec3<u32>) {
-    let loadAccumulator : vec4<u32> = (textureLoad(accumulatorTexture, GlobalInvocationID.xy));
-    var accumulator : vec3<f32> = unpack4x8unorm(loadAccumulator.x).xyz;
-    let worldPosition : vec3<f32> = textureLoad(worldPositionTexture, GlobalInvocationID.xy).xyz;
-    let normal : vec3<f32> = textureLoad(normalTexture, GlobalInvocationID.xy).xyz;
-    switch(light.lightType) {
-        case LIGHTTYPE_DIRECTIONAL {
-            accumulator = accumulator + directionalLight(light, normal);
-        }
-        case LIGHTTYPE_POINT {
-            accumulator = accumulator + pointLight(light, normal, worldPosition);
+    let screenDimensions : vec2<u32> = textureDimensions(accumulatorTexture);
+    if (any(GlobalInvocationID.xy >= screenDimensions)) {
+        return;
+    }
+    var accumulator : vec3<f32> = vec3<f32>(AMBIENT_LIGHT);
+    let depth : f32 = textureLoad(depthTexture, GlobalInvocationID.xy, 0);
+    if (depth >= 1.0) { //nothing was drawn here
+        let result : u32 = pack4x8unorm(vec4<f32>(accumulator, 1.0));
+        textureStore(accumulatorTexture, GlobalInvocationID.xy, vec4<u32>(result, result, result, result));
+        return;
+    }
+    let worldPosition : vec3<f32> = reconstructWorldPosition(GlobalInvocationID.xy, depth, screenDimensions);
+    let normal : vec3<f32> = octahedralDecode(unpack2x16snorm(textureLoad(normalTexture, GlobalInvocationID.xy).x));
+    let tileCountX : u32 = (screenDimensions.x + LIGHT_TILE_SIZE - 1u) / LIGHT_TILE_SIZE;
+    let tile : vec2<u32> = GlobalInvocationID.xy / LIGHT_TILE_SIZE;
+    let tileIndex : u32 = tile.y * tileCountX + tile.x;
+    let lightCount : u32 = tileLights[tileIndex].count;
+    for (var i : u32 = 0u; i < lightCount; i++) {
+        let light : Light = lights[tileLights[tileIndex].indices[i]];
+        var contribution : vec3<f32> = vec3<f32>(0.0);
+        switch(light.lightType) {
+            case LIGHTTYPE_DIRECTIONAL {
+                contribution = directionalLight(light, normal);
+            }
+            case LIGHTTYPE_POINT {
+                contribution = pointLight(light, normal, worldPosition);
+            }
+            case LIGHTTYPE_SPOT {
+                contribution = spotLight(light, normal, worldPosition);
+            }
+            case default: {}
         }
-        case LIGHTTYPE_SPOT {
-            accumulator = accumulator + spotLight(light, normal, worldPosition);
+        //Each light is only darkened by its own shadow map
+        if (any(contribution > vec3<f32>(0.0))) {
+            contribution = contribution * shadowVisibility(light, worldPosition, normal);
         }
-        case default: {}
+        accumulator = accumulator + contribution;
     }
     let result : u32 = pack4x8unorm(vec4<f32>(accumulator, 1.0));
     textureStore(accumulatorTexture, GlobalInvocationID.xy, vec4<u32>(result, result, result, result));
@@ -0,0 +1,30 @@
+//Builds one mip level of the texture array from the level above it with a 2x2 box filter
+@group(0) @binding(0) var sourceTexture: texture_2d_array<f32>;
+@group(0) @binding(1) var destinationTexture: texture_storage_2d_array<rgba8unorm, write>;
+
+override WORKGROUP_SIZE_X : u32 = 8u;
+override WORKGROUP_SIZE_Y : u32 = 8u;
+
+@compute @workgroup_size(WORKGROUP_SIZE_X, WORKGROUP_SIZE_Y, 1)
+fn cs_main(@builtin(global_invocation_id) global_id: vec3<u32>) {
+    if (any(global_id.xy >= textureDimensions(destinationTexture))) {
+        return;
+    }
+    //Odd sized levels clamp the last row and column rather than reading past the edge
+    let sourceMax : vec2<u32> = textureDimensions(sourceTexture) - vec2<u32>(1u);
+    let sourceCoord : vec2<u32> = global_id.xy * 2u;
+    let layer : u32 = global_id.z;
+
+    var color : vec4<f32> = vec4<f32>(0.0);
+    color += textureLoad(sourceTexture, min(sourceCoord, sourceMax), layer, 0);
+    color += textureLoad(sourceTexture, min(sourceCoord + vec2<u32>(1u, 0u), sourceMax), layer, 0);
+    color += textureLoad(sourceTexture, min(sourceCoord + vec2<u32>(0u, 1u), sourceMax), layer, 0);
+    color += textureLoad(sourceTexture, min(sourceCoord + vec2<u32>(1u, 1u), sourceMax), layer, 0);
+
+    textureStore(
+        destinationTexture,
+        global_id.xy,
+        layer,
+        color * 0.25
+    );
+}
@@ -0,0 +1,54 @@
+#include "_octahedral.wgsl"
+#include "_textureArrays.wgsl"
+#include "_textureLod.wgsl"
+
+@group(0) @binding(0) var accumulatorTexture: texture_storage_2d<r32uint, write>;
+@group(0) @binding(1) var texCoordTexture: texture_storage_2d<r32uint, read>;
+@group(0) @binding(2) var textureIdTexture : texture_storage_2d<r32uint, read>;
+@group(0) @binding(3) var<uniform> screenDimensions : vec2<u32>;
+
+@group(1) @binding(0) var<storage, read> lookups: array<TextureArrayLookup>;
+@group(1) @binding(1) var linearSamplerState: sampler;
+@group(1) @binding(2) var nearestSamplerState: sampler;
+
+override WORKGROUP_SIZE_X : u32 = 8u;
+override WORKGROUP_SIZE_Y : u32 = 8u;
+
+@compute @workgroup_size(WORKGROUP_SIZE_X, WORKGROUP_SIZE_Y, 1)
+fn cs_main(@builtin(global_invocation_id) global_id: vec3<u32>) {
+    if (any(global_id.xy >= screenDimensions)) {
+        return;
+    }
+    let textureId : u32 = loadTextureId(vec2<i32>(global_id.xy));
+    if (textureId == NO_TEXTURE_ID || textureId >= arrayLength(&lookups)) {
+        return;
+    }
+    let lookup : TextureArrayLookup = lookups[textureId];
+    if (lookup.layer == NO_LAYER) {
+        return;
+    }
+
+    let packedTexCoord : u32 = textureLoad(texCoordTexture, global_id.xy).x;
+    let texCoord : vec2<f32> = unpack2x16unorm(packedTexCoord);
+
+    var lod : f32 = 0.0;
+    if (lookup.useMipmaps != 0u) {
+        lod = computeLod(vec2<i32>(global_id.xy), textureId, texCoord, vec2<f32>(textureArraySize(lookup.arrayIndex)));
+    }
+
+    var sampledColor : vec4<f32>;
+    if (lookup.useNearestFilter != 0u) {
+        sampledColor = sampleTextureArray(lookup.arrayIndex, nearestSamplerState, texCoord, lookup.layer, lod);
+    } else {
+        sampledColor = sampleTextureArray(lookup.arrayIndex, linearSamplerState, texCoord, lookup.layer, lod);
+    }
+
+    //normal maps store [-1, 1] in [0, 1]
+    let normal : vec3<f32> = normalize(sampledColor.xyz * 2.0 - 1.0);
+    let packedNormal : u32 = pack2x16snorm(octahedralEncode(normal));
+    textureStore(
+        accumulatorTexture,
+        global_id.xy,
+        vec4<u32>(packedNormal, 0u, 0u, 0u)
+    );
+}
@@ -0,0 +1,7 @@
+//One triangle over the whole viewport at the far plane, drawn with depth compare always to clear a shadow map's square of
+//the atlas without touching the others
+@vertex
+fn vs_main(@builtin(vertex_index) vertexIndex : u32) -> @builtin(position) vec4<f32> {
+    let uv : vec2<f32> = vec2<f32>(f32((vertexIndex << 1u) & 2u), f32(vertexIndex & 2u));
+    return vec4<f32>(uv * 2.0 - 1.0, 1.0, 1.0);
+}
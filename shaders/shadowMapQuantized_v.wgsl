@@ -0,0 +1,43 @@
+#include "_vertexQuantization.wgsl"
+
+//shadowMap_v.hlsl for a vbo of structs::QuantizedVBO, its output matches VSOutput in shadowMap.hlsli for shadowMap_f.hlsl
+
+//Must match structs::Instance
+struct Instance {
+    transformIndex : u32,
+    materialIndex : u32,
+};
+
+//The start of structs::Light, the rest of the uniform is not read
+struct ShadowLight {
+    lightSpaceMatrix : mat4x4<f32>,
+};
+
+@group(0) @binding(0) var<storage, read> transforms : array<mat4x4<f32>>;
+@group(0) @binding(1) var<storage, read> vertexQuantizations : array<VertexQuantization>;
+@group(0) @binding(2) var<storage, read> vertexQuantizationIndices : array<u32>;
+@group(0) @binding(3) var<storage, read> instances : array<Instance>;
+@group(1) @binding(0) var<uniform> light : ShadowLight;
+
+struct VSInput {
+    @location(0) position : vec4<f32>, //unorm16x4, the normal and texcoord are not needed
+};
+
+struct VSOutput {
+    @builtin(position) clipPosition : vec4<f32>,
+    @location(0) position : vec3<f32>,
+};
+
+@vertex
+fn vs_main(
+    input : VSInput,
+    @builtin(instance_index) instanceIndex : u32
+) -> VSOutput {
+    let transformIndex : u32 = instances[instanceIndex].transformIndex;
+    let position : vec3<f32> = dequantizePosition(vertexQuantizations[vertexQuantizationIndices[transformIndex]], input.position);
+
+    var output : VSOutput;
+    output.position = (transforms[transformIndex] * vec4<f32>(position, 1.0)).xyz;
+    output.clipPosition = light.lightSpaceMatrix * vec4<f32>(output.position, 1.0);
+    return output;
+}
@@ -1,5 +1,13 @@
 #include "shadowMap.hlsli"
+//Must match structs::Instance
+struct Instance
+{
+    uint transformIndex;
+    uint materialIndex;
+};
+
 StructuredBuffer<float4x4> transforms : register(t0, space0);
+StructuredBuffer<Instance> instances : register(t3, space0);
 ConstantBuffer<Light> light : register(b0, space1);
 
 struct VSInput
@@ -13,7 +21,7 @@ VSOutput vs_main(VSInput input, uint VertexIndex : SV_VertexID, uint InstanceInd
 {
     VSOutput output = (VSOutput) 0;    
     
-    output.Position = (float3) mul(transforms[InstanceIndex], float4(input.Position, 1.0));
+    output.Position = (float3) mul(transforms[instances[InstanceIndex].transformIndex], float4(input.Position, 1.0));
     output.ClipPosition = mul(light.lightSpaceMatrix, float4(output.Position, 1.0));
     
     return output;
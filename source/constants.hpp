@@ -5,4 +5,28 @@
 namespace constants {
 	constexpr glm::f32vec3 UP = glm::f32vec3{ 0.0f, 1.0f, 0.0f };
 	constexpr wgpu::TextureFormat DEPTH_FORMAT = wgpu::TextureFormat::Depth32Float;
+
+	//Must match the consts in lightCulling_c.wgsl and lighting_c.wgsl
+	constexpr uint32_t LIGHT_TILE_SIZE = 16;
+	constexpr uint32_t MAX_LIGHTS_PER_TILE = 255;
+
+	//Scene draws are split into a Uint16 and a Uint32 run, see HostSceneResources::uint16DrawCount. Must match culling_c.wgsl
+	constexpr uint32_t INDEX_FORMAT_COUNT = 2;
+
+	//Every shadow map is a square of the one atlas, see render::shadowAtlas. Powers of two, so squares pack without gaps
+	constexpr uint32_t SHADOW_ATLAS_SIZE = 4096;
+	constexpr uint32_t MIN_SHADOW_MAP_SIZE = 128;
+	constexpr uint32_t MAX_SHADOW_MAP_SIZE = 2048;
+	//structs::Light::shadowViewIndex of a light without a shadow map. Must match lighting_c.wgsl
+	constexpr uint32_t NO_SHADOW_VIEW = UINT32_MAX;
+
+	//Initial packs a sampler texture pair id per accumulator into one texel, base color in the low bits and normal above.
+	//The all ones id is no texture. Must match initialRender_f.wgsl
+	constexpr uint32_t TEXTURE_ID_BITS = 16;
+	constexpr uint32_t NO_TEXTURE_ID = (1u << TEXTURE_ID_BITS) - 1;
+	constexpr uint32_t BASE_COLOR_TEXTURE_ID_SHIFT = 0;
+	constexpr uint32_t NORMAL_TEXTURE_ID_SHIFT = TEXTURE_ID_BITS;
+
+	//Scene images are grouped into a texture array per size, the accumulators bind this many. Must match _textureArrays.wgsl
+	constexpr uint32_t MAX_TEXTURE_ARRAYS = 8;
 }
\ No newline at end of file
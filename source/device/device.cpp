@@ -1,6 +1,11 @@
 #pragma once
 #include <iostream>
+#include <filesystem>
+#include <set>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <fstream>
 #include <absl/log/log.h>
 #include "device.hpp"
@@ -39,6 +44,27 @@ namespace {
 			return string;
 		}
 
+	std::string readWGSLWithIncludes(const std::filesystem::path& path, std::set<std::filesystem::path>& includedPaths) {
+		constexpr std::string_view INCLUDE_DIRECTIVE = "#include \"";
+		std::istringstream lines(readShaderToString(path.generic_string()));
+		std::string code;
+		std::string line;
+		while (std::getline(lines, line)) {
+			if (!line.starts_with(INCLUDE_DIRECTIVE)) {
+				code += line + "\n";
+				continue;
+			}
+			const size_t end = line.find('"', INCLUDE_DIRECTIVE.size());
+			if (end == std::string::npos) {
+				throw std::runtime_error("unterminated #include in " + path.generic_string());
+			}
+			const std::filesystem::path includePath = (path.parent_path() / line.substr(INCLUDE_DIRECTIVE.size(), end - INCLUDE_DIRECTIVE.size())).lexically_normal();
+			if (includedPaths.insert(includePath).second) {
+				code += readWGSLWithIncludes(includePath, includedPaths);
+			}
+		}
+		return code;
+	}
 }
 
 namespace device {
@@ -57,7 +83,8 @@ namespace device {
 
 	wgpu::ShaderModule createWGSLShaderModule(const wgpu::Device& device, const wgpu::StringView& label, const std::string& filename)
 		{
-			const std::string shaderCode = readShaderToString(std::string(filename));
+			std::set<std::filesystem::path> includedPaths;
+			const std::string shaderCode = readWGSLWithIncludes(std::filesystem::path(filename).lexically_normal(), includedPaths);
 			wgpu::ShaderSourceWGSL shaderSource = wgpu::ShaderSourceWGSL();
 			shaderSource.code = wgpu::StringView(shaderCode);
 			const wgpu::ShaderModuleDescriptor shaderModuleDescriptor = {
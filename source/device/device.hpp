@@ -3,6 +3,8 @@
 #include <string>
 #include <vector>
 #include "../wgpuContext/wgpuContext.hpp"
+#include "../enums.hpp"
+#include "stagingBelt.hpp"
 
 namespace device {
 	wgpu::ShaderModule createShaderModule(
@@ -11,6 +13,8 @@ namespace device {
 		const std::string& filename
 	);
 
+	//WGSL has no includes, a line #include "file.wgsl" is replaced by that file, which is looked up next to the
+	//including file. Each file is included once, so shared files can include each other
 	wgpu::ShaderModule createWGSLShaderModule(
 		const wgpu::Device& device,
 		const wgpu::StringView& label,
@@ -20,9 +24,10 @@ namespace device {
 	template <typename T>
 	wgpu::Buffer createBuffer(
 		WGPUContext& wgpuContext,
-		const std::vector<T> vector,
+		const std::vector<T>& vector,
 		const std::string& label,
-		const wgpu::BufferUsage bufferUsage
+		const wgpu::BufferUsage bufferUsage,
+		const enums::MemoryCategory memoryCategory = enums::MemoryCategory::OTHER
 	) {
 		const wgpu::BufferDescriptor bufferDescriptor = {
 			.label = wgpu::StringView(label + " buffer"),
@@ -30,16 +35,39 @@ namespace device {
 			.size = sizeof(T) * vector.size(),
 		};
 		wgpu::Buffer buffer = wgpuContext.device.CreateBuffer(&bufferDescriptor);
+		wgpuContext.getMemoryRegistry().track(buffer, label, memoryCategory);
 		wgpuContext.queue.WriteBuffer(buffer, 0, vector.data(), bufferDescriptor.size);
 		return buffer;
 	}
 
+	//The contents arrive once stagingBelt is submitted, the size must be a multiple of 4
+	template <typename T>
+	wgpu::Buffer createBuffer(
+		WGPUContext& wgpuContext,
+		StagingBelt& stagingBelt,
+		const std::vector<T>& vector,
+		const std::string& label,
+		const wgpu::BufferUsage bufferUsage,
+		const enums::MemoryCategory memoryCategory = enums::MemoryCategory::OTHER
+	) {
+		const wgpu::BufferDescriptor bufferDescriptor = {
+			.label = wgpu::StringView(label + " buffer"),
+			.usage = wgpu::BufferUsage::CopyDst | bufferUsage,
+			.size = sizeof(T) * vector.size(),
+		};
+		wgpu::Buffer buffer = wgpuContext.device.CreateBuffer(&bufferDescriptor);
+		wgpuContext.getMemoryRegistry().track(buffer, label, memoryCategory);
+		stagingBelt.writeBuffer(buffer, 0, vector.data(), bufferDescriptor.size);
+		return buffer;
+	}
+
 	template <typename T>
 	wgpu::Buffer createBuffer(
 		WGPUContext& wgpuContext,
 		const T& structure,
 		const std::string& label,
-		const wgpu::BufferUsage bufferUsage
+		const wgpu::BufferUsage bufferUsage,
+		const enums::MemoryCategory memoryCategory = enums::MemoryCategory::OTHER
 	) {
 		const wgpu::BufferDescriptor bufferDescriptor = {
 			.label = wgpu::StringView(label + " buffer"),
@@ -47,6 +75,7 @@ namespace device {
 			.size = sizeof(T)
 		};
 		wgpu::Buffer buffer = wgpuContext.device.CreateBuffer(&bufferDescriptor);
+		wgpuContext.getMemoryRegistry().track(buffer, label, memoryCategory);
 		wgpuContext.queue.WriteBuffer(buffer, 0, &structure, bufferDescriptor.size);
 		return buffer;
 	}
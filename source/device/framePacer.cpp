@@ -0,0 +1,50 @@
+#pragma once
+#include "framePacer.hpp"
+#include <stdexcept>
+#include "absl/log/log.h"
+
+FramePacer::FramePacer(WGPUContext* wgpuContext, const uint32_t framesInFlight)
+	: _wgpuContext(wgpuContext), _framesInFlight(framesInFlight) {
+	if (_framesInFlight == 0) {
+		throw std::invalid_argument("at least one frame must be in flight");
+	}
+	_fences.resize(_framesInFlight);
+	LOG(INFO) << "Frames in flight: " << _framesInFlight;
+}
+
+uint32_t FramePacer::getFramesInFlight() const {
+	return _framesInFlight;
+}
+
+uint32_t FramePacer::beginFrame() {
+	_slot = static_cast<uint32_t>(_frame % _framesInFlight);
+	wait(_fences[_slot]);
+	return _slot;
+}
+
+void FramePacer::endFrame() {
+	_fences[_slot].future = _wgpuContext->queue.OnSubmittedWorkDone(
+		wgpu::CallbackMode::WaitAnyOnly,
+		[](wgpu::QueueWorkDoneStatus status) {
+			if (status != wgpu::QueueWorkDoneStatus::Success) {
+				LOG(ERROR) << "frame did not complete: " << static_cast<uint32_t>(status);
+			}
+		}
+	);
+	_fences[_slot].pending = true;
+	++_frame;
+}
+
+void FramePacer::waitForAll() {
+	for (Fence& fence : _fences) {
+		wait(fence);
+	}
+}
+
+void FramePacer::wait(Fence& fence) {
+	if (!fence.pending) {
+		return;
+	}
+	_wgpuContext->instance.WaitAny(fence.future, UINT64_MAX);
+	fence.pending = false;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <dawn/webgpu_cpp.h>
+#include "../wgpuContext/wgpuContext.hpp"
+
+//Bounds how many frames the CPU can encode ahead of the GPU. Each frame in flight owns a slot and beginFrame waits
+//until the frame that last used its slot has completed, so anything owned by a slot can be reused without stalling
+//the queue. One frame in flight gives the lowest latency, more frames let encoding overlap the GPU for throughput
+class FramePacer {
+public:
+	FramePacer(WGPUContext* wgpuContext, const uint32_t framesInFlight);
+
+	uint32_t getFramesInFlight() const;
+	//Blocks until the slot is free and returns it
+	uint32_t beginFrame();
+	//Must be called right after the frame's submit
+	void endFrame();
+	//Blocks until every submitted frame has completed
+	void waitForAll();
+
+private:
+	WGPUContext* _wgpuContext;
+	uint32_t _framesInFlight;
+	uint64_t _frame = 0;
+	uint32_t _slot = 0;
+
+	struct Fence {
+		wgpu::Future future;
+		bool pending = false;
+	};
+	std::vector<Fence> _fences;
+
+	void wait(Fence& fence);
+};
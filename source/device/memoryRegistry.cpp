@@ -0,0 +1,212 @@
+#pragma once
+#include "memoryRegistry.hpp"
+#include <algorithm>
+#include <format>
+#include <webgpu/webgpu_cpp_print.h>
+#include "absl/log/log.h"
+
+namespace {
+	//Ordered by enums::MemoryCategory
+	const std::array<std::string_view, enums::MemoryCategory::MEMORY_CATEGORY_COUNT> memoryCategoryNames = {
+		"G-buffer",
+		"Shadow",
+		"Scene",
+		"Staging",
+		"Other",
+	};
+
+	std::string formatBytes(const uint64_t bytes) {
+		return std::format("{:.2f} MiB", static_cast<double>(bytes) / (1024.0 * 1024.0));
+	}
+
+	struct BlockInfo {
+		uint32_t blockSize; //texels along each edge of a block
+		uint32_t bytesPerBlock;
+	};
+
+	//The formats the engine creates and the KTX2 transcode targets, anything else is counted as 4 bytes per texel
+	BlockInfo getBlockInfo(const wgpu::TextureFormat format) {
+		switch (format) {
+		case wgpu::TextureFormat::R8Unorm:
+			return { 1, 1 };
+		case wgpu::TextureFormat::R16Float:
+		case wgpu::TextureFormat::Depth16Unorm:
+			return { 1, 2 };
+		case wgpu::TextureFormat::RGBA8Unorm:
+		case wgpu::TextureFormat::RGBA8UnormSrgb:
+		case wgpu::TextureFormat::BGRA8Unorm:
+		case wgpu::TextureFormat::BGRA8UnormSrgb:
+		case wgpu::TextureFormat::R32Uint:
+		case wgpu::TextureFormat::R32Sint:
+		case wgpu::TextureFormat::R32Float:
+		case wgpu::TextureFormat::Depth24Plus:
+		case wgpu::TextureFormat::Depth24PlusStencil8:
+		case wgpu::TextureFormat::Depth32Float:
+			return { 1, 4 };
+		case wgpu::TextureFormat::RGBA16Float:
+		case wgpu::TextureFormat::RG32Float:
+		case wgpu::TextureFormat::Depth32FloatStencil8:
+			return { 1, 8 };
+		case wgpu::TextureFormat::RGBA32Float:
+			return { 1, 16 };
+		case wgpu::TextureFormat::BC1RGBAUnorm:
+		case wgpu::TextureFormat::BC1RGBAUnormSrgb:
+		case wgpu::TextureFormat::ETC2RGB8Unorm:
+		case wgpu::TextureFormat::ETC2RGB8UnormSrgb:
+			return { 4, 8 };
+		case wgpu::TextureFormat::BC3RGBAUnorm:
+		case wgpu::TextureFormat::BC3RGBAUnormSrgb:
+		case wgpu::TextureFormat::BC7RGBAUnorm:
+		case wgpu::TextureFormat::BC7RGBAUnormSrgb:
+		case wgpu::TextureFormat::ASTC4x4Unorm:
+		case wgpu::TextureFormat::ASTC4x4UnormSrgb:
+		case wgpu::TextureFormat::ETC2RGBA8Unorm:
+		case wgpu::TextureFormat::ETC2RGBA8UnormSrgb:
+			return { 4, 16 };
+		default:
+			return { 1, 4 };
+		}
+	}
+}
+
+MemoryRegistry::MemoryRegistry(const uint64_t budget) : _budget(budget) {
+}
+
+MemoryRegistry::~MemoryRegistry() {
+	if (!_entries.empty()) {
+		LOG(WARNING) << _entries.size() << " GPU allocations were not untracked by their owners";
+		logReport("not released");
+	}
+}
+
+void MemoryRegistry::track(const wgpu::Buffer& buffer, const std::string& label, const enums::MemoryCategory category) {
+	if (buffer == nullptr) {
+		return;
+	}
+	insert(buffer.Get(), Entry{
+		.buffer = buffer,
+		.allocation = {
+			.label = label,
+			.category = category,
+			.size = buffer.GetSize(),
+		},
+	});
+}
+
+void MemoryRegistry::track(const wgpu::Texture& texture, const std::string& label, const enums::MemoryCategory category) {
+	if (texture == nullptr) {
+		return;
+	}
+	insert(texture.Get(), Entry{
+		.texture = texture,
+		.allocation = {
+			.label = label,
+			.category = category,
+			.format = texture.GetFormat(),
+			.size = getTextureSize(texture),
+		},
+	});
+}
+
+void MemoryRegistry::untrack(const wgpu::Buffer& buffer) {
+	erase(buffer.Get());
+}
+
+void MemoryRegistry::untrack(const wgpu::Texture& texture) {
+	erase(texture.Get());
+}
+
+uint64_t MemoryRegistry::getTotal() const {
+	const std::lock_guard<std::mutex> lock(_mutex);
+	return _total;
+}
+
+uint64_t MemoryRegistry::getTotal(const enums::MemoryCategory category) const {
+	const std::lock_guard<std::mutex> lock(_mutex);
+	return _categoryTotals[category];
+}
+
+uint64_t MemoryRegistry::getPeak() const {
+	const std::lock_guard<std::mutex> lock(_mutex);
+	return _peak;
+}
+
+uint64_t MemoryRegistry::getBudget() const {
+	return _budget;
+}
+
+std::vector<MemoryRegistry::Allocation> MemoryRegistry::getAllocations() const {
+	std::vector<Allocation> allocations;
+	{
+		const std::lock_guard<std::mutex> lock(_mutex);
+		allocations.reserve(_entries.size());
+		for (const auto& [handle, entry] : _entries) {
+			allocations.push_back(entry.allocation);
+		}
+	}
+	std::sort(allocations.begin(), allocations.end(), [](const Allocation& lhs, const Allocation& rhs) {
+		return lhs.size != rhs.size ? lhs.size > rhs.size : lhs.label < rhs.label;
+	});
+	return allocations;
+}
+
+void MemoryRegistry::logReport(const std::string_view title) const {
+	const std::vector<Allocation> allocations = getAllocations();
+	const uint64_t total = getTotal();
+	LOG(INFO) << "GPU memory (" << title << "): " << formatBytes(total) << " in " << allocations.size() << " allocations, peak " << formatBytes(getPeak())
+		<< (_budget > 0 ? std::format(", budget {}", formatBytes(_budget)) : "");
+	for (uint32_t category = 0; category < enums::MemoryCategory::MEMORY_CATEGORY_COUNT; ++category) {
+		LOG(INFO) << "  " << memoryCategoryNames[category] << ": " << formatBytes(getTotal(static_cast<enums::MemoryCategory>(category)));
+	}
+	for (const Allocation& allocation : allocations) {
+		if (allocation.format == wgpu::TextureFormat::Undefined) {
+			LOG(INFO) << "    " << formatBytes(allocation.size) << " " << memoryCategoryNames[allocation.category] << " " << allocation.label;
+		}
+		else {
+			LOG(INFO) << "    " << formatBytes(allocation.size) << " " << memoryCategoryNames[allocation.category] << " " << allocation.label << " " << allocation.format;
+		}
+	}
+}
+
+uint64_t MemoryRegistry::getTextureSize(const wgpu::Texture& texture) {
+	const BlockInfo blockInfo = getBlockInfo(texture.GetFormat());
+	const bool is3D = texture.GetDimension() == wgpu::TextureDimension::e3D;
+	uint64_t size = 0;
+	for (uint32_t level = 0; level < texture.GetMipLevelCount(); ++level) {
+		const uint64_t blocksWide = (std::max(texture.GetWidth() >> level, 1u) + blockInfo.blockSize - 1) / blockInfo.blockSize;
+		const uint64_t blocksHigh = (std::max(texture.GetHeight() >> level, 1u) + blockInfo.blockSize - 1) / blockInfo.blockSize;
+		const uint64_t depth = is3D ? std::max(texture.GetDepthOrArrayLayers() >> level, 1u) : texture.GetDepthOrArrayLayers();
+		size += blocksWide * blocksHigh * depth * blockInfo.bytesPerBlock;
+	}
+	return size * texture.GetSampleCount();
+}
+
+void MemoryRegistry::insert(const void* handle, Entry entry) {
+	const std::lock_guard<std::mutex> lock(_mutex);
+	const auto previous = _entries.find(handle);
+	if (previous != _entries.end()) {
+		_categoryTotals[previous->second.allocation.category] -= previous->second.allocation.size;
+		_total -= previous->second.allocation.size;
+	}
+	const Allocation& allocation = entry.allocation;
+	const uint64_t totalBefore = _total;
+	_categoryTotals[allocation.category] += allocation.size;
+	_total += allocation.size;
+	_peak = std::max(_peak, _total);
+	//Warns once each time the total crosses the budget rather than for every allocation over it
+	if (_budget > 0 && totalBefore <= _budget && _total > _budget) {
+		LOG(WARNING) << "GPU memory budget of " << formatBytes(_budget) << " exceeded by " << allocation.label << ", " << formatBytes(_total) << " allocated";
+	}
+	_entries[handle] = std::move(entry);
+}
+
+void MemoryRegistry::erase(const void* handle) {
+	const std::lock_guard<std::mutex> lock(_mutex);
+	const auto entry = _entries.find(handle);
+	if (entry == _entries.end()) {
+		return;
+	}
+	_categoryTotals[entry->second.allocation.category] -= entry->second.allocation.size;
+	_total -= entry->second.allocation.size;
+	_entries.erase(entry);
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <dawn/webgpu_cpp.h>
+#include "../enums.hpp"
+
+//Bookkeeping of the buffers and textures the engine creates, so that the memory a scene needs at a resolution can be
+//read without an external tool. Sizes are computed from the descriptors, drivers add alignment and padding on top.
+//The registry keeps a reference to every object it tracks, so a tracked handle is never freed and reused by another object.
+//Owners untrack what they release, whatever is still tracked when the registry is destroyed is logged as not released
+class MemoryRegistry {
+public:
+	struct Allocation {
+		std::string label;
+		enums::MemoryCategory category;
+		wgpu::TextureFormat format = wgpu::TextureFormat::Undefined; //Undefined for buffers
+		uint64_t size = 0; //bytes
+	};
+
+	//budget is in bytes, 0 never warns
+	MemoryRegistry(const uint64_t budget = 0);
+	~MemoryRegistry();
+	MemoryRegistry(const MemoryRegistry&) = delete;
+	MemoryRegistry& operator=(const MemoryRegistry&) = delete;
+
+	//Null handles are ignored, tracking an object again replaces its entry
+	void track(const wgpu::Buffer& buffer, const std::string& label, const enums::MemoryCategory category);
+	void track(const wgpu::Texture& texture, const std::string& label, const enums::MemoryCategory category);
+	void untrack(const wgpu::Buffer& buffer);
+	void untrack(const wgpu::Texture& texture);
+
+	uint64_t getTotal() const;
+	uint64_t getTotal(const enums::MemoryCategory category) const;
+	uint64_t getPeak() const;
+	uint64_t getBudget() const;
+	//Largest first
+	std::vector<Allocation> getAllocations() const;
+	//Totals per category, then every allocation
+	void logReport(const std::string_view title) const;
+
+	//Every mip level, layer and sample of the texture
+	static uint64_t getTextureSize(const wgpu::Texture& texture);
+
+private:
+	//One of buffer and texture is set
+	struct Entry {
+		wgpu::Buffer buffer;
+		wgpu::Texture texture;
+		Allocation allocation;
+	};
+
+	mutable std::mutex _mutex;
+	uint64_t _budget;
+	std::unordered_map<const void*, Entry> _entries; //keyed by the handle of the entry's object
+	std::array<uint64_t, enums::MemoryCategory::MEMORY_CATEGORY_COUNT> _categoryTotals = {};
+	uint64_t _total = 0;
+	uint64_t _peak = 0;
+
+	void insert(const void* handle, Entry entry);
+	void erase(const void* handle);
+};
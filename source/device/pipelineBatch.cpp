@@ -0,0 +1,86 @@
+#pragma once
+#include "pipelineBatch.hpp"
+#include <chrono>
+#include <format>
+#include <stdexcept>
+#include <string_view>
+#include "absl/log/log.h"
+
+PipelineBatch::PipelineBatch(WGPUContext* wgpuContext) : _wgpuContext(wgpuContext) {}
+
+PipelineBatch::~PipelineBatch() {
+	if (_pending.empty()) {
+		return;
+	}
+	const wgpu::WaitStatus status = waitForPending();
+	if (status != wgpu::WaitStatus::Success) {
+		LOG(ERROR) << std::format("waiting for pipelines on destruction failed with status {}", static_cast<uint32_t>(status));
+	}
+}
+
+//WaitAnyOnly callbacks run inside waitForAll on this thread, so _errors needs no lock
+void PipelineBatch::createRenderPipeline(const wgpu::RenderPipelineDescriptor& descriptor, wgpu::RenderPipeline& outPipeline) {
+	const std::string label = std::string(std::string_view(descriptor.label));
+	_pending.push_back(wgpu::FutureWaitInfo{
+		.future = _wgpuContext->device.CreateRenderPipelineAsync(
+			&descriptor,
+			wgpu::CallbackMode::WaitAnyOnly,
+			[this, label, &outPipeline](wgpu::CreatePipelineAsyncStatus status, wgpu::RenderPipeline pipeline, wgpu::StringView message) {
+				if (status != wgpu::CreatePipelineAsyncStatus::Success) {
+					_errors.push_back(std::format("{}: {}", label, std::string_view(message)));
+					return;
+				}
+				outPipeline = std::move(pipeline);
+			}
+		),
+	});
+}
+
+void PipelineBatch::createComputePipeline(const wgpu::ComputePipelineDescriptor& descriptor, wgpu::ComputePipeline& outPipeline) {
+	const std::string label = std::string(std::string_view(descriptor.label));
+	_pending.push_back(wgpu::FutureWaitInfo{
+		.future = _wgpuContext->device.CreateComputePipelineAsync(
+			&descriptor,
+			wgpu::CallbackMode::WaitAnyOnly,
+			[this, label, &outPipeline](wgpu::CreatePipelineAsyncStatus status, wgpu::ComputePipeline pipeline, wgpu::StringView message) {
+				if (status != wgpu::CreatePipelineAsyncStatus::Success) {
+					_errors.push_back(std::format("{}: {}", label, std::string_view(message)));
+					return;
+				}
+				outPipeline = std::move(pipeline);
+			}
+		),
+	});
+}
+
+void PipelineBatch::waitForAll() {
+	const size_t pipelineCount = _pending.size();
+	const auto start = std::chrono::steady_clock::now();
+	const wgpu::WaitStatus status = waitForPending();
+	if (status != wgpu::WaitStatus::Success) {
+		throw std::runtime_error(std::format("waiting for pipelines failed with status {}", static_cast<uint32_t>(status)));
+	}
+	const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	LOG(INFO) << std::format("Waited {:.1f} ms for {} pipelines", milliseconds, pipelineCount);
+
+	if (!_errors.empty()) {
+		std::string errors = "failed to create pipelines:";
+		for (const std::string& error : _errors) {
+			errors += "\n" + error;
+		}
+		_errors.clear();
+		throw std::runtime_error(errors);
+	}
+}
+
+//WaitAny returns as soon as one future completes, so it is called again on whatever is still pending
+wgpu::WaitStatus PipelineBatch::waitForPending() {
+	while (!_pending.empty()) {
+		const wgpu::WaitStatus status = _wgpuContext->instance.WaitAny(_pending.size(), _pending.data(), UINT64_MAX);
+		if (status != wgpu::WaitStatus::Success) {
+			return status;
+		}
+		std::erase_if(_pending, [](const wgpu::FutureWaitInfo& waitInfo) { return waitInfo.completed; });
+	}
+	return wgpu::WaitStatus::Success;
+}
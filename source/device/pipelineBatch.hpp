@@ -0,0 +1,29 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <dawn/webgpu_cpp.h>
+#include "../wgpuContext/wgpuContext.hpp"
+
+//Issues pipeline creation with CreateRenderPipelineAsync/CreateComputePipelineAsync so dawn compiles them on its worker
+//threads while the caller moves on, e.g. to import the scene. The output pipelines are only valid after waitForAll
+class PipelineBatch {
+public:
+	PipelineBatch(WGPUContext* wgpuContext);
+	//Waits for the pipelines still compiling without throwing, their callbacks capture this and the output pipelines
+	~PipelineBatch();
+	PipelineBatch(const PipelineBatch&) = delete;
+	PipelineBatch& operator=(const PipelineBatch&) = delete;
+
+	//outPipeline must outlive waitForAll
+	void createRenderPipeline(const wgpu::RenderPipelineDescriptor& descriptor, wgpu::RenderPipeline& outPipeline);
+	void createComputePipeline(const wgpu::ComputePipelineDescriptor& descriptor, wgpu::ComputePipeline& outPipeline);
+	//Blocks until every pipeline of the batch is created, throws if any failed
+	void waitForAll();
+
+private:
+	WGPUContext* _wgpuContext;
+	std::vector<wgpu::FutureWaitInfo> _pending;
+	std::vector<std::string> _errors;
+
+	wgpu::WaitStatus waitForPending();
+};
@@ -0,0 +1,132 @@
+#pragma once
+#include "pipelineCache.hpp"
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <vector>
+#include "absl/log/log.h"
+
+namespace {
+	//FNV-1a, only names the entry file
+	uint64_t hashKey(const void* key, const size_t keySize) {
+		uint64_t hash = 0xcbf29ce484222325ull;
+		const unsigned char* bytes = static_cast<const unsigned char*>(key);
+		for (size_t i = 0; i < keySize; ++i) {
+			hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+		}
+		return hash;
+	}
+}
+
+PipelineCache::PipelineCache(const std::filesystem::path& directory) : _directory(directory) {
+	std::error_code error;
+	std::filesystem::create_directories(_directory, error);
+	if (error) {
+		LOG(WARNING) << "Pipeline cache directory " << _directory << " could not be created: " << error.message();
+	}
+}
+
+wgpu::DawnCacheDeviceDescriptor PipelineCache::getDeviceDescriptor(const std::string& isolationKey) {
+	wgpu::DawnCacheDeviceDescriptor cacheDeviceDescriptor = {};
+	cacheDeviceDescriptor.isolationKey = wgpu::StringView(isolationKey);
+	cacheDeviceDescriptor.loadDataFunction = loadCallback;
+	cacheDeviceDescriptor.storeDataFunction = storeCallback;
+	cacheDeviceDescriptor.functionUserdata = this;
+	return cacheDeviceDescriptor;
+}
+
+uint32_t PipelineCache::getHitCount() const {
+	return _hitCount;
+}
+
+uint32_t PipelineCache::getMissCount() const {
+	return _missCount;
+}
+
+uint32_t PipelineCache::getStoreCount() const {
+	return _storeCount;
+}
+
+std::filesystem::path PipelineCache::getEntryPath(const void* key, const size_t keySize) const {
+	return _directory / std::format("{:016x}.bin", hashKey(key, keySize));
+}
+
+//Entry file layout: uint64_t key size, key, value.
+//Dawn first calls with a null value to learn the size, then again with a buffer of exactly that size
+size_t PipelineCache::load(const void* key, const size_t keySize, void* value, const size_t valueSize) {
+	const std::lock_guard<std::mutex> lock(_mutex);
+	const bool sizeQuery = value == nullptr;
+	const auto miss = [&]() -> size_t {
+		if (sizeQuery) {
+			++_missCount;
+		}
+		return 0;
+	};
+
+	std::ifstream file(getEntryPath(key, keySize), std::ios::binary | std::ios::ate);
+	if (!file) {
+		return miss();
+	}
+	const size_t fileSize = static_cast<size_t>(file.tellg());
+	file.seekg(0);
+
+	uint64_t storedKeySize = 0;
+	file.read(reinterpret_cast<char*>(&storedKeySize), sizeof(storedKeySize));
+	if (!file || storedKeySize != keySize || fileSize < sizeof(storedKeySize) + keySize) {
+		return miss();
+	}
+	std::vector<char> storedKey(keySize);
+	file.read(storedKey.data(), static_cast<std::streamsize>(keySize));
+	if (!file || std::memcmp(storedKey.data(), key, keySize) != 0) {
+		return miss();
+	}
+
+	const size_t storedValueSize = fileSize - sizeof(storedKeySize) - keySize;
+	if (sizeQuery) {
+		++_hitCount;
+		return storedValueSize;
+	}
+	if (valueSize != storedValueSize) {
+		return storedValueSize;
+	}
+	file.read(static_cast<char*>(value), static_cast<std::streamsize>(valueSize));
+	return file ? storedValueSize : 0;
+}
+
+//Written to a temporary file first so a concurrent run never reads half an entry. The temporary name is random so two
+//runs storing the same entry at once never write into the same file
+void PipelineCache::store(const void* key, const size_t keySize, const void* value, const size_t valueSize) {
+	const std::lock_guard<std::mutex> lock(_mutex);
+	const std::filesystem::path entryPath = getEntryPath(key, keySize);
+	std::filesystem::path temporaryPath = entryPath;
+	temporaryPath += std::format(".{:016x}.tmp", _temporarySuffix());
+	std::error_code error;
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		const uint64_t storedKeySize = keySize;
+		file.write(reinterpret_cast<const char*>(&storedKeySize), sizeof(storedKeySize));
+		file.write(static_cast<const char*>(key), static_cast<std::streamsize>(keySize));
+		file.write(static_cast<const char*>(value), static_cast<std::streamsize>(valueSize));
+		if (!file) {
+			LOG(WARNING) << "Failed to write pipeline cache entry " << temporaryPath;
+			file.close();
+			std::filesystem::remove(temporaryPath, error);
+			return;
+		}
+	}
+	std::filesystem::rename(temporaryPath, entryPath, error);
+	if (error) {
+		LOG(WARNING) << "Failed to write pipeline cache entry " << entryPath << ": " << error.message();
+		std::filesystem::remove(temporaryPath, error);
+		return;
+	}
+	++_storeCount;
+}
+
+size_t PipelineCache::loadCallback(const void* key, size_t keySize, void* value, size_t valueSize, void* userdata) {
+	return static_cast<PipelineCache*>(userdata)->load(key, keySize, value, valueSize);
+}
+
+void PipelineCache::storeCallback(const void* key, size_t keySize, const void* value, size_t valueSize, void* userdata) {
+	static_cast<PipelineCache*>(userdata)->store(key, keySize, value, valueSize);
+}
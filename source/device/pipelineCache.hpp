@@ -0,0 +1,40 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <random>
+#include <string>
+#include <dawn/webgpu_cpp.h>
+
+//On disk store behind dawn's blob cache. Dawn derives the keys from the shader source, entry point, pipeline layout,
+//state and adapter, and hands back the compiled backend blobs, so a warm start skips WGSL/SPIR-V to backend compilation.
+//Each entry is one file named by the hash of its key, the key is stored in the file too so a hash collision reads as a miss
+class PipelineCache {
+public:
+	PipelineCache(const std::filesystem::path& directory);
+
+	//Chain the result into the wgpu::DeviceDescriptor. isolationKey separates adapters and driver versions sharing the directory,
+	//it must outlive the call to CreateDevice. The cache must outlive every pipeline and shader module creation on the device
+	wgpu::DawnCacheDeviceDescriptor getDeviceDescriptor(const std::string& isolationKey);
+
+	uint32_t getHitCount() const;
+	uint32_t getMissCount() const;
+	uint32_t getStoreCount() const;
+
+private:
+	std::filesystem::path _directory;
+	//dawn may compile pipelines on its own threads
+	std::mutex _mutex;
+	std::mt19937_64 _temporarySuffix{ std::random_device{}() }; //under _mutex
+	std::atomic<uint32_t> _hitCount = 0;
+	std::atomic<uint32_t> _missCount = 0;
+	std::atomic<uint32_t> _storeCount = 0;
+
+	std::filesystem::path getEntryPath(const void* key, const size_t keySize) const;
+	size_t load(const void* key, const size_t keySize, void* value, const size_t valueSize);
+	void store(const void* key, const size_t keySize, const void* value, const size_t valueSize);
+
+	static size_t loadCallback(const void* key, size_t keySize, void* value, size_t valueSize, void* userdata);
+	static void storeCallback(const void* key, size_t keySize, const void* value, size_t valueSize, void* userdata);
+};
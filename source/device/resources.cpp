@@ -2,158 +2,130 @@
 #include "../texture/texture.hpp"
 #include "device.hpp"
 #include "resources.hpp"
+#include "stagingBelt.hpp"
+#include "uniformSuballocator.hpp"
 #include <glm/ext/matrix_transform.hpp>
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <format>
 #include <string>
+#include <utility>
 #include <vector>
 #include <glm/fwd.hpp>
 #include "../constants.hpp"
+#include "../enums.hpp"
 #include "../host/host.hpp"
 #include "../structs/structs.hpp"
 #include "../wgpuContext/wgpuContext.hpp"
+#include "../render/frameGraph.hpp"
+#include "../render/shadowAtlas.hpp"
 #include <dawn/webgpu_cpp.h>
 
-const std::string worldPositionLabel = "world position info";
 const std::string baseColorLabel = "base color";
 const std::string normalLabel = "normals";
 const std::string texCoordLabel = "texcoord";
 const std::string depthTextureLabel = "depth texture";
-const std::string baseColorIdLabel = "base color id";
-const std::string normalIdLabel = "normal id";
+const std::string textureIdsLabel = "texture ids";
 const std::string lightingLabel = "lighting";
-const std::string shadowMapLabel = "shadow map";
-const std::string shadowLabel = "shadow";
+const std::string shadowAtlasLabel = "shadow atlas";
 const std::string ultimateLabel = "ultimate";
 
-constexpr wgpu::TextureUsage worldPositionTextureUsage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::StorageBinding;
 constexpr wgpu::TextureUsage baseColorTextureUsage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::StorageBinding;
 constexpr wgpu::TextureUsage normalTextureUsage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::StorageBinding;
 constexpr wgpu::TextureUsage texCoordTextureUsage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::StorageBinding;
-constexpr wgpu::TextureUsage baseColorIdTextureUsage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::StorageBinding;
-constexpr wgpu::TextureUsage normalIdTextureUsage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::StorageBinding;
-constexpr wgpu::TextureUsage depthTextureUsage = wgpu::TextureUsage::RenderAttachment;
+constexpr wgpu::TextureUsage textureIdsTextureUsage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::StorageBinding;
+constexpr wgpu::TextureUsage depthTextureUsage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::TextureBinding;
 constexpr wgpu::TextureUsage lightingTextureUsage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::StorageBinding;
-constexpr wgpu::TextureUsage shadowMapTextureUsage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::TextureBinding;
-constexpr wgpu::TextureUsage shadowTextureUsage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::StorageBinding;
-constexpr wgpu::TextureUsage ultimateTextureUsage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::StorageBinding | wgpu::TextureUsage::TextureBinding;
-
-constexpr wgpu::Extent2D shadowDimensions = wgpu::Extent2D{ 2048, 2048 };
-constexpr uint32_t maxShadowMaps = 5;
-
-RenderResources::RenderResources(WGPUContext* wgpuContext) {
-	const texture::descriptor::CreateTextureView worldPositionTextureViewDescriptor = {
-		.label = worldPositionLabel,
-		.device = &wgpuContext->device,
-		.textureUsage = worldPositionTextureUsage,
-		.textureDimensions = wgpuContext->getScreenDimensions(),
-		.textureFormat = worldPositionTextureFormat,
-		.outputTextureView = worldPositionTextureView,
-	};
-	texture::createTextureView(&worldPositionTextureViewDescriptor);
+constexpr wgpu::TextureUsage shadowAtlasTextureUsage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::TextureBinding;
+constexpr wgpu::TextureUsage ultimateTextureUsage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::StorageBinding | wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopySrc;
 
-	const texture::descriptor::CreateTextureView baseColorTextureViewDescriptor = {
-		.label = baseColorLabel,
-		.device = &wgpuContext->device,
-		.textureUsage = baseColorTextureUsage,
-		.textureDimensions = wgpuContext->getScreenDimensions(),
-		.textureFormat = baseColorTextureFormat,
-		.outputTextureView = baseColorTextureView,
-	};
-	texture::createTextureView(&baseColorTextureViewDescriptor);
 
-	const texture::descriptor::CreateTextureView normalTextureViewDescriptor = {
+RenderResources::RenderResources(WGPUContext* wgpuContext, render::FrameGraph& frameGraph) : _wgpuContext(wgpuContext) {
+	const wgpu::Extent2D screenDimensions = wgpuContext->getScreenDimensions();
+	frameGraph.addTexture(enums::FrameResource::BASE_COLOR, {
+		.label = baseColorLabel,
+		.format = baseColorTextureFormat,
+		.usage = baseColorTextureUsage,
+		.size = screenDimensions,
+	});
+	frameGraph.addTexture(enums::FrameResource::NORMAL, {
 		.label = normalLabel,
-		.device = &wgpuContext->device,
-		.textureUsage = normalTextureUsage,
-		.textureDimensions = wgpuContext->getScreenDimensions(),
-		.textureFormat = normalTextureFormat,
-		.outputTextureView = normalTextureView,
-	};
-	texture::createTextureView(&normalTextureViewDescriptor);
-
-	const texture::descriptor::CreateTextureView texCoordTextureViewDescriptor = {
+		.format = normalTextureFormat,
+		.usage = normalTextureUsage,
+		.size = screenDimensions,
+	});
+	frameGraph.addTexture(enums::FrameResource::TEX_COORD, {
 		.label = texCoordLabel,
-		.device = &wgpuContext->device,
-		.textureUsage = texCoordTextureUsage,
-		.textureDimensions = wgpuContext->getScreenDimensions(),
-		.textureFormat = texCoordTextureFormat,
-		.outputTextureView = texCoordTextureView,
-	};
-	texture::createTextureView(&texCoordTextureViewDescriptor);
-
-	const texture::descriptor::CreateTextureView baseColorIdTextureViewDescriptor = {
-		.label = baseColorIdLabel,
-		.device = &wgpuContext->device,
-		.textureUsage = baseColorIdTextureUsage,
-		.textureDimensions = wgpuContext->getScreenDimensions(),
-		.textureFormat = baseColorIdTextureFormat,
-		.outputTextureView = baseColorIdTextureView,
-	};
-	texture::createTextureView(&baseColorIdTextureViewDescriptor);
-
-	const texture::descriptor::CreateTextureView normalIdTextureViewDescriptor = {
-		.label = normalIdLabel,
-		.device = &wgpuContext->device,
-		.textureUsage = normalIdTextureUsage,
-		.textureDimensions = wgpuContext->getScreenDimensions(),
-		.textureFormat = normalIdTextureFormat,
-		.outputTextureView = normalIdTextureView,
-	};
-	texture::createTextureView(&normalIdTextureViewDescriptor);
-
-	const texture::descriptor::CreateTextureView depthTextureViewDescriptor = {
+		.format = texCoordTextureFormat,
+		.usage = texCoordTextureUsage,
+		.size = screenDimensions,
+	});
+	frameGraph.addTexture(enums::FrameResource::TEXTURE_IDS, {
+		.label = textureIdsLabel,
+		.format = textureIdsTextureFormat,
+		.usage = textureIdsTextureUsage,
+		.size = screenDimensions,
+	});
+	frameGraph.addTexture(enums::FrameResource::DEPTH, {
 		.label = depthTextureLabel,
-		.device = &wgpuContext->device,
-		.textureUsage = depthTextureUsage,
-		.textureDimensions = wgpuContext->getScreenDimensions(),
-		.textureFormat = depthTextureFormat,
-		.outputTextureView = depthTextureView,
-	};
-	texture::createTextureView(&depthTextureViewDescriptor);
-
-	const texture::descriptor::CreateTextureView lightingTextureViewDescriptor = {
+		.format = depthTextureFormat,
+		.usage = depthTextureUsage,
+		.size = screenDimensions,
+	});
+	frameGraph.addTexture(enums::FrameResource::LIGHTING, {
 		.label = lightingLabel,
-		.device = &wgpuContext->device,
-		.textureUsage = lightingTextureUsage,
-		.textureDimensions = wgpuContext->getScreenDimensions(),
-		.textureFormat = lightingTextureFormat,
-		.outputTextureView = lightingTextureView,
-	};
-	texture::createTextureView(&lightingTextureViewDescriptor);
-
-	shadowMapTextureViews.resize(maxShadowMaps);
-	for (uint32_t i = 0; i < maxShadowMaps; i++) {
-		const texture::descriptor::CreateTextureView shadowMapTextureViewDescriptor = {
-			.label = shadowMapLabel,
-			.device = &wgpuContext->device,
-			.textureUsage = shadowMapTextureUsage,
-			.textureDimensions = shadowDimensions,
-			.textureFormat = constants::DEPTH_FORMAT,
-			.outputTextureView = shadowMapTextureViews[i],
-		};
-		texture::createTextureView(&shadowMapTextureViewDescriptor);
-	}
+		.format = lightingTextureFormat,
+		.usage = lightingTextureUsage,
+		.size = screenDimensions,
+	});
+	//Shadow maps that nothing changed for are kept from earlier frames, see render::ShadowMap
+	frameGraph.addTexture(enums::FrameResource::SHADOW_ATLAS, {
+		.label = shadowAtlasLabel,
+		.format = shadowAtlasTextureFormat,
+		.usage = shadowAtlasTextureUsage,
+		.size = { constants::SHADOW_ATLAS_SIZE, constants::SHADOW_ATLAS_SIZE },
+		.persistent = true,
+		.memoryCategory = enums::MemoryCategory::SHADOW,
+	});
+	//Read back after the frame
+	frameGraph.addTexture(enums::FrameResource::ULTIMATE, {
+		.label = ultimateLabel,
+		.format = ultimateTextureFormat,
+		.usage = ultimateTextureUsage,
+		.size = screenDimensions,
+		.persistent = true,
+	});
+	frameGraph.compile();
 
-	const texture::descriptor::CreateTextureView shadowTextureViewDescriptor = {
-		.label = shadowLabel,
-		.device = &wgpuContext->device,
-		.textureUsage = shadowTextureUsage,
-		.textureDimensions = wgpuContext->getScreenDimensions(),
-		.textureFormat = shadowTextureFormat,
-		.outputTextureView = shadowTextureView,
-	};
-	texture::createTextureView(&shadowTextureViewDescriptor);
+	this->baseColorTextureView = frameGraph.getTextureViews(enums::FrameResource::BASE_COLOR).front();
+	this->normalTextureView = frameGraph.getTextureViews(enums::FrameResource::NORMAL).front();
+	this->texCoordTextureView = frameGraph.getTextureViews(enums::FrameResource::TEX_COORD).front();
+	this->textureIdsTextureView = frameGraph.getTextureViews(enums::FrameResource::TEXTURE_IDS).front();
+	this->depthTextureView = frameGraph.getTextureViews(enums::FrameResource::DEPTH).front();
+	this->lightingTextureView = frameGraph.getTextureViews(enums::FrameResource::LIGHTING).front();
+	this->shadowAtlasTextureView = frameGraph.getTextureViews(enums::FrameResource::SHADOW_ATLAS).front();
+	this->ultimateTextureView = frameGraph.getTextureViews(enums::FrameResource::ULTIMATE).front();
+	this->ultimateTexture = frameGraph.getTextures(enums::FrameResource::ULTIMATE).front();
 
-	const texture::descriptor::CreateTextureView ultimateTextureViewDescriptor = {
-		.label = ultimateLabel,
-		.device = &wgpuContext->device,
-		.textureUsage = ultimateTextureUsage,
-		.textureDimensions = wgpuContext->getScreenDimensions(),
-		.textureFormat = ultimateTextureFormat,
-		.outputTextureView = ultimateTextureView,
+	this->lightTileCount = {
+		.width = (screenDimensions.width + constants::LIGHT_TILE_SIZE - 1) / constants::LIGHT_TILE_SIZE,
+		.height = (screenDimensions.height + constants::LIGHT_TILE_SIZE - 1) / constants::LIGHT_TILE_SIZE,
+	};
+	const wgpu::BufferDescriptor tileLightsBufferDescriptor = {
+		.label = "tile lights buffer",
+		.usage = wgpu::BufferUsage::Storage,
+		.size = sizeof(structs::TileLights) * lightTileCount.width * lightTileCount.height,
 	};
-	texture::createTextureView(&ultimateTextureViewDescriptor);
+	this->tileLights = wgpuContext->device.CreateBuffer(&tileLightsBufferDescriptor);
+	wgpuContext->getMemoryRegistry().track(this->tileLights, "tile lights", enums::MemoryCategory::GBUFFER);
+	const wgpu::BufferDescriptor tileLightOverflowBufferDescriptor = {
+		.label = "tile light overflow buffer",
+		.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::CopySrc,
+		.size = sizeof(structs::TileLightOverflow),
+	};
+	this->tileLightOverflow = wgpuContext->device.CreateBuffer(&tileLightOverflowBufferDescriptor);
+	wgpuContext->getMemoryRegistry().track(this->tileLightOverflow, "tile light overflow", enums::MemoryCategory::OTHER);
 
 	const wgpu::SamplerDescriptor defaultSamplerDescriptor = {
 		.label = "shadow map sampler",
@@ -167,87 +139,290 @@ RenderResources::RenderResources(WGPUContext* wgpuContext) {
 	this->shadowMapSampler = wgpuContext->device.CreateSampler(&defaultSamplerDescriptor);
 }
 
-SceneResources::SceneResources(WGPUContext* wgpuContext, HostSceneResources& host) {
-	this->vbo = device::createBuffer<structs::VBO>(
+//The render targets belong to the frame graph
+RenderResources::~RenderResources() {
+	_wgpuContext->getMemoryRegistry().untrack(this->tileLights);
+	_wgpuContext->getMemoryRegistry().untrack(this->tileLightOverflow);
+}
+
+SceneResources::SceneResources(WGPUContext* wgpuContext, StagingBelt& stagingBelt, const HostSceneResources& host, ThreadPool& threadPool) : _wgpuContext(wgpuContext) {
+	if (host.quantizedVbo.empty()) {
+		this->vbo = device::createBuffer<structs::VBO>(
+			*wgpuContext,
+			stagingBelt,
+			host.vbo,
+			"vbo",
+			wgpu::BufferUsage::Vertex,
+			enums::MemoryCategory::SCENE
+		);
+	}
+	else {
+		this->vbo = device::createBuffer<structs::QuantizedVBO>(
+			*wgpuContext,
+			stagingBelt,
+			host.quantizedVbo,
+			"quantized vbo",
+			wgpu::BufferUsage::Vertex,
+			enums::MemoryCategory::SCENE
+		);
+		this->vertexQuantizations = device::createBuffer<structs::VertexQuantization>(
+			*wgpuContext,
+			stagingBelt,
+			host.vertexQuantizations,
+			"vertex quantizations",
+			wgpu::BufferUsage::Storage,
+			enums::MemoryCategory::SCENE
+		);
+		this->vertexQuantizationIndices = device::createBuffer<uint32_t>(
+			*wgpuContext,
+			stagingBelt,
+			host.vertexQuantizationIndices,
+			"vertex quantization indices",
+			wgpu::BufferUsage::Storage,
+			enums::MemoryCategory::SCENE
+		);
+	}
+	this->indices16 = device::createBuffer<uint16_t>(
 		*wgpuContext,
-		host.vbo,
-		"vbo",
-		wgpu::BufferUsage::Vertex
+		stagingBelt,
+		host.indices16,
+		"16 bit indices",
+		wgpu::BufferUsage::Index,
+		enums::MemoryCategory::SCENE
 	);
-	this->indices = device::createBuffer<uint16_t>(
+	this->indices32 = device::createBuffer<uint32_t>(
 		*wgpuContext,
-		host.indices,
-		"indices",
-		wgpu::BufferUsage::Index
+		stagingBelt,
+		host.indices32,
+		"32 bit indices",
+		wgpu::BufferUsage::Index,
+		enums::MemoryCategory::SCENE
 	);
+	this->uint16DrawCount = host.uint16DrawCount;
 	this->transforms = device::createBuffer<glm::f32mat4x4>(
 		*wgpuContext,
+		stagingBelt,
 		host.transforms,
 		"transforms",
-		wgpu::BufferUsage::Storage
+		wgpu::BufferUsage::Storage,
+		enums::MemoryCategory::SCENE
 	);
-	this->materialIndices = device::createBuffer<uint32_t>(
+	this->instances = device::createBuffer<structs::Instance>(
 		*wgpuContext,
-		host.materialIndices,
-		"materialIndices",
-		wgpu::BufferUsage::Storage
+		stagingBelt,
+		host.instances,
+		"instances",
+		wgpu::BufferUsage::Storage,
+		enums::MemoryCategory::SCENE
 	);
-	for (uint32_t i = 0; auto & light : host.lights) {
-		const std::string lightLabel = std::format("light {0}", i);
-		this->lights.emplace_back(
-			device::createBuffer(
-				*wgpuContext,
-				light,
-				lightLabel,
-				wgpu::BufferUsage::Uniform)
-		);
-		++i;
+	//Storage too so the culling pass can read it
+	this->drawCalls = device::createBuffer<structs::host::DrawCall>(
+		*wgpuContext,
+		stagingBelt,
+		host.drawCalls,
+		"draw calls",
+		wgpu::BufferUsage::Indirect | wgpu::BufferUsage::Storage,
+		enums::MemoryCategory::SCENE
+	);
+	this->hostDrawCalls = host.drawCalls;
+	this->drawBounds = device::createBuffer<structs::DrawBounds>(
+		*wgpuContext,
+		stagingBelt,
+		host.drawBounds,
+		"draw bounds",
+		wgpu::BufferUsage::Storage,
+		enums::MemoryCategory::SCENE
+	);
+	//Culled lists are only read by indirect draws, see render::sceneDraw::canDrawIndirect
+	if (wgpuContext->device.HasFeature(wgpu::FeatureName::IndirectFirstInstance) && !host.drawCalls.empty()) {
+		this->cullViewCount = 1 + static_cast<uint32_t>(host.lights.size());
+		const wgpu::BufferDescriptor culledDrawCallsDescriptor = {
+			.label = "culled draw calls buffer",
+			.usage = wgpu::BufferUsage::Indirect | wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst,
+			.size = sizeof(structs::host::DrawCall) * host.drawCalls.size() * this->cullViewCount,
+		};
+		this->culledDrawCalls = wgpuContext->device.CreateBuffer(&culledDrawCallsDescriptor);
+		wgpuContext->getMemoryRegistry().track(this->culledDrawCalls, "culled draw calls", enums::MemoryCategory::SCENE);
+		const wgpu::BufferDescriptor culledDrawCountsDescriptor = {
+			.label = "culled draw counts buffer",
+			.usage = wgpu::BufferUsage::Indirect | wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst,
+			.size = sizeof(uint32_t) * constants::INDEX_FORMAT_COUNT * this->cullViewCount,
+		};
+		this->culledDrawCounts = wgpuContext->device.CreateBuffer(&culledDrawCountsDescriptor);
+		wgpuContext->getMemoryRegistry().track(this->culledDrawCounts, "culled draw counts", enums::MemoryCategory::SCENE);
+	}
+	std::vector<glm::f32mat4x4> projectionViews;
+	std::vector<glm::f32mat4x4> inverseProjectionViews;
+	getCameraMatrices(host.cameras, projectionViews, inverseProjectionViews);
+	if (!projectionViews.empty()) {
+		this->shadowAtlasCamera = projectionViews.front();
+		this->shadowAtlasRects = render::shadowAtlas::allocate(host.lights, this->shadowAtlasCamera, wgpuContext->getScreenDimensions());
 	}
+	this->hostLights = host.lights;
+	assignShadowViews();
+
+	UniformSuballocator lightUniforms = UniformSuballocator(wgpuContext);
+	for (const structs::Light& light : this->hostLights) {
+		this->lightUniformOffsets.push_back(lightUniforms.push(light));
+	}
+	this->lightUniforms = lightUniforms.createBuffer(stagingBelt, "light uniforms", wgpu::BufferUsage::None, enums::MemoryCategory::SCENE);
+	this->lightStorage = device::createBuffer<structs::Light>(
+		*wgpuContext,
+		stagingBelt,
+		this->hostLights,
+		"light storage",
+		wgpu::BufferUsage::Storage,
+		enums::MemoryCategory::SCENE
+	);
 	this->materials = device::createBuffer<structs::Material>(
 		*wgpuContext,
+		stagingBelt,
 		host.materials,
 		"materials",
-		wgpu::BufferUsage::Storage
+		wgpu::BufferUsage::Storage,
+		enums::MemoryCategory::SCENE
 	);
 	this->samplerTexturePairs = device::createBuffer<structs::SamplerTexturePair>(
 		*wgpuContext,
+		stagingBelt,
 		host.samplerTexturePairs,
 		"sampler texture pairs",
-		wgpu::BufferUsage::Storage
+		wgpu::BufferUsage::Storage,
+		enums::MemoryCategory::SCENE
 	);
 
-	std::vector<glm::f32mat4x4> projectionViews;
-	for (uint32_t i = 0; i < host.cameras.size(); i++) {
-		const glm::f32mat4x4 view = glm::lookAt(
-			host.cameras[i].position,
-			host.cameras[i].position + host.cameras[i].forward,
-			constants::UP
-		);
-		projectionViews.push_back(host.cameras[i].projection * view);
-	}
 	this->cameras = device::createBuffer<glm::f32mat4x4>(
 		*wgpuContext,
+		stagingBelt,
 		projectionViews,
 		"cameras",
-		wgpu::BufferUsage::Uniform
+		wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopySrc, //CopySrc for the previous frame camera of the culling pass
+		enums::MemoryCategory::SCENE
+	);
+	this->inverseCameras = device::createBuffer<glm::f32mat4x4>(
+		*wgpuContext,
+		stagingBelt,
+		inverseProjectionViews,
+		"inverse cameras",
+		wgpu::BufferUsage::Uniform,
+		enums::MemoryCategory::SCENE
+	);
+	//Room for every light, so the atlas allocated again by updateLight always fits the buffer the bind groups hold
+	std::vector<structs::ShadowView> shadowViews = render::shadowAtlas::getShadowViews(this->hostLights, this->shadowAtlasRects);
+	shadowViews.resize(std::max<size_t>(shadowViews.size(), this->hostLights.size()));
+	this->shadowViews = device::createBuffer<structs::ShadowView>(
+		*wgpuContext,
+		stagingBelt,
+		shadowViews,
+		"shadow views",
+		wgpu::BufferUsage::Storage,
+		enums::MemoryCategory::SCENE
 	);
 
-	for (uint32_t i = 0; i < this->samplers.size(); ++i) {
-		this->samplers[i] = wgpuContext->device.CreateSampler(&host.samplers[i]);
-	}
-	const wgpu::SamplerDescriptor defaultSamplerDescriptor = {
-		.label = "default sampler",
-		.addressModeU = wgpu::AddressMode::Repeat,
-		.addressModeV = wgpu::AddressMode::Repeat,
+	//texCoords are already in [0, 1] when they are unpacked so the address mode of the gltf sampler no longer matters
+	const wgpu::SamplerDescriptor textureArrayLinearSamplerDescriptor = {
+		.label = "texture array linear sampler",
+		.addressModeU = wgpu::AddressMode::ClampToEdge,
+		.addressModeV = wgpu::AddressMode::ClampToEdge,
 		.magFilter = wgpu::FilterMode::Linear,
 		.minFilter = wgpu::FilterMode::Linear,
+		.mipmapFilter = wgpu::MipmapFilterMode::Linear,
+	};
+	this->textureArrayLinearSampler = wgpuContext->device.CreateSampler(&textureArrayLinearSamplerDescriptor);
+	const wgpu::SamplerDescriptor textureArrayNearestSamplerDescriptor = {
+		.label = "texture array nearest sampler",
+		.addressModeU = wgpu::AddressMode::ClampToEdge,
+		.addressModeV = wgpu::AddressMode::ClampToEdge,
+		.magFilter = wgpu::FilterMode::Nearest,
+		.minFilter = wgpu::FilterMode::Nearest,
 		.mipmapFilter = wgpu::MipmapFilterMode::Nearest,
 	};
-	this->samplers[UINT32_MAX] = wgpuContext->device.CreateSampler(&defaultSamplerDescriptor);
+	this->textureArrayNearestSampler = wgpuContext->device.CreateSampler(&textureArrayNearestSamplerDescriptor);
+
+	stagingBelt.submit();
+	texture::getTextureArrays(*wgpuContext, stagingBelt, threadPool, host.textureUris, this->textureArrays, this->textureArrayViews, this->textureLayers);
+}
 
-	this->textures.resize(host.textureUris.size());
-	this->textureViews.resize(host.textureUris.size());
-	for (uint32_t i = 0; i < host.textureUris.size(); ++i) {
-		texture::getTexture(*wgpuContext, host.textureUris[i], this->textures[i], this->textureViews[i]);
+SceneResources::~SceneResources() {
+	MemoryRegistry& memoryRegistry = _wgpuContext->getMemoryRegistry();
+	for (const wgpu::Buffer* buffer : {
+		&this->vbo, &this->vertexQuantizations, &this->vertexQuantizationIndices, &this->transforms, &this->indices16, &this->indices32, &this->instances,
+		&this->drawCalls, &this->drawBounds, &this->culledDrawCalls, &this->culledDrawCounts, &this->lightUniforms,
+		&this->lightStorage, &this->shadowViews, &this->cameras, &this->inverseCameras, &this->materials, &this->samplerTexturePairs,
+	}) {
+		memoryRegistry.untrack(*buffer);
 	}
-}
\ No newline at end of file
+	for (const wgpu::Texture& textureArray : this->textureArrays) {
+		memoryRegistry.untrack(textureArray);
+	}
+}
+
+void SceneResources::updateLight(StagingBelt& stagingBelt, const uint32_t lightIndex, const structs::Light& light) {
+	const uint32_t shadowViewIndex = this->hostLights[lightIndex].shadowViewIndex;
+	this->hostLights[lightIndex] = light;
+	this->hostLights[lightIndex].shadowViewIndex = shadowViewIndex;
+	std::vector<structs::host::ShadowAtlasRect> shadowAtlasRects = render::shadowAtlas::allocate(this->hostLights, this->shadowAtlasCamera, _wgpuContext->getScreenDimensions());
+	if (shadowAtlasRects == this->shadowAtlasRects) {
+		writeLight(stagingBelt, lightIndex);
+		if (shadowViewIndex != constants::NO_SHADOW_VIEW) {
+			const structs::ShadowView shadowView = render::shadowAtlas::getShadowViews(this->hostLights, { this->shadowAtlasRects[shadowViewIndex] }).front();
+			stagingBelt.writeBuffer(this->shadowViews, sizeof(structs::ShadowView) * shadowViewIndex, &shadowView, sizeof(structs::ShadowView));
+		}
+		return;
+	}
+
+	//Every shadowViewIndex may have moved with the squares
+	this->shadowAtlasRects = std::move(shadowAtlasRects);
+	this->shadowAtlasVersion++;
+	std::vector<uint32_t> shadowViewIndices;
+	shadowViewIndices.reserve(this->hostLights.size());
+	for (const structs::Light& hostLight : this->hostLights) {
+		shadowViewIndices.push_back(hostLight.shadowViewIndex);
+	}
+	assignShadowViews();
+	for (uint32_t i = 0; i < this->hostLights.size(); ++i) {
+		if (i == lightIndex || this->hostLights[i].shadowViewIndex != shadowViewIndices[i]) {
+			writeLight(stagingBelt, i);
+		}
+	}
+	const std::vector<structs::ShadowView> shadowViews = render::shadowAtlas::getShadowViews(this->hostLights, this->shadowAtlasRects);
+	stagingBelt.writeBuffer(this->shadowViews, shadowViews);
+}
+
+void SceneResources::writeLight(StagingBelt& stagingBelt, const uint32_t lightIndex) {
+	const structs::Light& light = this->hostLights[lightIndex];
+	stagingBelt.writeBuffer(this->lightUniforms, this->lightUniformOffsets[lightIndex], &light, sizeof(structs::Light));
+	stagingBelt.writeBuffer(this->lightStorage, sizeof(structs::Light) * lightIndex, &light, sizeof(structs::Light));
+}
+
+//The lighting pass finds each light's own shadow map through its shadowViewIndex
+void SceneResources::assignShadowViews() {
+	for (structs::Light& light : this->hostLights) {
+		light.shadowViewIndex = constants::NO_SHADOW_VIEW;
+	}
+	for (uint32_t i = 0; i < this->shadowAtlasRects.size(); ++i) {
+		this->hostLights[this->shadowAtlasRects[i].lightIndex].shadowViewIndex = i;
+	}
+}
+
+void SceneResources::markGeometryChanged() {
+	this->geometryVersion++;
+}
+
+void SceneResources::getCameraMatrices(
+	const std::vector<structs::host::H_Camera>& cameras,
+	std::vector<glm::f32mat4x4>& outProjectionViews,
+	std::vector<glm::f32mat4x4>& outInverseProjectionViews
+) {
+	outProjectionViews.clear();
+	outInverseProjectionViews.clear();
+	for (uint32_t i = 0; i < cameras.size(); i++) {
+		const glm::f32mat4x4 view = glm::lookAt(
+			cameras[i].position,
+			cameras[i].position + cameras[i].forward,
+			constants::UP
+		);
+		outProjectionViews.push_back(cameras[i].projection * view);
+		outInverseProjectionViews.push_back(glm::inverse(outProjectionViews.back()));
+	}
+}
@@ -1,60 +1,117 @@
 #pragma once
 #include <string>
 #include <vector>
-#include <unordered_map>
 #include <dawn/webgpu_cpp.h>
 #include "../wgpuContext/wgpuContext.hpp"
 #include "../constants.hpp"
 #include "../host/host.hpp"
+#include "../render/frameGraph.hpp"
+#include "stagingBelt.hpp"
 
 struct RenderResources {
-	RenderResources(WGPUContext* wgpuContext);
+	//Registers the textures with frameGraph and compiles it, the passes must already be declared. Aliased resources share a texture
+	RenderResources(WGPUContext* wgpuContext, render::FrameGraph& frameGraph);
+	~RenderResources();
+	RenderResources(const RenderResources&) = delete;
+	RenderResources& operator=(const RenderResources&) = delete;
 
-	const wgpu::TextureFormat worldPositionTextureFormat = wgpu::TextureFormat::RGBA32Float;
-	const wgpu::TextureFormat baseColorTextureFormat = wgpu::TextureFormat::RGBA32Float;
-	const wgpu::TextureFormat normalTextureFormat = wgpu::TextureFormat::RGBA32Float; //normal texture can tangent-ized	if I need it
+	//World position is not stored, it is reconstructed from depth and SceneResources::inverseCameras
+	const wgpu::TextureFormat baseColorTextureFormat = wgpu::TextureFormat::RGBA8Unorm; //srgb formats cannot be storage textures
+	const wgpu::TextureFormat normalTextureFormat = wgpu::TextureFormat::R32Uint; //Packed Snorm16x2 octahedral
 	const wgpu::TextureFormat texCoordTextureFormat = wgpu::TextureFormat::R32Uint; //Packed Unorm16x2
-	const wgpu::TextureFormat baseColorIdTextureFormat = wgpu::TextureFormat::R32Uint;
-	const wgpu::TextureFormat normalIdTextureFormat = wgpu::TextureFormat::R32Uint;
+	//Packed sampler texture pair ids, see constants::TEXTURE_ID_BITS. One target so Initial stays within four
+	const wgpu::TextureFormat textureIdsTextureFormat = wgpu::TextureFormat::R32Uint;
 	const wgpu::TextureFormat depthTextureFormat = constants::DEPTH_FORMAT;
 
 	const wgpu::TextureFormat lightingTextureFormat = wgpu::TextureFormat::R32Uint;
-	const wgpu::TextureFormat shadowMapTextureFormat = constants::DEPTH_FORMAT;
-	const wgpu::TextureFormat shadowTextureFormat = wgpu::TextureFormat::R32Float;
-	const wgpu::TextureFormat ultimateTextureFormat = wgpu::TextureFormat::RGBA32Float;
+	const wgpu::TextureFormat shadowAtlasTextureFormat = constants::DEPTH_FORMAT;
+	const wgpu::TextureFormat ultimateTextureFormat = wgpu::TextureFormat::RGBA16Float;
 
-	wgpu::TextureView worldPositionTextureView;
 	wgpu::TextureView baseColorTextureView;
 	wgpu::TextureView normalTextureView;
 	wgpu::TextureView texCoordTextureView;
-	wgpu::TextureView baseColorIdTextureView;
-	wgpu::TextureView normalIdTextureView;
+	wgpu::TextureView textureIdsTextureView;
 	wgpu::TextureView depthTextureView;
 	wgpu::TextureView lightingTextureView;
-	std::vector<wgpu::TextureView> shadowMapTextureViews;
-	wgpu::TextureView shadowTextureView; //accumulation of all shadowMaps in clip space
+	wgpu::TextureView shadowAtlasTextureView; //constants::SHADOW_ATLAS_SIZE square holding every shadow map
 	wgpu::TextureView ultimateTextureView;
+	wgpu::Texture ultimateTexture; //kept for reading the final image back
+
+	wgpu::Extent2D lightTileCount;
+	wgpu::Buffer tileLights; //structs::TileLights for every lightTileCount tile
+	wgpu::Buffer tileLightOverflow; //structs::TileLightOverflow of the last light culling pass
 
 	wgpu::Sampler shadowMapSampler;
+
+private:
+	WGPUContext* _wgpuContext;
 };
 
 struct SceneResources {
-	SceneResources(WGPUContext* wgpuContext, HostSceneResources& host);
+	//Everything is uploaded through stagingBelt, which is submitted before this returns. Textures are decoded on threadPool
+	SceneResources(WGPUContext* wgpuContext, StagingBelt& stagingBelt, const HostSceneResources& host, ThreadPool& threadPool);
+	~SceneResources();
+	SceneResources(const SceneResources&) = delete;
+	SceneResources& operator=(const SceneResources&) = delete;
+	//Writes the light to every buffer that holds it through stagingBelt and allocates the shadow atlas again, since the
+	//light's frustum may now cover more or less of the screen. The light keeps its shadowViewIndex unless the squares change,
+	//then the lights whose shadowViewIndex moved and the shadow views are rewritten too and shadowAtlasVersion is bumped
+	void updateLight(StagingBelt& stagingBelt, const uint32_t lightIndex, const structs::Light& light);
+	//Must be called whenever vbo, the indices or transforms change, so cached shadow maps are redrawn
+	void markGeometryChanged();
+	//The contents of cameras and inverseCameras for the host cameras
+	static void getCameraMatrices(
+		const std::vector<structs::host::H_Camera>& cameras,
+		std::vector<glm::f32mat4x4>& outProjectionViews,
+		std::vector<glm::f32mat4x4>& outInverseProjectionViews
+	);
 
-	wgpu::Buffer vbo;
-	wgpu::Buffer transforms;
-	wgpu::Buffer indices;
-	wgpu::Buffer materialIndices; //MaterialId for each instance
+	wgpu::Buffer vbo; //structs::QuantizedVBO when the host scene was quantized, structs::VBO otherwise
+	wgpu::Buffer vertexQuantizations; //structs::VertexQuantization for each mesh, null unless vbo is quantized
+	wgpu::Buffer vertexQuantizationIndices; //index into vertexQuantizations for each transform, null unless vbo is quantized
+	wgpu::Buffer transforms; //one per mesh instance, read through instances
+	wgpu::Buffer indices16;
+	wgpu::Buffer indices32;
+	uint32_t uint16DrawCount = 0; //drawCalls before it read indices16, the rest indices32
+	wgpu::Buffer instances; //structs::Instance for each instance of each draw
+	wgpu::Buffer drawCalls; //structs::host::DrawCall for each instance cluster of each primitive, read as DrawIndexedIndirect arguments
+	std::vector<structs::host::DrawCall> hostDrawCalls;
+	wgpu::Buffer drawBounds; //structs::DrawBounds for each draw
+	//Written every frame by render::Culling, null when indirect draws are unavailable. Each view owns hostDrawCalls.size()
+	//slots and INDEX_FORMAT_COUNT counts. The visible draws of each index format are compacted to the front of that format's
+	//run of slots, and counted in that format's count. View 0 is camera 0, view 1 + i is light i
+	uint32_t cullViewCount = 0;
+	wgpu::Buffer culledDrawCalls;
+	wgpu::Buffer culledDrawCounts;
 
-	std::vector<wgpu::Buffer> lights;
+	std::vector<structs::Light> hostLights;
+	uint64_t geometryVersion = 0; //see markGeometryChanged
+	wgpu::Buffer lightUniforms; //every structs::Light as a uniform, light i at lightUniformOffsets[i]
+	std::vector<uint32_t> lightUniformOffsets;
+	wgpu::Buffer lightStorage; //every light in one storage buffer
+	//The lights with a shadow map and where it is in the atlas, sized from what the first camera sees, see render::shadowAtlas
+	std::vector<structs::host::ShadowAtlasRect> shadowAtlasRects;
+	glm::f32mat4x4 shadowAtlasCamera = glm::f32mat4x4(1.0f); //the projectionView shadowAtlasRects are sized for
+	uint64_t shadowAtlasVersion = 0; //bumped whenever shadowAtlasRects change, see updateLight
+	wgpu::Buffer shadowViews; //structs::ShadowView for each of shadowAtlasRects, with room for one per light
 	wgpu::Buffer cameras;
+	wgpu::Buffer inverseCameras; //inverse projectionView to get from clip space back to world space
 
 	wgpu::Buffer materials;
 	wgpu::Buffer samplerTexturePairs;
 
-	std::unordered_map<uint32_t, wgpu::Sampler> samplers;
-	std::vector<wgpu::Texture> textures;
-	std::vector<wgpu::TextureView> textureViews;
+	std::vector<wgpu::Texture> textureArrays; //every scene image, one per layer of the array of its size
+	std::vector<wgpu::TextureView> textureArrayViews;
+	std::vector<structs::host::TextureLayer> textureLayers; //one per scene image
+	wgpu::Sampler textureArrayLinearSampler;
+	wgpu::Sampler textureArrayNearestSampler;
+
+private:
+	WGPUContext* _wgpuContext;
+
+	void assignShadowViews();
+	//Into lightUniforms and lightStorage
+	void writeLight(StagingBelt& stagingBelt, const uint32_t lightIndex);
 };
 
 struct DeviceResources {
@@ -0,0 +1,221 @@
+#pragma once
+#include "stagingBelt.hpp"
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#include "absl/log/log.h"
+
+namespace {
+	uint64_t alignUp(const uint64_t value, const uint64_t alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+StagingBelt::StagingBelt(WGPUContext* wgpuContext, const std::string& label, const uint64_t chunkSize, const uint32_t chunkCount)
+	: _wgpuContext(wgpuContext), _label(label), _chunkSize(alignUp(chunkSize, TEXTURE_COPY_ALIGNMENT)), _chunkCount(std::max(chunkCount, 1u)) {
+}
+
+//Chunks still mapping are kept alive by their pending map, they only stop counting as staging memory of the belt
+StagingBelt::~StagingBelt() {
+	MemoryRegistry& memoryRegistry = _wgpuContext->getMemoryRegistry();
+	for (const std::vector<Chunk>* chunks : { &_freeChunks, &_activeChunks, &_recordedChunks }) {
+		for (const Chunk& chunk : *chunks) {
+			memoryRegistry.untrack(chunk.buffer);
+		}
+	}
+	for (const Chunk& chunk : _inFlightChunks) {
+		memoryRegistry.untrack(chunk.buffer);
+	}
+}
+
+void StagingBelt::writeBuffer(const wgpu::Buffer& destination, const uint64_t destinationOffset, const void* data, const uint64_t size) {
+	if (size % COPY_ALIGNMENT != 0 || destinationOffset % COPY_ALIGNMENT != 0) {
+		throw std::invalid_argument(std::format("{} staging belt write of {} bytes at {} is not 4 byte aligned", _label, size, destinationOffset));
+	}
+	const std::byte* source = static_cast<const std::byte*>(data);
+	for (uint64_t written = 0; written < size; ) {
+		const uint64_t pieceSize = std::min(size - written, _chunkSize);
+		BufferCopy copy = {
+			.destination = destination,
+			.destinationOffset = destinationOffset + written,
+			.size = pieceSize,
+		};
+		void* mapped = allocate(pieceSize, COPY_ALIGNMENT, copy.chunk, copy.chunkOffset);
+		std::memcpy(mapped, source + written, pieceSize);
+		_bufferCopies.push_back(copy);
+		written += pieceSize;
+	}
+}
+
+//Images larger than a chunk are copied in bands of rows
+void StagingBelt::writeTexture(
+	const wgpu::TexelCopyTextureInfo& destination,
+	const void* data,
+	const wgpu::TexelCopyBufferLayout& dataLayout,
+	const wgpu::Extent3D& writeSize
+) {
+	if (dataLayout.rowsPerImage == wgpu::kCopyStrideUndefined || dataLayout.rowsPerImage == 0) {
+		throw std::invalid_argument("staging belt texture writes need rowsPerImage");
+	}
+	const uint64_t stagedBytesPerRow = alignUp(dataLayout.bytesPerRow, TEXTURE_COPY_ALIGNMENT);
+	if (stagedBytesPerRow > _chunkSize) {
+		throw std::invalid_argument(std::format("{} staging belt chunks of {} bytes cannot hold a {} byte row", _label, _chunkSize, stagedBytesPerRow));
+	}
+	const uint32_t blockHeight = writeSize.height / dataLayout.rowsPerImage;
+	const uint32_t rowsPerBand = static_cast<uint32_t>(std::min<uint64_t>(_chunkSize / stagedBytesPerRow, dataLayout.rowsPerImage));
+
+	const std::byte* source = static_cast<const std::byte*>(data) + dataLayout.offset;
+	for (uint32_t image = 0; image < writeSize.depthOrArrayLayers; ++image) {
+		for (uint32_t firstRow = 0; firstRow < dataLayout.rowsPerImage; firstRow += rowsPerBand) {
+			const uint32_t rowCount = std::min(rowsPerBand, dataLayout.rowsPerImage - firstRow);
+			TextureCopy copy = {
+				.destination = destination,
+				.size = {
+					.width = writeSize.width,
+					.height = rowCount * blockHeight,
+					.depthOrArrayLayers = 1,
+				},
+			};
+			copy.destination.origin.y += firstRow * blockHeight;
+			copy.destination.origin.z += image;
+			uint64_t chunkOffset = 0;
+			std::byte* mapped = static_cast<std::byte*>(allocate(stagedBytesPerRow * rowCount, TEXTURE_COPY_ALIGNMENT, copy.chunk, chunkOffset));
+			const std::byte* band = source + (uint64_t{ image } * dataLayout.rowsPerImage + firstRow) * dataLayout.bytesPerRow;
+			for (uint32_t row = 0; row < rowCount; ++row) {
+				std::memcpy(mapped + row * stagedBytesPerRow, band + uint64_t{ row } * dataLayout.bytesPerRow, dataLayout.bytesPerRow);
+			}
+			copy.layout = {
+				.offset = chunkOffset,
+				.bytesPerRow = static_cast<uint32_t>(stagedBytesPerRow),
+				.rowsPerImage = rowCount,
+			};
+			_textureCopies.push_back(copy);
+		}
+	}
+}
+
+void StagingBelt::submit() {
+	if (_activeChunks.empty()) {
+		return;
+	}
+	const std::string encoderLabel = _label + " staging belt command encoder";
+	const wgpu::CommandEncoderDescriptor commandEncoderDescriptor = {
+		.label = wgpu::StringView(encoderLabel),
+	};
+	const wgpu::CommandEncoder commandEncoder = _wgpuContext->device.CreateCommandEncoder(&commandEncoderDescriptor);
+	recordCopies(commandEncoder);
+	const wgpu::CommandBuffer commandBuffer = commandEncoder.Finish();
+	_wgpuContext->queue.Submit(1, &commandBuffer);
+	submitted();
+}
+
+void StagingBelt::recordCopies(const wgpu::CommandEncoder& commandEncoder) {
+	if (!_recordedChunks.empty()) {
+		throw std::logic_error(_label + " staging belt copies were recorded twice without submitted()");
+	}
+	for (const BufferCopy& copy : _bufferCopies) {
+		commandEncoder.CopyBufferToBuffer(_activeChunks[copy.chunk].buffer, copy.chunkOffset, copy.destination, copy.destinationOffset, copy.size);
+	}
+	for (const TextureCopy& copy : _textureCopies) {
+		const wgpu::TexelCopyBufferInfo source = {
+			.layout = copy.layout,
+			.buffer = _activeChunks[copy.chunk].buffer,
+		};
+		commandEncoder.CopyBufferToTexture(&source, &copy.destination, &copy.size);
+	}
+	for (Chunk& chunk : _activeChunks) {
+		chunk.buffer.Unmap();
+		chunk.mapped = nullptr;
+	}
+	_recordedChunks = std::move(_activeChunks);
+	_activeChunks.clear();
+	_bufferCopies.clear();
+	_textureCopies.clear();
+}
+
+//The map only resolves once the copies submitted from the chunk have executed
+void StagingBelt::submitted() {
+	for (Chunk& chunk : _recordedChunks) {
+		chunk.mapFuture = chunk.buffer.MapAsync(
+			wgpu::MapMode::Write,
+			0,
+			chunk.buffer.GetSize(),
+			wgpu::CallbackMode::WaitAnyOnly,
+			[](wgpu::MapAsyncStatus status, wgpu::StringView message) {
+				if (status != wgpu::MapAsyncStatus::Success) {
+					LOG(ERROR) << "staging belt map failed: " << message;
+				}
+			}
+		);
+		_inFlightChunks.push_back(std::move(chunk));
+	}
+	_recordedChunks.clear();
+}
+
+void* StagingBelt::allocate(const uint64_t size, const uint64_t alignment, uint32_t& outChunk, uint64_t& outChunkOffset) {
+	if (!_activeChunks.empty()) {
+		Chunk& chunk = _activeChunks.back();
+		const uint64_t offset = alignUp(chunk.used, alignment);
+		if (offset + size <= chunk.buffer.GetSize()) {
+			chunk.used = offset + size;
+			outChunk = static_cast<uint32_t>(_activeChunks.size() - 1);
+			outChunkOffset = offset;
+			return chunk.mapped + offset;
+		}
+	}
+
+	acquireChunk();
+	_activeChunks.push_back(std::move(_freeChunks.back()));
+	_freeChunks.pop_back();
+	Chunk& chunk = _activeChunks.back();
+	chunk.used = size;
+	outChunk = static_cast<uint32_t>(_activeChunks.size() - 1);
+	outChunkOffset = 0;
+	return chunk.mapped;
+}
+
+void StagingBelt::acquireChunk() {
+	while (_freeChunks.empty()) {
+		if (_liveChunkCount < _chunkCount) {
+			const std::string chunkLabel = std::format("{} staging belt chunk {}", _label, _createdChunkCount++);
+			const wgpu::BufferDescriptor bufferDescriptor = {
+				.label = wgpu::StringView(chunkLabel),
+				.usage = wgpu::BufferUsage::MapWrite | wgpu::BufferUsage::CopySrc,
+				.size = _chunkSize,
+				.mappedAtCreation = true,
+			};
+			Chunk chunk = {
+				.buffer = _wgpuContext->device.CreateBuffer(&bufferDescriptor),
+			};
+			_wgpuContext->getMemoryRegistry().track(chunk.buffer, chunkLabel, enums::MemoryCategory::STAGING);
+			chunk.mapped = static_cast<std::byte*>(chunk.buffer.GetMappedRange(0, _chunkSize));
+			if (chunk.mapped == nullptr) {
+				throw std::runtime_error(std::format("{} staging belt could not map a {} byte chunk", _label, _chunkSize));
+			}
+			_freeChunks.push_back(std::move(chunk));
+			++_liveChunkCount;
+			return;
+		}
+		//Every chunk is written by the current batch, which is submitted so they can be reused
+		if (_inFlightChunks.empty()) {
+			if (!_recordedChunks.empty()) {
+				throw std::logic_error(std::format("{} staging belt ran out of its {} chunks between recordCopies() and submitted()", _label, _chunkCount));
+			}
+			submit();
+		}
+
+		Chunk chunk = std::move(_inFlightChunks.front());
+		_inFlightChunks.pop_front();
+		_wgpuContext->instance.WaitAny(chunk.mapFuture, UINT64_MAX);
+		if (chunk.buffer.GetMapState() != wgpu::BufferMapState::Mapped) {
+			//Dropped, a new chunk is created in its place
+			_wgpuContext->getMemoryRegistry().untrack(chunk.buffer);
+			--_liveChunkCount;
+			continue;
+		}
+		chunk.mapped = static_cast<std::byte*>(chunk.buffer.GetMappedRange(0, chunk.buffer.GetSize()));
+		chunk.used = 0;
+		_freeChunks.push_back(std::move(chunk));
+	}
+}
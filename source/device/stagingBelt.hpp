@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+#include <dawn/webgpu_cpp.h>
+#include "../wgpuContext/wgpuContext.hpp"
+
+//Every upload of the engine, the scene once and the per frame data every frame, goes through chunks of mapped staging
+//memory instead of queue writes. Writes are copied straight into a mapped chunk, and the copies of a batch are recorded
+//either into a command buffer of the belt's own by submit() or into the frame's encoder by recordCopies(). A chunk is
+//mapped again as soon as its batch is submitted, the map resolves once the GPU has read it. There are never more than
+//chunkCount chunks: once they are all in use the belt submits its batch and blocks on the oldest chunk, and writes larger
+//than a chunk are split across chunks
+class StagingBelt {
+public:
+	StagingBelt(WGPUContext* wgpuContext, const std::string& label, const uint64_t chunkSize = DEFAULT_CHUNK_SIZE, const uint32_t chunkCount = DEFAULT_CHUNK_COUNT);
+	~StagingBelt();
+	StagingBelt(const StagingBelt&) = delete;
+	StagingBelt& operator=(const StagingBelt&) = delete;
+
+	//size and destinationOffset must be multiples of 4
+	void writeBuffer(const wgpu::Buffer& destination, const uint64_t destinationOffset, const void* data, const uint64_t size);
+	template <typename T>
+	void writeBuffer(const wgpu::Buffer& destination, const std::vector<T>& vector) {
+		writeBuffer(destination, 0, vector.data(), sizeof(T) * vector.size());
+	}
+	//Same arguments as wgpu::Queue::WriteTexture, except rowsPerImage must be the height of writeSize in blocks. Rows are
+	//repacked to the 256 byte bytesPerRow copies need
+	void writeTexture(
+		const wgpu::TexelCopyTextureInfo& destination,
+		const void* data,
+		const wgpu::TexelCopyBufferLayout& dataLayout,
+		const wgpu::Extent3D& writeSize
+	);
+	//Submits the copies written since the last submit, later submits on the queue see their results
+	void submit();
+	//Records the copies written since the last submit into commandEncoder instead, submitted() must follow once the
+	//command buffer of commandEncoder has been submitted
+	void recordCopies(const wgpu::CommandEncoder& commandEncoder);
+	void submitted();
+
+private:
+	static constexpr uint64_t DEFAULT_CHUNK_SIZE = 4 * 1024 * 1024;
+	static constexpr uint32_t DEFAULT_CHUNK_COUNT = 4;
+	static constexpr uint64_t COPY_ALIGNMENT = 4;
+	static constexpr uint64_t TEXTURE_COPY_ALIGNMENT = 256; //bytesPerRow and a multiple of every texel block size
+
+	struct Chunk {
+		wgpu::Buffer buffer;
+		std::byte* mapped = nullptr; //the whole chunk, null while a batch that reads it is in flight
+		uint64_t used = 0;
+		wgpu::Future mapFuture; //of the map issued when its batch was submitted
+	};
+	struct BufferCopy {
+		uint32_t chunk; //into _activeChunks
+		uint64_t chunkOffset;
+		wgpu::Buffer destination;
+		uint64_t destinationOffset;
+		uint64_t size;
+	};
+	struct TextureCopy {
+		uint32_t chunk;
+		wgpu::TexelCopyBufferLayout layout; //offset is into the chunk
+		wgpu::TexelCopyTextureInfo destination;
+		wgpu::Extent3D size;
+	};
+
+	WGPUContext* _wgpuContext;
+	std::string _label;
+	uint64_t _chunkSize;
+	uint32_t _chunkCount;
+	uint32_t _createdChunkCount = 0; //for the labels
+	uint32_t _liveChunkCount = 0;
+	std::vector<Chunk> _freeChunks; //mapped and empty
+	std::vector<Chunk> _activeChunks; //mapped, written by the current batch
+	std::vector<Chunk> _recordedChunks; //unmapped, read by copies recorded into an encoder that is not submitted yet
+	std::deque<Chunk> _inFlightChunks; //mapping, oldest batch first
+	std::vector<BufferCopy> _bufferCopies;
+	std::vector<TextureCopy> _textureCopies;
+
+	//Returns a mapped range of size bytes, which must fit in a chunk, and the chunk and offset it is at
+	void* allocate(const uint64_t size, const uint64_t alignment, uint32_t& outChunk, uint64_t& outChunkOffset);
+	//Makes a chunk free, creating one while there are fewer than _chunkCount and otherwise waiting for the oldest one
+	void acquireChunk();
+};
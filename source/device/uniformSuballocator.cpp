@@ -0,0 +1,38 @@
+#pragma once
+#include "uniformSuballocator.hpp"
+#include <cstring>
+
+UniformSuballocator::UniformSuballocator(WGPUContext* wgpuContext) : _wgpuContext(wgpuContext) {
+	wgpu::Limits limits;
+	_wgpuContext->device.GetLimits(&limits);
+	_alignment = limits.minUniformBufferOffsetAlignment;
+}
+
+uint32_t UniformSuballocator::push(const void* data, const uint64_t size) {
+	const size_t offset = (_data.size() + _alignment - 1) / _alignment * _alignment;
+	_data.resize(offset + size);
+	std::memcpy(_data.data() + offset, data, size);
+	return static_cast<uint32_t>(offset);
+}
+
+wgpu::Buffer UniformSuballocator::createBuffer(
+	StagingBelt& stagingBelt,
+	const std::string& label,
+	const wgpu::BufferUsage bufferUsage,
+	const enums::MemoryCategory memoryCategory
+) {
+	if (_data.empty()) {
+		return nullptr;
+	}
+	//Copies are made of 4 byte words
+	_data.resize((_data.size() + 3) / 4 * 4);
+	const wgpu::BufferDescriptor bufferDescriptor = {
+		.label = wgpu::StringView(label + " buffer"),
+		.usage = wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst | bufferUsage,
+		.size = _data.size(),
+	};
+	wgpu::Buffer buffer = _wgpuContext->device.CreateBuffer(&bufferDescriptor);
+	_wgpuContext->getMemoryRegistry().track(buffer, label, memoryCategory);
+	stagingBelt.writeBuffer(buffer, 0, _data.data(), _data.size());
+	return buffer;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <dawn/webgpu_cpp.h>
+#include "../wgpuContext/wgpuContext.hpp"
+#include "../enums.hpp"
+#include "stagingBelt.hpp"
+
+//Packs small uniforms into one buffer instead of a buffer each. Every uniform starts at a multiple of
+//minUniformBufferOffsetAlignment, so its offset can be used as a dynamic offset or as a bind group entry offset
+class UniformSuballocator {
+public:
+	UniformSuballocator(WGPUContext* wgpuContext);
+
+	//Returns the offset of the uniform in the buffer
+	uint32_t push(const void* data, const uint64_t size);
+	template <typename T>
+	uint32_t push(const T& uniform) {
+		return push(&uniform, sizeof(T));
+	}
+	//Creates the buffer and uploads every pushed uniform, null if nothing was pushed
+	wgpu::Buffer createBuffer(
+		StagingBelt& stagingBelt,
+		const std::string& label,
+		const wgpu::BufferUsage bufferUsage = wgpu::BufferUsage::None,
+		const enums::MemoryCategory memoryCategory = enums::MemoryCategory::OTHER
+	);
+
+private:
+	WGPUContext* _wgpuContext;
+	uint32_t _alignment;
+	std::vector<std::byte> _data;
+};
@@ -5,11 +5,40 @@
 #include "../gltf/gltf.hpp"
 #include <fastgltf/types.hpp>
 #include "../host/host.hpp"
+#include <algorithm>
+#include <chrono>
+#include <format>
 #include "absl/log/log.h"
 #include "engine.hpp"
+#include "../texture/texture.hpp"
 #include "../wgpuContext/wgpuContext.hpp"
+#include "../constants.hpp"
+#include "../enums.hpp"
 
 namespace {
+	//Ordered by enums::GpuPass
+	const std::vector<std::string> gpuPassNames = {
+		"Initial",
+		"LightCulling",
+		"BaseColorAccumulator",
+		"NormalAccumulator",
+		"Lighting",
+		"ShadowMap",
+		"Ultimate",
+		"ToSurface",
+		"Culling",
+		"HiZ",
+	};
+
+	//Ordered by enums::CpuPhase
+	const std::vector<std::string> cpuPhaseNames = {
+		"FrameWait",
+		"Acquire",
+		"Encode",
+		"Submit",
+		"Present",
+	};
+
 	wgpu::TextureView getNextSurfaceTextureView(wgpu::Surface surface) {
 		wgpu::SurfaceTexture surfaceTexture;
 		surface.GetCurrentTexture(&surfaceTexture);
@@ -33,93 +62,166 @@ namespace {
 
 		return textureView;
 	}
-
 }
 
-Engine::Engine() {
+Engine::Engine(const engine::Options& options) : _options(options), _wgpuContext(options.context) {
+	_cullingRender = new render::Culling(&_wgpuContext, _options.occlusionCulling);
+	_initialRender = new render::Initial(&_wgpuContext, _options.quantizeVertices);
+	_baseColorAccumulatorRender = new render::FourChannel(&_wgpuContext);
+	_normalAccumulatorRender = new render::OctahedralNormal(&_wgpuContext);
+	_lightCullingRender = new render::LightCulling(&_wgpuContext);
+	_lightingRender = new render::Lighting(&_wgpuContext);
+	_shadowMapRender = new render::ShadowMap(&_wgpuContext, _options.quantizeVertices, _options.cacheShadowMaps);
+	_ultimateRender = new render::Ultimate(&_wgpuContext);
+	_toSurfaceRender = new render::ToSurface(&_wgpuContext);
+
+	//Declared in the order the passes ran before the graph ordered them, which it keeps since that order is valid
+	_frameGraph = new render::FrameGraph(&_wgpuContext, gpuPassNames);
+	_cullingRender->declareResources(*_frameGraph);
+	_initialRender->declareResources(*_frameGraph);
+	const render::accumulator::descriptor::DeclareResources baseColorDeclareResourcesDescriptor = {
+		.frameGraph = *_frameGraph,
+		.pass = enums::GpuPass::BASE_COLOR_ACCUMULATOR,
+		.accumulator = enums::FrameResource::BASE_COLOR,
+	};
+	_baseColorAccumulatorRender->declareResources(&baseColorDeclareResourcesDescriptor);
+	const render::accumulator::descriptor::DeclareResources normalDeclareResourcesDescriptor = {
+		.frameGraph = *_frameGraph,
+		.pass = enums::GpuPass::NORMAL_ACCUMULATOR,
+		.accumulator = enums::FrameResource::NORMAL,
+	};
+	_normalAccumulatorRender->declareResources(&normalDeclareResourcesDescriptor);
+	_lightCullingRender->declareResources(*_frameGraph);
+	_lightingRender->declareResources(*_frameGraph);
+	_shadowMapRender->declareResources(*_frameGraph);
+	_ultimateRender->declareResources(*_frameGraph);
+	_toSurfaceRender->declareResources(*_frameGraph);
+
+	_deviceResources = new DeviceResources();
+	_deviceResources->render = new RenderResources(&_wgpuContext, *_frameGraph);
+
+	//Pipelines only depend on the render target formats, so they are all issued before the scene is loaded and
+	//compile on dawn's worker threads while the glTF is imported and its textures are uploaded
+	PipelineBatch pipelineBatch = PipelineBatch(&_wgpuContext);
+
+	_cullingRender->createPipelineAsync(pipelineBatch);
+	_initialRender->createPipelineAsync(pipelineBatch, _deviceResources->render);
+
+	const render::accumulator::descriptor::CreatePipelineAsync baseColorCreatePipelineAsyncDescriptor = {
+		.pipelineBatch = pipelineBatch,
+		.accumulatorTextureFormat = _deviceResources->render->baseColorTextureFormat,
+		.texCoordTextureFormat = _deviceResources->render->texCoordTextureFormat,
+		.textureIdTextureFormat = _deviceResources->render->textureIdsTextureFormat,
+		.textureIdShift = constants::BASE_COLOR_TEXTURE_ID_SHIFT,
+	};
+	_baseColorAccumulatorRender->createPipelineAsync(&baseColorCreatePipelineAsyncDescriptor);
+
+	const render::accumulator::descriptor::CreatePipelineAsync normalCreatePipelineAsyncDescriptor = {
+		.pipelineBatch = pipelineBatch,
+		.accumulatorTextureFormat = _deviceResources->render->normalTextureFormat,
+		.texCoordTextureFormat = _deviceResources->render->texCoordTextureFormat,
+		.textureIdTextureFormat = _deviceResources->render->textureIdsTextureFormat,
+		.textureIdShift = constants::NORMAL_TEXTURE_ID_SHIFT,
+	};
+	_normalAccumulatorRender->createPipelineAsync(&normalCreatePipelineAsyncDescriptor);
+
+	_lightCullingRender->createPipelineAsync(pipelineBatch);
+	_lightingRender->createPipelineAsync(pipelineBatch, _deviceResources->render);
+	_shadowMapRender->createPipelineAsync(pipelineBatch);
+	_ultimateRender->createPipelineAsync(pipelineBatch, _deviceResources->render);
+	_toSurfaceRender->createPipelineAsync(pipelineBatch, _wgpuContext.surfaceFormat);
+
+	//Shared by the glTF import and the texture decoding
+	ThreadPool threadPool;
 	HostSceneResources h_objects = HostSceneResources(
-		gltfDirectory,
-		gltfFileName,
-		std::array<uint32_t, 2>{_wgpuContext.getScreenDimensions().width, _wgpuContext.getScreenDimensions().height}
+		_options.gltfDirectory,
+		_options.gltfFileName,
+		std::array<uint32_t, 2>{_wgpuContext.getScreenDimensions().width, _wgpuContext.getScreenDimensions().height},
+		threadPool,
+		_options.meshOptimization,
+		_options.quantizeVertices
 	);
-	_drawCalls = h_objects.drawCalls;
+	_cameras = h_objects.cameras;
+	//Every upload of the engine, the scene now and the per frame data later, shares one belt
+	_stagingBelt = new StagingBelt(&_wgpuContext, "engine");
+	_deviceResources->scene = new SceneResources(&_wgpuContext, *_stagingBelt, h_objects, threadPool);
 
-	_deviceResources = new DeviceResources();
-	_deviceResources->render = new RenderResources(&_wgpuContext);
-	_deviceResources->scene = new SceneResources(&_wgpuContext, h_objects);
+	pipelineBatch.waitForAll();
 
-	render::Initial* initialRender = new render::Initial(&_wgpuContext);
-	_initialRender = initialRender;
+	_cullingRender->generateGpuObjects(_deviceResources);
 	_initialRender->generateGpuObjects(_deviceResources);
 
-	_baseColorAccumulatorRender = new render::FourChannel(&_wgpuContext);
 	const render::accumulator::descriptor::GenerateGpuObjects baseColorGenerateGpuObjectsDescriptor = {
 		.accumulatorTextureView = _deviceResources->render->baseColorTextureView,
-		.accumulatorTextureFormat = _deviceResources->render->baseColorTextureFormat,
 		.texCoordTextureView = _deviceResources->render->texCoordTextureView,
-		.texCoordTextureFormat = _deviceResources->render->texCoordTextureFormat,
-		.textureIdTextureView = _deviceResources->render->baseColorIdTextureView,
-		.textureIdTextureFormat = _deviceResources->render->baseColorIdTextureFormat,
+		.textureIdTextureView = _deviceResources->render->textureIdsTextureView,
 		.stpIds = h_objects.baseColorStpIds,
 		.inputSTPs = h_objects.samplerTexturePairs,
-		.allTextureViews = _deviceResources->scene->textureViews,
-		.allSamplers = _deviceResources->scene->samplers,
+		.inputSamplers = h_objects.samplers,
+		.textureArrayViews = _deviceResources->scene->textureArrayViews,
+		.textureLayers = _deviceResources->scene->textureLayers,
+		.linearSampler = _deviceResources->scene->textureArrayLinearSampler,
+		.nearestSampler = _deviceResources->scene->textureArrayNearestSampler,
 	};
 	_baseColorAccumulatorRender->generateGpuObjects(&baseColorGenerateGpuObjectsDescriptor);
 	
-	_normalAccumulatorRender = new render::FourChannel(&_wgpuContext);
 	const render::accumulator::descriptor::GenerateGpuObjects normalGenerateGpuObjectsDescriptor = {
 		.accumulatorTextureView = _deviceResources->render->normalTextureView,
-		.accumulatorTextureFormat = _deviceResources->render->normalTextureFormat,
 		.texCoordTextureView = _deviceResources->render->texCoordTextureView,
-		.texCoordTextureFormat = _deviceResources->render->texCoordTextureFormat,
-		.textureIdTextureView = _deviceResources->render->normalIdTextureView,
-		.textureIdTextureFormat = _deviceResources->render->normalIdTextureFormat,
+		.textureIdTextureView = _deviceResources->render->textureIdsTextureView,
 		.stpIds = h_objects.normalStpIds,
 		.inputSTPs = h_objects.samplerTexturePairs,
-		.allTextureViews = _deviceResources->scene->textureViews,
-		.allSamplers = _deviceResources->scene->samplers,
+		.inputSamplers = h_objects.samplers,
+		.textureArrayViews = _deviceResources->scene->textureArrayViews,
+		.textureLayers = _deviceResources->scene->textureLayers,
+		.linearSampler = _deviceResources->scene->textureArrayLinearSampler,
+		.nearestSampler = _deviceResources->scene->textureArrayNearestSampler,
 	};
 	_normalAccumulatorRender->generateGpuObjects(&normalGenerateGpuObjectsDescriptor);
 
-	_lightingRender = new render::Lighting(&_wgpuContext);
+	_lightCullingRender->generateGpuObjects(_deviceResources);
 	_lightingRender->generateGpuObjects(_deviceResources);
-
-	_shadowMapRender = new render::ShadowMap(&_wgpuContext);
 	_shadowMapRender->generateGpuObjects(_deviceResources);
-
-	_shadowToCamera = new render::ShadowToCamera(&_wgpuContext);
-	_shadowToCamera->generateGpuObjects(_deviceResources);
-
-	_ultimateRender = new render::Ultimate(&_wgpuContext);
 	_ultimateRender->generateGpuObjects(_deviceResources);
 
-	render::ToSurface* toSurfaceRender = new render::ToSurface(&_wgpuContext);
-	_toSurfaceRender = toSurfaceRender;
 	const render::toSurface::descriptor::GenerateGpuObjects toSurfaceGenerateGpuObjectsDescriptor = {
 		.ultimateTextureView = _deviceResources->render->ultimateTextureView,
-		.surfaceTextureFormat = _wgpuContext.surfaceFormat,
 	};
 	_toSurfaceRender->generateGpuObjects(&toSurfaceGenerateGpuObjectsDescriptor);
 
-	render::Clear* clearLightingRender = new render::Clear(&_wgpuContext);
-	_clearLightingRender = clearLightingRender;
-	const render::clear::descriptor::GenerateGpuObjects clearLightingRenderDescriptor = {
-		.textureFormat = _deviceResources->render->lightingTextureFormat,
-		.textureView = _deviceResources->render->lightingTextureView,
-	};
-	_clearLightingRender->generateGpuObjects(&clearLightingRenderDescriptor);
+	_gpuProfiler = new GpuProfiler(&_wgpuContext, gpuPassNames);
+	_frameStats = new FrameStats(&_wgpuContext, cpuPhaseNames, _options.collectFrameStats);
+
+	_framePacer = new FramePacer(&_wgpuContext, _options.framesInFlight);
+
+	_startupMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _constructionStart).count();
+	const PipelineCache* pipelineCache = _wgpuContext.getPipelineCache();
+	if (pipelineCache != nullptr) {
+		LOG(INFO) << std::format(
+			"Startup took {:.1f} ms, pipeline cache: {} hits, {} misses, {} stores",
+			_startupMilliseconds,
+			pipelineCache->getHitCount(),
+			pipelineCache->getMissCount(),
+			pipelineCache->getStoreCount()
+		);
+	}
+	else {
+		LOG(INFO) << std::format("Startup took {:.1f} ms, pipeline cache disabled", _startupMilliseconds);
+	}
+	_wgpuContext.getMemoryRegistry().logReport("startup");
 }
 
-void Engine::run() {
+void Engine::run(const std::function<void(uint32_t)>& beforeFrame) {
 	SDL_Event e;
 	bool bQuit = false;
 	bool stopRendering = false;
+	uint32_t frame = 0;
+	const auto start = std::chrono::steady_clock::now();
 
 	// main loop
 	while (!bQuit) {
 		// Handle events on queue
-		while (SDL_PollEvent(&e) != 0) {
+		while (!_wgpuContext.isHeadless() && SDL_PollEvent(&e) != 0) {
 			// close the window when user alt-f4s or clicks the X button
 			if (e.type == SDL_EVENT_QUIT) {
 				bQuit = true;
@@ -140,93 +242,187 @@ void Engine::run() {
 		//    continue;
 		//}
 
+		if (beforeFrame) {
+			beforeFrame(frame);
+		}
 		this->draw();
+
+		++frame;
+		if (_options.frameCount > 0 && frame >= _options.frameCount) {
+			bQuit = true;
+		}
+	}
+
+	_framePacer->waitForAll();
+	const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	LOG(INFO) << std::format("Rendered {} frames in {:.1f} ms, {:.3f} ms/frame", frame, milliseconds, milliseconds / std::max(frame, 1u));
+
+	if (!_options.outputPath.empty()) {
+		texture::writePng(_wgpuContext, _deviceResources->render->ultimateTexture, _options.outputPath);
 	}
 }
 
+const FrameStats* Engine::getFrameStats() const {
+	return _frameStats;
+}
+
+const std::vector<structs::Light>& Engine::getLights() const {
+	return _deviceResources->scene->hostLights;
+}
+
+void Engine::updateLight(const uint32_t lightIndex, const structs::Light& light) {
+	_deviceResources->scene->updateLight(*_stagingBelt, lightIndex, light);
+}
+
+void Engine::markGeometryChanged() {
+	_deviceResources->scene->markGeometryChanged();
+}
+
+double Engine::getStartupMilliseconds() const {
+	return _startupMilliseconds;
+}
+
+const GpuProfiler* Engine::getGpuProfiler() const {
+	return _gpuProfiler;
+}
+
+const WGPUContext* Engine::getWGPUContext() const {
+	return &_wgpuContext;
+}
+
+//Per frame uniforms go through the staging belt so writing them never waits on a frame the GPU is still reading
+void Engine::uploadFrameData() {
+	SceneResources::getCameraMatrices(_cameras, _projectionViews, _inverseProjectionViews);
+	_stagingBelt->writeBuffer(_deviceResources->scene->cameras, _projectionViews);
+	_stagingBelt->writeBuffer(_deviceResources->scene->inverseCameras, _inverseProjectionViews);
+}
+
 void Engine::draw() {
+	_frameStats->beginFrame();
+	_framePacer->beginFrame();
+	_frameStats->endPhase(enums::CpuPhase::FRAME_WAIT);
+	_gpuProfiler->beginFrame();
 
 	//Get next surface texture view
-	wgpu::TextureView surfaceTextureView = getNextSurfaceTextureView(_wgpuContext.surface);
+	wgpu::TextureView surfaceTextureView = _wgpuContext.isHeadless()
+		? _wgpuContext.offscreenTextureView
+		: getNextSurfaceTextureView(_wgpuContext.surface);
+	_frameStats->endPhase(enums::CpuPhase::ACQUIRE);
 
 	constexpr wgpu::CommandEncoderDescriptor commandEncoderDescriptor = {
 		.label = "My command encoder"
 	};
 	wgpu::CommandEncoder commandEncoder = _wgpuContext.device.CreateCommandEncoder(&commandEncoderDescriptor);
+	uploadFrameData();
+	_stagingBelt->recordCopies(commandEncoder);
+
+	//One encoder for the whole frame, dawn places the barriers between passes from how each uses its textures
+	for (const enums::GpuPass pass : _frameGraph->getPassOrder()) {
+		const wgpu::PassTimestampWrites* timestampWrites = _gpuProfiler->getTimestampWrites(pass);
+		switch (pass) {
+		case enums::GpuPass::CULLING: {
+			const render::culling::descriptor::DoCommands doCullingCommandsDescriptor = {
+				.commandEncoder = commandEncoder,
+				.timestampWrites = timestampWrites,
+			};
+			_cullingRender->doCommands(&doCullingCommandsDescriptor);
+			break;
+		}
+		case enums::GpuPass::INITIAL: {
+			const render::initial::descriptor::DoCommands doInitialRenderCommandsDescriptor = {
+				.commandEncoder = commandEncoder,
+				.depthTextureView = _deviceResources->render->depthTextureView,
+				.timestampWrites = timestampWrites,
+			};
+			_initialRender->doCommands(&doInitialRenderCommandsDescriptor);
+			break;
+		}
+		case enums::GpuPass::HI_Z: {
+			const render::culling::descriptor::DoCommands doHiZCommandsDescriptor = {
+				.commandEncoder = commandEncoder,
+				.timestampWrites = timestampWrites,
+			};
+			_cullingRender->doHiZCommands(&doHiZCommandsDescriptor);
+			break;
+		}
+		case enums::GpuPass::BASE_COLOR_ACCUMULATOR: {
+			const render::accumulator::descriptor::DoCommands doBaseColorAccumulatorRenderCommandsDescriptor = {
+				.commandEncoder = commandEncoder,
+				.timestampWrites = timestampWrites,
+			};
+			_baseColorAccumulatorRender->doCommands(&doBaseColorAccumulatorRenderCommandsDescriptor);
+			break;
+		}
+		case enums::GpuPass::NORMAL_ACCUMULATOR: {
+			const render::accumulator::descriptor::DoCommands doNormalAccumulatorRenderCommandsDescriptor = {
+				.commandEncoder = commandEncoder,
+				.timestampWrites = timestampWrites,
+			};
+			_normalAccumulatorRender->doCommands(&doNormalAccumulatorRenderCommandsDescriptor);
+			break;
+		}
+		case enums::GpuPass::LIGHT_CULLING: {
+			const render::lightCulling::descriptor::DoCommands doLightCullingRenderCommandsDescriptor = {
+				.commandEncoder = commandEncoder,
+				.timestampWrites = timestampWrites,
+			};
+			_lightCullingRender->doCommands(&doLightCullingRenderCommandsDescriptor);
+			break;
+		}
+		case enums::GpuPass::LIGHTING: {
+			const render::lighting::descriptor::DoCommands doLightingAccumulatorRenderCommandsDescriptor = {
+				.commandEncoder = commandEncoder,
+				.timestampWrites = timestampWrites,
+			};
+			_lightingRender->doCommands(&doLightingAccumulatorRenderCommandsDescriptor);
+			break;
+		}
+		case enums::GpuPass::SHADOW_MAP: {
+			const render::shadowMap::descriptor::DoCommands doShadowMapRenderCommandsDescriptor = {
+				.commandEncoder = commandEncoder,
+				.shadowAtlasTextureView = _deviceResources->render->shadowAtlasTextureView,
+				.timestampWrites = timestampWrites,
+			};
+			_shadowMapRender->doCommands(&doShadowMapRenderCommandsDescriptor);
+			break;
+		}
+		case enums::GpuPass::ULTIMATE: {
+			const render::ultimate::descriptor::DoCommands doUltimateRenderCommandsDescriptor = {
+				.commandEncoder = commandEncoder,
+				.timestampWrites = timestampWrites,
+			};
+			_ultimateRender->doCommands(&doUltimateRenderCommandsDescriptor);
+			break;
+		}
+		case enums::GpuPass::TO_SURFACE: {
+			const render::toSurface::descriptor::DoCommands doToSurfaceRenderCommandsDescriptor = {
+				.commandEncoder = commandEncoder,
+				.surfaceTextureView = surfaceTextureView,
+				.timestampWrites = timestampWrites,
+			};
+			_toSurfaceRender->doCommands(&doToSurfaceRenderCommandsDescriptor);
+			break;
+		}
+		default:
+			throw std::runtime_error("frame graph ordered a pass the engine does not record");
+		}
+	}
+
+	_gpuProfiler->resolve(commandEncoder);
 
-	const render::clear::descriptor::DoCommands doLightingClearRenderCommandsDescriptor = {
-		.commandEncoder = commandEncoder,
-	};
-	_clearLightingRender->doCommands(&doLightingClearRenderCommandsDescriptor);
-
-	const render::initial::descriptor::DoCommands doInitialRenderCommandsDescriptor = {
-		.commandEncoder = commandEncoder,
-		.vertexBuffer = _deviceResources->scene->vbo,
-		.indexBuffer = _deviceResources->scene->indices,
-		.drawCalls = _drawCalls,
-		.depthTextureView = _deviceResources->render->depthTextureView,
-	};
-	_initialRender->doCommands(&doInitialRenderCommandsDescriptor);
 	constexpr wgpu::CommandBufferDescriptor commandBufferDescriptor = {
 		.label = "Command Buffer",
 	};
 	wgpu::CommandBuffer commandBuffer = commandEncoder.Finish(&commandBufferDescriptor);
 
-	constexpr wgpu::CommandEncoderDescriptor commandEncoder2Descriptor = {
-		.label = "My command encoder 2"
-	};
-	wgpu::CommandEncoder commandEncoder2 = _wgpuContext.device.CreateCommandEncoder(&commandEncoder2Descriptor);
-	const render::accumulator::descriptor::DoCommands doBaseColorAccumulatorRenderCommandsDescriptor = {
-		.commandEncoder = commandEncoder2,
-	};
-	_baseColorAccumulatorRender->doCommands(&doBaseColorAccumulatorRenderCommandsDescriptor);
-
-	const render::accumulator::descriptor::DoCommands doNormalAccumulatorRenderCommandsDescriptor = {
-		.commandEncoder = commandEncoder2,
-	};
-	_normalAccumulatorRender->doCommands(&doNormalAccumulatorRenderCommandsDescriptor);
-
-	const render::lighting::descriptor::DoCommands doLightingAccumulatorRenderCommandsDescriptor = {
-		.commandEncoder = commandEncoder2,
-	};
-	_lightingRender->doCommands(&doLightingAccumulatorRenderCommandsDescriptor);
-
-	const render::shadowMap::descriptor::DoCommands doShadowMapRenderCommandsDescriptor = {
-		.commandEncoder = commandEncoder2,
-		.vertexBuffer = _deviceResources->scene->vbo,
-		.indexBuffer = _deviceResources->scene->indices,
-		.drawCalls = _drawCalls,
-		.shadowMapTextureViews = _deviceResources->render->shadowMapTextureViews,
-	};
-	_shadowMapRender->doCommands(&doShadowMapRenderCommandsDescriptor);
+	_frameStats->endPhase(enums::CpuPhase::ENCODE);
 
-	const render::shadowToCamera::descriptor::DoCommands doShadowToCameraRenderCommandsDescriptor = {
-		.commandEncoder = commandEncoder2,
-	};
-	_shadowToCamera->doCommands(&doShadowToCameraRenderCommandsDescriptor);
-
-	const render::ultimate::descriptor::DoCommands doUltimateRenderCommandsDescriptor = {
-		.commandEncoder = commandEncoder2,
-	};
-	_ultimateRender->doCommands(&doUltimateRenderCommandsDescriptor);
-
-	const render::toSurface::descriptor::DoCommands doToSurfaceRenderCommandsDescriptor = {
-		.commandEncoder = commandEncoder2,
-		.surfaceTextureView = surfaceTextureView,
-	};
-	_toSurfaceRender->doCommands(&doToSurfaceRenderCommandsDescriptor);
-
-	constexpr wgpu::CommandBufferDescriptor commandBuffer2Descriptor = {
-		.label = "Command Buffer 2",
-	};
-	wgpu::CommandBuffer commandBuffer2 = commandEncoder2.Finish(&commandBuffer2Descriptor);
-
-	std::array<wgpu::CommandBuffer, 2> commandBuffers = {
-		commandBuffer,
-		commandBuffer2,
-	};
-
-	_wgpuContext.queue.Submit(commandBuffers.size(), commandBuffers.data());
+	_wgpuContext.queue.Submit(1, &commandBuffer);
+	_frameStats->endPhase(enums::CpuPhase::SUBMIT);
+	_frameStats->submitted();
+	_framePacer->endFrame();
+	_stagingBelt->submitted();
+	_gpuProfiler->endFrame();
 
 	_wgpuContext.device.Tick();
 
@@ -239,23 +435,36 @@ void Engine::draw() {
 			std::cerr << std::format("Error: {} \r\n", message.data);
 		});
 
-	_wgpuContext.surface.Present();
-
+	if (!_wgpuContext.isHeadless()) {
+		_wgpuContext.surface.Present();
+	}
+	_frameStats->endPhase(enums::CpuPhase::PRESENT);
+	_frameStats->endFrame();
 }
 	
+//Every owner untracks its buffers and textures, the memory registry reports what is left once _wgpuContext is destroyed
 Engine::~Engine() {
+	delete _deviceResources->render;
+	delete _deviceResources->scene;
 	delete _deviceResources;
+	delete _frameGraph;
+	delete _cullingRender;
 	delete _initialRender;
 	delete _shadowMapRender;
-	delete _shadowToCamera;
 	delete _baseColorAccumulatorRender;
 	delete _normalAccumulatorRender;
+	delete _lightCullingRender;
 	delete _lightingRender;
 	delete _ultimateRender;
 	delete _toSurfaceRender;
-	delete _clearLightingRender;
+	delete _gpuProfiler;
+	delete _frameStats;
+	delete _stagingBelt;
+	delete _framePacer;
 
 	//device and gpu object destruction is done by dawn destructor
-	_wgpuContext.surface.Unconfigure();
-	SDL_Quit();
+	if (!_wgpuContext.isHeadless()) {
+		_wgpuContext.surface.Unconfigure();
+		SDL_Quit();
+	}
 }
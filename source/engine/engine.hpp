@@ -1,43 +1,71 @@
 #pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
 #include "../device/device.hpp"
 #include "../wgpuContext/wgpuContext.hpp"
 #include "../render/initial.hpp"
-#include "../render/shadowToCamera.hpp"
 #include "../render/shadowMap.hpp"
 #include "../render/accumulator/fourChannel.hpp"
+#include "../render/accumulator/octahedralNormal.hpp"
 #include "../render/ultimate.hpp"
 #include "../render/toSurface.hpp"
+#include "../render/lightCulling.hpp"
 #include "../render/lighting.hpp"
-#include "../render/clear.hpp"
+#include "../render/culling.hpp"
+#include "../render/frameGraph.hpp"
 #include "../device/resources.hpp"
+#include "../device/framePacer.hpp"
+#include "../device/stagingBelt.hpp"
+#include "../profiler/gpuProfiler.hpp"
+#include "../profiler/frameStats.hpp"
+#include "options.hpp"
 
 class Engine {
 
 public:
-	Engine();
+	Engine(const engine::Options& options = {});
 	~Engine();
-	void run();
+	//beforeFrame is called with the index of each frame before it is drawn, e.g. to move lights
+	void run(const std::function<void(uint32_t)>& beforeFrame = nullptr);
+	const std::vector<structs::Light>& getLights() const;
+	//See SceneResources::updateLight, cached shadow maps of moved lights are redrawn
+	void updateLight(const uint32_t lightIndex, const structs::Light& light);
+	//See SceneResources::markGeometryChanged
+	void markGeometryChanged();
+	//Valid once run() has returned, empty unless Options::collectFrameStats is set
+	const FrameStats* getFrameStats() const;
+	const GpuProfiler* getGpuProfiler() const;
+	const WGPUContext* getWGPUContext() const;
+	//Construction time, from device creation until every pipeline is built
+	double getStartupMilliseconds() const;
 
 private:
-	const std::string gltfDirectory = "models/monoBox/"; //must end with "/"
-	const std::string gltfFileName = "cornellbox.gltf";
-//	const std::string gltfDirectory = "models/avocado/"; // must end with "/"
-// const std::string gltfFileName = "avocado2.gltf";
-//	const std::string gltfDirectory = "models/boombox/"; //must end with "/"
-//	const std::string gltfFileName = "BoomBoxWithAxes.gltf";
-
+	engine::Options _options;
+	//Declared before _wgpuContext so it is initialized first and the startup time includes device creation
+	std::chrono::steady_clock::time_point _constructionStart = std::chrono::steady_clock::now();
+	double _startupMilliseconds = 0.0;
 	WGPUContext _wgpuContext;
 	DeviceResources* _deviceResources;
+	render::FrameGraph* _frameGraph;
+	render::Culling* _cullingRender;
 	render::Initial* _initialRender;
 	render::ShadowMap* _shadowMapRender;
-	render::ShadowToCamera* _shadowToCamera;
 	render::FourChannel* _baseColorAccumulatorRender;
-	render::FourChannel* _normalAccumulatorRender;
+	render::OctahedralNormal* _normalAccumulatorRender;
+	render::LightCulling* _lightCullingRender;
 	render::Lighting* _lightingRender;
 	render::Ultimate* _ultimateRender;
 	render::ToSurface* _toSurfaceRender;
-	render::Clear* _clearLightingRender;
-	std::vector<structs::host::DrawCall> _drawCalls;
+	GpuProfiler* _gpuProfiler;
+	FrameStats* _frameStats;
+	FramePacer* _framePacer;
+	StagingBelt* _stagingBelt;
+	std::vector<structs::host::H_Camera> _cameras;
+	std::vector<glm::f32mat4x4> _projectionViews;
+	std::vector<glm::f32mat4x4> _inverseProjectionViews;
 
 	void draw();
+	void uploadFrameData();
 };
@@ -0,0 +1,120 @@
+#pragma once
+#include "options.hpp"
+#include <filesystem>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+	constexpr uint32_t DEFAULT_HEADLESS_FRAME_COUNT = 100;
+
+	const std::unordered_map<std::string_view, wgpu::BackendType> backendTypes = {
+		{ "d3d12", wgpu::BackendType::D3D12 },
+		{ "d3d11", wgpu::BackendType::D3D11 },
+		{ "vulkan", wgpu::BackendType::Vulkan },
+		{ "metal", wgpu::BackendType::Metal },
+		{ "opengl", wgpu::BackendType::OpenGL },
+		{ "opengles", wgpu::BackendType::OpenGLES },
+		{ "null", wgpu::BackendType::Null },
+	};
+
+	const std::unordered_map<std::string_view, enums::MeshOptimization> meshOptimizations = {
+		{ "off", enums::MeshOptimization::NONE },
+		{ "cache", enums::MeshOptimization::VERTEX_CACHE },
+		{ "overdraw", enums::MeshOptimization::OVERDRAW },
+	};
+
+	//Returns the text after "name=" or an empty view when the argument is a different option
+	std::string_view getValue(std::string_view argument, std::string_view name) {
+		if (argument.size() <= name.size() || !argument.starts_with(name) || argument[name.size()] != '=') {
+			return {};
+		}
+		return argument.substr(name.size() + 1);
+	}
+}
+
+namespace engine {
+	Options parseOptions(int argc, char* argv[]) {
+		Options options;
+		for (int i = 1; i < argc; ++i) {
+			const std::string_view argument = argv[i];
+			if (argument == "--headless") {
+				options.context.headless = true;
+			}
+			else if (argument == "--occlusion-culling") {
+				options.occlusionCulling = true;
+			}
+			else if (argument == "--quantize-vertices") {
+				options.quantizeVertices = true;
+			}
+			else if (argument == "--no-shadow-cache") {
+				options.cacheShadowMaps = false;
+			}
+			else if (const std::string_view scene = getValue(argument, "--scene"); !scene.empty()) {
+				const std::filesystem::path scenePath = std::filesystem::path(scene);
+				if (!scenePath.has_filename()) {
+					throw std::invalid_argument("scene is not a file: " + std::string(scene));
+				}
+				options.gltfDirectory = scenePath.has_parent_path() ? scenePath.parent_path().generic_string() + "/" : "./";
+				options.gltfFileName = scenePath.filename().string();
+			}
+			else if (const std::string_view resolution = getValue(argument, "--resolution"); !resolution.empty()) {
+				const size_t separator = resolution.find('x');
+				if (separator == std::string_view::npos) {
+					throw std::invalid_argument("resolution must be <width>x<height>: " + std::string(resolution));
+				}
+				options.context.screenDimensions = {
+					.width = static_cast<uint32_t>(std::stoul(std::string(resolution.substr(0, separator)))),
+					.height = static_cast<uint32_t>(std::stoul(std::string(resolution.substr(separator + 1)))),
+				};
+			}
+			else if (const std::string_view frames = getValue(argument, "--frames"); !frames.empty()) {
+				options.frameCount = static_cast<uint32_t>(std::stoul(std::string(frames)));
+			}
+			else if (const std::string_view framesInFlight = getValue(argument, "--frames-in-flight"); !framesInFlight.empty()) {
+				options.framesInFlight = static_cast<uint32_t>(std::stoul(std::string(framesInFlight)));
+				if (options.framesInFlight == 0) {
+					throw std::invalid_argument("frames in flight must be at least 1");
+				}
+			}
+			else if (const std::string_view output = getValue(argument, "--output"); !output.empty()) {
+				options.outputPath = output;
+			}
+			else if (const std::string_view optimizeMeshes = getValue(argument, "--optimize-meshes"); !optimizeMeshes.empty()) {
+				const auto meshOptimization = meshOptimizations.find(optimizeMeshes);
+				if (meshOptimization == meshOptimizations.end()) {
+					throw std::invalid_argument("unknown mesh optimization: " + std::string(optimizeMeshes));
+				}
+				options.meshOptimization = meshOptimization->second;
+			}
+			else if (const std::string_view vramBudget = getValue(argument, "--vram-budget"); !vramBudget.empty()) {
+				options.context.memoryBudget = std::stoull(std::string(vramBudget)) * 1024 * 1024;
+			}
+			else if (const std::string_view pipelineCache = getValue(argument, "--pipeline-cache"); !pipelineCache.empty()) {
+				options.context.pipelineCacheDirectory = std::string(pipelineCache);
+			}
+			else if (const std::string_view adapter = getValue(argument, "--adapter"); !adapter.empty()) {
+				if (adapter != "gpu" && adapter != "cpu") {
+					throw std::invalid_argument("unknown adapter: " + std::string(adapter));
+				}
+				options.context.forceFallbackAdapter = adapter == "cpu";
+			}
+			else if (const std::string_view backend = getValue(argument, "--backend"); !backend.empty()) {
+				const auto backendType = backendTypes.find(backend);
+				if (backendType == backendTypes.end()) {
+					throw std::invalid_argument("unknown backend: " + std::string(backend));
+				}
+				options.context.backendType = backendType->second;
+			}
+			else {
+				throw std::invalid_argument("unknown option: " + std::string(argument));
+			}
+		}
+
+		//Without a window there is nothing to close, so headless always stops
+		if (options.context.headless && options.frameCount == 0) {
+			options.frameCount = DEFAULT_HEADLESS_FRAME_COUNT;
+		}
+		return options;
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include "../wgpuContext/wgpuContext.hpp"
+#include "../enums.hpp"
+
+namespace engine {
+	struct Options {
+		wgpuContext::descriptor::Create context;
+		std::string gltfDirectory = "models/monoBox/"; //must end with "/"
+		std::string gltfFileName = "cornellbox.gltf";
+//		std::string gltfDirectory = "models/avocado/"; // must end with "/"
+//		std::string gltfFileName = "avocado2.gltf";
+//		std::string gltfDirectory = "models/boombox/"; //must end with "/"
+//		std::string gltfFileName = "BoomBoxWithAxes.gltf";
+		uint32_t frameCount = 0; //0 renders until the window is closed
+		std::string outputPath; //the last frame's ultimate texture is written here as a png when set
+		bool collectFrameStats = false; //keeps the CPU timings of every frame, see FrameStats
+		uint32_t framesInFlight = 2; //1 for the lowest latency, more to let CPU encoding overlap the GPU, see FramePacer
+		bool occlusionCulling = false; //cull against the previous frame's depth as well as the view frustums, see render::Culling
+		enums::MeshOptimization meshOptimization = enums::MeshOptimization::NONE;
+		bool quantizeVertices = false; //16 byte vertices instead of 32, see structs::QuantizedVBO
+		bool cacheShadowMaps = true; //redraw a shadow map only when its light or the scene geometry changed, see render::ShadowMap
+	};
+
+	//--headless                        render offscreen without a window, stops after 100 frames unless --frames is given
+	//--scene=<path/to/scene.gltf>
+	//--resolution=<width>x<height>
+	//--frames=<count>                  stop after count frames
+	//--output=<file.png>               write the last frame to file.png
+	//--frames-in-flight=<count>        how many frames the CPU may encode ahead of the GPU
+	//--occlusion-culling               also cull what the previous frame's depth hides from the camera
+	//--quantize-vertices              draw 16 bit positions, normals and texcoords instead of 32 bit floats
+	//--no-shadow-cache                 redraw every shadow map every frame
+	//--optimize-meshes=<off|cache|overdraw>  reorder the scene's triangles and vertices while loading it
+	//--vram-budget=<MiB>               warn once the tracked buffers and textures exceed the budget, see MemoryRegistry
+	//--pipeline-cache=<directory>      keep compiled shaders and pipelines in directory between runs, off by default
+	//--adapter=<gpu|cpu>               cpu forces dawn's fallback adapter (SwiftShader)
+	//--backend=<d3d12|d3d11|vulkan|metal|opengl|opengles|null>
+	Options parseOptions(int argc, char* argv[]);
+}
@@ -15,6 +15,66 @@ namespace enums {
 		HAS_METALLIC_ROUGHNESS_TEXTURE = 1,
 	};
 
+	//Index of each pass in the GpuProfiler
+	enum GpuPass {
+		INITIAL = 0,
+		LIGHT_CULLING = 1,
+		BASE_COLOR_ACCUMULATOR = 2,
+		NORMAL_ACCUMULATOR = 3,
+		LIGHTING = 4,
+		SHADOW_MAP = 5,
+		ULTIMATE = 6,
+		TO_SURFACE = 7,
+		CULLING = 8,
+		HI_Z = 9,
+		GPU_PASS_COUNT = 10,
+	};
+
+	//What passes hand to each other within a frame, see render::FrameGraph. Only the textures among them are allocated by the
+	//graph, the buffers and the surface are there to order the passes
+	enum class FrameResource {
+		DEPTH = 0,
+		NORMAL = 1,
+		TEX_COORD = 2,
+		BASE_COLOR = 3,
+		TEXTURE_IDS = 4,
+		LIGHTING = 5,
+		SHADOW_ATLAS = 6,
+		ULTIMATE = 7,
+		SURFACE = 8,
+		CULLED_DRAWS = 9,
+		HI_Z = 10,
+		TILE_LIGHTS = 11,
+		FRAME_RESOURCE_COUNT = 12,
+	};
+
+	//Index of each phase of Engine::draw in FrameStats
+	enum CpuPhase {
+		FRAME_WAIT = 0,
+		ACQUIRE = 1,
+		ENCODE = 2,
+		SUBMIT = 3,
+		PRESENT = 4,
+		CPU_PHASE_COUNT = 5,
+	};
+
+	//Usage of a buffer or texture in the MemoryRegistry
+	enum MemoryCategory {
+		GBUFFER = 0, //screen sized render targets and per tile buffers, they grow with the resolution
+		SHADOW = 1,
+		SCENE = 2, //geometry, materials, lights and the texture array of the loaded glTF
+		STAGING = 3, //upload and readback memory
+		OTHER = 4,
+		MEMORY_CATEGORY_COUNT = 5,
+	};
+
+	//Import time reordering of the scene's primitives, see HostSceneResources
+	enum class MeshOptimization {
+		NONE = 0,
+		VERTEX_CACHE = 1, //reorders triangles for the post-transform cache, then vertices for fetch locality
+		OVERDRAW = 2, //VERTEX_CACHE, then sorts clusters of triangles front to back
+	};
+
 	//TODO: Fill this out with more Texture Types.
 	enum class MaterialProperty {
 		COLOR = 0,
@@ -7,9 +7,15 @@
 #include "absl/log/log.h"
 #include "../structs/host.hpp"
 #include "convert.hpp"
+#include <algorithm>
 #include <map>
 #include <cstdint>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <variant>
@@ -20,77 +26,277 @@
 #include "../host/host.hpp"
 #include "../enums.hpp"
 #include "../constants.hpp"
+#include "../threading/threadPool.hpp"
 
 namespace {
-	void addMeshData(HostSceneResources& objects, fastgltf::Asset& asset, glm::f32mat4x4& transform, uint32_t meshIndex) {
-		//		if (_meshIndexToDrawInfoMap.count(meshIndex)) {
-		//			++_meshIndexToDrawInfoMap[meshIndex]->instanceCount;
-		//			return;
-		//		};
+	struct MeshInstance {
+		glm::f32mat4x4 transform;
+		uint32_t meshIndex;
+	};
 
-		auto& mesh = asset.meshes[meshIndex];
+	//Where one primitive's vertices and indices land in HostSceneResources, fixed before any conversion starts
+	//so the workers write disjoint ranges and the result does not depend on which worker finishes first
+	struct PrimitiveRange {
+		uint32_t meshIndex;
+		uint32_t primitiveIndex;
+		size_t vbosOffset;
+		size_t indicesOffset; //into indices16 or indices32, by indexFormat
+		size_t firstDrawIndex; //one draw per instance cluster of the mesh
+		size_t drawCount;
+		wgpu::IndexFormat indexFormat;
+	};
 
-		for (auto& primitive : mesh.primitives) {
-			const size_t vbosOffset = objects.vbo.size();
+	//The largest index of a primitive is one less than its vertex count
+	wgpu::IndexFormat getIndexFormat(const size_t vertexCount) {
+		return vertexCount <= size_t{ UINT16_MAX } + 1 ? wgpu::IndexFormat::Uint16 : wgpu::IndexFormat::Uint32;
+	}
 
-			objects.transforms.push_back(transform);
+	//Instances of a mesh are drawn in spatial clusters of at most this many, so culling can reject the ones out of view
+	constexpr size_t MAX_CLUSTER_INSTANCES = 64;
 
-			//vertice
+	//The transforms of one instance cluster, contiguous in HostSceneResources::transforms
+	struct InstanceCluster {
+		uint32_t firstTransform;
+		uint32_t transformCount;
+	};
+
+	//Reorders transforms so each cluster is contiguous, splitting at the median instance position along the longest axis
+	void clusterInstances(std::span<glm::f32mat4x4> transforms, std::vector<uint32_t>& outClusterSizes) {
+		if (transforms.size() <= MAX_CLUSTER_INSTANCES) {
+			outClusterSizes.push_back(static_cast<uint32_t>(transforms.size()));
+			return;
+		}
+		glm::f32vec3 positionMin = glm::f32vec3(std::numeric_limits<float>::max());
+		glm::f32vec3 positionMax = glm::f32vec3(std::numeric_limits<float>::lowest());
+		for (const glm::f32mat4x4& transform : transforms) {
+			positionMin = glm::min(positionMin, glm::f32vec3(transform[3]));
+			positionMax = glm::max(positionMax, glm::f32vec3(transform[3]));
+		}
+		const glm::f32vec3 extent = positionMax - positionMin;
+		const glm::length_t axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+		const size_t half = transforms.size() / 2;
+		std::nth_element(transforms.begin(), transforms.begin() + half, transforms.end(), [axis](const glm::f32mat4x4& a, const glm::f32mat4x4& b) {
+			return a[3][axis] < b[3][axis];
+		});
+		clusterInstances(transforms.first(half), outClusterSizes);
+		clusterInstances(transforms.subspan(half), outClusterSizes);
+	}
+
+	//World space box around every instance of a cluster from the box of its local positions
+	structs::DrawBounds getDrawBounds(std::span<const glm::f32mat4x4> transforms, const glm::f32vec3& localMin, const glm::f32vec3& localMax) {
+		glm::f32vec3 worldMin = glm::f32vec3(std::numeric_limits<float>::max());
+		glm::f32vec3 worldMax = glm::f32vec3(std::numeric_limits<float>::lowest());
+		for (const glm::f32mat4x4& transform : transforms) {
+			for (uint32_t corner = 0; corner < 8; ++corner) {
+				const glm::f32vec4 localCorner = {
+					(corner & 1) ? localMax.x : localMin.x,
+					(corner & 2) ? localMax.y : localMin.y,
+					(corner & 4) ? localMax.z : localMin.z,
+					1.0f,
+				};
+				const glm::f32vec3 worldCorner = glm::f32vec3(transform * localCorner);
+				worldMin = glm::min(worldMin, worldCorner);
+				worldMax = glm::max(worldMax, worldCorner);
+			}
+		}
+		return structs::DrawBounds{
+			.center = (worldMin + worldMax) * 0.5f,
+			.extent = (worldMax - worldMin) * 0.5f,
+		};
+	}
+
+	//Appends the per draw data serially and reserves space for the vertices and indices of the primitives that use indexFormat.
+	//Each primitive is laid out once and drawn once per instance cluster. The primitives of a mesh share the transforms of
+	//its clusters, each draw gets a contiguous range of instances that starts at its firstInstance
+	void addMeshLayout(
+		HostSceneResources& objects,
+		fastgltf::Asset& asset,
+		const uint32_t meshIndex,
+		const std::vector<InstanceCluster>& clusters,
+		const wgpu::IndexFormat indexFormat,
+		std::vector<PrimitiveRange>& primitiveRanges
+	) {
+		auto& mesh = asset.meshes[meshIndex];
+
+		for (uint32_t primitiveIndex = 0; primitiveIndex < mesh.primitives.size(); ++primitiveIndex) {
+			auto& primitive = mesh.primitives[primitiveIndex];
 			fastgltf::Attribute& positionAttribute = *primitive.findAttribute("POSITION");
 			fastgltf::Accessor& positionAccessor = asset.accessors[positionAttribute.accessorIndex];
+			if (getIndexFormat(positionAccessor.count) != indexFormat) {
+				continue;
+			}
+			const size_t vbosOffset = objects.vbo.size();
 			objects.vbo.resize(objects.vbo.size() + positionAccessor.count);
-			fastgltf::iterateAccessorWithIndex<fastgltf::math::f32vec3>(
-				asset, positionAccessor, [&](fastgltf::math::f32vec3 vertex, size_t i) {
-					memcpy(&objects.vbo[i + vbosOffset].vertex, &vertex, sizeof(glm::f32vec3));
+
+			if (!primitive.indicesAccessor.has_value()) {
+				LOG(FATAL) << "no indices accessor value";
+			}
+			auto& accessor = asset.accessors[primitive.indicesAccessor.value()];
+			size_t indicesOffset = 0;
+			if (indexFormat == wgpu::IndexFormat::Uint16) {
+				indicesOffset = objects.indices16.size();
+				objects.indices16.resize(objects.indices16.size() + accessor.count);
+			}
+			else {
+				indicesOffset = objects.indices32.size();
+				objects.indices32.resize(objects.indices32.size() + accessor.count);
+			}
+
+			const uint32_t materialIndex = static_cast<uint32_t>(primitive.materialIndex.value_or(UINT32_MAX));
+			const size_t firstDrawIndex = objects.drawCalls.size();
+			for (const InstanceCluster& cluster : clusters) {
+				const size_t firstInstance = objects.instances.size();
+				for (uint32_t i = 0; i < cluster.transformCount; ++i) {
+					objects.instances.push_back(structs::Instance{
+						.transformIndex = cluster.firstTransform + i,
+						.materialIndex = materialIndex,
+					});
+				}
+
+				const structs::host::DrawCall drawCall = {
+					.indexCount = static_cast<uint32_t>(accessor.count),
+					.instanceCount = cluster.transformCount,
+					.firstIndex = static_cast<uint32_t>(indicesOffset),
+					.baseVertex = static_cast<uint32_t>(vbosOffset),
+					.firstInstance = static_cast<uint32_t>(firstInstance),
+				};
+				objects.drawCalls.emplace_back(drawCall);
+				objects.drawBounds.emplace_back(); //filled by convertPrimitive
+				objects.drawMeshIndices.push_back(meshIndex);
+			}
+
+			primitiveRanges.push_back(PrimitiveRange{
+				.meshIndex = meshIndex,
+				.primitiveIndex = primitiveIndex,
+				.vbosOffset = vbosOffset,
+				.indicesOffset = indicesOffset,
+				.firstDrawIndex = firstDrawIndex,
+				.drawCount = clusters.size(),
+				.indexFormat = indexFormat,
+			});
+		}
+	}
+
+	//Runs on a worker, only writes inside the primitive's range
+	void convertPrimitive(HostSceneResources& objects, fastgltf::Asset& asset, const PrimitiveRange& range) {
+		auto& primitive = asset.meshes[range.meshIndex].primitives[range.primitiveIndex];
+		const size_t vbosOffset = range.vbosOffset;
+
+		//vertice
+		fastgltf::Attribute& positionAttribute = *primitive.findAttribute("POSITION");
+		fastgltf::Accessor& positionAccessor = asset.accessors[positionAttribute.accessorIndex];
+		glm::f32vec3 localMin = glm::f32vec3(std::numeric_limits<float>::max());
+		glm::f32vec3 localMax = glm::f32vec3(std::numeric_limits<float>::lowest());
+		fastgltf::iterateAccessorWithIndex<fastgltf::math::f32vec3>(
+			asset, positionAccessor, [&](fastgltf::math::f32vec3 vertex, size_t i) {
+				glm::f32vec3& position = objects.vbo[i + vbosOffset].vertex;
+				memcpy(&position, &vertex, sizeof(glm::f32vec3));
+				localMin = glm::min(localMin, position);
+				localMax = glm::max(localMax, position);
+			}
+		);
+		if (positionAccessor.count > 0) {
+			for (size_t drawIndex = range.firstDrawIndex; drawIndex < range.firstDrawIndex + range.drawCount; ++drawIndex) {
+				const structs::host::DrawCall& drawCall = objects.drawCalls[drawIndex];
+				const std::span<const glm::f32mat4x4> clusterTransforms = std::span<const glm::f32mat4x4>(objects.transforms)
+					.subspan(objects.instances[drawCall.firstInstance].transformIndex, drawCall.instanceCount);
+				objects.drawBounds[drawIndex] = getDrawBounds(clusterTransforms, localMin, localMax);
+			}
+		}
+
+		//normal
+		fastgltf::Attribute& normalAttribute = *primitive.findAttribute("NORMAL");
+		fastgltf::Accessor& normalAccessor = asset.accessors[normalAttribute.accessorIndex];
+		fastgltf::iterateAccessorWithIndex<fastgltf::math::f32vec3>(
+			asset, normalAccessor, [&](fastgltf::math::f32vec3 normal, size_t i) {
+				memcpy(&objects.vbo[i + vbosOffset].normal, &normal, sizeof(glm::f32vec3));
+			}
+		);
+
+		//texcoord_0
+		fastgltf::Attribute* p_texcoordAttribute = primitive.findAttribute("TEXCOORD_0");
+		if (!p_texcoordAttribute->name.empty()) {
+			fastgltf::Accessor& texcoordAccessor = asset.accessors[p_texcoordAttribute->accessorIndex];
+			fastgltf::iterateAccessorWithIndex<fastgltf::math::f32vec2>(
+				asset, texcoordAccessor, [&](fastgltf::math::f32vec2 texcoord, size_t i) {
+					memcpy(&objects.vbo[i + vbosOffset].texcoord, &texcoord, sizeof(glm::f32vec2));
 				}
 			);
+		}
 
-			//normal
-			fastgltf::Attribute& normalAttribute = *primitive.findAttribute("NORMAL");
-			fastgltf::Accessor& normalAccessor = asset.accessors[normalAttribute.accessorIndex];
-			fastgltf::iterateAccessorWithIndex<fastgltf::math::f32vec3>(
-				asset, normalAccessor, [&](fastgltf::math::f32vec3 normal, size_t i) {
-					memcpy(&objects.vbo[i + vbosOffset].normal, &normal, sizeof(glm::f32vec3));
+		//indice, read as uint32_t so uint8, uint16 and uint32 accessors all convert
+		auto& accessor = asset.accessors[primitive.indicesAccessor.value()];
+		if (range.indexFormat == wgpu::IndexFormat::Uint16) {
+			fastgltf::iterateAccessorWithIndex<uint32_t>(
+				asset, accessor, [&](uint32_t index, size_t i) {
+					objects.indices16[i + range.indicesOffset] = static_cast<uint16_t>(index);
 				}
 			);
+		}
+		else {
+			fastgltf::iterateAccessorWithIndex<uint32_t>(
+				asset, accessor, [&](uint32_t index, size_t i) {
+					objects.indices32[i + range.indicesOffset] = index;
+				}
+			);
+		}
+	}
 
-			//texcoord_0
-			//fastgltf::Attribute& texcoordAttribute = 
-			fastgltf::Attribute* p_texcoordAttribute = primitive.findAttribute("TEXCOORD_0");
-			if (!p_texcoordAttribute->name.empty()) {
-				fastgltf::Accessor& texcoordAccessor = asset.accessors[p_texcoordAttribute->accessorIndex];
-				fastgltf::iterateAccessorWithIndex<fastgltf::math::f32vec2>(
-					asset, texcoordAccessor, [&](fastgltf::math::f32vec2 texcoord, size_t i) {
-						memcpy(&objects.vbo[i + vbosOffset].texcoord, &texcoord, sizeof(glm::f32vec2));
-					}
-				);
+	void addMeshData(HostSceneResources& objects, fastgltf::Asset& asset, const std::vector<MeshInstance>& meshInstances, ThreadPool& threadPool) {
+		//Nodes sharing a mesh become instances of it, meshes keep the order they are first referenced in
+		std::vector<uint32_t> meshOrder;
+		std::map<uint32_t, std::vector<glm::f32mat4x4>> meshTransforms;
+		for (const MeshInstance& meshInstance : meshInstances) {
+			const auto [transforms, inserted] = meshTransforms.try_emplace(meshInstance.meshIndex);
+			if (inserted) {
+				meshOrder.push_back(meshInstance.meshIndex);
 			}
+			transforms->second.push_back(meshInstance.transform);
+		}
 
-			//indice
-			if (!primitive.indicesAccessor.has_value()) {
-				LOG(FATAL) << "no indices accessor value";
+		//The transforms of each mesh are stored once, cluster by cluster, whatever the index format of its primitives
+		std::map<uint32_t, std::vector<InstanceCluster>> meshClusters;
+		for (const uint32_t meshIndex : meshOrder) {
+			std::vector<glm::f32mat4x4>& transforms = meshTransforms[meshIndex];
+			std::vector<uint32_t> clusterSizes;
+			clusterInstances(transforms, clusterSizes);
+			std::vector<InstanceCluster>& clusters = meshClusters[meshIndex];
+			uint32_t firstTransform = static_cast<uint32_t>(objects.transforms.size());
+			for (const uint32_t clusterSize : clusterSizes) {
+				clusters.push_back(InstanceCluster{ .firstTransform = firstTransform, .transformCount = clusterSize });
+				firstTransform += clusterSize;
 			}
-			auto& accessor = asset.accessors[primitive.indicesAccessor.value()];
-			size_t indicesOffset = objects.indices.size();
-			objects.indices.resize(objects.indices.size() + accessor.count);
-			fastgltf::iterateAccessorWithIndex<uint16_t>(
-				asset, accessor, [&](uint16_t index, size_t i) {
-					objects.indices[i + indicesOffset] = static_cast<uint16_t>(vbosOffset) + index;
-				}
-			);
+			objects.transforms.insert(objects.transforms.end(), transforms.begin(), transforms.end());
+		}
 
-			//material indices
-			objects.materialIndices.emplace_back(static_cast<uint32_t>(primitive.materialIndex.value_or(UINT32_MAX)));
-
-			//drawCall
-			const structs::host::DrawCall drawCall = {
-				.indexCount = static_cast<uint32_t>(accessor.count),
-				.instanceCount = 1, //TODO handle multiple instances
-				.firstIndex = static_cast<uint32_t>(indicesOffset),
-				.firstInstance = static_cast<uint32_t>(objects.drawCalls.size()),
-			};
-			objects.drawCalls.emplace_back(drawCall);
-			//_meshIndexToDrawInfoMap.insert(std::make_pair(meshIndex, &objects.drawCalls.emplace_back(drawCall)));
+		//Every Uint16 draw before every Uint32 draw, so each index format is one contiguous run of drawCalls
+		std::vector<PrimitiveRange> primitiveRanges;
+		for (const wgpu::IndexFormat indexFormat : { wgpu::IndexFormat::Uint16, wgpu::IndexFormat::Uint32 }) {
+			for (const uint32_t meshIndex : meshOrder) {
+				addMeshLayout(objects, asset, meshIndex, meshClusters[meshIndex], indexFormat, primitiveRanges);
+			}
+			if (indexFormat == wgpu::IndexFormat::Uint16) {
+				objects.uint16DrawCount = static_cast<uint32_t>(objects.drawCalls.size());
+			}
+		}
+		LOG(INFO) << meshInstances.size() << " mesh instances of " << meshOrder.size() << " meshes in " << objects.drawCalls.size() << " draws, "
+			<< objects.drawCalls.size() - objects.uint16DrawCount << " with 32 bit indices";
+
+		std::vector<std::future<void>> conversions;
+		conversions.reserve(primitiveRanges.size());
+		for (const PrimitiveRange& range : primitiveRanges) {
+			conversions.push_back(threadPool.submit([&objects, &asset, range]() {
+				convertPrimitive(objects, asset, range);
+			}));
+		}
+		//get() rethrows the first failure in primitive order
+		ThreadPool::waitForAll(conversions);
+		for (std::future<void>& conversion : conversions) {
+			conversion.get();
+		}
+		//Buffer writes must be a multiple of 4 bytes, no draw reads the padding
+		if (objects.indices16.size() % 2 != 0) {
+			objects.indices16.push_back(0);
 		}
 	}
 
@@ -151,14 +357,18 @@ namespace {
 		objects.cameras.push_back(h_camera);
 	}
 
-	void processNodes(HostSceneResources& object, fastgltf::Asset& asset, const std::array<uint32_t, 2> screenDimensions) {
+	//Meshes are only collected here, they are converted afterwards by addMeshData
+	void processNodes(HostSceneResources& object, fastgltf::Asset& asset, const std::array<uint32_t, 2> screenDimensions, std::vector<MeshInstance>& meshInstances) {
 		const size_t sceneIndex = asset.defaultScene.value_or(0);
 		fastgltf::iterateSceneNodes(asset, sceneIndex, fastgltf::math::fmat4x4(),
 			[&](fastgltf::Node& node, fastgltf::math::fmat4x4 m) {
 				glm::f32mat4x4 matrix = reinterpret_cast<glm::f32mat4x4&>(m);
 
 				if (node.meshIndex.has_value()) {
-					addMeshData(object, asset, matrix, static_cast<uint32_t>(node.meshIndex.value()));
+					meshInstances.push_back(MeshInstance{
+						.transform = matrix,
+						.meshIndex = static_cast<uint32_t>(node.meshIndex.value()),
+					});
 					return;
 				}
 				else if (node.lightIndex.has_value()) {
@@ -190,14 +400,18 @@ namespace {
 	}
 
 	//texture is gltf name - stp will be DawnEngine name.
+	//KHR_texture_basisu images are preferred over the fallback image, they can always be transcoded
 	void addSamplerTexturePair(const fastgltf::Texture& inputTexture, structs::SamplerTexturePair& outputStp) {
-		if (!inputTexture.imageIndex.has_value()) {
+		const fastgltf::Optional<std::size_t> imageIndex = inputTexture.basisuImageIndex.has_value()
+			? inputTexture.basisuImageIndex
+			: inputTexture.imageIndex;
+		if (!imageIndex.has_value()) {
 			LOG(ERROR) << "cannot add stp - missing image index";
 		}
 
 		const structs::SamplerTexturePair samplerTexturePair = {
 			.samplerIndex = static_cast<uint32_t>(inputTexture.samplerIndex.value_or(UINT32_MAX)),
-			.textureIndex = static_cast<uint32_t>(inputTexture.imageIndex.value()),
+			.textureIndex = static_cast<uint32_t>(imageIndex.value()),
 		};
 		outputStp = samplerTexturePair;
 	}
@@ -224,8 +438,41 @@ namespace {
 	}
 }
 
+namespace {
+	//fastgltf reads external buffers one after another while parsing, they are read here in parallel instead
+	void loadExternalBuffers(fastgltf::Asset& asset, const std::string& gltfDirectory, ThreadPool& threadPool) {
+		std::vector<std::future<void>> loads;
+		for (fastgltf::Buffer& buffer : asset.buffers) {
+			const fastgltf::sources::URI* uri = std::get_if<fastgltf::sources::URI>(&buffer.data);
+			if (uri == nullptr) {
+				continue;
+			}
+			if (!uri->uri.isLocalPath()) {
+				throw std::runtime_error("unsupported gltf buffer uri: " + std::string(uri->uri.string()));
+			}
+			const std::filesystem::path path = std::filesystem::path(gltfDirectory) / uri->uri.fspath();
+			loads.push_back(threadPool.submit([&buffer, path, fileByteOffset = uri->fileByteOffset, mimeType = uri->mimeType]() {
+				std::ifstream file(path, std::ios::binary);
+				file.seekg(static_cast<std::streamoff>(fileByteOffset));
+				fastgltf::sources::Vector vector;
+				vector.bytes.resize(buffer.byteLength);
+				vector.mimeType = mimeType;
+				file.read(reinterpret_cast<char*>(vector.bytes.data()), static_cast<std::streamsize>(buffer.byteLength));
+				if (!file) {
+					throw std::runtime_error("failed to read gltf buffer: " + path.string());
+				}
+				buffer.data = std::move(vector);
+			}));
+		}
+		ThreadPool::waitForAll(loads);
+		for (std::future<void>& load : loads) {
+			load.get();
+		}
+	}
+}
+
 namespace gltf {
-	fastgltf::Asset getAsset(const std::string& gltfDirectory, const std::string& gltfFileName) {
+	fastgltf::Asset getAsset(const std::string& gltfDirectory, const std::string& gltfFileName, ThreadPool& threadPool) {
 		fastgltf::Parser parser = fastgltf::Parser::Parser(fastgltf::Extensions::KHR_lights_punctual | fastgltf::Extensions::KHR_texture_basisu);
 
 		std::string gltfFilePath = gltfDirectory + gltfFileName;
@@ -234,16 +481,20 @@ namespace gltf {
 			LOG(ERROR) << "can't load gltf file";
 		}
 
-		auto wholeGltf = parser.loadGltf(gltfFile.get(), gltfDirectory, fastgltf::Options::LoadExternalBuffers);
+		auto wholeGltf = parser.loadGltf(gltfFile.get(), gltfDirectory, fastgltf::Options::None);
 		if (wholeGltf.error() != fastgltf::Error::None) {
 			LOG(ERROR) << "can't load whole gltf";
 		}
 
-		return std::move(wholeGltf.get());
+		fastgltf::Asset asset = std::move(wholeGltf.get());
+		loadExternalBuffers(asset, gltfDirectory, threadPool);
+		return asset;
 	}
 
-	void processAsset(HostSceneResources& hostObjects, fastgltf::Asset& asset, std::array<uint32_t, 2> screenDimensions, const std::string gltfDirectory) {
-		processNodes(hostObjects, asset, screenDimensions);
+	void processAsset(HostSceneResources& hostObjects, fastgltf::Asset& asset, std::array<uint32_t, 2> screenDimensions, const std::string gltfDirectory, ThreadPool& threadPool) {
+		std::vector<MeshInstance> meshInstances;
+		processNodes(hostObjects, asset, screenDimensions, meshInstances);
+		addMeshData(hostObjects, asset, meshInstances, threadPool);
 
 		hostObjects.materials.resize(asset.materials.size());
 		for (uint32_t i = 0; i < hostObjects.materials.size(); ++i) {
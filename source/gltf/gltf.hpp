@@ -1,8 +1,11 @@
 #pragma once
 #include "fastgltf/types.hpp"
 #include "../host/host.hpp"
+#include "../threading/threadPool.hpp"
 
 namespace gltf {
-	fastgltf::Asset getAsset(const std::string& gltfDirectory, const std::string& gltfFilePath);
-	void processAsset(HostSceneResources& sceneResources, fastgltf::Asset& asset, std::array<uint32_t, 2> screenDimensions, const std::string gltfDirectory);
+	//External buffers are read on threadPool
+	fastgltf::Asset getAsset(const std::string& gltfDirectory, const std::string& gltfFilePath, ThreadPool& threadPool);
+	//Primitives are converted on threadPool, the output is identical to a serial import
+	void processAsset(HostSceneResources& sceneResources, fastgltf::Asset& asset, std::array<uint32_t, 2> screenDimensions, const std::string gltfDirectory, ThreadPool& threadPool);
 };
\ No newline at end of file
@@ -2,16 +2,81 @@
 #include "host.hpp"
 #include "../device/device.hpp"
 #include "../gltf/gltf.hpp"
+#include "../threading/threadPool.hpp"
+#include "meshOptimizer.hpp"
+#include "packing.hpp"
+#include "../constants.hpp"
+#include "absl/log/log.h"
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <set>
+#include <span>
+#include <stdexcept>
+#include <future>
 #include <glm/ext/matrix_clip_space.hpp>
 
+namespace {
+	struct OptimizeStats {
+		uint64_t triangleCount = 0;
+		uint64_t missesBefore = 0;
+		uint64_t missesAfter = 0;
+	};
+
+	//The bounds of every vertex range of one mesh, so its primitives and all its instances share one quantization
+	structs::VertexQuantization getVertexQuantization(std::span<const structs::VBO> vbo, const std::map<uint32_t, uint32_t>& vertexRanges) {
+		glm::f32vec3 positionMin = glm::f32vec3(std::numeric_limits<float>::max());
+		glm::f32vec3 positionMax = glm::f32vec3(std::numeric_limits<float>::lowest());
+		glm::f32vec2 texcoordMin = glm::f32vec2(std::numeric_limits<float>::max());
+		glm::f32vec2 texcoordMax = glm::f32vec2(std::numeric_limits<float>::lowest());
+		for (const auto& [baseVertex, vertexCount] : vertexRanges) {
+			for (const structs::VBO& vertex : vbo.subspan(baseVertex, vertexCount)) {
+				positionMin = glm::min(positionMin, vertex.vertex);
+				positionMax = glm::max(positionMax, vertex.vertex);
+				texcoordMin = glm::min(texcoordMin, vertex.texcoord);
+				texcoordMax = glm::max(texcoordMax, vertex.texcoord);
+			}
+		}
+		return structs::VertexQuantization{
+			.positionMin = positionMin,
+			.positionScale = positionMax - positionMin,
+			.texcoordMin = texcoordMin,
+			.texcoordScale = texcoordMax - texcoordMin,
+		};
+	}
+
+	void quantizeVertices(std::span<const structs::VBO> vertices, const structs::VertexQuantization& quantization, std::span<structs::QuantizedVBO> quantizedVertices) {
+		for (size_t i = 0; i < vertices.size(); ++i) {
+			const structs::VBO& vertex = vertices[i];
+			structs::QuantizedVBO& quantizedVertex = quantizedVertices[i];
+			//A flat axis has a scale of 0 and dequantizes to its min whatever is stored
+			for (glm::length_t c = 0; c < 3; ++c) {
+				quantizedVertex.vertex[c] = quantization.positionScale[c] > 0.0f ? packing::quantizeUnorm16((vertex.vertex[c] - quantization.positionMin[c]) / quantization.positionScale[c]) : uint16_t{ 0 };
+			}
+			quantizedVertex.vertex.w = 0;
+			for (glm::length_t c = 0; c < 2; ++c) {
+				quantizedVertex.texcoord[c] = quantization.texcoordScale[c] > 0.0f ? packing::quantizeUnorm16((vertex.texcoord[c] - quantization.texcoordMin[c]) / quantization.texcoordScale[c]) : uint16_t{ 0 };
+			}
+			quantizedVertex.normal = packing::packOctahedralNormal(vertex.normal);
+		}
+	}
+}
+
 HostSceneResources::HostSceneResources(
 	const std::string& gltfDirectory,
 	const std::string& gltfFileName,
-	const std::array<uint32_t, 2> screenDimensions) {
-	fastgltf::Asset asset = gltf::getAsset(gltfDirectory, gltfFileName);
-	gltf::processAsset(*this, asset, screenDimensions, gltfDirectory);
+	const std::array<uint32_t, 2> screenDimensions,
+	ThreadPool& threadPool,
+	const enums::MeshOptimization meshOptimization,
+	const bool quantizeVertices) {
+	//Every task that reads asset is waited for before it goes out of scope, even when one of them throws
+	fastgltf::Asset asset = gltf::getAsset(gltfDirectory, gltfFileName, threadPool);
+	gltf::processAsset(*this, asset, screenDimensions, gltfDirectory, threadPool);
 	addDefaults(screenDimensions);
-	postProcessData();
+	postProcessData(meshOptimization, quantizeVertices, threadPool);
 };
 
 //defaults if none found
@@ -33,7 +98,17 @@ void HostSceneResources::addDefaults(const std::array<uint32_t, 2> screenDimensi
 	}
 }
 
-void HostSceneResources::postProcessData() {
+void HostSceneResources::postProcessData(const enums::MeshOptimization meshOptimization, const bool quantizeVertices, ThreadPool& threadPool) {
+	if (meshOptimization != enums::MeshOptimization::NONE) {
+		optimizeMeshes(meshOptimization, threadPool);
+	}
+	//After optimizeMeshes, which reorders vbo
+	if (quantizeVertices) {
+		addQuantizedVertices(threadPool);
+	}
+	if (samplerTexturePairs.size() >= constants::NO_TEXTURE_ID) {
+		throw std::runtime_error(std::format("{} sampler texture pairs do not fit the {} bit texture ids", samplerTexturePairs.size(), constants::TEXTURE_ID_BITS));
+	}
 	for (auto& m : materials) {
 		const uint32_t baseColorStpId = m.pbrMetallicRoughness.baseColorTextureInfo.index;
 		if (baseColorStpId != UINT32_MAX) {
@@ -49,3 +124,158 @@ void HostSceneResources::postProcessData() {
 		}
 	}
 }
+
+std::vector<uint32_t> HostSceneResources::getVertexCounts() const {
+	std::vector<uint32_t> baseVertices;
+	baseVertices.reserve(drawCalls.size() + 1);
+	for (const structs::host::DrawCall& drawCall : drawCalls) {
+		baseVertices.push_back(drawCall.baseVertex);
+	}
+	baseVertices.push_back(static_cast<uint32_t>(vbo.size()));
+	std::sort(baseVertices.begin(), baseVertices.end());
+	baseVertices.erase(std::unique(baseVertices.begin(), baseVertices.end()), baseVertices.end());
+
+	std::vector<uint32_t> vertexCounts;
+	vertexCounts.reserve(drawCalls.size());
+	for (const structs::host::DrawCall& drawCall : drawCalls) {
+		vertexCounts.push_back(*std::upper_bound(baseVertices.begin(), baseVertices.end(), drawCall.baseVertex) - drawCall.baseVertex);
+	}
+	return vertexCounts;
+}
+
+void HostSceneResources::optimizeMeshes(const enums::MeshOptimization meshOptimization, ThreadPool& threadPool) {
+	std::vector<uint32_t> vertexCounts = getVertexCounts();
+	//The draws of one primitive, one per instance cluster, share its indices and are optimized once. Different primitives
+	//sharing vertices would undo each other's vertex order
+	std::map<uint32_t, std::set<uint32_t>> baseVertexFirstIndices;
+	for (const structs::host::DrawCall& drawCall : drawCalls) {
+		baseVertexFirstIndices[drawCall.baseVertex].insert(drawCall.firstIndex);
+	}
+	for (size_t i = 0; i < drawCalls.size(); ++i) {
+		if (baseVertexFirstIndices[drawCalls[i].baseVertex].size() > 1) {
+			vertexCounts[i] = 0;
+		}
+	}
+
+	//Each primitive owns its indices and vertices, so they are optimized in parallel and written back in place
+	std::vector<std::future<OptimizeStats>> futures;
+	futures.reserve(drawCalls.size());
+	std::set<uint32_t> submittedBaseVertices;
+	for (uint32_t drawIndex = 0; drawIndex < drawCalls.size(); ++drawIndex) {
+		if (!submittedBaseVertices.insert(drawCalls[drawIndex].baseVertex).second) {
+			continue;
+		}
+		futures.push_back(threadPool.submit([this, drawIndex, vertexCount = vertexCounts[drawIndex], meshOptimization]() {
+			const structs::host::DrawCall& drawCall = drawCalls[drawIndex];
+			const bool isUint16 = drawIndex < uint16DrawCount;
+			std::vector<uint32_t> indices(drawCall.indexCount);
+			if (isUint16) {
+				std::copy_n(indices16.begin() + drawCall.firstIndex, drawCall.indexCount, indices.begin());
+			}
+			else {
+				std::copy_n(indices32.begin() + drawCall.firstIndex, drawCall.indexCount, indices.begin());
+			}
+			if (vertexCount == 0 || indices.size() % 3 != 0 || std::any_of(indices.begin(), indices.end(), [vertexCount](const uint32_t index) { return index >= vertexCount; })) {
+				LOG(WARNING) << "draw " << drawIndex << " is not a triangle list over its own vertices, not optimized";
+				return OptimizeStats{};
+			}
+
+			OptimizeStats stats = {
+				.triangleCount = indices.size() / 3,
+				.missesBefore = meshOptimizer::getCacheMisses(indices, vertexCount),
+			};
+			const std::span<structs::VBO> vertices = std::span<structs::VBO>(vbo).subspan(drawCall.baseVertex, vertexCount);
+			meshOptimizer::optimizeVertexCache(indices, vertexCount);
+			if (meshOptimization == enums::MeshOptimization::OVERDRAW) {
+				meshOptimizer::optimizeOverdraw(indices, vertices, meshOptimizer::OVERDRAW_THRESHOLD);
+			}
+			const std::vector<uint32_t> oldVertices = meshOptimizer::optimizeVertexFetch(indices, vertexCount);
+			stats.missesAfter = meshOptimizer::getCacheMisses(indices, vertexCount);
+
+			const std::vector<structs::VBO> oldVbo = std::vector<structs::VBO>(vertices.begin(), vertices.end());
+			for (uint32_t v = 0; v < vertexCount; ++v) {
+				vertices[v] = oldVbo[oldVertices[v]];
+			}
+			if (isUint16) {
+				std::transform(indices.begin(), indices.end(), indices16.begin() + drawCall.firstIndex, [](const uint32_t index) {
+					return static_cast<uint16_t>(index);
+				});
+			}
+			else {
+				std::copy(indices.begin(), indices.end(), indices32.begin() + drawCall.firstIndex);
+			}
+			return stats;
+		}));
+	}
+
+	ThreadPool::waitForAll(futures);
+	OptimizeStats total;
+	for (std::future<OptimizeStats>& future : futures) {
+		const OptimizeStats stats = future.get();
+		total.triangleCount += stats.triangleCount;
+		total.missesBefore += stats.missesBefore;
+		total.missesAfter += stats.missesAfter;
+	}
+	if (total.triangleCount == 0) {
+		return;
+	}
+	LOG(INFO) << "optimized " << total.triangleCount << " triangles, ACMR "
+		<< static_cast<double>(total.missesBefore) / static_cast<double>(total.triangleCount) << " -> "
+		<< static_cast<double>(total.missesAfter) / static_cast<double>(total.triangleCount);
+}
+
+void HostSceneResources::addQuantizedVertices(ThreadPool& threadPool) {
+	const std::vector<uint32_t> vertexCounts = getVertexCounts();
+	quantizedVbo.resize(vbo.size());
+
+	//The vertex ranges of each mesh by baseVertex, draws sharing vertices share a range
+	std::map<uint32_t, uint32_t> meshQuantizationIndices;
+	std::vector<std::map<uint32_t, uint32_t>> meshVertexRanges;
+	for (size_t i = 0; i < drawCalls.size(); ++i) {
+		const auto [quantizationIndex, inserted] = meshQuantizationIndices.try_emplace(drawMeshIndices[i], static_cast<uint32_t>(meshVertexRanges.size()));
+		if (inserted) {
+			meshVertexRanges.emplace_back();
+		}
+		meshVertexRanges[quantizationIndex->second].emplace(drawCalls[i].baseVertex, vertexCounts[i]);
+	}
+
+	std::vector<std::future<structs::VertexQuantization>> boundsFutures;
+	boundsFutures.reserve(meshVertexRanges.size());
+	for (const std::map<uint32_t, uint32_t>& vertexRanges : meshVertexRanges) {
+		boundsFutures.push_back(threadPool.submit([this, &vertexRanges]() {
+			return getVertexQuantization(vbo, vertexRanges);
+		}));
+	}
+	ThreadPool::waitForAll(boundsFutures);
+	vertexQuantizations.clear();
+	vertexQuantizations.reserve(boundsFutures.size());
+	for (std::future<structs::VertexQuantization>& future : boundsFutures) {
+		vertexQuantizations.push_back(future.get());
+	}
+
+	std::vector<std::future<void>> quantizations;
+	for (size_t quantizationIndex = 0; quantizationIndex < meshVertexRanges.size(); ++quantizationIndex) {
+		for (const auto& [baseVertex, vertexCount] : meshVertexRanges[quantizationIndex]) {
+			quantizations.push_back(threadPool.submit([this, quantizationIndex, baseVertex, vertexCount]() {
+				quantizeVertices(
+					std::span<const structs::VBO>(vbo).subspan(baseVertex, vertexCount),
+					vertexQuantizations[quantizationIndex],
+					std::span<structs::QuantizedVBO>(quantizedVbo).subspan(baseVertex, vertexCount)
+				);
+			}));
+		}
+	}
+	ThreadPool::waitForAll(quantizations);
+	for (std::future<void>& future : quantizations) {
+		future.get();
+	}
+
+	vertexQuantizationIndices.resize(transforms.size());
+	for (size_t i = 0; i < drawCalls.size(); ++i) {
+		const uint32_t quantizationIndex = meshQuantizationIndices.at(drawMeshIndices[i]);
+		for (uint32_t instance = drawCalls[i].firstInstance; instance < drawCalls[i].firstInstance + drawCalls[i].instanceCount; ++instance) {
+			vertexQuantizationIndices[instances[instance].transformIndex] = quantizationIndex;
+		}
+	}
+	LOG(INFO) << "quantized " << vbo.size() << " vertices of " << vertexQuantizations.size() << " meshes to " << sizeof(structs::QuantizedVBO) << " bytes each";
+}
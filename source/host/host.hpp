@@ -5,6 +5,8 @@
 #include <glm/fwd.hpp>
 #include "../structs/host.hpp"
 #include "../device/device.hpp"
+#include "../enums.hpp"
+#include "../threading/threadPool.hpp"
 
 //Objects for the wgpu::Device but in RAM waiting to be processed
 //This data should be in a format that can be consumed by the shader if its written into the device as is
@@ -12,10 +14,20 @@ class HostSceneResources {
 	public:
 		//Mesh data
 		std::vector<structs::VBO> vbo;
-		std::vector<uint16_t> indices;
-		std::vector<glm::f32mat4x4> transforms;
-		std::vector<uint32_t> materialIndices;
+		//Indices are local to their primitive, DrawCall::baseVertex locates the vertices. Primitives with at most 65536
+		//vertices use indices16, the rest indices32. The first uint16DrawCount drawCalls index indices16, the others indices32
+		std::vector<uint16_t> indices16;
+		std::vector<uint32_t> indices32;
+		uint32_t uint16DrawCount = 0;
+		std::vector<glm::f32mat4x4> transforms; //one per mesh instance, the instances of a mesh in spatial clusters
+		std::vector<structs::Instance> instances; //one per instance of each drawCall, from its firstInstance
 		std::vector<structs::host::DrawCall> drawCalls;
+		std::vector<structs::DrawBounds> drawBounds; //one per drawCall, around the instances of its cluster
+		std::vector<uint32_t> drawMeshIndices; //one per drawCall, the glTF mesh it is a primitive of
+		//Only filled for quantized scenes, the device draws quantizedVbo instead of vbo then
+		std::vector<structs::QuantizedVBO> quantizedVbo;
+		std::vector<structs::VertexQuantization> vertexQuantizations; //one per mesh
+		std::vector<uint32_t> vertexQuantizationIndices; //one per transform, into vertexQuantizations
 
 		//Other data
 		std::vector<structs::Light> lights;
@@ -36,10 +48,19 @@ class HostSceneResources {
 		HostSceneResources(
 			const std::string& gltfDirectory,
 			const std::string& gltfFileName,
-			const std::array<uint32_t, 2> screenDimensions
+			const std::array<uint32_t, 2> screenDimensions,
+			ThreadPool& threadPool,
+			const enums::MeshOptimization meshOptimization = enums::MeshOptimization::NONE,
+			const bool quantizeVertices = false
 		);
 
 	private:
 		void addDefaults(std::array<uint32_t, 2> screenDimensions);
-		void postProcessData();
+		void postProcessData(const enums::MeshOptimization meshOptimization, const bool quantizeVertices, ThreadPool& threadPool);
+		//Vertices of each drawCall, a primitive's run from its baseVertex to the next primitive's
+		std::vector<uint32_t> getVertexCounts() const;
+		//Reorders each primitive's indices and its range of vbo in place, the vertices of a primitive stay in its range
+		void optimizeMeshes(const enums::MeshOptimization meshOptimization, ThreadPool& threadPool);
+		//Fills quantizedVbo and vertexQuantizations from vbo, positions and texcoords relative to the bounds of their mesh
+		void addQuantizedVertices(ThreadPool& threadPool);
 };
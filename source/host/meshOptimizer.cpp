@@ -0,0 +1,275 @@
+#pragma once
+#include "meshOptimizer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <glm/glm.hpp>
+
+namespace {
+	//Scoring of Forsyth's article, the LRU cache it models is larger than the FIFO ACMR is measured with
+	constexpr uint32_t LRU_CACHE_SIZE = 32;
+	constexpr float CACHE_DECAY_POWER = 1.5f;
+	constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+	constexpr float VALENCE_BOOST_SCALE = 2.0f;
+	constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+	//cachePosition is -1 when the vertex is not in the cache
+	float getVertexScore(const int32_t cachePosition, const uint32_t remainingTriangles) {
+		if (remainingTriangles == 0) {
+			return -1.0f;
+		}
+		float score = 0.0f;
+		if (cachePosition >= 3) {
+			const float decay = 1.0f - static_cast<float>(cachePosition - 3) / static_cast<float>(LRU_CACHE_SIZE - 3);
+			score = std::pow(decay, CACHE_DECAY_POWER);
+		}
+		else if (cachePosition >= 0) {
+			//The triangle just drawn, scored lower so that the next one does not strip along one edge
+			score = LAST_TRIANGLE_SCORE;
+		}
+		//Favour vertices with few triangles left so that they leave the cache for good
+		return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+	}
+
+	//FIFO vertex cache of meshOptimizer::ACMR_CACHE_SIZE entries. A vertex is cached while fewer than ACMR_CACHE_SIZE
+	//misses happened since its own
+	class FifoCache {
+	public:
+		FifoCache(const uint32_t vertexCount) : _timestamps(vertexCount, 0) {}
+
+		//Returns 1 on a miss
+		uint32_t touch(const uint32_t index) {
+			if (_timestamp - _timestamps[index] <= meshOptimizer::ACMR_CACHE_SIZE) {
+				return 0;
+			}
+			_timestamps[index] = _timestamp++;
+			return 1;
+		}
+
+		void flush() {
+			_timestamp += meshOptimizer::ACMR_CACHE_SIZE + 1;
+		}
+
+	private:
+		std::vector<uint32_t> _timestamps;
+		uint32_t _timestamp = meshOptimizer::ACMR_CACHE_SIZE + 1;
+	};
+
+	uint32_t touchTriangle(FifoCache& cache, std::span<const uint32_t> indices, const size_t triangle) {
+		return cache.touch(indices[triangle * 3]) + cache.touch(indices[triangle * 3 + 1]) + cache.touch(indices[triangle * 3 + 2]);
+	}
+}
+
+namespace meshOptimizer {
+	uint64_t getCacheMisses(std::span<const uint32_t> indices, const uint32_t vertexCount) {
+		FifoCache cache = FifoCache(vertexCount);
+		uint64_t misses = 0;
+		for (const uint32_t index : indices) {
+			misses += cache.touch(index);
+		}
+		return misses;
+	}
+
+	void optimizeVertexCache(std::vector<uint32_t>& indices, const uint32_t vertexCount) {
+		const size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0) {
+			return;
+		}
+
+		//Triangles of each vertex, the first remainingTriangles[v] of a vertex's list are not drawn yet
+		std::vector<uint32_t> triangleOffsets(vertexCount + 1, 0);
+		for (const uint32_t index : indices) {
+			triangleOffsets[index + 1]++;
+		}
+		std::vector<uint32_t> remainingTriangles(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; ++v) {
+			remainingTriangles[v] = triangleOffsets[v + 1];
+			triangleOffsets[v + 1] += triangleOffsets[v];
+		}
+		std::vector<uint32_t> vertexTriangles(indices.size());
+		std::vector<uint32_t> fillOffsets(triangleOffsets.begin(), triangleOffsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); ++i) {
+			vertexTriangles[fillOffsets[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		std::vector<int32_t> cachePositions(vertexCount, -1);
+		std::vector<float> vertexScores(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; ++v) {
+			vertexScores[v] = getVertexScore(-1, remainingTriangles[v]);
+		}
+
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<uint32_t> cache;
+		std::vector<uint32_t> nextCache;
+		cache.reserve(LRU_CACHE_SIZE + 3);
+		nextCache.reserve(LRU_CACHE_SIZE + 3);
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+		size_t nextUnemitted = 0; //where to look for a triangle once none in the cache is left
+		size_t triangle = 0;
+
+		while (triangle < triangleCount) {
+			emitted[triangle] = true;
+			nextCache.clear();
+			for (size_t k = 0; k < 3; ++k) {
+				const uint32_t v = indices[triangle * 3 + k];
+				result.push_back(v);
+				if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end()) {
+					nextCache.push_back(v);
+				}
+				const auto begin = vertexTriangles.begin() + triangleOffsets[v];
+				const auto end = begin + remainingTriangles[v];
+				std::iter_swap(std::find(begin, end, static_cast<uint32_t>(triangle)), end - 1);
+				remainingTriangles[v]--;
+			}
+			const size_t triangleVertexCount = nextCache.size();
+			for (const uint32_t v : cache) {
+				if (std::find(nextCache.begin(), nextCache.begin() + triangleVertexCount, v) == nextCache.begin() + triangleVertexCount) {
+					nextCache.push_back(v);
+				}
+			}
+			for (size_t i = LRU_CACHE_SIZE; i < nextCache.size(); ++i) {
+				cachePositions[nextCache[i]] = -1;
+				vertexScores[nextCache[i]] = getVertexScore(-1, remainingTriangles[nextCache[i]]);
+			}
+			nextCache.resize(std::min<size_t>(nextCache.size(), LRU_CACHE_SIZE));
+			std::swap(cache, nextCache);
+
+			for (size_t i = 0; i < cache.size(); ++i) {
+				cachePositions[cache[i]] = static_cast<int32_t>(i);
+				vertexScores[cache[i]] = getVertexScore(static_cast<int32_t>(i), remainingTriangles[cache[i]]);
+			}
+
+			//Only triangles touching the cache changed score, the best of them is drawn next
+			float bestScore = -1.0f;
+			triangle = triangleCount;
+			for (const uint32_t v : cache) {
+				const uint32_t* candidates = vertexTriangles.data() + triangleOffsets[v];
+				for (uint32_t i = 0; i < remainingTriangles[v]; ++i) {
+					const uint32_t candidate = candidates[i];
+					const float score = vertexScores[indices[candidate * 3]] + vertexScores[indices[candidate * 3 + 1]] + vertexScores[indices[candidate * 3 + 2]];
+					if (score > bestScore) {
+						bestScore = score;
+						triangle = candidate;
+					}
+				}
+			}
+			if (triangle == triangleCount) {
+				while (nextUnemitted < triangleCount && emitted[nextUnemitted]) {
+					nextUnemitted++;
+				}
+				triangle = nextUnemitted;
+			}
+		}
+		indices = std::move(result);
+	}
+
+	void optimizeOverdraw(std::vector<uint32_t>& indices, std::span<const structs::VBO> vertices, const float threshold) {
+		const size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0) {
+			return;
+		}
+		const uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+
+		//A triangle missing on all of its vertices starts a new run of the cache order, clusters may not cross it
+		std::vector<size_t> hardBoundaries;
+		FifoCache cache = FifoCache(vertexCount);
+		for (size_t t = 0; t < triangleCount; ++t) {
+			if (touchTriangle(cache, indices, t) == 3 || t == 0) {
+				hardBoundaries.push_back(t);
+			}
+		}
+		hardBoundaries.push_back(triangleCount);
+
+		//Within a run, a cluster ends as soon as its own ACMR, measured from a flushed cache, is close enough to the run's
+		std::vector<size_t> clusterStarts;
+		for (size_t h = 0; h + 1 < hardBoundaries.size(); ++h) {
+			const size_t runStart = hardBoundaries[h];
+			const size_t runEnd = hardBoundaries[h + 1];
+			cache.flush();
+			uint32_t runMisses = 0;
+			for (size_t t = runStart; t < runEnd; ++t) {
+				runMisses += touchTriangle(cache, indices, t);
+			}
+			const float clusterThreshold = threshold * static_cast<float>(runMisses) / static_cast<float>(runEnd - runStart);
+
+			cache.flush();
+			size_t clusterStart = runStart;
+			uint32_t clusterMisses = 0;
+			clusterStarts.push_back(clusterStart);
+			for (size_t t = runStart; t + 1 < runEnd; ++t) {
+				clusterMisses += touchTriangle(cache, indices, t);
+				if (static_cast<float>(clusterMisses) / static_cast<float>(t + 1 - clusterStart) <= clusterThreshold) {
+					clusterStart = t + 1;
+					clusterMisses = 0;
+					clusterStarts.push_back(clusterStart);
+					cache.flush();
+				}
+			}
+		}
+		clusterStarts.push_back(triangleCount);
+
+		glm::f32vec3 meshCentroid = glm::f32vec3(0.0f);
+		for (const structs::VBO& vertex : vertices) {
+			meshCentroid += vertex.vertex;
+		}
+		meshCentroid = meshCentroid / static_cast<float>(std::max(vertexCount, 1u));
+
+		//How far a cluster faces away from the middle of the mesh
+		const size_t clusterCount = clusterStarts.size() - 1;
+		std::vector<float> clusterSortKeys(clusterCount);
+		for (size_t c = 0; c < clusterCount; ++c) {
+			glm::f32vec3 centroid = glm::f32vec3(0.0f);
+			glm::f32vec3 normal = glm::f32vec3(0.0f);
+			float area = 0.0f;
+			for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t) {
+				const glm::f32vec3& a = vertices[indices[t * 3]].vertex;
+				const glm::f32vec3& b = vertices[indices[t * 3 + 1]].vertex;
+				const glm::f32vec3& d = vertices[indices[t * 3 + 2]].vertex;
+				const glm::f32vec3 triangleNormal = glm::cross(b - a, d - a);
+				const float triangleArea = glm::length(triangleNormal);
+				centroid += (a + b + d) * (triangleArea / 3.0f);
+				normal += triangleNormal;
+				area += triangleArea;
+			}
+			const float normalLength = glm::length(normal);
+			if (area == 0.0f || normalLength == 0.0f) {
+				clusterSortKeys[c] = 0.0f;
+				continue;
+			}
+			clusterSortKeys[c] = glm::dot(centroid / area - meshCentroid, normal / normalLength);
+		}
+
+		std::vector<uint32_t> clusterOrder(clusterCount);
+		std::iota(clusterOrder.begin(), clusterOrder.end(), 0);
+		std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&clusterSortKeys](const uint32_t lhs, const uint32_t rhs) {
+			return clusterSortKeys[lhs] > clusterSortKeys[rhs];
+		});
+
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+		for (const uint32_t c : clusterOrder) {
+			result.insert(result.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+		}
+		indices = std::move(result);
+	}
+
+	std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t>& indices, const uint32_t vertexCount) {
+		std::vector<uint32_t> newVertices(vertexCount, UINT32_MAX);
+		std::vector<uint32_t> oldVertices;
+		oldVertices.reserve(vertexCount);
+		for (uint32_t& index : indices) {
+			if (newVertices[index] == UINT32_MAX) {
+				newVertices[index] = static_cast<uint32_t>(oldVertices.size());
+				oldVertices.push_back(index);
+			}
+			index = newVertices[index];
+		}
+		for (uint32_t v = 0; v < vertexCount; ++v) {
+			if (newVertices[v] == UINT32_MAX) {
+				oldVertices.push_back(v);
+			}
+		}
+		return oldVertices;
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "../structs/structs.hpp"
+
+//Import time reordering of one primitive's triangle list. Indices are local to the primitive and each must be less than
+//vertexCount, the vertices are the primitive's own range of the scene VBO
+namespace meshOptimizer {
+	//Size of the FIFO cache ACMR is measured with, about what current GPUs reuse between triangles
+	constexpr uint32_t ACMR_CACHE_SIZE = 16;
+	//How much worse than the cache optimized order a cluster of optimizeOverdraw may make the ACMR
+	constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+	//Vertices transformed when drawing indices through the ACMR cache. Divided by the triangle count this is the ACMR,
+	//3 without any reuse and about 0.5 for a large regular grid
+	uint64_t getCacheMisses(std::span<const uint32_t> indices, const uint32_t vertexCount);
+
+	//Greedily emits the triangle whose vertices score best against a modelled LRU cache, Tom Forsyth's
+	//"Linear-Speed Vertex Cache Optimisation"
+	void optimizeVertexCache(std::vector<uint32_t>& indices, const uint32_t vertexCount);
+
+	//Splits a cache optimized list into clusters where the cache order restarts or the ACMR allows it, then draws the most
+	//outward facing clusters first so that they hide the ones behind them, as Sander et al. do for Tipsify
+	void optimizeOverdraw(std::vector<uint32_t>& indices, std::span<const structs::VBO> vertices, const float threshold);
+
+	//Renumbers the vertices in the order the indices first use them. Returns the old vertex of each new vertex, vertices no
+	//index uses keep their relative order after the rest
+	std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t>& indices, const uint32_t vertexCount);
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "packing.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace packing {
+	uint16_t quantizeUnorm16(const float value) {
+		return static_cast<uint16_t>(std::round(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+	}
+
+	int16_t quantizeSnorm16(const float value) {
+		return static_cast<int16_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	glm::f32vec2 octahedralEncode(const glm::f32vec3& normal) {
+		const glm::f32vec3 octahedron = normal / (std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z));
+		if (octahedron.z >= 0.0f) {
+			return glm::f32vec2(octahedron.x, octahedron.y);
+		}
+		return glm::f32vec2(
+			(1.0f - std::abs(octahedron.y)) * (octahedron.x >= 0.0f ? 1.0f : -1.0f),
+			(1.0f - std::abs(octahedron.x)) * (octahedron.y >= 0.0f ? 1.0f : -1.0f)
+		);
+	}
+
+	glm::i16vec2 packOctahedralNormal(const glm::f32vec3& normal) {
+		const float normalLength = glm::length(normal);
+		if (!(normalLength > 0.0f)) {
+			return glm::i16vec2(0, 0);
+		}
+		const glm::f32vec2 encoded = octahedralEncode(normal / normalLength);
+		return glm::i16vec2(quantizeSnorm16(encoded.x), quantizeSnorm16(encoded.y));
+	}
+}
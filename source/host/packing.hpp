@@ -0,0 +1,13 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+
+//Host side of the packed vertex and G-buffer formats, the shaders unpack them with the WGSL pack/unpack builtins
+namespace packing {
+	uint16_t quantizeUnorm16(const float value);
+	int16_t quantizeSnorm16(const float value);
+	//Maps the unit sphere onto the [-1, 1] square, must match octahedralEncode in shaders/_octahedral.wgsl
+	glm::f32vec2 octahedralEncode(const glm::f32vec3& normal);
+	//octahedralEncode as snorm16x2, a zero normal encodes as zero
+	glm::i16vec2 packOctahedralNormal(const glm::f32vec3& normal);
+}
@@ -5,10 +5,11 @@
 #include "absl/log/log.h"
 #include "engine/engine.hpp"
 
-int main()
+int main(int argc, char* argv[])
 {
 	try {
-		Engine engine = Engine();
+		const engine::Options options = engine::parseOptions(argc, argv);
+		Engine engine = Engine(options);
 		engine.run();
 	}
 	catch (std::exception& err) {
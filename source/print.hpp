@@ -13,6 +13,8 @@ namespace print {
 				LOG(INFO) << "DeviceID: " << std::hex << info.deviceID << std::dec;
 				LOG(INFO) << "Name: " << info.device;
 				LOG(INFO) << "Driver description: " << info.description;
+				LOG(INFO) << "Backend: " << info.backendType;
+				LOG(INFO) << "Adapter type: " << info.adapterType;
 				LOG(INFO) << std::endl;
 		}
 
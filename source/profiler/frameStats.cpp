@@ -0,0 +1,113 @@
+#pragma once
+#include "frameStats.hpp"
+#include <algorithm>
+#include <dawn/native/DawnNative.h>
+
+FrameStats::FrameStats(WGPUContext* wgpuContext, const std::vector<std::string>& phaseNames, const bool enabled)
+	: _wgpuContext(wgpuContext), _enabled(enabled), _phaseNames(phaseNames) {
+	_phaseMilliseconds.resize(_phaseNames.size());
+}
+
+bool FrameStats::isEnabled() const {
+	return _enabled;
+}
+
+void FrameStats::beginFrame() {
+	if (!_enabled) {
+		return;
+	}
+	for (std::vector<double>& phase : _phaseMilliseconds) {
+		phase.push_back(0.0);
+	}
+	{
+		const std::lock_guard<std::mutex> lock(_completionMutex);
+		_submitLatencyMilliseconds.push_back(0.0);
+		_completionTimes.push_back(Clock::time_point());
+	}
+	_frameStart = Clock::now();
+	_phaseStart = _frameStart;
+}
+
+void FrameStats::endPhase(const uint32_t phaseIndex) {
+	if (!_enabled) {
+		return;
+	}
+	const Clock::time_point now = Clock::now();
+	_phaseMilliseconds.at(phaseIndex).back() += std::chrono::duration<double, std::milli>(now - _phaseStart).count();
+	_phaseStart = now;
+}
+
+//Spontaneous so the completion is stamped when dawn notices it rather than when the engine next polls,
+//the resolution is still bounded by how often dawn checks the queue
+void FrameStats::submitted() {
+	if (!_enabled) {
+		return;
+	}
+	const size_t frameIndex = _cpuFrameMilliseconds.size();
+	const Clock::time_point submitTime = Clock::now();
+	_wgpuContext->queue.OnSubmittedWorkDone(
+		wgpu::CallbackMode::AllowSpontaneous,
+		[this, frameIndex, submitTime](wgpu::QueueWorkDoneStatus status) {
+			if (status != wgpu::QueueWorkDoneStatus::Success) {
+				return;
+			}
+			const Clock::time_point now = Clock::now();
+			const std::lock_guard<std::mutex> lock(_completionMutex);
+			_submitLatencyMilliseconds[frameIndex] = std::chrono::duration<double, std::milli>(now - submitTime).count();
+			_completionTimes[frameIndex] = now;
+		}
+	);
+}
+
+void FrameStats::endFrame() {
+	if (!_enabled) {
+		return;
+	}
+	_cpuFrameMilliseconds.push_back(std::chrono::duration<double, std::milli>(Clock::now() - _frameStart).count());
+
+	const dawn::native::MemoryUsageInfo memoryUsageInfo = dawn::native::ComputeEstimatedMemoryUsageInfo(_wgpuContext->device.Get());
+	const dawn::native::AllocatorMemoryInfo allocatorMemoryInfo = dawn::native::GetAllocatorMemoryInfo(_wgpuContext->device.Get());
+	_peakEstimatedMemory = std::max(_peakEstimatedMemory, memoryUsageInfo.totalUsage);
+	_peakAllocatedMemory = std::max(_peakAllocatedMemory, allocatorMemoryInfo.totalAllocatedMemory);
+}
+
+uint64_t FrameStats::getFrameCount() const {
+	return _cpuFrameMilliseconds.size();
+}
+
+const std::vector<std::string>& FrameStats::getPhaseNames() const {
+	return _phaseNames;
+}
+
+const std::vector<double>& FrameStats::getPhaseMilliseconds(const uint32_t phaseIndex) const {
+	return _phaseMilliseconds.at(phaseIndex);
+}
+
+const std::vector<double>& FrameStats::getCpuFrameMilliseconds() const {
+	return _cpuFrameMilliseconds;
+}
+
+std::vector<double> FrameStats::getSubmitLatencyMilliseconds() const {
+	const std::lock_guard<std::mutex> lock(_completionMutex);
+	return _submitLatencyMilliseconds;
+}
+
+std::vector<double> FrameStats::getFrameIntervalMilliseconds() const {
+	const std::lock_guard<std::mutex> lock(_completionMutex);
+	std::vector<double> intervals;
+	for (size_t i = 1; i < _completionTimes.size(); ++i) {
+		if (_completionTimes[i - 1] == Clock::time_point() || _completionTimes[i] == Clock::time_point()) {
+			continue;
+		}
+		intervals.push_back(std::chrono::duration<double, std::milli>(_completionTimes[i] - _completionTimes[i - 1]).count());
+	}
+	return intervals;
+}
+
+uint64_t FrameStats::getPeakEstimatedMemory() const {
+	return _peakEstimatedMemory;
+}
+
+uint64_t FrameStats::getPeakAllocatedMemory() const {
+	return _peakAllocatedMemory;
+}
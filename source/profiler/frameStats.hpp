@@ -0,0 +1,53 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <dawn/webgpu_cpp.h>
+#include "../wgpuContext/wgpuContext.hpp"
+
+//CPU side timings of every frame: time spent in each draw phase, submit to queue completion latency and the
+//peak device memory dawn estimates. Every frame is kept so a benchmark can take percentiles once the run ends
+class FrameStats {
+public:
+	FrameStats(WGPUContext* wgpuContext, const std::vector<std::string>& phaseNames, const bool enabled);
+
+	bool isEnabled() const;
+	void beginFrame();
+	//Attributes the time since the previous endPhase, or beginFrame, to phaseIndex
+	void endPhase(const uint32_t phaseIndex);
+	//Must be called right after the frame's submit
+	void submitted();
+	void endFrame();
+
+	uint64_t getFrameCount() const;
+	const std::vector<std::string>& getPhaseNames() const;
+	const std::vector<double>& getPhaseMilliseconds(const uint32_t phaseIndex) const;
+	const std::vector<double>& getCpuFrameMilliseconds() const;
+	//Only complete once the queue has drained
+	std::vector<double> getSubmitLatencyMilliseconds() const;
+	//Time between the queue completing consecutive frames, the rate the GPU actually delivers frames at
+	std::vector<double> getFrameIntervalMilliseconds() const;
+	uint64_t getPeakEstimatedMemory() const;
+	uint64_t getPeakAllocatedMemory() const;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	WGPUContext* _wgpuContext;
+	bool _enabled = false;
+	std::vector<std::string> _phaseNames;
+	std::vector<std::vector<double>> _phaseMilliseconds;
+	std::vector<double> _cpuFrameMilliseconds;
+	Clock::time_point _frameStart;
+	Clock::time_point _phaseStart;
+
+	//Written by the OnSubmittedWorkDone callbacks, which may run on any thread
+	mutable std::mutex _completionMutex;
+	std::vector<double> _submitLatencyMilliseconds;
+	std::vector<Clock::time_point> _completionTimes;
+
+	uint64_t _peakEstimatedMemory = 0;
+	uint64_t _peakAllocatedMemory = 0;
+};
@@ -0,0 +1,166 @@
+#pragma once
+#include "gpuProfiler.hpp"
+#include <format>
+#include "absl/log/log.h"
+
+GpuProfiler::GpuProfiler(WGPUContext* wgpuContext, const std::vector<std::string>& passNames)
+	: _wgpuContext(wgpuContext), _passNames(passNames) {
+	_passMilliseconds.resize(_passNames.size(), 0.0);
+
+	_enabled = _wgpuContext->device.HasFeature(wgpu::FeatureName::TimestampQuery);
+	if (!_enabled) {
+		LOG(WARNING) << "GPU profiler disabled: device does not support timestamp queries";
+		return;
+	}
+
+	const wgpu::QuerySetDescriptor querySetDescriptor = {
+		.label = "gpu profiler query set",
+		.type = wgpu::QueryType::Timestamp,
+		.count = static_cast<uint32_t>(_passNames.size() * 2),
+	};
+	_querySet = _wgpuContext->device.CreateQuerySet(&querySetDescriptor);
+
+	const wgpu::BufferDescriptor resolveBufferDescriptor = {
+		.label = "gpu profiler resolve buffer",
+		.usage = wgpu::BufferUsage::QueryResolve | wgpu::BufferUsage::CopySrc,
+		.size = getQueryBufferSize(),
+	};
+	_resolveBuffer = _wgpuContext->device.CreateBuffer(&resolveBufferDescriptor);
+	_wgpuContext->getMemoryRegistry().track(_resolveBuffer, "gpu profiler resolve", enums::MemoryCategory::OTHER);
+
+	for (uint32_t i = 0; i < _readbacks.size(); ++i) {
+		const std::string label = std::format("gpu profiler readback buffer {}", i);
+		const wgpu::BufferDescriptor readbackBufferDescriptor = {
+			.label = wgpu::StringView(label),
+			.usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst,
+			.size = getQueryBufferSize(),
+		};
+		_readbacks[i].buffer = _wgpuContext->device.CreateBuffer(&readbackBufferDescriptor);
+		_wgpuContext->getMemoryRegistry().track(_readbacks[i].buffer, label, enums::MemoryCategory::STAGING);
+	}
+
+	for (uint32_t i = 0; i < _passNames.size(); ++i) {
+		_timestampWrites.push_back(wgpu::PassTimestampWrites{
+			.querySet = _querySet,
+			.beginningOfPassWriteIndex = i * 2,
+			.endOfPassWriteIndex = i * 2 + 1,
+		});
+	}
+}
+
+GpuProfiler::~GpuProfiler() {
+	for (Readback& readback : _readbacks) {
+		if (!readback.pending) {
+			continue;
+		}
+		const wgpu::WaitStatus status = _wgpuContext->instance.WaitAny(readback.mapFuture, UINT64_MAX);
+		if (status != wgpu::WaitStatus::Success) {
+			LOG(ERROR) << "GPU profiler failed to wait for a readback with status " << static_cast<uint32_t>(status);
+		}
+	}
+	_wgpuContext->getMemoryRegistry().untrack(_resolveBuffer);
+	for (const Readback& readback : _readbacks) {
+		_wgpuContext->getMemoryRegistry().untrack(readback.buffer);
+	}
+}
+
+bool GpuProfiler::isEnabled() const {
+	return _enabled;
+}
+
+void GpuProfiler::beginFrame() {
+	if (!_enabled) {
+		return;
+	}
+	//Runs the map callbacks of earlier frames that have finished
+	_wgpuContext->instance.ProcessEvents();
+
+	_frameReadback = static_cast<uint32_t>(_frame % READBACK_RING_SIZE);
+	_frameTimed = !_readbacks[_frameReadback].pending;
+}
+
+const wgpu::PassTimestampWrites* GpuProfiler::getTimestampWrites(const uint32_t passIndex) const {
+	if (!_enabled || !_frameTimed) {
+		return nullptr;
+	}
+	return &_timestampWrites.at(passIndex);
+}
+
+void GpuProfiler::resolve(const wgpu::CommandEncoder& commandEncoder) {
+	if (!_enabled || !_frameTimed) {
+		return;
+	}
+	commandEncoder.ResolveQuerySet(_querySet, 0, _querySet.GetCount(), _resolveBuffer, 0);
+	commandEncoder.CopyBufferToBuffer(_resolveBuffer, 0, _readbacks[_frameReadback].buffer, 0, getQueryBufferSize());
+}
+
+void GpuProfiler::endFrame() {
+	if (!_enabled) {
+		return;
+	}
+	if (_frameTimed) {
+		const uint32_t readbackIndex = _frameReadback;
+		_readbacks[readbackIndex].pending = true;
+		_readbacks[readbackIndex].mapFuture = _readbacks[readbackIndex].buffer.MapAsync(
+			wgpu::MapMode::Read,
+			0,
+			getQueryBufferSize(),
+			wgpu::CallbackMode::AllowProcessEvents,
+			[this, readbackIndex](wgpu::MapAsyncStatus status, wgpu::StringView message) {
+				if (status != wgpu::MapAsyncStatus::Success) {
+					LOG(ERROR) << "GPU profiler readback failed: " << message;
+					_readbacks[readbackIndex].pending = false;
+					return;
+				}
+				readTimestamps(readbackIndex);
+			}
+		);
+	}
+
+	++_frame;
+	if (_frame % LOG_INTERVAL_FRAMES == 0) {
+		logPassMilliseconds();
+	}
+}
+
+double GpuProfiler::getPassMilliseconds(const uint32_t passIndex) const {
+	return _passMilliseconds.at(passIndex);
+}
+
+const std::vector<std::string>& GpuProfiler::getPassNames() const {
+	return _passNames;
+}
+
+uint64_t GpuProfiler::getQueryBufferSize() const {
+	return _passNames.size() * 2 * sizeof(uint64_t);
+}
+
+//Timestamps are in nanoseconds. A pass that was not recorded this frame leaves its pair at zero or out of order
+void GpuProfiler::readTimestamps(const uint32_t readbackIndex) {
+	Readback& readback = _readbacks[readbackIndex];
+	const uint64_t* timestamps = static_cast<const uint64_t*>(readback.buffer.GetConstMappedRange(0, getQueryBufferSize()));
+	for (uint32_t i = 0; i < _passNames.size(); ++i) {
+		const uint64_t begin = timestamps[i * 2];
+		const uint64_t end = timestamps[i * 2 + 1];
+		if (begin == 0 || end < begin) {
+			continue;
+		}
+		const double milliseconds = static_cast<double>(end - begin) / 1e6;
+		_passMilliseconds[i] = _passMilliseconds[i] == 0.0
+			? milliseconds
+			: _passMilliseconds[i] + SMOOTHING * (milliseconds - _passMilliseconds[i]);
+	}
+	readback.buffer.Unmap();
+	readback.pending = false;
+}
+
+void GpuProfiler::logPassMilliseconds() const {
+	std::string line = "GPU ms:";
+	double total = 0.0;
+	for (uint32_t i = 0; i < _passNames.size(); ++i) {
+		line += std::format(" {} {:.3f} |", _passNames[i], _passMilliseconds[i]);
+		total += _passMilliseconds[i];
+	}
+	line += std::format(" total {:.3f}", total);
+	LOG(INFO) << line;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <array>
+#include <string>
+#include <vector>
+#include <dawn/webgpu_cpp.h>
+#include "../wgpuContext/wgpuContext.hpp"
+
+//Times every pass with timestamp queries. Each frame resolves into its own readback buffer from a small ring
+//so reading the results never waits on the queue, a frame whose buffer is still mapping is simply not timed
+class GpuProfiler {
+public:
+	GpuProfiler(WGPUContext* wgpuContext, const std::vector<std::string>& passNames);
+	//Waits for the readbacks still mapping, their callbacks capture this
+	~GpuProfiler();
+	GpuProfiler(const GpuProfiler&) = delete;
+	GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+	bool isEnabled() const;
+	void beginFrame();
+	//nullptr when timestamps are unsupported or this frame is not being timed
+	const wgpu::PassTimestampWrites* getTimestampWrites(const uint32_t passIndex) const;
+	//Must be recorded after the last timed pass
+	void resolve(const wgpu::CommandEncoder& commandEncoder);
+	//Must be called after the frame has been submitted
+	void endFrame();
+
+	//Exponential moving average of the gpu time of each pass
+	double getPassMilliseconds(const uint32_t passIndex) const;
+	const std::vector<std::string>& getPassNames() const;
+
+private:
+	static constexpr uint32_t READBACK_RING_SIZE = 3;
+	static constexpr uint32_t LOG_INTERVAL_FRAMES = 300;
+	static constexpr double SMOOTHING = 0.1;
+
+	struct Readback {
+		wgpu::Buffer buffer;
+		wgpu::Future mapFuture;
+		bool pending = false;
+	};
+
+	WGPUContext* _wgpuContext;
+	bool _enabled = false;
+	std::vector<std::string> _passNames;
+	std::vector<double> _passMilliseconds;
+	std::vector<wgpu::PassTimestampWrites> _timestampWrites;
+
+	wgpu::QuerySet _querySet;
+	wgpu::Buffer _resolveBuffer;
+	std::array<Readback, READBACK_RING_SIZE> _readbacks;
+	uint64_t _frame = 0;
+	uint32_t _frameReadback = 0;
+	bool _frameTimed = false;
+
+	uint64_t getQueryBufferSize() const;
+	void readTimestamps(const uint32_t readbackIndex);
+	void logPassMilliseconds() const;
+};
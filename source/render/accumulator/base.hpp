@@ -1,6 +1,6 @@
 #pragma once
 #include <vector>
-#include <unordered_map>
+#include <algorithm>
 #include "../../structs/structs.hpp"
 #include <string>
 #include "../../wgpuContext/wgpuContext.hpp"
@@ -10,27 +10,47 @@
 #include <array>
 #include <cstdint>
 #include "../../device/resources.hpp"
+#include "../dispatch.hpp"
+#include "../frameGraph.hpp"
+#include "../../device/pipelineBatch.hpp"
+#include "../../constants.hpp"
+#include "../../structs/host.hpp"
 
 namespace render {
 	namespace accumulator {
 		namespace descriptor {
+			struct CreatePipelineAsync {
+				PipelineBatch& pipelineBatch;
+				wgpu::TextureFormat accumulatorTextureFormat;
+				wgpu::TextureFormat texCoordTextureFormat;
+				wgpu::TextureFormat textureIdTextureFormat;
+				uint32_t textureIdShift; //where this accumulator's id sits in the packed ids, see constants::TEXTURE_ID_BITS
+			};
+
 			struct GenerateGpuObjects {
 				wgpu::TextureView& accumulatorTextureView;
-				wgpu::TextureFormat accumulatorTextureFormat;
 				wgpu::TextureView& texCoordTextureView;
-				wgpu::TextureFormat texCoordTextureFormat;
 				wgpu::TextureView& textureIdTextureView;
-				wgpu::TextureFormat textureIdTextureFormat;
 
 				//for input bind group
 				std::vector<uint32_t>& stpIds;
 				std::vector<structs::SamplerTexturePair>& inputSTPs;
-				std::vector<wgpu::TextureView>& allTextureViews;
-				std::unordered_map<uint32_t, wgpu::Sampler>& allSamplers;
+				std::vector<wgpu::SamplerDescriptor>& inputSamplers;
+				std::vector<wgpu::TextureView>& textureArrayViews;
+				std::vector<structs::host::TextureLayer>& textureLayers;
+				wgpu::Sampler& linearSampler;
+				wgpu::Sampler& nearestSampler;
 			};
 
 			struct DoCommands {
 				wgpu::CommandEncoder& commandEncoder;
+				const wgpu::PassTimestampWrites* timestampWrites = nullptr;
+			};
+
+			struct DeclareResources {
+				FrameGraph& frameGraph;
+				enums::GpuPass pass;
+				enums::FrameResource accumulator;
 			};
 		}
 	}
@@ -41,68 +61,89 @@ namespace render {
 		BaseAccumulator(WGPUContext* wgpuContext) : _wgpuContext(wgpuContext) {};
 
 	public:
-		void generateGpuObjects(const accumulator::descriptor::GenerateGpuObjects* descriptor) {
+		//Pixels without a texture keep the accumulator value Initial wrote, so it is read as well
+		void declareResources(const accumulator::descriptor::DeclareResources* descriptor) const {
+			descriptor->frameGraph.addPass({
+				.pass = descriptor->pass,
+				.reads = { enums::FrameResource::TEX_COORD, enums::FrameResource::TEXTURE_IDS, descriptor->accumulator },
+				.writes = { descriptor->accumulator },
+			});
+		}
+
+		void createPipelineAsync(const accumulator::descriptor::CreatePipelineAsync* descriptor) {
 			createAccumulatorBindGroupLayout(
 				descriptor->accumulatorTextureFormat,
 				descriptor->texCoordTextureFormat,
 				descriptor->textureIdTextureFormat
 			);
 			createInputBindGroupLayout();
-			createComputePipeline();
+			createComputePipeline(descriptor->pipelineBatch, descriptor->textureIdShift);
+		}
 
+		//The pipeline batch must have been waited on
+		void generateGpuObjects(const accumulator::descriptor::GenerateGpuObjects* descriptor) {
 			createAccumulatorBindGroup(
 				descriptor->accumulatorTextureView,
 				descriptor->texCoordTextureView,
 				descriptor->textureIdTextureView
 			);
 
-			std::vector<wgpu::Buffer> inputInfoBuffers;
-			for (uint32_t i = 0; i < descriptor->inputSTPs.size(); i++) {
-				structs::InputInfo inputInfo = {
-					.stpIndex = i
-				};
-				inputInfoBuffers.emplace_back(
-					device::createBuffer(*_wgpuContext, inputInfo, "input info", wgpu::BufferUsage::Uniform)
-				);
-			};
+			//Pairs that are not in stpIds keep the UINT32_MAX layer so this pass leaves their pixels alone
+			std::vector<structs::TextureArrayLookup> lookups(
+				std::max<size_t>(descriptor->inputSTPs.size(), 1),
+				structs::TextureArrayLookup{ .layer = UINT32_MAX }
+			);
 			for (auto& stpId : descriptor->stpIds) {
-				structs::SamplerTexturePair stp = descriptor->inputSTPs.at(stpId);
-				insertInputBindGroup(
-					inputInfoBuffers[stpId],
-					descriptor->allTextureViews[stp.textureIndex],
-					descriptor->allSamplers[stp.samplerIndex]
-				);
+				const structs::SamplerTexturePair stp = descriptor->inputSTPs.at(stpId);
+				const bool useNearestFilter = stp.samplerIndex != UINT32_MAX &&
+					descriptor->inputSamplers.at(stp.samplerIndex).magFilter == wgpu::FilterMode::Nearest;
+				//glTF defaults to mipmapped minification when a texture has no sampler
+				const bool useMipmaps = stp.samplerIndex == UINT32_MAX ||
+					descriptor->inputSamplers.at(stp.samplerIndex).mipmapFilter != wgpu::MipmapFilterMode::Undefined;
+				const structs::host::TextureLayer textureLayer = descriptor->textureLayers.at(stp.textureIndex);
+				lookups[stpId] = structs::TextureArrayLookup{
+					.layer = textureLayer.layer,
+					.useNearestFilter = useNearestFilter,
+					.useMipmaps = useMipmaps,
+					.arrayIndex = textureLayer.arrayIndex,
+				};
 			}
+			_lookupBuffer = device::createBuffer<structs::TextureArrayLookup>(*_wgpuContext, lookups, "texture array lookups", wgpu::BufferUsage::Storage, enums::MemoryCategory::SCENE);
+
+			createInputBindGroup(
+				descriptor->textureArrayViews,
+				descriptor->linearSampler,
+				descriptor->nearestSampler
+			);
 		}
 
 		void doCommands(const render::accumulator::descriptor::DoCommands* descriptor) {
 			wgpu::ComputePassDescriptor computePassDescriptor = {
 				.label = "accumulator compute pass",
+				.timestampWrites = descriptor->timestampWrites,
 			};
 			wgpu::ComputePassEncoder computePassEncoder = descriptor->commandEncoder.BeginComputePass(&computePassDescriptor);
 			computePassEncoder.SetPipeline(_computePipeline);
 			computePassEncoder.SetBindGroup(0, _accumulatorBindGroup);
-			for (auto& bg : _inputBindGroups) {
-				computePassEncoder.SetBindGroup(1, bg);
-				computePassEncoder.DispatchWorkgroups(
-					_wgpuContext->getScreenDimensions().width, 
-					_wgpuContext->getScreenDimensions().height
-				);
-			}
+			computePassEncoder.SetBindGroup(1, _inputBindGroup);
+			render::dispatch::fullScreen(computePassEncoder, _wgpuContext);
 			computePassEncoder.End();
 		}
 
 	private:
+		//The first of constants::MAX_TEXTURE_ARRAYS consecutive bindings of the input bind group
+		static constexpr uint32_t TEXTURE_ARRAY_BINDING = 3;
+
 		wgpu::ShaderModule _computeShaderModule;
 
 		WGPUContext* _wgpuContext;
 
-		std::vector<wgpu::Buffer> _infoBuffer;
+		wgpu::Buffer _lookupBuffer;
 
 		wgpu::BindGroupLayout _accumulatorBindGroupLayout;
 		wgpu::BindGroupLayout _inputBindGroupLayout;
 		wgpu::BindGroup _accumulatorBindGroup;
-		std::vector<wgpu::BindGroup> _inputBindGroups;
+		wgpu::BindGroup _inputBindGroup;
 		wgpu::ComputePipeline _computePipeline;
 
 		void createAccumulatorBindGroupLayout(
@@ -166,34 +207,43 @@ namespace render {
 		}
 
 		void createInputBindGroupLayout() {
-			const wgpu::BindGroupLayoutEntry inputInfoBindGroupLayoutEntry = {
+			const wgpu::BindGroupLayoutEntry lookupBindGroupLayoutEntry = {
 				.binding = 0,
 				.visibility = wgpu::ShaderStage::Compute,
 				.buffer = {
-					.type = wgpu::BufferBindingType::Uniform,
-					.minBindingSize = 16,
+					.type = wgpu::BufferBindingType::ReadOnlyStorage,
+					.minBindingSize = sizeof(structs::TextureArrayLookup),
 				},
 			};
-			const wgpu::BindGroupLayoutEntry textureBindGroupLayoutEntry = {
+			const wgpu::BindGroupLayoutEntry linearSamplerBindGroupLayoutEntry = {
 				.binding = 1,
 				.visibility = wgpu::ShaderStage::Compute,
-				.texture = {
-					.sampleType = wgpu::TextureSampleType::Float,
-					.viewDimension = wgpu::TextureViewDimension::e2D,
+				.sampler = {
+					.type = wgpu::SamplerBindingType::Filtering,
 				},
 			};
-			const wgpu::BindGroupLayoutEntry samplerBindGroupLayoutEntry = {
+			const wgpu::BindGroupLayoutEntry nearestSamplerBindGroupLayoutEntry = {
 				.binding = 2,
 				.visibility = wgpu::ShaderStage::Compute,
 				.sampler = {
 					.type = wgpu::SamplerBindingType::Filtering,
 				},
 			};
-			std::array<wgpu::BindGroupLayoutEntry, 3> bindGroupLayoutEntries = {
-				inputInfoBindGroupLayoutEntry,
-				textureBindGroupLayoutEntry,
-				samplerBindGroupLayoutEntry,
+			std::vector<wgpu::BindGroupLayoutEntry> bindGroupLayoutEntries = {
+				lookupBindGroupLayoutEntry,
+				linearSamplerBindGroupLayoutEntry,
+				nearestSamplerBindGroupLayoutEntry,
 			};
+			for (uint32_t i = 0; i < constants::MAX_TEXTURE_ARRAYS; ++i) {
+				bindGroupLayoutEntries.push_back(wgpu::BindGroupLayoutEntry{
+					.binding = TEXTURE_ARRAY_BINDING + i,
+					.visibility = wgpu::ShaderStage::Compute,
+					.texture = {
+						.sampleType = wgpu::TextureSampleType::Float,
+						.viewDimension = wgpu::TextureViewDimension::e2DArray,
+					},
+				});
+			}
 
 			const wgpu::BindGroupLayoutDescriptor bindGroupLayoutDescriptor = {
 				.label = "input bind group layout",
@@ -217,11 +267,22 @@ namespace render {
 			return _wgpuContext->device.CreatePipelineLayout(&pipelineLayoutDescriptor);
 		};
 
-		void createComputePipeline() {
+		void createComputePipeline(PipelineBatch& pipelineBatch, const uint32_t textureIdShift) {
 			const wgpu::PipelineLayout pipelineLayout = getPipelineLayout();
+			const std::array<wgpu::ConstantEntry, 2> workgroupSizeConstants = render::dispatch::getWorkgroupSizeConstants(_wgpuContext);
+			const std::array<wgpu::ConstantEntry, 3> constants = {
+				workgroupSizeConstants[0],
+				workgroupSizeConstants[1],
+				wgpu::ConstantEntry{
+					.key = "TEXTURE_ID_SHIFT",
+					.value = static_cast<double>(textureIdShift),
+				},
+			};
 			wgpu::ComputeState computeState = {
 				.module = static_cast<Derived*>(this)->computeShaderModule,
 				.entryPoint = enums::EntryPoint::COMPUTE,
+				.constantCount = constants.size(),
+				.constants = constants.data(),
 			};
 
 			const wgpu::ComputePipelineDescriptor computePipelineDescriptor = {
@@ -229,7 +290,7 @@ namespace render {
 				.layout = pipelineLayout,
 				.compute = computeState,
 			};
-			_computePipeline = _wgpuContext->device.CreateComputePipeline(&computePipelineDescriptor);
+			pipelineBatch.createComputePipeline(computePipelineDescriptor, _computePipeline);
 		}
 
 		void createAccumulatorBindGroup(
@@ -269,35 +330,43 @@ namespace render {
 			_accumulatorBindGroup = _wgpuContext->device.CreateBindGroup(&bindGroupDescriptor);
 		}
 
-		void insertInputBindGroup(
-			const wgpu::Buffer& inputInfoBuffer,
-			const wgpu::TextureView& inputTextureView,
-			const wgpu::Sampler& sampler
+		//Slots past the scene's arrays repeat the first one, the lookups never point at them
+		void createInputBindGroup(
+			const std::vector<wgpu::TextureView>& textureArrayViews,
+			const wgpu::Sampler& linearSampler,
+			const wgpu::Sampler& nearestSampler
 		) {
-			const wgpu::BindGroupEntry inputInfoBindGroupEntry = {
+			const wgpu::BindGroupEntry lookupBindGroupEntry = {
 				.binding = 0,
-				.buffer = inputInfoBuffer,
+				.buffer = _lookupBuffer,
+				.size = _lookupBuffer.GetSize(),
 			};
-			const wgpu::BindGroupEntry textureBindGroupEntry = {
+			const wgpu::BindGroupEntry linearSamplerBindGroupEntry = {
 				.binding = 1,
-				.textureView = inputTextureView,
+				.sampler = linearSampler,
 			};
-			const wgpu::BindGroupEntry samplerBindGroupEntry = {
+			const wgpu::BindGroupEntry nearestSamplerBindGroupEntry = {
 				.binding = 2,
-				.sampler = sampler,
+				.sampler = nearestSampler,
 			};
-			std::array<wgpu::BindGroupEntry, 3> bindGroupEntries = {
-				inputInfoBindGroupEntry,
-				textureBindGroupEntry,
-				samplerBindGroupEntry,
+			std::vector<wgpu::BindGroupEntry> bindGroupEntries = {
+				lookupBindGroupEntry,
+				linearSamplerBindGroupEntry,
+				nearestSamplerBindGroupEntry,
 			};
+			for (uint32_t i = 0; i < constants::MAX_TEXTURE_ARRAYS; ++i) {
+				bindGroupEntries.push_back(wgpu::BindGroupEntry{
+					.binding = TEXTURE_ARRAY_BINDING + i,
+					.textureView = i < textureArrayViews.size() ? textureArrayViews[i] : textureArrayViews.front(),
+				});
+			}
 			const wgpu::BindGroupDescriptor bindGroupDescriptor = {
 				.label = "accumulator input bind group",
 				.layout = _inputBindGroupLayout,
 				.entryCount = bindGroupEntries.size(),
 				.entries = bindGroupEntries.data(),
 			};
-			_inputBindGroups.emplace_back(_wgpuContext->device.CreateBindGroup(&bindGroupDescriptor));
+			_inputBindGroup = _wgpuContext->device.CreateBindGroup(&bindGroupDescriptor);
 		}
 	};
 }
\ No newline at end of file
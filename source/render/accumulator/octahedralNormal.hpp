@@ -0,0 +1,23 @@
+#pragma once
+#include "base.hpp"
+
+namespace render {
+	//Resolves normal map texels into the octahedral packed normal texture
+	class OctahedralNormal : public BaseAccumulator<OctahedralNormal> {
+	public:
+		OctahedralNormal(WGPUContext* wgpuContext) : BaseAccumulator(wgpuContext) {
+			computeShaderModule = device::createWGSLShaderModule(
+				wgpuContext->device,
+				ACCUMULATOR_SHADER_LABEL,
+				ACCUMULATOR_SHADER_PATH
+			);
+		};
+
+		wgpu::ShaderModule computeShaderModule;
+
+	private:
+		const wgpu::StringView ACCUMULATOR_SHADER_LABEL = "octahedral normal accumulator shader";
+		const std::string ACCUMULATOR_SHADER_PATH = "shaders/octahedralNormalAccumulator_c.wgsl";
+
+	};
+}
@@ -0,0 +1,458 @@
+#pragma once
+#include "culling.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <format>
+#include "sceneDraw.hpp"
+#include "../device/device.hpp"
+#include "../enums.hpp"
+#include "../structs/host.hpp"
+
+namespace render {
+	Culling::Culling(WGPUContext* wgpuContext, const bool occlusionCulling) : _wgpuContext(wgpuContext), _occlusionCulling(occlusionCulling) {
+		_cullingShaderModule = device::createWGSLShaderModule(wgpuContext->device, CULLING_SHADER_LABEL, CULLING_SHADER_PATH);
+		_hiZDepthShaderModule = device::createWGSLShaderModule(wgpuContext->device, HI_Z_DEPTH_SHADER_LABEL, HI_Z_DEPTH_SHADER_PATH);
+		_hiZReduceShaderModule = device::createWGSLShaderModule(wgpuContext->device, HI_Z_REDUCE_SHADER_LABEL, HI_Z_REDUCE_SHADER_PATH);
+	}
+
+	Culling::~Culling() {
+		_wgpuContext->getMemoryRegistry().untrack(_hiZTexture);
+	}
+
+	void Culling::declareResources(FrameGraph& frameGraph) const {
+		//The hi-z the culling pass tests against is the one the previous frame built
+		frameGraph.addPass({
+			.pass = enums::GpuPass::CULLING,
+			.writes = { enums::FrameResource::CULLED_DRAWS },
+			.historyReads = { enums::FrameResource::HI_Z },
+		});
+		frameGraph.addPass({
+			.pass = enums::GpuPass::HI_Z,
+			.reads = { enums::FrameResource::DEPTH },
+			.writes = { enums::FrameResource::HI_Z },
+		});
+	}
+
+	void Culling::createPipelineAsync(PipelineBatch& pipelineBatch) {
+		createBindGroupLayouts();
+		createComputePipelines(pipelineBatch);
+	}
+
+	void Culling::generateGpuObjects(const DeviceResources* deviceResources) {
+		_sceneResources = deviceResources->scene;
+		if (!_sceneResources->culledDrawCalls) {
+			return;
+		}
+		_multiDraw = sceneDraw::canMultiDraw(_wgpuContext->device);
+
+		createHiZTexture(_occlusionCulling ? _wgpuContext->getScreenDimensions() : wgpu::Extent2D{ 1, 1 });
+		_params = {
+			.drawCount = static_cast<uint32_t>(_sceneResources->hostDrawCalls.size()),
+			.viewCount = getViewCount(),
+			.occlusionCulling = 0,
+			.hiZMipCount = _hiZTexture.GetMipLevelCount(),
+			.uint16DrawCount = _sceneResources->uint16DrawCount,
+		};
+		_shadowAtlasVersion = _sceneResources->shadowAtlasVersion;
+		_paramsBuffer = device::createBuffer(*_wgpuContext, _params, "culling params", wgpu::BufferUsage::Uniform);
+		_previousCamera = device::createBuffer(*_wgpuContext, glm::f32mat4x4(1.0f), "previous camera", wgpu::BufferUsage::Uniform);
+
+		createBindGroups(deviceResources);
+	}
+
+	void Culling::doCommands(const render::culling::descriptor::DoCommands* descriptor) {
+		if (!_cullingBindGroup) {
+			return;
+		}
+		//Written between frames, so it lands after the submit that built the first Hi-Z
+		bool paramsChanged = false;
+		if (_hiZBuilt && _params.occlusionCulling == 0) {
+			_params.occlusionCulling = 1;
+			paramsChanged = true;
+		}
+		//SceneResources::updateLight can give a square to a light past the last one that had a shadow map
+		if (_shadowAtlasVersion != _sceneResources->shadowAtlasVersion) {
+			_shadowAtlasVersion = _sceneResources->shadowAtlasVersion;
+			_params.viewCount = getViewCount();
+			paramsChanged = true;
+		}
+		if (paramsChanged) {
+			_wgpuContext->queue.WriteBuffer(_paramsBuffer, 0, &_params, sizeof(_params));
+		}
+
+		descriptor->commandEncoder.ClearBuffer(_sceneResources->culledDrawCounts);
+		//Render bundles draw every slot, the ones past the count must draw nothing
+		if (!_multiDraw) {
+			descriptor->commandEncoder.ClearBuffer(_sceneResources->culledDrawCalls);
+		}
+
+		wgpu::ComputePassDescriptor computePassDescriptor = {
+			.label = "culling compute pass",
+			.timestampWrites = descriptor->timestampWrites,
+		};
+		wgpu::ComputePassEncoder computePassEncoder = descriptor->commandEncoder.BeginComputePass(&computePassDescriptor);
+		computePassEncoder.SetPipeline(_cullingPipeline);
+		computePassEncoder.SetBindGroup(0, _cullingBindGroup);
+		computePassEncoder.DispatchWorkgroups((_params.drawCount + CULLING_WORKGROUP_SIZE - 1) / CULLING_WORKGROUP_SIZE, _params.viewCount);
+		computePassEncoder.End();
+	}
+
+	void Culling::doHiZCommands(const render::culling::descriptor::DoCommands* descriptor) {
+		if (!_occlusionCulling || !_cullingBindGroup) {
+			return;
+		}
+
+		wgpu::ComputePassDescriptor computePassDescriptor = {
+			.label = "hi-z compute pass",
+			.timestampWrites = descriptor->timestampWrites,
+		};
+		//Each level reads the one above it, dispatches in a pass are ordered so one pass covers the whole chain
+		wgpu::ComputePassEncoder computePassEncoder = descriptor->commandEncoder.BeginComputePass(&computePassDescriptor);
+		computePassEncoder.SetPipeline(_hiZDepthPipeline);
+		computePassEncoder.SetBindGroup(0, _hiZDepthBindGroup);
+		computePassEncoder.DispatchWorkgroups(
+			(_hiZTexture.GetWidth() + HI_Z_WORKGROUP_SIZE - 1) / HI_Z_WORKGROUP_SIZE,
+			(_hiZTexture.GetHeight() + HI_Z_WORKGROUP_SIZE - 1) / HI_Z_WORKGROUP_SIZE
+		);
+		computePassEncoder.SetPipeline(_hiZReducePipeline);
+		for (uint32_t level = 1; level < _hiZTexture.GetMipLevelCount(); ++level) {
+			const uint32_t levelWidth = std::max(_hiZTexture.GetWidth() >> level, 1u);
+			const uint32_t levelHeight = std::max(_hiZTexture.GetHeight() >> level, 1u);
+			computePassEncoder.SetBindGroup(0, _hiZReduceBindGroups[level - 1]);
+			computePassEncoder.DispatchWorkgroups(
+				(levelWidth + HI_Z_WORKGROUP_SIZE - 1) / HI_Z_WORKGROUP_SIZE,
+				(levelHeight + HI_Z_WORKGROUP_SIZE - 1) / HI_Z_WORKGROUP_SIZE
+			);
+		}
+		computePassEncoder.End();
+
+		descriptor->commandEncoder.CopyBufferToBuffer(_sceneResources->cameras, 0, _previousCamera, 0, sizeof(glm::f32mat4x4));
+		_hiZBuilt = true;
+	}
+
+	void Culling::createBindGroupLayouts() {
+		const std::array<wgpu::BindGroupLayoutEntry, 9> cullingBindGroupLayoutEntries = {
+			wgpu::BindGroupLayoutEntry{
+				.binding = 0,
+				.visibility = wgpu::ShaderStage::Compute,
+				.buffer = {
+					.type = wgpu::BufferBindingType::Uniform,
+					.minBindingSize = sizeof(structs::CullingParams),
+				},
+			},
+			wgpu::BindGroupLayoutEntry{
+				.binding = 1,
+				.visibility = wgpu::ShaderStage::Compute,
+				.buffer = {
+					.type = wgpu::BufferBindingType::ReadOnlyStorage,
+					.minBindingSize = sizeof(structs::host::DrawCall),
+				},
+			},
+			wgpu::BindGroupLayoutEntry{
+				.binding = 2,
+				.visibility = wgpu::ShaderStage::Compute,
+				.buffer = {
+					.type = wgpu::BufferBindingType::ReadOnlyStorage,
+					.minBindingSize = sizeof(structs::DrawBounds),
+				},
+			},
+			wgpu::BindGroupLayoutEntry{
+				.binding = 3,
+				.visibility = wgpu::ShaderStage::Compute,
+				.buffer = {
+					.type = wgpu::BufferBindingType::Uniform,
+					.minBindingSize = sizeof(glm::f32mat4x4),
+				},
+			},
+			wgpu::BindGroupLayoutEntry{
+				.binding = 4,
+				.visibility = wgpu::ShaderStage::Compute,
+				.buffer = {
+					.type = wgpu::BufferBindingType::ReadOnlyStorage,
+					.minBindingSize = sizeof(structs::Light),
+				},
+			},
+			wgpu::BindGroupLayoutEntry{
+				.binding = 5,
+				.visibility = wgpu::ShaderStage::Compute,
+				.buffer = {
+					.type = wgpu::BufferBindingType::Uniform,
+					.minBindingSize = sizeof(glm::f32mat4x4),
+				},
+			},
+			wgpu::BindGroupLayoutEntry{
+				.binding = 6,
+				.visibility = wgpu::ShaderStage::Compute,
+				.texture = {
+					.sampleType = wgpu::TextureSampleType::UnfilterableFloat,
+					.viewDimension = wgpu::TextureViewDimension::e2D,
+				},
+			},
+			wgpu::BindGroupLayoutEntry{
+				.binding = 7,
+				.visibility = wgpu::ShaderStage::Compute,
+				.buffer = {
+					.type = wgpu::BufferBindingType::Storage,
+					.minBindingSize = sizeof(structs::host::DrawCall),
+				},
+			},
+			wgpu::BindGroupLayoutEntry{
+				.binding = 8,
+				.visibility = wgpu::ShaderStage::Compute,
+				.buffer = {
+					.type = wgpu::BufferBindingType::Storage,
+					.minBindingSize = sizeof(uint32_t),
+				},
+			},
+		};
+		const wgpu::BindGroupLayoutDescriptor cullingBindGroupLayoutDescriptor = {
+			.label = "culling bind group layout",
+			.entryCount = cullingBindGroupLayoutEntries.size(),
+			.entries = cullingBindGroupLayoutEntries.data(),
+		};
+		_cullingBindGroupLayout = _wgpuContext->device.CreateBindGroupLayout(&cullingBindGroupLayoutDescriptor);
+
+		const std::array<wgpu::BindGroupLayoutEntry, 2> hiZDepthBindGroupLayoutEntries = {
+			wgpu::BindGroupLayoutEntry{
+				.binding = 0,
+				.visibility = wgpu::ShaderStage::Compute,
+				.texture = {
+					.sampleType = wgpu::TextureSampleType::Depth,
+					.viewDimension = wgpu::TextureViewDimension::e2D,
+				},
+			},
+			wgpu::BindGroupLayoutEntry{
+				.binding = 1,
+				.visibility = wgpu::ShaderStage::Compute,
+				.storageTexture = {
+					.access = wgpu::StorageTextureAccess::WriteOnly,
+					.format = HI_Z_FORMAT,
+					.viewDimension = wgpu::TextureViewDimension::e2D,
+				},
+			},
+		};
+		const wgpu::BindGroupLayoutDescriptor hiZDepthBindGroupLayoutDescriptor = {
+			.label = "hi-z depth bind group layout",
+			.entryCount = hiZDepthBindGroupLayoutEntries.size(),
+			.entries = hiZDepthBindGroupLayoutEntries.data(),
+		};
+		_hiZDepthBindGroupLayout = _wgpuContext->device.CreateBindGroupLayout(&hiZDepthBindGroupLayoutDescriptor);
+
+		const std::array<wgpu::BindGroupLayoutEntry, 2> hiZReduceBindGroupLayoutEntries = {
+			wgpu::BindGroupLayoutEntry{
+				.binding = 0,
+				.visibility = wgpu::ShaderStage::Compute,
+				.texture = {
+					.sampleType = wgpu::TextureSampleType::UnfilterableFloat,
+					.viewDimension = wgpu::TextureViewDimension::e2D,
+				},
+			},
+			wgpu::BindGroupLayoutEntry{
+				.binding = 1,
+				.visibility = wgpu::ShaderStage::Compute,
+				.storageTexture = {
+					.access = wgpu::StorageTextureAccess::WriteOnly,
+					.format = HI_Z_FORMAT,
+					.viewDimension = wgpu::TextureViewDimension::e2D,
+				},
+			},
+		};
+		const wgpu::BindGroupLayoutDescriptor hiZReduceBindGroupLayoutDescriptor = {
+			.label = "hi-z reduce bind group layout",
+			.entryCount = hiZReduceBindGroupLayoutEntries.size(),
+			.entries = hiZReduceBindGroupLayoutEntries.data(),
+		};
+		_hiZReduceBindGroupLayout = _wgpuContext->device.CreateBindGroupLayout(&hiZReduceBindGroupLayoutDescriptor);
+	}
+
+	void Culling::createComputePipelines(PipelineBatch& pipelineBatch) {
+		const wgpu::ComputePipelineDescriptor cullingPipelineDescriptor = {
+			.label = "culling compute pipeline",
+			.layout = getPipelineLayout(_cullingBindGroupLayout, "culling pipeline layout"),
+			.compute = {
+				.module = _cullingShaderModule,
+				.entryPoint = enums::EntryPoint::COMPUTE,
+			},
+		};
+		pipelineBatch.createComputePipeline(cullingPipelineDescriptor, _cullingPipeline);
+
+		//Occlusion culling may be off, but the Hi-Z pipelines are cheap and keep every pipeline known before the scene loads
+		const wgpu::ComputePipelineDescriptor hiZDepthPipelineDescriptor = {
+			.label = "hi-z depth compute pipeline",
+			.layout = getPipelineLayout(_hiZDepthBindGroupLayout, "hi-z depth pipeline layout"),
+			.compute = {
+				.module = _hiZDepthShaderModule,
+				.entryPoint = enums::EntryPoint::COMPUTE,
+			},
+		};
+		pipelineBatch.createComputePipeline(hiZDepthPipelineDescriptor, _hiZDepthPipeline);
+
+		const wgpu::ComputePipelineDescriptor hiZReducePipelineDescriptor = {
+			.label = "hi-z reduce compute pipeline",
+			.layout = getPipelineLayout(_hiZReduceBindGroupLayout, "hi-z reduce pipeline layout"),
+			.compute = {
+				.module = _hiZReduceShaderModule,
+				.entryPoint = enums::EntryPoint::COMPUTE,
+			},
+		};
+		pipelineBatch.createComputePipeline(hiZReducePipelineDescriptor, _hiZReducePipeline);
+	}
+
+	uint32_t Culling::getViewCount() const {
+		uint32_t culledLightCount = 0;
+		for (const structs::host::ShadowAtlasRect& rect : _sceneResources->shadowAtlasRects) {
+			culledLightCount = std::max(culledLightCount, rect.lightIndex + 1);
+		}
+		return sceneDraw::getLightView(culledLightCount);
+	}
+
+	wgpu::PipelineLayout Culling::getPipelineLayout(const wgpu::BindGroupLayout& bindGroupLayout, const std::string& label) {
+		const wgpu::PipelineLayoutDescriptor pipelineLayoutDescriptor = {
+			.label = wgpu::StringView(label),
+			.bindGroupLayoutCount = 1,
+			.bindGroupLayouts = &bindGroupLayout,
+		};
+		return _wgpuContext->device.CreatePipelineLayout(&pipelineLayoutDescriptor);
+	}
+
+	//Level 0 matches the depth texture, each level after it halves down to 1x1
+	void Culling::createHiZTexture(const wgpu::Extent2D& dimensions) {
+		const wgpu::TextureDescriptor textureDescriptor = {
+			.label = "hi-z texture",
+			.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::StorageBinding,
+			.dimension = wgpu::TextureDimension::e2D,
+			.size = {
+				.width = dimensions.width,
+				.height = dimensions.height,
+			},
+			.format = HI_Z_FORMAT,
+			.mipLevelCount = static_cast<uint32_t>(std::bit_width(std::max(dimensions.width, dimensions.height))),
+		};
+		_wgpuContext->getMemoryRegistry().untrack(_hiZTexture);
+		_hiZTexture = _wgpuContext->device.CreateTexture(&textureDescriptor);
+		_wgpuContext->getMemoryRegistry().track(_hiZTexture, "hi-z", enums::MemoryCategory::GBUFFER);
+
+		_hiZLevelViews.clear();
+		for (uint32_t level = 0; level < textureDescriptor.mipLevelCount; ++level) {
+			const std::string label = std::format("hi-z level {} view", level);
+			const wgpu::TextureViewDescriptor textureViewDescriptor = {
+				.label = wgpu::StringView(label),
+				.format = HI_Z_FORMAT,
+				.dimension = wgpu::TextureViewDimension::e2D,
+				.baseMipLevel = level,
+				.mipLevelCount = 1,
+				.arrayLayerCount = 1,
+				.aspect = wgpu::TextureAspect::All,
+			};
+			_hiZLevelViews.push_back(_hiZTexture.CreateView(&textureViewDescriptor));
+		}
+	}
+
+	void Culling::createBindGroups(const DeviceResources* deviceResources) {
+		const wgpu::TextureViewDescriptor hiZViewDescriptor = {
+			.label = "hi-z view",
+			.format = HI_Z_FORMAT,
+			.dimension = wgpu::TextureViewDimension::e2D,
+			.mipLevelCount = _hiZTexture.GetMipLevelCount(),
+			.arrayLayerCount = 1,
+			.aspect = wgpu::TextureAspect::All,
+			.usage = wgpu::TextureUsage::TextureBinding,
+		};
+		const std::array<wgpu::BindGroupEntry, 9> cullingBindGroupEntries = {
+			wgpu::BindGroupEntry{
+				.binding = 0,
+				.buffer = _paramsBuffer,
+				.size = sizeof(structs::CullingParams),
+			},
+			wgpu::BindGroupEntry{
+				.binding = 1,
+				.buffer = _sceneResources->drawCalls,
+				.size = _sceneResources->drawCalls.GetSize(),
+			},
+			wgpu::BindGroupEntry{
+				.binding = 2,
+				.buffer = _sceneResources->drawBounds,
+				.size = _sceneResources->drawBounds.GetSize(),
+			},
+			wgpu::BindGroupEntry{
+				.binding = 3,
+				.buffer = _sceneResources->cameras,
+				.size = sizeof(glm::f32mat4x4),
+			},
+			wgpu::BindGroupEntry{
+				.binding = 4,
+				.buffer = _sceneResources->lightStorage,
+				.size = _sceneResources->lightStorage.GetSize(),
+			},
+			wgpu::BindGroupEntry{
+				.binding = 5,
+				.buffer = _previousCamera,
+				.size = sizeof(glm::f32mat4x4),
+			},
+			wgpu::BindGroupEntry{
+				.binding = 6,
+				.textureView = _hiZTexture.CreateView(&hiZViewDescriptor),
+			},
+			wgpu::BindGroupEntry{
+				.binding = 7,
+				.buffer = _sceneResources->culledDrawCalls,
+				.size = _sceneResources->culledDrawCalls.GetSize(),
+			},
+			wgpu::BindGroupEntry{
+				.binding = 8,
+				.buffer = _sceneResources->culledDrawCounts,
+				.size = _sceneResources->culledDrawCounts.GetSize(),
+			},
+		};
+		const wgpu::BindGroupDescriptor cullingBindGroupDescriptor = {
+			.label = "culling bind group",
+			.layout = _cullingBindGroupLayout,
+			.entryCount = cullingBindGroupEntries.size(),
+			.entries = cullingBindGroupEntries.data(),
+		};
+		_cullingBindGroup = _wgpuContext->device.CreateBindGroup(&cullingBindGroupDescriptor);
+
+		if (!_occlusionCulling) {
+			return;
+		}
+		const std::array<wgpu::BindGroupEntry, 2> hiZDepthBindGroupEntries = {
+			wgpu::BindGroupEntry{
+				.binding = 0,
+				.textureView = deviceResources->render->depthTextureView,
+			},
+			wgpu::BindGroupEntry{
+				.binding = 1,
+				.textureView = _hiZLevelViews[0],
+			},
+		};
+		const wgpu::BindGroupDescriptor hiZDepthBindGroupDescriptor = {
+			.label = "hi-z depth bind group",
+			.layout = _hiZDepthBindGroupLayout,
+			.entryCount = hiZDepthBindGroupEntries.size(),
+			.entries = hiZDepthBindGroupEntries.data(),
+		};
+		_hiZDepthBindGroup = _wgpuContext->device.CreateBindGroup(&hiZDepthBindGroupDescriptor);
+
+		_hiZReduceBindGroups.clear();
+		for (uint32_t level = 1; level < _hiZLevelViews.size(); ++level) {
+			const std::array<wgpu::BindGroupEntry, 2> hiZReduceBindGroupEntries = {
+				wgpu::BindGroupEntry{
+					.binding = 0,
+					.textureView = _hiZLevelViews[level - 1],
+				},
+				wgpu::BindGroupEntry{
+					.binding = 1,
+					.textureView = _hiZLevelViews[level],
+				},
+			};
+			const wgpu::BindGroupDescriptor hiZReduceBindGroupDescriptor = {
+				.label = "hi-z reduce bind group",
+				.layout = _hiZReduceBindGroupLayout,
+				.entryCount = hiZReduceBindGroupEntries.size(),
+				.entries = hiZReduceBindGroupEntries.data(),
+			};
+			_hiZReduceBindGroups.push_back(_wgpuContext->device.CreateBindGroup(&hiZReduceBindGroupDescriptor));
+		}
+	}
+}
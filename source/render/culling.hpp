@@ -0,0 +1,85 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <dawn/webgpu_cpp.h>
+#include "../wgpuContext/wgpuContext.hpp"
+#include "../device/resources.hpp"
+#include "../device/pipelineBatch.hpp"
+#include "frameGraph.hpp"
+#include "../structs/structs.hpp"
+
+namespace render {
+	namespace culling::descriptor {
+		struct DoCommands {
+			wgpu::CommandEncoder& commandEncoder;
+			const wgpu::PassTimestampWrites* timestampWrites = nullptr;
+		};
+	}
+
+	//Frustum culls every primitive against the camera and each shadow casting light, and optionally occlusion culls it against
+	//a Hi-Z built from the previous frame's depth. Fills SceneResources::culledDrawCalls and culledDrawCounts, does nothing
+	//when SceneResources has no culled lists. A primitive that comes into view from behind an occluder shows up one frame late.
+	//Instanced draws are kept or culled as a whole
+	class Culling {
+	public:
+		Culling(WGPUContext* wgpuContext, const bool occlusionCulling);
+		~Culling();
+		Culling(const Culling&) = delete;
+		Culling& operator=(const Culling&) = delete;
+		void declareResources(FrameGraph& frameGraph) const;
+		void createPipelineAsync(PipelineBatch& pipelineBatch);
+		//The pipeline batch must have been waited on
+		void generateGpuObjects(const DeviceResources* deviceResources);
+		//Before any pass that draws the scene
+		void doCommands(const render::culling::descriptor::DoCommands* descriptor);
+		//After Initial, builds the Hi-Z the next frame is culled against. Does nothing without occlusion culling
+		void doHiZCommands(const render::culling::descriptor::DoCommands* descriptor);
+
+	private:
+		const wgpu::StringView CULLING_SHADER_LABEL = "culling compute shader";
+		const std::string CULLING_SHADER_PATH = "shaders/culling_c.wgsl";
+		const wgpu::StringView HI_Z_DEPTH_SHADER_LABEL = "hi-z depth compute shader";
+		const std::string HI_Z_DEPTH_SHADER_PATH = "shaders/hiZDepth_c.wgsl";
+		const wgpu::StringView HI_Z_REDUCE_SHADER_LABEL = "hi-z reduce compute shader";
+		const std::string HI_Z_REDUCE_SHADER_PATH = "shaders/hiZReduce_c.wgsl";
+		//Must match the WORKGROUP_SIZE overrides of the shaders
+		const uint32_t CULLING_WORKGROUP_SIZE = 64;
+		const uint32_t HI_Z_WORKGROUP_SIZE = 8;
+		const wgpu::TextureFormat HI_Z_FORMAT = wgpu::TextureFormat::R32Float;
+
+		wgpu::ShaderModule _cullingShaderModule;
+		wgpu::ShaderModule _hiZDepthShaderModule;
+		wgpu::ShaderModule _hiZReduceShaderModule;
+
+		WGPUContext* _wgpuContext;
+		const SceneResources* _sceneResources = nullptr;
+		bool _occlusionCulling;
+		bool _hiZBuilt = false; //occlusion culling starts the frame after the first Hi-Z
+		bool _multiDraw = false;
+		structs::CullingParams _params = {};
+		uint64_t _shadowAtlasVersion = 0; //the SceneResources::shadowAtlasVersion _params.viewCount is for
+
+		wgpu::Buffer _paramsBuffer;
+		wgpu::Buffer _previousCamera; //the camera the Hi-Z was built with
+		wgpu::Texture _hiZTexture; //1x1 placeholder without occlusion culling
+		std::vector<wgpu::TextureView> _hiZLevelViews;
+
+		wgpu::ComputePipeline _cullingPipeline;
+		wgpu::ComputePipeline _hiZDepthPipeline;
+		wgpu::ComputePipeline _hiZReducePipeline;
+		wgpu::BindGroupLayout _cullingBindGroupLayout;
+		wgpu::BindGroupLayout _hiZDepthBindGroupLayout;
+		wgpu::BindGroupLayout _hiZReduceBindGroupLayout;
+		wgpu::BindGroup _cullingBindGroup;
+		wgpu::BindGroup _hiZDepthBindGroup;
+		std::vector<wgpu::BindGroup> _hiZReduceBindGroups; //level i + 1 from level i
+
+		void createBindGroupLayouts();
+		void createComputePipelines(PipelineBatch& pipelineBatch);
+		wgpu::PipelineLayout getPipelineLayout(const wgpu::BindGroupLayout& bindGroupLayout, const std::string& label);
+		void createHiZTexture(const wgpu::Extent2D& dimensions);
+		void createBindGroups(const DeviceResources* deviceResources);
+		//The camera and the lights up to the last one with a shadow map, the lights after it are never drawn from
+		uint32_t getViewCount() const;
+	};
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include "dispatch.hpp"
+
+namespace render {
+	namespace dispatch {
+		std::array<wgpu::ConstantEntry, 2> getWorkgroupSizeConstants(WGPUContext* wgpuContext) {
+			const wgpu::Extent2D tileSize = wgpuContext->getComputeTileSize();
+			return std::array<wgpu::ConstantEntry, 2>{
+				wgpu::ConstantEntry{
+					.key = WORKGROUP_SIZE_X,
+					.value = static_cast<double>(tileSize.width),
+				},
+				wgpu::ConstantEntry{
+					.key = WORKGROUP_SIZE_Y,
+					.value = static_cast<double>(tileSize.height),
+				},
+			};
+		}
+
+		void fullScreen(const wgpu::ComputePassEncoder& computePassEncoder, WGPUContext* wgpuContext) {
+			const wgpu::Extent2D screenDimensions = wgpuContext->getScreenDimensions();
+			const wgpu::Extent2D tileSize = wgpuContext->getComputeTileSize();
+			computePassEncoder.DispatchWorkgroups(
+				(screenDimensions.width + tileSize.width - 1) / tileSize.width,
+				(screenDimensions.height + tileSize.height - 1) / tileSize.height
+			);
+		}
+	}
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <array>
+#include <dawn/webgpu_cpp.h>
+#include "../wgpuContext/wgpuContext.hpp"
+
+namespace render {
+	namespace dispatch {
+		//Names of the override constants every full screen compute shader declares for its @workgroup_size
+		constexpr wgpu::StringView WORKGROUP_SIZE_X = "WORKGROUP_SIZE_X";
+		constexpr wgpu::StringView WORKGROUP_SIZE_Y = "WORKGROUP_SIZE_Y";
+
+		//Pipeline constants that size the workgroup to WGPUContext::getComputeTileSize()
+		std::array<wgpu::ConstantEntry, 2> getWorkgroupSizeConstants(WGPUContext* wgpuContext);
+
+		//Dispatches enough tiles to cover the screen, the shader must bounds check the partial tiles on the edges
+		void fullScreen(const wgpu::ComputePassEncoder& computePassEncoder, WGPUContext* wgpuContext);
+	}
+}
@@ -0,0 +1,257 @@
+#pragma once
+#include "frameGraph.hpp"
+#include <algorithm>
+#include <format>
+#include <stdexcept>
+#include "absl/log/log.h"
+
+namespace {
+	//Ordered by enums::FrameResource
+	const std::array<std::string_view, static_cast<size_t>(enums::FrameResource::FRAME_RESOURCE_COUNT)> frameResourceNames = {
+		"depth",
+		"normal",
+		"texCoord",
+		"baseColor",
+		"textureIds",
+		"lighting",
+		"shadowAtlas",
+		"ultimate",
+		"surface",
+		"culledDraws",
+		"hiZ",
+		"tileLights",
+	};
+
+	size_t toIndex(const enums::FrameResource resource) {
+		return static_cast<size_t>(resource);
+	}
+
+	bool contains(const std::vector<enums::FrameResource>& resources, const enums::FrameResource resource) {
+		return std::find(resources.begin(), resources.end(), resource) != resources.end();
+	}
+}
+
+namespace render {
+	FrameGraph::FrameGraph(WGPUContext* wgpuContext, const std::vector<std::string>& passNames)
+		: _wgpuContext(wgpuContext), _passNames(passNames) {
+	}
+
+	//Aliased resources share textures, untracking one again does nothing
+	FrameGraph::~FrameGraph() {
+		for (const Resource& resource : _resources) {
+			for (const wgpu::Texture& texture : resource.textures) {
+				_wgpuContext->getMemoryRegistry().untrack(texture);
+			}
+		}
+	}
+
+	void FrameGraph::addPass(const frameGraph::descriptor::Pass& pass) {
+		_passes.push_back(pass);
+	}
+
+	void FrameGraph::addTexture(const enums::FrameResource resource, const frameGraph::descriptor::Texture& texture) {
+		Resource& entry = _resources[toIndex(resource)];
+		entry.hasTexture = true;
+		entry.texture = texture;
+	}
+
+	void FrameGraph::compile() {
+		const std::vector<uint32_t> order = orderPasses();
+		_passOrder.clear();
+		std::string passOrder;
+		for (const uint32_t p : order) {
+			_passOrder.push_back(_passes[p].pass);
+			passOrder += (passOrder.empty() ? "" : " > ") + getPassName(_passes[p].pass);
+		}
+		LOG(INFO) << "Frame graph pass order: " << passOrder;
+		allocateTextures(order);
+	}
+
+	const std::vector<enums::GpuPass>& FrameGraph::getPassOrder() const {
+		return _passOrder;
+	}
+
+	const std::vector<wgpu::Texture>& FrameGraph::getTextures(const enums::FrameResource resource) const {
+		return _resources[toIndex(resource)].textures;
+	}
+
+	const std::vector<wgpu::TextureView>& FrameGraph::getTextureViews(const enums::FrameResource resource) const {
+		return _resources[toIndex(resource)].textureViews;
+	}
+
+	uint64_t FrameGraph::getAliasedBytes() const {
+		return _aliasedBytes;
+	}
+
+	std::string FrameGraph::getPassName(const enums::GpuPass pass) const {
+		return static_cast<size_t>(pass) < _passNames.size() ? _passNames[pass] : std::format("pass {}", static_cast<uint32_t>(pass));
+	}
+
+	//Writers of a resource run in the order they were added, readers after its last writer. Among the passes that are
+	//ready, the one added first runs first, so passes added in a valid order keep it
+	std::vector<uint32_t> FrameGraph::orderPasses() const {
+		const uint32_t passCount = static_cast<uint32_t>(_passes.size());
+		std::vector<std::vector<uint32_t>> successors(passCount);
+		std::vector<uint32_t> predecessorCounts(passCount, 0);
+		const auto addEdge = [&successors, &predecessorCounts](const uint32_t from, const uint32_t to) {
+			successors[from].push_back(to);
+			predecessorCounts[to]++;
+		};
+
+		for (size_t r = 0; r < RESOURCE_COUNT; ++r) {
+			const enums::FrameResource resource = static_cast<enums::FrameResource>(r);
+			std::vector<uint32_t> writers;
+			for (uint32_t p = 0; p < passCount; ++p) {
+				if (contains(_passes[p].writes, resource)) {
+					writers.push_back(p);
+				}
+			}
+			for (size_t w = 1; w < writers.size(); ++w) {
+				addEdge(writers[w - 1], writers[w]);
+			}
+			for (uint32_t p = 0; p < passCount; ++p) {
+				if (!contains(_passes[p].reads, resource) || contains(_passes[p].writes, resource)) {
+					continue;
+				}
+				if (!writers.empty()) {
+					addEdge(writers.back(), p);
+				}
+				else if (!_resources[r].hasTexture || !_resources[r].texture.persistent) {
+					throw std::runtime_error(std::format("{} reads {} but no pass writes it", getPassName(_passes[p].pass), frameResourceNames[r]));
+				}
+			}
+		}
+
+		std::vector<uint32_t> order;
+		std::vector<bool> ordered(passCount, false);
+		while (order.size() < passCount) {
+			uint32_t next = passCount;
+			for (uint32_t p = 0; p < passCount; ++p) {
+				if (!ordered[p] && predecessorCounts[p] == 0) {
+					next = p;
+					break;
+				}
+			}
+			if (next == passCount) {
+				throw std::runtime_error("frame graph passes depend on each other in a cycle");
+			}
+			ordered[next] = true;
+			order.push_back(next);
+			for (const uint32_t successor : successors[next]) {
+				predecessorCounts[successor]--;
+			}
+		}
+		return order;
+	}
+
+	//Greedy interval allocation in order of first use, a texture is reused once the last pass of its previous resources has run.
+	//A pass that ends one resource and starts another never gets them on the same texture
+	void FrameGraph::allocateTextures(const std::vector<uint32_t>& order) {
+		std::array<uint32_t, RESOURCE_COUNT> firstUses;
+		std::array<uint32_t, RESOURCE_COUNT> lastUses;
+		firstUses.fill(UINT32_MAX);
+		lastUses.fill(0);
+		for (uint32_t position = 0; position < order.size(); ++position) {
+			const frameGraph::descriptor::Pass& pass = _passes[order[position]];
+			for (const std::vector<enums::FrameResource>* resources : { &pass.reads, &pass.writes }) {
+				for (const enums::FrameResource resource : *resources) {
+					const size_t r = toIndex(resource);
+					if (firstUses[r] == UINT32_MAX) {
+						firstUses[r] = position;
+						//Another resource's contents would be read
+						if (contains(pass.reads, resource) && _resources[r].hasTexture && !_resources[r].texture.persistent) {
+							throw std::runtime_error(std::format("{} reads the transient {} before any pass writes it", getPassName(pass.pass), frameResourceNames[r]));
+						}
+					}
+					lastUses[r] = position;
+				}
+			}
+		}
+
+		std::vector<size_t> textured;
+		for (size_t r = 0; r < RESOURCE_COUNT; ++r) {
+			if (_resources[r].hasTexture) {
+				textured.push_back(r);
+			}
+		}
+		std::stable_sort(textured.begin(), textured.end(), [&firstUses](const size_t lhs, const size_t rhs) {
+			return firstUses[lhs] < firstUses[rhs];
+		});
+
+		std::vector<Allocation> allocations;
+		for (const size_t r : textured) {
+			const frameGraph::descriptor::Texture& texture = _resources[r].texture;
+			const bool shared = !texture.persistent && firstUses[r] != UINT32_MAX;
+			const auto compatible = std::find_if(allocations.begin(), allocations.end(), [&](const Allocation& allocation) {
+				const frameGraph::descriptor::Texture& other = _resources[toIndex(allocation.resources.front())].texture;
+				return shared && allocation.shared && allocation.lastUse < firstUses[r] &&
+					other.format == texture.format && other.size.width == texture.size.width && other.size.height == texture.size.height &&
+					other.count == texture.count;
+			});
+			Allocation& allocation = compatible != allocations.end() ? *compatible : allocations.emplace_back(Allocation{ .shared = shared });
+			allocation.resources.push_back(static_cast<enums::FrameResource>(r));
+			allocation.usage = allocation.usage | texture.usage;
+			allocation.lastUse = lastUses[r];
+		}
+
+		uint64_t unaliasedBytes = 0;
+		uint64_t allocatedBytes = 0;
+		for (const Allocation& allocation : allocations) {
+			createTextures(allocation);
+			uint64_t allocationBytes = 0;
+			for (const wgpu::Texture& texture : _resources[toIndex(allocation.resources.front())].textures) {
+				allocationBytes += MemoryRegistry::getTextureSize(texture);
+			}
+			unaliasedBytes += allocationBytes * allocation.resources.size();
+			allocatedBytes += allocationBytes;
+		}
+		_aliasedBytes = unaliasedBytes - allocatedBytes;
+		LOG(INFO) << std::format(
+			"Frame graph: {} textured resources in {} allocations, aliasing saves {:.2f} MiB",
+			textured.size(),
+			allocations.size(),
+			static_cast<double>(_aliasedBytes) / (1024.0 * 1024.0)
+		);
+	}
+
+	void FrameGraph::createTextures(const Allocation& allocation) {
+		const frameGraph::descriptor::Texture& first = _resources[toIndex(allocation.resources.front())].texture;
+		std::string allocationLabel;
+		for (const enums::FrameResource resource : allocation.resources) {
+			allocationLabel += (allocationLabel.empty() ? "" : " / ") + _resources[toIndex(resource)].texture.label;
+		}
+
+		for (uint32_t i = 0; i < first.count; ++i) {
+			const std::string label = first.count > 1 ? std::format("{} {}", allocationLabel, i) : allocationLabel;
+			const std::string textureLabel = label + " texture";
+			const wgpu::TextureDescriptor textureDescriptor = {
+				.label = wgpu::StringView(textureLabel),
+				.usage = allocation.usage,
+				.dimension = wgpu::TextureDimension::e2D,
+				.size = {
+					.width = first.size.width,
+					.height = first.size.height,
+				},
+				.format = first.format,
+			};
+			const wgpu::Texture texture = _wgpuContext->device.CreateTexture(&textureDescriptor);
+			_wgpuContext->getMemoryRegistry().track(texture, label, first.memoryCategory);
+
+			for (const enums::FrameResource resource : allocation.resources) {
+				Resource& entry = _resources[toIndex(resource)];
+				const std::string viewLabel = entry.texture.label + " texture view";
+				const wgpu::TextureViewDescriptor textureViewDescriptor = {
+					.label = wgpu::StringView(viewLabel),
+					.format = first.format,
+					.dimension = wgpu::TextureViewDimension::e2D,
+					.mipLevelCount = 1,
+					.arrayLayerCount = 1,
+					.aspect = wgpu::TextureAspect::All,
+					.usage = entry.texture.usage,
+				};
+				entry.textures.push_back(texture);
+				entry.textureViews.push_back(texture.CreateView(&textureViewDescriptor));
+			}
+		}
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <dawn/webgpu_cpp.h>
+#include "../wgpuContext/wgpuContext.hpp"
+#include "../enums.hpp"
+
+namespace render {
+	namespace frameGraph::descriptor {
+		struct Pass {
+			enums::GpuPass pass;
+			std::vector<enums::FrameResource> reads;
+			std::vector<enums::FrameResource> writes; //a pass that keeps part of what it writes lists it in reads too
+			std::vector<enums::FrameResource> historyReads; //what the previous frame left, these do not order the passes
+		};
+
+		struct Texture {
+			std::string label;
+			wgpu::TextureFormat format;
+			wgpu::TextureUsage usage;
+			wgpu::Extent2D size;
+			uint32_t count = 1; //textures of the resource, all live for the same passes
+			//Contents that outlive the passes using it, e.g. read back after the frame or never written. Never aliased
+			bool persistent = false;
+			enums::MemoryCategory memoryCategory = enums::MemoryCategory::GBUFFER;
+		};
+	}
+
+	//Each render class declares which FrameResources its passes read and write. compile() orders the passes so that every
+	//read comes after the writes of the resource, writers keeping the order they were added in. It then shares one texture
+	//between transient resources of the same format and size whose lifetimes within that order do not overlap.
+	//Dawn already inserts the barriers between passes from the usage of each texture, so the graph only orders them
+	class FrameGraph {
+	public:
+		//passNames are ordered by enums::GpuPass and only used for logging and errors
+		FrameGraph(WGPUContext* wgpuContext, const std::vector<std::string>& passNames);
+		~FrameGraph();
+		FrameGraph(const FrameGraph&) = delete;
+		FrameGraph& operator=(const FrameGraph&) = delete;
+
+		void addPass(const frameGraph::descriptor::Pass& pass);
+		//Resources without a texture are buffers or the surface, they only order the passes
+		void addTexture(const enums::FrameResource resource, const frameGraph::descriptor::Texture& texture);
+		//Throws when a pass reads a resource that nothing writes, the passes form a cycle, or a transient texture is read
+		//before it is written
+		void compile();
+
+		const std::vector<enums::GpuPass>& getPassOrder() const;
+		//count textures of the resource, aliased resources return the same textures
+		const std::vector<wgpu::Texture>& getTextures(const enums::FrameResource resource) const;
+		const std::vector<wgpu::TextureView>& getTextureViews(const enums::FrameResource resource) const;
+		//Bytes the textures would take if no resource shared them, minus what they take
+		uint64_t getAliasedBytes() const;
+
+	private:
+		static constexpr size_t RESOURCE_COUNT = static_cast<size_t>(enums::FrameResource::FRAME_RESOURCE_COUNT);
+
+		struct Resource {
+			bool hasTexture = false;
+			frameGraph::descriptor::Texture texture;
+			std::vector<wgpu::Texture> textures;
+			std::vector<wgpu::TextureView> textureViews;
+		};
+		//Textures shared by every resource in it
+		struct Allocation {
+			std::vector<enums::FrameResource> resources;
+			wgpu::TextureUsage usage = wgpu::TextureUsage::None;
+			bool shared = true; //false for persistent resources and those no pass uses
+			uint32_t lastUse = 0; //position in _passOrder
+		};
+
+		WGPUContext* _wgpuContext;
+		std::vector<std::string> _passNames;
+		std::vector<frameGraph::descriptor::Pass> _passes;
+		std::array<Resource, RESOURCE_COUNT> _resources;
+		std::vector<enums::GpuPass> _passOrder;
+		uint64_t _aliasedBytes = 0;
+
+		std::string getPassName(const enums::GpuPass pass) const;
+		//Indices into _passes
+		std::vector<uint32_t> orderPasses() const;
+		void allocateTextures(const std::vector<uint32_t>& order);
+		void createTextures(const Allocation& allocation);
+	};
+}
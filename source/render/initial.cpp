@@ -4,27 +4,41 @@
 #include "../device/device.hpp"
 #include "../enums.hpp"
 #include "vertexBufferLayout.hpp"
+#include "sceneDraw.hpp"
 
 namespace render {
-	Initial::Initial(WGPUContext* wgpuContext) : _wgpuContext(wgpuContext) {
-		_vertexShaderModule = device::createWGSLShaderModule(_wgpuContext->device, VERTEX_SHADER_LABEL, VERTEX_SHADER_PATH);
+	Initial::Initial(WGPUContext* wgpuContext, const bool quantizedVertices) : _wgpuContext(wgpuContext), _quantizedVertices(quantizedVertices) {
+		_vertexShaderModule = device::createWGSLShaderModule(
+			_wgpuContext->device,
+			VERTEX_SHADER_LABEL,
+			_quantizedVertices ? QUANTIZED_VERTEX_SHADER_PATH : VERTEX_SHADER_PATH
+		);
 		_oneFragmentShaderModule = device::createWGSLShaderModule(_wgpuContext->device, FRAGMENT_SHADER_LABEL, FRAGMENT_SHADER_PATH);
 	};
 
+	void Initial::declareResources(FrameGraph& frameGraph) const {
+		frameGraph.addPass({
+			.pass = enums::GpuPass::INITIAL,
+			.reads = { enums::FrameResource::CULLED_DRAWS },
+			.writes = { enums::FrameResource::DEPTH, enums::FrameResource::NORMAL, enums::FrameResource::TEX_COORD, enums::FrameResource::BASE_COLOR, enums::FrameResource::TEXTURE_IDS },
+		});
+	}
+
+	void Initial::createPipelineAsync(PipelineBatch& pipelineBatch, const RenderResources* renderResources) {
+		createInputBindGroupLayout();
+		createPipelines(pipelineBatch, renderResources);
+	}
+
 	void Initial::generateGpuObjects(
 		const DeviceResources* deviceResources
 	) {
-		createInputBindGroupLayout();
-		createPipelines(deviceResources);
 		createInputBindGroup(deviceResources);
+		_sceneResources = deviceResources->scene;
+		if (!sceneDraw::canMultiDraw(_wgpuContext->device)) {
+			createRenderBundle(deviceResources->render);
+		}
 
 		_renderPassColorAttachments = {
-			wgpu::RenderPassColorAttachment {
-				.view = deviceResources->render->worldPositionTextureView,
-				.loadOp = wgpu::LoadOp::Clear,
-				.storeOp = wgpu::StoreOp::Store,
-				.clearValue = wgpu::Color{0.0f, 0.0f, 0.0f, 0.0f},
-			},
 			wgpu::RenderPassColorAttachment {
 				.view = deviceResources->render->normalTextureView,
 				.loadOp = wgpu::LoadOp::Clear,
@@ -43,6 +57,13 @@ namespace render {
 				.storeOp = wgpu::StoreOp::Store,
 				.clearValue = wgpu::Color{0.3f, 0.3f, 1.0f, 1.0f},
 			},
+			//Background has no texture for either accumulator
+			wgpu::RenderPassColorAttachment {
+				.view = deviceResources->render->textureIdsTextureView,
+				.loadOp = wgpu::LoadOp::Clear,
+				.storeOp = wgpu::StoreOp::Store,
+				.clearValue = wgpu::Color{static_cast<double>(UINT32_MAX), 0.0f, 0.0f, 0.0f},
+			},
 		};
 	};
 
@@ -61,33 +82,29 @@ namespace render {
 				.colorAttachmentCount = _renderPassColorAttachments.size(),
 				.colorAttachments = _renderPassColorAttachments.data(),
 				.depthStencilAttachment = &renderPassDepthStencilAttachment,
+				.timestampWrites = descriptor->timestampWrites,
 			};
 			wgpu::RenderPassEncoder renderPassEncoder = descriptor->commandEncoder.BeginRenderPass(&renderPassDescriptor);
-			renderPassEncoder.SetPipeline(_renderPipeline);
-			renderPassEncoder.SetVertexBuffer(0, descriptor->vertexBuffer, 0, descriptor->vertexBuffer.GetSize());
-			renderPassEncoder.SetIndexBuffer(
-				descriptor->indexBuffer,
-				wgpu::IndexFormat::Uint16,
-				0,
-				descriptor->indexBuffer.GetSize()
-			);
-			renderPassEncoder.SetBindGroup(0, _inputBindGroup);
-
-			for (const auto& dc : descriptor->drawCalls) {
-				renderPassEncoder.DrawIndexed(dc.indexCount, dc.instanceCount, dc.firstIndex, dc.baseVertex, dc.firstInstance);
+			if (_renderBundle) {
+				renderPassEncoder.ExecuteBundles(1, &_renderBundle);
+			}
+			else {
+				renderPassEncoder.SetPipeline(_renderPipeline);
+				renderPassEncoder.SetBindGroup(0, _inputBindGroup);
+				sceneDraw::multiDraw(renderPassEncoder, _sceneResources, sceneDraw::CAMERA_VIEW);
 			}
 			renderPassEncoder.End();
 		}
 	}
 
-	void Initial::createPipelines(const DeviceResources* deviceResources) {
+	void Initial::createPipelines(PipelineBatch& pipelineBatch, const RenderResources* renderResources) {
 		const wgpu::PipelineLayout pipelineLayout = getPipelineLayout();
 
 		const wgpu::VertexState vertexState = {
 			.module = _vertexShaderModule,
 			.entryPoint = enums::EntryPoint::VERTEX,
 			.bufferCount = 1,
-			.buffers = &render::vertexBufferLayout,
+			.buffers = _quantizedVertices ? &render::quantizedVertexBufferLayout : &render::vertexBufferLayout,
 		};
 
 		wgpu::RenderPipelineDescriptor renderPipelineDescriptor = {
@@ -106,10 +123,10 @@ namespace render {
 
 		renderPipelineDescriptor.label = "initial render pipeline";
 		const std::array<wgpu::ColorTargetState, 4> colorTargetStates = {
-			wgpu::ColorTargetState {.format = deviceResources->render->worldPositionTextureFormat},
-			wgpu::ColorTargetState {.format = deviceResources->render->normalTextureFormat},
-			wgpu::ColorTargetState {.format = deviceResources->render->texCoordTextureFormat},
-			wgpu::ColorTargetState {.format = deviceResources->render->baseColorTextureFormat},
+			wgpu::ColorTargetState {.format = renderResources->normalTextureFormat},
+			wgpu::ColorTargetState {.format = renderResources->texCoordTextureFormat},
+			wgpu::ColorTargetState {.format = renderResources->baseColorTextureFormat},
+			wgpu::ColorTargetState {.format = renderResources->textureIdsTextureFormat},
 		};
 		const wgpu::FragmentState fragmentState = {
 			.module = _oneFragmentShaderModule,
@@ -120,13 +137,38 @@ namespace render {
 		renderPipelineDescriptor.fragment = &fragmentState;
 
 		const wgpu::DepthStencilState depthStencilState = {
-			.format = deviceResources->render->depthTextureFormat,
+			.format = renderResources->depthTextureFormat,
 			.depthWriteEnabled = true,
 			.depthCompare = wgpu::CompareFunction::Less,
 		};
 		renderPipelineDescriptor.depthStencil = &depthStencilState;
 
-		_renderPipeline = _wgpuContext->device.CreateRenderPipeline(&renderPipelineDescriptor);
+		pipelineBatch.createRenderPipeline(renderPipelineDescriptor, _renderPipeline);
+	}
+
+	//Recorded once, the culling pass rewrites the draw arguments the bundle reads rather than the bundle itself
+	void Initial::createRenderBundle(const RenderResources* renderResources) {
+		const std::array<wgpu::TextureFormat, 4> colorFormats = {
+			renderResources->normalTextureFormat,
+			renderResources->texCoordTextureFormat,
+			renderResources->baseColorTextureFormat,
+			renderResources->textureIdsTextureFormat,
+		};
+		const wgpu::RenderBundleEncoderDescriptor renderBundleEncoderDescriptor = {
+			.label = "initial render bundle encoder",
+			.colorFormatCount = colorFormats.size(),
+			.colorFormats = colorFormats.data(),
+			.depthStencilFormat = renderResources->depthTextureFormat,
+			.sampleCount = 1,
+		};
+		const wgpu::RenderBundleEncoder renderBundleEncoder = _wgpuContext->device.CreateRenderBundleEncoder(&renderBundleEncoderDescriptor);
+		renderBundleEncoder.SetPipeline(_renderPipeline);
+		renderBundleEncoder.SetBindGroup(0, _inputBindGroup);
+		sceneDraw::drawEach(renderBundleEncoder, _wgpuContext->device, _sceneResources, sceneDraw::CAMERA_VIEW);
+		const wgpu::RenderBundleDescriptor renderBundleDescriptor = {
+			.label = "initial render bundle",
+		};
+		_renderBundle = renderBundleEncoder.Finish(&renderBundleDescriptor);
 	}
 
 	void Initial::createInputBindGroup(
@@ -147,10 +189,10 @@ namespace render {
 			.buffer = deviceResources->scene->transforms,
 			.size = deviceResources->scene->transforms.GetSize(),
 		};
-		const wgpu::BindGroupEntry materialIndicesBindGroupEntry = {
+		const wgpu::BindGroupEntry instancesBindGroupEntry = {
 			.binding = 3,
-			.buffer = deviceResources->scene->materialIndices,
-			.size = deviceResources->scene->materialIndices.GetSize(),
+			.buffer = deviceResources->scene->instances,
+			.size = deviceResources->scene->instances.GetSize(),
 		};
 		const wgpu::BindGroupEntry materialBindGroupEntry = {
 			.binding = 4,
@@ -158,13 +200,25 @@ namespace render {
 			.size = deviceResources->scene->materials.GetSize(),
 		};
 
-		std::array<wgpu::BindGroupEntry, 5> bindGroupEntries = {
+		std::vector<wgpu::BindGroupEntry> bindGroupEntries = {
 			screenDimensionsBindGroupEntry,
 			cameraBindGroupEntry,
 			transformBindGroupEntry,
-			materialIndicesBindGroupEntry,
+			instancesBindGroupEntry,
 			materialBindGroupEntry,
 		};
+		if (_quantizedVertices) {
+			bindGroupEntries.push_back(wgpu::BindGroupEntry{
+				.binding = 5,
+				.buffer = deviceResources->scene->vertexQuantizations,
+				.size = deviceResources->scene->vertexQuantizations.GetSize(),
+			});
+			bindGroupEntries.push_back(wgpu::BindGroupEntry{
+				.binding = 6,
+				.buffer = deviceResources->scene->vertexQuantizationIndices,
+				.size = deviceResources->scene->vertexQuantizationIndices.GetSize(),
+			});
+		}
 		const wgpu::BindGroupDescriptor bindGroupDescriptor = {
 			.label = "initial render input bind group",
 			.layout = _inputBindGroupLayout,
@@ -199,12 +253,12 @@ namespace render {
 				.minBindingSize = sizeof(glm::f32mat4x4),
 			},
 		};
-		const wgpu::BindGroupLayoutEntry instancePropertiesBindGroupLayoutEntry = {
+		const wgpu::BindGroupLayoutEntry instancesBindGroupLayoutEntry = {
 			.binding = 3,
-			.visibility = wgpu::ShaderStage::Fragment,
+			.visibility = wgpu::ShaderStage::Vertex,
 			.buffer = {
 				.type = wgpu::BufferBindingType::ReadOnlyStorage,
-				.minBindingSize = sizeof(uint32_t),
+				.minBindingSize = sizeof(structs::Instance),
 			}
 		};
 		const wgpu::BindGroupLayoutEntry materialBindGroupLayoutEntry = {
@@ -216,13 +270,31 @@ namespace render {
 			},
 		};
 
-		std::array<wgpu::BindGroupLayoutEntry, 5> bindGroupLayoutEntries = {
+		std::vector<wgpu::BindGroupLayoutEntry> bindGroupLayoutEntries = {
 			screenDimensionBindGroupLayoutEntry,
 			cameraBindGroupLayoutEntry,
 			transformBindGroupLayoutEntry,
-			instancePropertiesBindGroupLayoutEntry,
+			instancesBindGroupLayoutEntry,
 			materialBindGroupLayoutEntry,
 		};
+		if (_quantizedVertices) {
+			bindGroupLayoutEntries.push_back(wgpu::BindGroupLayoutEntry{
+				.binding = 5,
+				.visibility = wgpu::ShaderStage::Vertex,
+				.buffer = {
+					.type = wgpu::BufferBindingType::ReadOnlyStorage,
+					.minBindingSize = sizeof(structs::VertexQuantization),
+				},
+			});
+			bindGroupLayoutEntries.push_back(wgpu::BindGroupLayoutEntry{
+				.binding = 6,
+				.visibility = wgpu::ShaderStage::Vertex,
+				.buffer = {
+					.type = wgpu::BufferBindingType::ReadOnlyStorage,
+					.minBindingSize = sizeof(uint32_t),
+				},
+			});
+		}
 
 		const wgpu::BindGroupLayoutDescriptor bindGroupLayoutDescriptor = {
 			.label = "initial render input bind group layout",
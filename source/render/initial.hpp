@@ -8,21 +8,25 @@
 #include "../structs/host.hpp"
 #include "../wgpuContext/wgpuContext.hpp"
 #include "../device/resources.hpp"
+#include "../device/pipelineBatch.hpp"
+#include "frameGraph.hpp"
 
 namespace render {
 	namespace initial::descriptor {
 		struct DoCommands {
 			wgpu::CommandEncoder& commandEncoder;
-			wgpu::Buffer& vertexBuffer;
-			wgpu::Buffer& indexBuffer;
-			std::vector<structs::host::DrawCall>& drawCalls;
 			wgpu::TextureView& depthTextureView;
+			const wgpu::PassTimestampWrites* timestampWrites = nullptr;
 		};
 	}
 
 	class Initial {
 	public:
-		Initial(WGPUContext* wgpuContext);
+		//quantizedVertices draws SceneResources::vbo as structs::QuantizedVBO, it must match how the scene was loaded
+		Initial(WGPUContext* wgpuContext, const bool quantizedVertices);
+		void declareResources(FrameGraph& frameGraph) const;
+		void createPipelineAsync(PipelineBatch& pipelineBatch, const RenderResources* renderResources);
+		//The pipeline batch must have been waited on
 		void generateGpuObjects(const DeviceResources* deviceResources);
 		void doCommands(const render::initial::descriptor::DoCommands* descriptor);
 
@@ -31,13 +35,17 @@ namespace render {
 
 		const wgpu::StringView VERTEX_SHADER_LABEL = "initial render vertex shader";
 		const std::string VERTEX_SHADER_PATH = "shaders/initialRender_v.wgsl";
+		const std::string QUANTIZED_VERTEX_SHADER_PATH = "shaders/initialRenderQuantized_v.wgsl";
 		wgpu::ShaderModule _vertexShaderModule;
+		bool _quantizedVertices;
 
 		const wgpu::StringView FRAGMENT_SHADER_LABEL = "initial render fragment shader";
 		const std::string FRAGMENT_SHADER_PATH = "shaders/initialRender_f.wgsl";
 		wgpu::ShaderModule _oneFragmentShaderModule;
 		
 		wgpu::RenderPipeline _renderPipeline;
+		const SceneResources* _sceneResources = nullptr;
+		wgpu::RenderBundle _renderBundle; //every draw of the pass, null when the pass multi draws instead
 
 		wgpu::BindGroupLayout _inputBindGroupLayout;
 		wgpu::BindGroup _inputBindGroup;
@@ -49,7 +57,8 @@ namespace render {
 
 		wgpu::PipelineLayout getPipelineLayout();
 		void createInputBindGroupLayout();
-		void createPipelines(const DeviceResources* deviceResources);
+		void createPipelines(PipelineBatch& pipelineBatch, const RenderResources* renderResources);
 		void createInputBindGroup(const DeviceResources* deviceResources);
+		void createRenderBundle(const RenderResources* renderResources);
 	};
 }
\ No newline at end of file
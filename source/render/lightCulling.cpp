@@ -0,0 +1,185 @@
+#pragma once
+#include "lightCulling.hpp"
+#include <array>
+#include "../device/device.hpp"
+#include "../enums.hpp"
+#include "../structs/structs.hpp"
+
+namespace render {
+	LightCulling::LightCulling(WGPUContext* wgpuContext) : _wgpuContext(wgpuContext) {
+		_computeShaderModule = device::createWGSLShaderModule(wgpuContext->device, LIGHTCULLING_SHADER_LABEL, LIGHTCULLING_SHADER_PATH);
+	};
+
+	void LightCulling::declareResources(FrameGraph& frameGraph) const {
+		frameGraph.addPass({
+			.pass = enums::GpuPass::LIGHT_CULLING,
+			.reads = { enums::FrameResource::DEPTH },
+			.writes = { enums::FrameResource::TILE_LIGHTS },
+		});
+	}
+
+	void LightCulling::createPipelineAsync(PipelineBatch& pipelineBatch) {
+		createBindGroupLayout();
+		createComputePipeline(pipelineBatch);
+	}
+
+	void LightCulling::generateGpuObjects(const DeviceResources* deviceResources) {
+		_lightTileCount = deviceResources->render->lightTileCount;
+		_tileLightOverflow = deviceResources->render->tileLightOverflow;
+
+		createBindGroup(
+			deviceResources->render->depthTextureView,
+			deviceResources->scene->inverseCameras,
+			deviceResources->scene->lightStorage,
+			deviceResources->render->tileLights,
+			deviceResources->render->tileLightOverflow
+		);
+	}
+
+	void LightCulling::doCommands(const render::lightCulling::descriptor::DoCommands* descriptor) {
+		descriptor->commandEncoder.ClearBuffer(_tileLightOverflow);
+		wgpu::ComputePassDescriptor computePassDescriptor = {
+			.label = "light culling compute pass",
+			.timestampWrites = descriptor->timestampWrites,
+		};
+		wgpu::ComputePassEncoder computePassEncoder = descriptor->commandEncoder.BeginComputePass(&computePassDescriptor);
+		computePassEncoder.SetPipeline(_computePipeline);
+		computePassEncoder.SetBindGroup(0, _bindGroup);
+		computePassEncoder.DispatchWorkgroups(_lightTileCount.width, _lightTileCount.height);
+		computePassEncoder.End();
+	}
+
+	void LightCulling::createBindGroupLayout() {
+		const wgpu::BindGroupLayoutEntry depthBindGroupLayoutEntry = {
+			.binding = 0,
+			.visibility = wgpu::ShaderStage::Compute,
+			.texture = {
+				.sampleType = wgpu::TextureSampleType::Depth,
+				.viewDimension = wgpu::TextureViewDimension::e2D,
+			},
+		};
+		const wgpu::BindGroupLayoutEntry inverseCameraBindGroupLayoutEntry = {
+			.binding = 1,
+			.visibility = wgpu::ShaderStage::Compute,
+			.buffer = {
+				.type = wgpu::BufferBindingType::Uniform,
+				.minBindingSize = sizeof(glm::f32mat4x4),
+			},
+		};
+		const wgpu::BindGroupLayoutEntry lightBindGroupLayoutEntry = {
+			.binding = 2,
+			.visibility = wgpu::ShaderStage::Compute,
+			.buffer = {
+				.type = wgpu::BufferBindingType::ReadOnlyStorage,
+				.minBindingSize = sizeof(structs::Light),
+			},
+		};
+		const wgpu::BindGroupLayoutEntry tileLightsBindGroupLayoutEntry = {
+			.binding = 3,
+			.visibility = wgpu::ShaderStage::Compute,
+			.buffer = {
+				.type = wgpu::BufferBindingType::Storage,
+				.minBindingSize = sizeof(structs::TileLights),
+			},
+		};
+
+		const wgpu::BindGroupLayoutEntry tileLightOverflowBindGroupLayoutEntry = {
+			.binding = 4,
+			.visibility = wgpu::ShaderStage::Compute,
+			.buffer = {
+				.type = wgpu::BufferBindingType::Storage,
+				.minBindingSize = sizeof(structs::TileLightOverflow),
+			},
+		};
+
+		std::array<wgpu::BindGroupLayoutEntry, 5> bindGroupLayoutEntries = {
+			depthBindGroupLayoutEntry,
+			inverseCameraBindGroupLayoutEntry,
+			lightBindGroupLayoutEntry,
+			tileLightsBindGroupLayoutEntry,
+			tileLightOverflowBindGroupLayoutEntry,
+		};
+		const wgpu::BindGroupLayoutDescriptor bindGroupLayoutDescriptor = {
+			.label = "light culling bind group layout",
+			.entryCount = bindGroupLayoutEntries.size(),
+			.entries = bindGroupLayoutEntries.data(),
+		};
+		_bindGroupLayout = _wgpuContext->device.CreateBindGroupLayout(&bindGroupLayoutDescriptor);
+	}
+
+	void LightCulling::createComputePipeline(PipelineBatch& pipelineBatch) {
+		const wgpu::PipelineLayout pipelineLayout = getPipelineLayout();
+		wgpu::ComputeState computeState = {
+			.module = _computeShaderModule,
+			.entryPoint = enums::EntryPoint::COMPUTE,
+		};
+
+		const wgpu::ComputePipelineDescriptor computePipelineDescriptor = {
+			.label = "light culling compute pipeline",
+			.layout = pipelineLayout,
+			.compute = computeState,
+		};
+		pipelineBatch.createComputePipeline(computePipelineDescriptor, _computePipeline);
+	}
+
+	wgpu::PipelineLayout LightCulling::getPipelineLayout() {
+		std::array<wgpu::BindGroupLayout, 1> bindGroupLayout = {
+			_bindGroupLayout,
+		};
+		const wgpu::PipelineLayoutDescriptor pipelineLayoutDescriptor = {
+			.label = "light culling pipeline layout",
+			.bindGroupLayoutCount = bindGroupLayout.size(),
+			.bindGroupLayouts = bindGroupLayout.data(),
+		};
+		return _wgpuContext->device.CreatePipelineLayout(&pipelineLayoutDescriptor);
+	}
+
+	void LightCulling::createBindGroup(
+		const wgpu::TextureView& depthTextureView,
+		const wgpu::Buffer& inverseCameraBuffer,
+		const wgpu::Buffer& lightStorageBuffer,
+		const wgpu::Buffer& tileLightsBuffer,
+		const wgpu::Buffer& tileLightOverflowBuffer
+	) {
+		const wgpu::BindGroupEntry depthBindGroupEntry = {
+			.binding = 0,
+			.textureView = depthTextureView,
+		};
+		const wgpu::BindGroupEntry inverseCameraBindGroupEntry = {
+			.binding = 1,
+			.buffer = inverseCameraBuffer,
+			.size = sizeof(glm::f32mat4x4),
+		};
+		const wgpu::BindGroupEntry lightBindGroupEntry = {
+			.binding = 2,
+			.buffer = lightStorageBuffer,
+			.size = lightStorageBuffer.GetSize(),
+		};
+		const wgpu::BindGroupEntry tileLightsBindGroupEntry = {
+			.binding = 3,
+			.buffer = tileLightsBuffer,
+			.size = tileLightsBuffer.GetSize(),
+		};
+
+		const wgpu::BindGroupEntry tileLightOverflowBindGroupEntry = {
+			.binding = 4,
+			.buffer = tileLightOverflowBuffer,
+			.size = sizeof(structs::TileLightOverflow),
+		};
+
+		std::array<wgpu::BindGroupEntry, 5> bindGroupEntries = {
+			depthBindGroupEntry,
+			inverseCameraBindGroupEntry,
+			lightBindGroupEntry,
+			tileLightsBindGroupEntry,
+			tileLightOverflowBindGroupEntry,
+		};
+		const wgpu::BindGroupDescriptor bindGroupDescriptor = {
+			.label = "light culling bind group",
+			.layout = _bindGroupLayout,
+			.entryCount = bindGroupEntries.size(),
+			.entries = bindGroupEntries.data(),
+		};
+		_bindGroup = _wgpuContext->device.CreateBindGroup(&bindGroupDescriptor);
+	}
+}
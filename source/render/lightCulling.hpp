@@ -0,0 +1,52 @@
+#pragma once
+#include <string>
+#include <dawn/webgpu_cpp.h>
+#include "../wgpuContext/wgpuContext.hpp"
+#include "../device/resources.hpp"
+#include "../device/pipelineBatch.hpp"
+#include "frameGraph.hpp"
+
+namespace render {
+	namespace lightCulling::descriptor {
+		struct DoCommands {
+			wgpu::CommandEncoder& commandEncoder;
+			const wgpu::PassTimestampWrites* timestampWrites = nullptr;
+		};
+	}
+
+	//Bins the lights into LIGHT_TILE_SIZE screen tiles using the depth bounds of each tile, Lighting only visits the lights of its tile.
+	//Lights past MAX_LIGHTS_PER_TILE in a tile are dropped and counted in RenderResources::tileLightOverflow
+	class LightCulling {
+	public:
+		LightCulling(WGPUContext* wgpuContext);
+		void declareResources(FrameGraph& frameGraph) const;
+		void createPipelineAsync(PipelineBatch& pipelineBatch);
+		//The pipeline batch must have been waited on
+		void generateGpuObjects(const DeviceResources* deviceResources);
+		void doCommands(const render::lightCulling::descriptor::DoCommands* descriptor);
+
+	private:
+		const wgpu::StringView LIGHTCULLING_SHADER_LABEL = "light culling compute shader";
+		const std::string LIGHTCULLING_SHADER_PATH = "shaders/lightCulling_c.wgsl";
+		wgpu::ShaderModule _computeShaderModule;
+
+		WGPUContext* _wgpuContext;
+
+		wgpu::Extent2D _lightTileCount;
+		wgpu::Buffer _tileLightOverflow;
+		wgpu::ComputePipeline _computePipeline;
+		wgpu::BindGroupLayout _bindGroupLayout;
+		wgpu::BindGroup _bindGroup;
+
+		wgpu::PipelineLayout getPipelineLayout();
+		void createBindGroupLayout();
+		void createComputePipeline(PipelineBatch& pipelineBatch);
+		void createBindGroup(
+			const wgpu::TextureView& depthTextureView,
+			const wgpu::Buffer& inverseCameraBuffer,
+			const wgpu::Buffer& lightStorageBuffer,
+			const wgpu::Buffer& tileLightsBuffer,
+			const wgpu::Buffer& tileLightOverflowBuffer
+		);
+	};
+}
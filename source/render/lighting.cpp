@@ -3,70 +3,77 @@
 #include "../device/device.hpp"
 #include "../enums.hpp"
 #include "../texture/texture.hpp"
+#include "dispatch.hpp"
 
-//TODO Create render pipeline to clear the storage texture
 namespace render {
 	Lighting::Lighting(WGPUContext* wgpuContext) : _wgpuContext(wgpuContext) {
 		_computeShaderModule = device::createWGSLShaderModule(wgpuContext->device, LIGHTING_SHADER_LABEL, LIGHTING_SHADER_PATH);
 	};
 
-	void Lighting::generateGpuObjects(const DeviceResources* deviceResources) {
+	void Lighting::declareResources(FrameGraph& frameGraph) const {
+		frameGraph.addPass({
+			.pass = enums::GpuPass::LIGHTING,
+			.reads = { enums::FrameResource::DEPTH, enums::FrameResource::NORMAL, enums::FrameResource::TILE_LIGHTS, enums::FrameResource::SHADOW_ATLAS },
+			.writes = { enums::FrameResource::LIGHTING },
+		});
+	}
+
+	void Lighting::createPipelineAsync(PipelineBatch& pipelineBatch, const RenderResources* renderResources) {
 		createAccumulatorBindGroupLayout(
-			deviceResources->render->lightingTextureFormat,
-			deviceResources->render->worldPositionTextureFormat,
-			deviceResources->render->normalTextureFormat
+			renderResources->lightingTextureFormat,
+			renderResources->normalTextureFormat
 		);
 		createInputBindGroupLayout();
-		createComputePipeline();
+		createComputePipeline(pipelineBatch);
+	}
 
+	void Lighting::generateGpuObjects(const DeviceResources* deviceResources) {
 		createAccumulatorBindGroup(
 			deviceResources->render->lightingTextureView,
-			deviceResources->render->worldPositionTextureView,
-			deviceResources->render->normalTextureView
+			deviceResources->render->depthTextureView,
+			deviceResources->render->normalTextureView,
+			deviceResources->scene->inverseCameras
+		);
+		createInputBindGroup(
+			deviceResources->scene->lightStorage,
+			deviceResources->render->tileLights,
+			deviceResources->scene->shadowViews,
+			deviceResources->render->shadowAtlasTextureView,
+			deviceResources->render->shadowMapSampler
 		);
-		
-		for (auto& buffer : deviceResources->scene->lights) {
-			insertInputBindGroup(buffer);
-		}
 	}
 
 	void Lighting::doCommands(const render::lighting::descriptor::DoCommands* descriptor) {
 		wgpu::ComputePassDescriptor computePassDescriptor = {
 			.label = "lighting compute pass",
+			.timestampWrites = descriptor->timestampWrites,
 		};
 		wgpu::ComputePassEncoder computePassEncoder = descriptor->commandEncoder.BeginComputePass(&computePassDescriptor);
 		computePassEncoder.SetPipeline(_computePipeline);
 		computePassEncoder.SetBindGroup(0, _accumulatorBindGroup);
-		for (auto& bg : _inputBindGroups) {
-			computePassEncoder.SetBindGroup(1, bg);
-			computePassEncoder.DispatchWorkgroups(
-				_wgpuContext->getScreenDimensions().width,
-				_wgpuContext->getScreenDimensions().height
-			);
-		}
+		computePassEncoder.SetBindGroup(1, _inputBindGroup);
+		render::dispatch::fullScreen(computePassEncoder, _wgpuContext);
 		computePassEncoder.End();
 	}
 
 	void Lighting::createAccumulatorBindGroupLayout(
 		const wgpu::TextureFormat lightingTextureFormat,
-		const wgpu::TextureFormat worldPositionTextureFormat,
 	  const wgpu::TextureFormat normalTextureFormat) {
 		const wgpu::BindGroupLayoutEntry accumulatorBindGroupLayoutEntry = {
 			.binding = 0,
 			.visibility = wgpu::ShaderStage::Compute,
 			.storageTexture = {
-				.access = wgpu::StorageTextureAccess::ReadWrite,
+				.access = wgpu::StorageTextureAccess::WriteOnly,
 				.format = lightingTextureFormat,
 				.viewDimension = wgpu::TextureViewDimension::e2D,
 			},
 		};
 
-		const wgpu::BindGroupLayoutEntry worldPositionBindGroupLayoutEntry = {
+		const wgpu::BindGroupLayoutEntry depthBindGroupLayoutEntry = {
 			.binding = 1,
 			.visibility = wgpu::ShaderStage::Compute,
-			.storageTexture = {
-				.access = wgpu::StorageTextureAccess::ReadOnly,
-				.format = worldPositionTextureFormat,
+			.texture = {
+				.sampleType = wgpu::TextureSampleType::Depth,
 				.viewDimension = wgpu::TextureViewDimension::e2D,
 			}
 		};
@@ -81,10 +88,20 @@ namespace render {
 			},
 		};
 
-		std::array<wgpu::BindGroupLayoutEntry, 3> bindGroupLayoutEntries = {
+		const wgpu::BindGroupLayoutEntry inverseCameraBindGroupLayoutEntry = {
+			.binding = 3,
+			.visibility = wgpu::ShaderStage::Compute,
+			.buffer = {
+				.type = wgpu::BufferBindingType::Uniform,
+				.minBindingSize = sizeof(glm::f32mat4x4),
+			},
+		};
+
+		std::array<wgpu::BindGroupLayoutEntry, 4> bindGroupLayoutEntries = {
 			accumulatorBindGroupLayoutEntry,
-			worldPositionBindGroupLayoutEntry,
+			depthBindGroupLayoutEntry,
 			normalBindGroupLayoutEntry,
+			inverseCameraBindGroupLayoutEntry,
 		};
 
 		const wgpu::BindGroupLayoutDescriptor bindGroupLayoutDescriptor = {
@@ -100,12 +117,48 @@ namespace render {
 			.binding = 0,
 			.visibility = wgpu::ShaderStage::Compute,
 			.buffer = {
-				.type = wgpu::BufferBindingType::Uniform,
+				.type = wgpu::BufferBindingType::ReadOnlyStorage,
 				.minBindingSize = sizeof(structs::Light),
 			},
 		};
-		std::array<wgpu::BindGroupLayoutEntry, 1> bindGroupLayoutEntries = {
-			lightBindGroupLayoutEntry
+		const wgpu::BindGroupLayoutEntry tileLightsBindGroupLayoutEntry = {
+			.binding = 1,
+			.visibility = wgpu::ShaderStage::Compute,
+			.buffer = {
+				.type = wgpu::BufferBindingType::ReadOnlyStorage,
+				.minBindingSize = sizeof(structs::TileLights),
+			},
+		};
+		//Each light with a shadow map is tested against its own view, see structs::Light::shadowViewIndex
+		const wgpu::BindGroupLayoutEntry shadowViewsBindGroupLayoutEntry = {
+			.binding = 2,
+			.visibility = wgpu::ShaderStage::Compute,
+			.buffer = {
+				.type = wgpu::BufferBindingType::ReadOnlyStorage,
+				.minBindingSize = sizeof(structs::ShadowView),
+			},
+		};
+		const wgpu::BindGroupLayoutEntry shadowAtlasBindGroupLayoutEntry = {
+			.binding = 3,
+			.visibility = wgpu::ShaderStage::Compute,
+			.texture = {
+				.sampleType = wgpu::TextureSampleType::Depth,
+				.viewDimension = wgpu::TextureViewDimension::e2D,
+			},
+		};
+		const wgpu::BindGroupLayoutEntry shadowSamplerBindGroupLayoutEntry = {
+			.binding = 4,
+			.visibility = wgpu::ShaderStage::Compute,
+			.sampler = {
+				.type = wgpu::SamplerBindingType::Comparison,
+			},
+		};
+		std::array<wgpu::BindGroupLayoutEntry, 5> bindGroupLayoutEntries = {
+			lightBindGroupLayoutEntry,
+			tileLightsBindGroupLayoutEntry,
+			shadowViewsBindGroupLayoutEntry,
+			shadowAtlasBindGroupLayoutEntry,
+			shadowSamplerBindGroupLayoutEntry,
 		};
 
 		const wgpu::BindGroupLayoutDescriptor bindGroupLayoutDescriptor = {
@@ -116,11 +169,14 @@ namespace render {
 		_inputBindGroupLayout = _wgpuContext->device.CreateBindGroupLayout(&bindGroupLayoutDescriptor);
 	}
 
-	void Lighting::createComputePipeline() {
+	void Lighting::createComputePipeline(PipelineBatch& pipelineBatch) {
 		const wgpu::PipelineLayout pipelineLayout = getPipelineLayout();
+		const std::array<wgpu::ConstantEntry, 2> workgroupSizeConstants = render::dispatch::getWorkgroupSizeConstants(_wgpuContext);
 		wgpu::ComputeState computeState = {
 			.module = _computeShaderModule,
 			.entryPoint = enums::EntryPoint::COMPUTE,
+			.constantCount = workgroupSizeConstants.size(),
+			.constants = workgroupSizeConstants.data(),
 		};
 
 		const wgpu::ComputePipelineDescriptor computePipelineDescriptor = {
@@ -128,7 +184,7 @@ namespace render {
 			.layout = pipelineLayout,
 			.compute = computeState,
 		};
-		_computePipeline = _wgpuContext->device.CreateComputePipeline(&computePipelineDescriptor);
+		pipelineBatch.createComputePipeline(computePipelineDescriptor, _computePipeline);
 	}
 
 	wgpu::PipelineLayout Lighting::getPipelineLayout() {
@@ -146,26 +202,34 @@ namespace render {
 
 	void Lighting::createAccumulatorBindGroup(
 		const wgpu::TextureView& lightingTextureView,
-		const wgpu::TextureView& worldPositionTextureView,
-		const wgpu::TextureView& normalTextureView
+		const wgpu::TextureView& depthTextureView,
+		const wgpu::TextureView& normalTextureView,
+		const wgpu::Buffer& inverseCameraBuffer
 	) {
 		const wgpu::BindGroupEntry accumulatorBindGroupEntry = {
 			.binding = 0,
 			.textureView = lightingTextureView,
 		};
-		const wgpu::BindGroupEntry worldPositionBindGroupEntry = {
+		const wgpu::BindGroupEntry depthBindGroupEntry = {
 			.binding = 1,
-			.textureView = worldPositionTextureView,
+			.textureView = depthTextureView,
 		};
 		const wgpu::BindGroupEntry normalBindGroupEntry = {
 			.binding = 2,
 			.textureView = normalTextureView,
 		};
 
-		std::array<wgpu::BindGroupEntry, 3> bindGroupEntries = {
+		const wgpu::BindGroupEntry inverseCameraBindGroupEntry = {
+			.binding = 3,
+			.buffer = inverseCameraBuffer,
+			.size = sizeof(glm::f32mat4x4),
+		};
+
+		std::array<wgpu::BindGroupEntry, 4> bindGroupEntries = {
 			accumulatorBindGroupEntry,
-			worldPositionBindGroupEntry,
+			depthBindGroupEntry,
 			normalBindGroupEntry,
+			inverseCameraBindGroupEntry,
 		};
 		const wgpu::BindGroupDescriptor bindGroupDescriptor = {
 			.label = "accumulator accumulator bind group",
@@ -176,15 +240,42 @@ namespace render {
 		_accumulatorBindGroup = _wgpuContext->device.CreateBindGroup(&bindGroupDescriptor);
 	}
 
-	void Lighting::insertInputBindGroup(
-		const wgpu::Buffer& lightBuffer
+	void Lighting::createInputBindGroup(
+		const wgpu::Buffer& lightStorageBuffer,
+		const wgpu::Buffer& tileLightsBuffer,
+		const wgpu::Buffer& shadowViewsBuffer,
+		const wgpu::TextureView& shadowAtlasTextureView,
+		const wgpu::Sampler& shadowMapSampler
 	) {
 		const wgpu::BindGroupEntry lightBindGroupEntry = {
 			.binding = 0,
-			.buffer = lightBuffer,
+			.buffer = lightStorageBuffer,
+			.size = lightStorageBuffer.GetSize(),
+		};
+		const wgpu::BindGroupEntry tileLightsBindGroupEntry = {
+			.binding = 1,
+			.buffer = tileLightsBuffer,
+			.size = tileLightsBuffer.GetSize(),
+		};
+		const wgpu::BindGroupEntry shadowViewsBindGroupEntry = {
+			.binding = 2,
+			.buffer = shadowViewsBuffer,
+			.size = shadowViewsBuffer.GetSize(),
+		};
+		const wgpu::BindGroupEntry shadowAtlasBindGroupEntry = {
+			.binding = 3,
+			.textureView = shadowAtlasTextureView,
+		};
+		const wgpu::BindGroupEntry shadowSamplerBindGroupEntry = {
+			.binding = 4,
+			.sampler = shadowMapSampler,
 		};
-		std::array<wgpu::BindGroupEntry, 1> bindGroupEntries = {
+		std::array<wgpu::BindGroupEntry, 5> bindGroupEntries = {
 			lightBindGroupEntry,
+			tileLightsBindGroupEntry,
+			shadowViewsBindGroupEntry,
+			shadowAtlasBindGroupEntry,
+			shadowSamplerBindGroupEntry,
 		};
 		const wgpu::BindGroupDescriptor bindGroupDescriptor = {
 			.label = "accumulator input bind group",
@@ -192,7 +283,7 @@ namespace render {
 			.entryCount = bindGroupEntries.size(),
 			.entries = bindGroupEntries.data(),
 		};
-		_inputBindGroups.emplace_back(_wgpuContext->device.CreateBindGroup(&bindGroupDescriptor));
+		_inputBindGroup = _wgpuContext->device.CreateBindGroup(&bindGroupDescriptor);
 	}
 
 
@@ -5,13 +5,13 @@
 #include "../structs/structs.hpp"
 #include "../wgpuContext/wgpuContext.hpp"
 #include "../device/resources.hpp"
+#include "../device/pipelineBatch.hpp"
+#include "frameGraph.hpp"
 
 namespace render {
 	namespace lighting::descriptor {
 
 		struct GenerateGpuObjects {
-			wgpu::TextureFormat worldTextureFormat;
-			wgpu::TextureView& worldTextureView;
 			wgpu::TextureFormat normalTextureFormat;
 			wgpu::TextureView& normalTextureView;
 
@@ -20,12 +20,16 @@ namespace render {
 
 		struct DoCommands {
 			wgpu::CommandEncoder& commandEncoder;
+			const wgpu::PassTimestampWrites* timestampWrites = nullptr;
 		};
 	}
 
 	class Lighting {
 	public:
 		Lighting(WGPUContext* wgpuContext);
+		void declareResources(FrameGraph& frameGraph) const;
+		void createPipelineAsync(PipelineBatch& pipelineBatch, const RenderResources* renderResources);
+		//The pipeline batch must have been waited on
 		void generateGpuObjects(const DeviceResources* deviceResources);
 		void doCommands(const render::lighting::descriptor::DoCommands* descriptor);
 
@@ -42,23 +46,27 @@ namespace render {
 		wgpu::BindGroupLayout _accumulatorBindGroupLayout;
 		wgpu::BindGroupLayout _inputBindGroupLayout;
 		wgpu::BindGroup _accumulatorBindGroup;
-		std::vector<wgpu::BindGroup> _inputBindGroups;
+		wgpu::BindGroup _inputBindGroup;
 
 		wgpu::PipelineLayout getPipelineLayout();
 		void createAccumulatorBindGroupLayout(
 			const wgpu::TextureFormat lightingTextureFormat,
-			const wgpu::TextureFormat worldPositionTextureFormat,
 			const wgpu::TextureFormat normalTextureFormat);
 		void createInputBindGroupLayout();
-		void createComputePipeline();
+		void createComputePipeline(PipelineBatch& pipelineBatch);
 
 		void createAccumulatorBindGroup(
 			const wgpu::TextureView& lightingTextureView,
-			const wgpu::TextureView& worldPositionTextureView,
-			const wgpu::TextureView& normalTextureView
+			const wgpu::TextureView& depthTextureView,
+			const wgpu::TextureView& normalTextureView,
+			const wgpu::Buffer& inverseCameraBuffer
 		);
-		void insertInputBindGroup(
-			const wgpu::Buffer& lightBuffer
+		void createInputBindGroup(
+			const wgpu::Buffer& lightStorageBuffer,
+			const wgpu::Buffer& tileLightsBuffer,
+			const wgpu::Buffer& shadowViewsBuffer,
+			const wgpu::TextureView& shadowAtlasTextureView,
+			const wgpu::Sampler& shadowMapSampler
 		);
 
 	};
@@ -0,0 +1,84 @@
+#pragma once
+#include "sceneDraw.hpp"
+#include <array>
+#include "../constants.hpp"
+
+namespace {
+	//One contiguous run of SceneResources::drawCalls that shares an index buffer
+	struct IndexRun {
+		const wgpu::Buffer& indices;
+		wgpu::IndexFormat indexFormat;
+		uint32_t firstDraw;
+		uint32_t drawCount;
+	};
+
+	//Ordered like the counts of each view in SceneResources::culledDrawCounts
+	std::array<IndexRun, constants::INDEX_FORMAT_COUNT> getIndexRuns(const SceneResources* sceneResources) {
+		const uint32_t drawCount = static_cast<uint32_t>(sceneResources->hostDrawCalls.size());
+		return {
+			IndexRun{ sceneResources->indices16, wgpu::IndexFormat::Uint16, 0, sceneResources->uint16DrawCount },
+			IndexRun{ sceneResources->indices32, wgpu::IndexFormat::Uint32, sceneResources->uint16DrawCount, drawCount - sceneResources->uint16DrawCount },
+		};
+	}
+}
+
+namespace render {
+	namespace sceneDraw {
+		bool canDrawIndirect(const wgpu::Device& device) {
+			return device.HasFeature(wgpu::FeatureName::IndirectFirstInstance);
+		}
+
+		bool canMultiDraw(const wgpu::Device& device) {
+			return canDrawIndirect(device) && device.HasFeature(wgpu::FeatureName::MultiDrawIndirect);
+		}
+
+		void multiDraw(const wgpu::RenderPassEncoder& renderPassEncoder, const SceneResources* sceneResources, const uint32_t view) {
+			const uint64_t drawCount = sceneResources->hostDrawCalls.size();
+			renderPassEncoder.SetVertexBuffer(0, sceneResources->vbo, 0, sceneResources->vbo.GetSize());
+			const std::array<IndexRun, constants::INDEX_FORMAT_COUNT> indexRuns = getIndexRuns(sceneResources);
+			for (uint32_t i = 0; i < indexRuns.size(); ++i) {
+				const IndexRun& indexRun = indexRuns[i];
+				if (indexRun.drawCount == 0) {
+					continue;
+				}
+				renderPassEncoder.SetIndexBuffer(indexRun.indices, indexRun.indexFormat, 0, indexRun.indices.GetSize());
+				if (sceneResources->culledDrawCalls) {
+					renderPassEncoder.MultiDrawIndexedIndirect(
+						sceneResources->culledDrawCalls,
+						(view * drawCount + indexRun.firstDraw) * sizeof(structs::host::DrawCall),
+						indexRun.drawCount,
+						sceneResources->culledDrawCounts,
+						(uint64_t{ view } * constants::INDEX_FORMAT_COUNT + i) * sizeof(uint32_t)
+					);
+				}
+				else {
+					renderPassEncoder.MultiDrawIndexedIndirect(sceneResources->drawCalls, indexRun.firstDraw * sizeof(structs::host::DrawCall), indexRun.drawCount);
+				}
+			}
+		}
+
+		void drawEach(const wgpu::RenderBundleEncoder& renderBundleEncoder, const wgpu::Device& device, const SceneResources* sceneResources, const uint32_t view) {
+			const uint64_t drawCount = sceneResources->hostDrawCalls.size();
+			renderBundleEncoder.SetVertexBuffer(0, sceneResources->vbo, 0, sceneResources->vbo.GetSize());
+			const bool indirect = canDrawIndirect(device);
+			for (const IndexRun& indexRun : getIndexRuns(sceneResources)) {
+				if (indexRun.drawCount == 0) {
+					continue;
+				}
+				renderBundleEncoder.SetIndexBuffer(indexRun.indices, indexRun.indexFormat, 0, indexRun.indices.GetSize());
+				for (uint32_t i = indexRun.firstDraw; i < indexRun.firstDraw + indexRun.drawCount; ++i) {
+					if (indirect && sceneResources->culledDrawCalls) {
+						renderBundleEncoder.DrawIndexedIndirect(sceneResources->culledDrawCalls, (view * drawCount + i) * sizeof(structs::host::DrawCall));
+					}
+					else if (indirect) {
+						renderBundleEncoder.DrawIndexedIndirect(sceneResources->drawCalls, i * sizeof(structs::host::DrawCall));
+					}
+					else {
+						const structs::host::DrawCall& dc = sceneResources->hostDrawCalls[i];
+						renderBundleEncoder.DrawIndexed(dc.indexCount, dc.instanceCount, dc.firstIndex, static_cast<int32_t>(dc.baseVertex), dc.firstInstance);
+					}
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <dawn/webgpu_cpp.h>
+#include "../structs/host.hpp"
+#include "../device/resources.hpp"
+
+namespace render {
+	namespace sceneDraw {
+		//SceneResources::drawCalls holds every DrawCall as DrawIndexedIndirect arguments
+		static_assert(sizeof(structs::host::DrawCall) == 5 * sizeof(uint32_t));
+
+		//Index of a view in SceneResources::culledDrawCalls
+		constexpr uint32_t CAMERA_VIEW = 0;
+		constexpr uint32_t getLightView(const uint32_t lightIndex) {
+			return 1 + lightIndex;
+		}
+
+		//firstInstance selects the transform of the primitive, so indirect draws need indirect-first-instance
+		bool canDrawIndirect(const wgpu::Device& device);
+		bool canMultiDraw(const wgpu::Device& device);
+
+		//Binds the vertex and index buffers and draws the primitives the culling pass kept for view with one MultiDrawIndexedIndirect
+		//per index format
+		void multiDraw(const wgpu::RenderPassEncoder& renderPassEncoder, const SceneResources* sceneResources, const uint32_t view);
+		//Binds the vertex and index buffers and draws with a DrawIndexedIndirect per slot of the culled list of view, or every
+		//primitive with DrawIndexed without indirect-first-instance. Meant to be recorded once into a render bundle that every
+		//frame executes, slots past the visible count are zeroed by the culling pass and draw nothing
+		void drawEach(const wgpu::RenderBundleEncoder& renderBundleEncoder, const wgpu::Device& device, const SceneResources* sceneResources, const uint32_t view);
+	}
+}
@@ -0,0 +1,158 @@
+#pragma once
+#include "shadowAtlas.hpp"
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <cmath>
+#include "absl/log/log.h"
+#include "../constants.hpp"
+
+namespace {
+	static_assert(std::has_single_bit(constants::SHADOW_ATLAS_SIZE) && std::has_single_bit(constants::MIN_SHADOW_MAP_SIZE) && std::has_single_bit(constants::MAX_SHADOW_MAP_SIZE));
+	static_assert(constants::MIN_SHADOW_MAP_SIZE <= constants::MAX_SHADOW_MAP_SIZE && constants::MAX_SHADOW_MAP_SIZE <= constants::SHADOW_ATLAS_SIZE);
+
+	struct Request {
+		uint32_t lightIndex;
+		uint32_t size;
+		float priority; //coverage times importance
+	};
+
+	//Weighs the lights against each other, not physically meaningful across light types
+	float getBrightness(const structs::Light& light) {
+		return light.intensity * std::max({ light.color.x, light.color.y, light.color.z });
+	}
+
+	//Every other bit of a Morton index
+	uint32_t compactBits(uint32_t bits) {
+		bits &= 0x55555555;
+		bits = (bits | (bits >> 1)) & 0x33333333;
+		bits = (bits | (bits >> 2)) & 0x0F0F0F0F;
+		bits = (bits | (bits >> 4)) & 0x00FF00FF;
+		bits = (bits | (bits >> 8)) & 0x0000FFFF;
+		return bits;
+	}
+}
+
+namespace render {
+	namespace shadowAtlas {
+		float getScreenCoverage(const glm::f32mat4x4& lightSpaceMatrix, const glm::f32mat4x4& cameraProjectionView) {
+			const glm::f32mat4x4 lightToCamera = cameraProjectionView * glm::inverse(lightSpaceMatrix);
+			glm::f32vec2 minimum = glm::f32vec2(FLT_MAX);
+			glm::f32vec2 maximum = glm::f32vec2(-FLT_MAX);
+			for (uint32_t corner = 0; corner < 8; ++corner) {
+				//Light projections are zero to one in depth
+				const glm::f32vec4 lightCorner = {
+					(corner & 1) != 0 ? 1.0f : -1.0f,
+					(corner & 2) != 0 ? 1.0f : -1.0f,
+					(corner & 4) != 0 ? 1.0f : 0.0f,
+					1.0f,
+				};
+				const glm::f32vec4 cameraCorner = lightToCamera * lightCorner;
+				//Also catches the degenerate matrices of lights without a range
+				if (!(cameraCorner.w > 0.0f)) {
+					return 1.0f;
+				}
+				const glm::f32vec2 ndc = glm::f32vec2(cameraCorner.x, cameraCorner.y) / cameraCorner.w;
+				minimum = glm::min(minimum, ndc);
+				maximum = glm::max(maximum, ndc);
+			}
+			const glm::f32vec2 extent = glm::max(glm::clamp(maximum, -1.0f, 1.0f) - glm::clamp(minimum, -1.0f, 1.0f), 0.0f);
+			const float coverage = extent.x * extent.y / 4.0f;
+			return std::isfinite(coverage) ? coverage : 1.0f;
+		}
+
+		std::vector<structs::host::ShadowAtlasRect> allocate(
+			const std::vector<structs::Light>& lights,
+			const glm::f32mat4x4& cameraProjectionView,
+			const wgpu::Extent2D screenDimensions
+		) {
+			float maxBrightness = 0.0f;
+			for (const structs::Light& light : lights) {
+				maxBrightness = std::max(maxBrightness, getBrightness(light));
+			}
+
+			std::vector<Request> requests;
+			const float screenPixels = static_cast<float>(screenDimensions.width) * static_cast<float>(screenDimensions.height);
+			for (uint32_t i = 0; i < lights.size(); ++i) {
+				const float coverage = getScreenCoverage(lights[i].lightSpaceMatrix, cameraProjectionView);
+				if (coverage <= 0.0f) {
+					continue;
+				}
+				const float importance = maxBrightness > 0.0f ? std::clamp(getBrightness(lights[i]) / maxBrightness, 0.0f, 1.0f) : 1.0f;
+				const float texels = std::ceil(std::sqrt(coverage * importance * screenPixels));
+				const uint32_t size = std::bit_ceil(static_cast<uint32_t>(std::min(texels, static_cast<float>(constants::MAX_SHADOW_MAP_SIZE))));
+				requests.push_back(Request{
+					.lightIndex = i,
+					.size = std::clamp(size, constants::MIN_SHADOW_MAP_SIZE, constants::MAX_SHADOW_MAP_SIZE),
+					.priority = coverage * importance,
+				});
+			}
+			std::stable_sort(requests.begin(), requests.end(), [](const Request& lhs, const Request& rhs) {
+				return lhs.priority > rhs.priority;
+			});
+
+			constexpr uint64_t atlasArea = static_cast<uint64_t>(constants::SHADOW_ATLAS_SIZE) * constants::SHADOW_ATLAS_SIZE;
+			uint64_t area = 0;
+			for (const Request& request : requests) {
+				area += static_cast<uint64_t>(request.size) * request.size;
+			}
+			uint32_t droppedCount = 0;
+			while (area > atlasArea) {
+				const auto shrinkable = std::find_if(requests.rbegin(), requests.rend(), [](const Request& request) {
+					return request.size > constants::MIN_SHADOW_MAP_SIZE;
+				});
+				if (shrinkable != requests.rend()) {
+					area -= static_cast<uint64_t>(shrinkable->size) * shrinkable->size * 3 / 4;
+					shrinkable->size /= 2;
+				}
+				else {
+					area -= static_cast<uint64_t>(requests.back().size) * requests.back().size;
+					requests.pop_back();
+					droppedCount++;
+				}
+			}
+			if (droppedCount > 0) {
+				LOG(WARNING) << droppedCount << " of " << lights.size() << " lights do not fit in the shadow atlas and cast no shadow";
+			}
+
+			//Squares of decreasing power of two sizes laid out along a Morton curve of minimum size cells always start on a cell
+			//index that is a multiple of their own cell count, so each lands aligned and the atlas fills without gaps
+			std::stable_sort(requests.begin(), requests.end(), [](const Request& lhs, const Request& rhs) {
+				return lhs.size > rhs.size;
+			});
+			std::vector<structs::host::ShadowAtlasRect> rects;
+			rects.reserve(requests.size());
+			uint32_t cell = 0;
+			for (const Request& request : requests) {
+				rects.push_back(structs::host::ShadowAtlasRect{
+					.lightIndex = request.lightIndex,
+					.x = compactBits(cell) * constants::MIN_SHADOW_MAP_SIZE,
+					.y = compactBits(cell >> 1) * constants::MIN_SHADOW_MAP_SIZE,
+					.size = request.size,
+				});
+				const uint32_t cellsWide = request.size / constants::MIN_SHADOW_MAP_SIZE;
+				cell += cellsWide * cellsWide;
+			}
+			return rects;
+		}
+
+		std::vector<structs::ShadowView> getShadowViews(
+			const std::vector<structs::Light>& lights,
+			const std::vector<structs::host::ShadowAtlasRect>& rects
+		) {
+			if (rects.empty()) {
+				return { structs::ShadowView{} };
+			}
+			constexpr float atlasSize = static_cast<float>(constants::SHADOW_ATLAS_SIZE);
+			std::vector<structs::ShadowView> shadowViews;
+			shadowViews.reserve(rects.size());
+			for (const structs::host::ShadowAtlasRect& rect : rects) {
+				shadowViews.push_back(structs::ShadowView{
+					.lightSpaceMatrix = lights[rect.lightIndex].lightSpaceMatrix,
+					.atlasRect = glm::f32vec4(rect.x, rect.y, rect.size, rect.size) / atlasSize,
+				});
+			}
+			return shadowViews;
+		}
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include <dawn/webgpu_cpp.h>
+#include "../structs/structs.hpp"
+#include "../structs/host.hpp"
+
+namespace render {
+	namespace shadowAtlas {
+		//Fraction of the screen the light's view frustum covers as seen by the camera, 1 when it reaches behind the camera
+		float getScreenCoverage(const glm::f32mat4x4& lightSpaceMatrix, const glm::f32mat4x4& cameraProjectionView);
+
+		//Gives each light a square of the constants::SHADOW_ATLAS_SIZE atlas, about one texel per screen pixel its frustum
+		//covers scaled by its brightness relative to the brightest light. Lights that cover nothing get no shadow map. When the
+		//squares do not fit the least important ones are halved down to constants::MIN_SHADOW_MAP_SIZE, then left without one
+		std::vector<structs::host::ShadowAtlasRect> allocate(
+			const std::vector<structs::Light>& lights,
+			const glm::f32mat4x4& cameraProjectionView,
+			const wgpu::Extent2D screenDimensions
+		);
+
+		//One per rect, or a single empty view without rects since a storage binding cannot be empty
+		std::vector<structs::ShadowView> getShadowViews(
+			const std::vector<structs::Light>& lights,
+			const std::vector<structs::host::ShadowAtlasRect>& rects
+		);
+	}
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "shadowMap.hpp"
 #include "vertexBufferLayout.hpp"
+#include "sceneDraw.hpp"
 #include "../device/device.hpp"
 #include "../enums.hpp"
 #include "../constants.hpp"
@@ -10,60 +11,142 @@
 
 namespace render {
 
-	ShadowMap::ShadowMap(WGPUContext* wgpuContext) : _wgpuContext(wgpuContext) {
-		_vertexShaderModule = device::createShaderModule(_wgpuContext->device, VERTEX_SHADER_LABEL, VERTEX_SHADER_PATH);
+	ShadowMap::ShadowMap(WGPUContext* wgpuContext, const bool quantizedVertices, const bool cacheShadowMaps)
+		: _wgpuContext(wgpuContext), _quantizedVertices(quantizedVertices), _cacheShadowMaps(cacheShadowMaps) {
+		//The quantized vertex shader is WGSL so it shares the dequantization with initialRenderQuantized_v.wgsl
+		_vertexShaderModule = _quantizedVertices
+			? device::createWGSLShaderModule(_wgpuContext->device, VERTEX_SHADER_LABEL, QUANTIZED_VERTEX_SHADER_PATH)
+			: device::createShaderModule(_wgpuContext->device, VERTEX_SHADER_LABEL, VERTEX_SHADER_PATH);
 		_fragmentShaderModule = device::createShaderModule(_wgpuContext->device, FRAGMENT_SHADER_LABEL, FRAGMENT_SHADER_PATH);
+		_clearShaderModule = device::createWGSLShaderModule(_wgpuContext->device, CLEAR_SHADER_LABEL, CLEAR_SHADER_PATH);
 	}
 
-	void ShadowMap::generateGpuObjects(const DeviceResources* deviceResources) {
-		const uint32_t maxShadowMapCount = static_cast<uint32_t>(deviceResources->render->shadowMapTextureViews.size());
-		const uint32_t lightCount = static_cast<uint32_t>(deviceResources->scene->lights.size());
-		_shadowMapCount = maxShadowMapCount > lightCount ? lightCount : maxShadowMapCount;
+	void ShadowMap::declareResources(FrameGraph& frameGraph) const {
+		frameGraph.addPass({
+			.pass = enums::GpuPass::SHADOW_MAP,
+			.reads = { enums::FrameResource::CULLED_DRAWS, enums::FrameResource::SHADOW_ATLAS },
+			.writes = { enums::FrameResource::SHADOW_ATLAS },
+		});
+	}
 
+	void ShadowMap::createPipelineAsync(PipelineBatch& pipelineBatch) {
 		createTransformBindGroupLayout();
 		createLightBindGroupLayout();
-		createPipeline();
+		createPipeline(pipelineBatch);
+		createClearPipeline(pipelineBatch);
+	}
+
+	void ShadowMap::generateGpuObjects(const DeviceResources* deviceResources) {
 		createTransformBindGroup(
-			deviceResources->scene->transforms
+			deviceResources->scene->transforms,
+			deviceResources->scene->instances,
+			deviceResources->scene->vertexQuantizations,
+			deviceResources->scene->vertexQuantizationIndices
 		);
-		for (uint32_t i = 0; i < _shadowMapCount; ++i) {
-			insertLightBindGroup(deviceResources->scene->lights[i]);
+		//Also without shadow maps yet, SceneResources::updateLight can give a light one later
+		if (!deviceResources->scene->hostLights.empty()) {
+			createLightBindGroup(deviceResources->scene->lightUniforms);
+		}
+
+		_sceneResources = deviceResources->scene;
+		resetShadowMaps();
+	}
+
+	//The squares of the atlas changed, so every shadow map is drawn again in its new square
+	void ShadowMap::resetShadowMaps() {
+		_shadowAtlasVersion = _sceneResources->shadowAtlasVersion;
+		_cachedShadowMaps.assign(_sceneResources->shadowAtlasRects.size(), CachedShadowMap{});
+		_renderBundles.clear();
+		if (!sceneDraw::canMultiDraw(_wgpuContext->device)) {
+			for (const structs::host::ShadowAtlasRect& rect : _sceneResources->shadowAtlasRects) {
+				insertRenderBundle(rect.lightIndex);
+			}
 		}
 	}
 
+	//One pass over the atlas, each shadow map is drawn through a viewport on its square. Only the stale ones are drawn, the
+	//rest of the atlas is loaded as the previous frame left it
 	void ShadowMap::doCommands(const render::shadowMap::descriptor::DoCommands* descriptor) {
-		for (uint32_t i = 0; i < _shadowMapCount; ++i) {
-			const wgpu::RenderPassDepthStencilAttachment renderPassDepthStencilAttachment = {
-				.view = descriptor->shadowMapTextureViews[i],
-				.depthLoadOp = wgpu::LoadOp::Clear,
-				.depthStoreOp = wgpu::StoreOp::Store,
-				.depthClearValue = 1.0f,
-			};
+		if (_shadowAtlasVersion != _sceneResources->shadowAtlasVersion) {
+			resetShadowMaps();
+		}
+		const std::vector<structs::host::ShadowAtlasRect>& rects = _sceneResources->shadowAtlasRects;
+		_staleShadowMaps.clear();
+		for (uint32_t i = 0; i < rects.size(); ++i) {
+			if (isStale(i)) {
+				_staleShadowMaps.push_back(i);
+			}
+		}
+		if (_staleShadowMaps.empty()) {
+			//An empty pass so the profiler reads the near zero time of the skipped pass rather than a stale one
+			if (descriptor->timestampWrites != nullptr) {
+				const wgpu::ComputePassDescriptor computePassDescriptor = {
+					.label = "skipped shadow atlas pass",
+					.timestampWrites = descriptor->timestampWrites,
+				};
+				descriptor->commandEncoder.BeginComputePass(&computePassDescriptor).End();
+			}
+			return;
+		}
 
-			const wgpu::RenderPassDescriptor renderPassDescriptor = {
-				.label = "shadow render pass #" + i,
-				.depthStencilAttachment = &renderPassDepthStencilAttachment,
-			};
-			wgpu::RenderPassEncoder renderPassEncoder = descriptor->commandEncoder.BeginRenderPass(&renderPassDescriptor);
-			renderPassEncoder.SetPipeline(_renderPipeline);
-			renderPassEncoder.SetBindGroup(0, _transformBindGroup);
-			renderPassEncoder.SetBindGroup(1, _lightBindGroups[i]);
-			renderPassEncoder.SetVertexBuffer(0, descriptor->vertexBuffer, 0, descriptor->vertexBuffer.GetSize());
-			renderPassEncoder.SetIndexBuffer(descriptor->indexBuffer, wgpu::IndexFormat::Uint16, 0, descriptor->indexBuffer.GetSize());
-
-			for (auto& dc : descriptor->drawCalls) {
-				renderPassEncoder.DrawIndexed(dc.indexCount, dc.instanceCount, dc.firstIndex, dc.baseVertex, dc.firstInstance);
+		const bool redrawAll = _staleShadowMaps.size() == rects.size();
+		const wgpu::RenderPassDepthStencilAttachment renderPassDepthStencilAttachment = {
+			.view = descriptor->shadowAtlasTextureView,
+			.depthLoadOp = redrawAll ? wgpu::LoadOp::Clear : wgpu::LoadOp::Load,
+			.depthStoreOp = wgpu::StoreOp::Store,
+			.depthClearValue = 1.0f,
+		};
+		const wgpu::RenderPassDescriptor renderPassDescriptor = {
+			.label = "shadow atlas render pass",
+			.depthStencilAttachment = &renderPassDepthStencilAttachment,
+			.timestampWrites = descriptor->timestampWrites,
+		};
+		wgpu::RenderPassEncoder renderPassEncoder = descriptor->commandEncoder.BeginRenderPass(&renderPassDescriptor);
+		for (const uint32_t i : _staleShadowMaps) {
+			const structs::host::ShadowAtlasRect& rect = rects[i];
+			renderPassEncoder.SetViewport(
+				static_cast<float>(rect.x),
+				static_cast<float>(rect.y),
+				static_cast<float>(rect.size),
+				static_cast<float>(rect.size),
+				0.0f,
+				1.0f
+			);
+			renderPassEncoder.SetScissorRect(rect.x, rect.y, rect.size, rect.size);
+			if (!redrawAll) {
+				renderPassEncoder.SetPipeline(_clearPipeline);
+				renderPassEncoder.Draw(3);
+			}
+			if (!_renderBundles.empty()) {
+				renderPassEncoder.ExecuteBundles(1, &_renderBundles[i]);
+			}
+			else {
+				renderPassEncoder.SetPipeline(_renderPipeline);
+				renderPassEncoder.SetBindGroup(0, _transformBindGroup);
+				renderPassEncoder.SetBindGroup(1, _lightBindGroup, 1, &_sceneResources->lightUniformOffsets[rect.lightIndex]);
+				sceneDraw::multiDraw(renderPassEncoder, _sceneResources, sceneDraw::getLightView(rect.lightIndex));
 			}
-			renderPassEncoder.End();
+			_cachedShadowMaps[i] = CachedShadowMap{
+				.valid = true,
+				.lightSpaceMatrix = _sceneResources->hostLights[rect.lightIndex].lightSpaceMatrix,
+				.geometryVersion = _sceneResources->geometryVersion,
+			};
 		}
+		renderPassEncoder.End();
+	}
+
+	bool ShadowMap::isStale(const uint32_t rectIndex) const {
+		const CachedShadowMap& cached = _cachedShadowMaps[rectIndex];
+		return !_cacheShadowMaps || !cached.valid || cached.geometryVersion != _sceneResources->geometryVersion ||
+			cached.lightSpaceMatrix != _sceneResources->hostLights[_sceneResources->shadowAtlasRects[rectIndex].lightIndex].lightSpaceMatrix;
 	}
 
-	void ShadowMap::createPipeline() {
+	void ShadowMap::createPipeline(PipelineBatch& pipelineBatch) {
 		const wgpu::VertexState vertexState = {
 				.module = _vertexShaderModule,
 				.entryPoint = enums::EntryPoint::VERTEX,
 				.bufferCount = 1,
-				.buffers = &render::vertexBufferLayout,
+				.buffers = _quantizedVertices ? &render::quantizedVertexBufferLayout : &render::vertexBufferLayout,
 		};
 
 		constexpr wgpu::BlendState blendState = {
@@ -108,7 +191,31 @@ namespace render {
 			.fragment = &fragmentState,
 		};
 
-		_renderPipeline = _wgpuContext->device.CreateRenderPipeline(&renderPipelineDescriptor);
+		pipelineBatch.createRenderPipeline(renderPipelineDescriptor, _renderPipeline);
+	}
+
+	void ShadowMap::createClearPipeline(PipelineBatch& pipelineBatch) {
+		const wgpu::PipelineLayoutDescriptor pipelineLayoutDescriptor = {
+			.label = "shadow clear pipeline layout",
+		};
+		constexpr wgpu::DepthStencilState depthStencilState = {
+			.format = constants::DEPTH_FORMAT,
+			.depthWriteEnabled = true,
+			.depthCompare = wgpu::CompareFunction::Always,
+		};
+		wgpu::RenderPipelineDescriptor renderPipelineDescriptor = {
+			.label = "shadow clear pipeline",
+			.layout = _wgpuContext->device.CreatePipelineLayout(&pipelineLayoutDescriptor),
+			.vertex = {
+				.module = _clearShaderModule,
+				.entryPoint = enums::EntryPoint::VERTEX,
+			},
+			.primitive = wgpu::PrimitiveState {
+				.topology = wgpu::PrimitiveTopology::TriangleList,
+			},
+			.depthStencil = &depthStencilState,
+		};
+		pipelineBatch.createRenderPipeline(renderPipelineDescriptor, _clearPipeline);
 	}
 
 	wgpu::PipelineLayout ShadowMap::getPipelineLayout() {
@@ -134,9 +241,37 @@ namespace render {
 			},
 		};
 
-		std::array<wgpu::BindGroupLayoutEntry, 1> bindGroupLayoutEntries = {
+		const wgpu::BindGroupLayoutEntry instancesBindGroupLayoutEntry = {
+			.binding = 3,
+			.visibility = wgpu::ShaderStage::Vertex,
+			.buffer = {
+				.type = wgpu::BufferBindingType::ReadOnlyStorage,
+				.minBindingSize = sizeof(structs::Instance),
+			},
+		};
+
+		std::vector<wgpu::BindGroupLayoutEntry> bindGroupLayoutEntries = {
 			transformBindGroupLayoutEntry,
+			instancesBindGroupLayoutEntry,
 		};
+		if (_quantizedVertices) {
+			bindGroupLayoutEntries.push_back(wgpu::BindGroupLayoutEntry{
+				.binding = 1,
+				.visibility = wgpu::ShaderStage::Vertex,
+				.buffer = {
+					.type = wgpu::BufferBindingType::ReadOnlyStorage,
+					.minBindingSize = sizeof(structs::VertexQuantization),
+				},
+			});
+			bindGroupLayoutEntries.push_back(wgpu::BindGroupLayoutEntry{
+				.binding = 2,
+				.visibility = wgpu::ShaderStage::Vertex,
+				.buffer = {
+					.type = wgpu::BufferBindingType::ReadOnlyStorage,
+					.minBindingSize = sizeof(uint32_t),
+				},
+			});
+		}
 		const wgpu::BindGroupLayoutDescriptor bindGroupLayoutDescriptor = {
 			.label = "shadow render transform bind group layout",
 			.entryCount = bindGroupLayoutEntries.size(),
@@ -151,6 +286,7 @@ namespace render {
 			.visibility = wgpu::ShaderStage::Vertex | wgpu::ShaderStage::Fragment,
 			.buffer = {
 				.type = wgpu::BufferBindingType::Uniform,
+				.hasDynamicOffset = true, //light i is at lightUniformOffsets[i] of the shared light uniform buffer
 				.minBindingSize = sizeof(structs::Light),
 			}
 		};
@@ -166,16 +302,37 @@ namespace render {
 	};
 
 	void ShadowMap::createTransformBindGroup(
-		const wgpu::Buffer& transformBuffer
+		const wgpu::Buffer& transformBuffer,
+		const wgpu::Buffer& instanceBuffer,
+		const wgpu::Buffer& vertexQuantizationBuffer,
+		const wgpu::Buffer& vertexQuantizationIndexBuffer
 	) {
 		const wgpu::BindGroupEntry transformBindGroupEntry = {
 			.binding = 0,
 			.buffer = transformBuffer,
 			.size = transformBuffer.GetSize(),
 		};
-		std::array<wgpu::BindGroupEntry, 1> bindGroupEntries = {
-			transformBindGroupEntry
+		const wgpu::BindGroupEntry instancesBindGroupEntry = {
+			.binding = 3,
+			.buffer = instanceBuffer,
+			.size = instanceBuffer.GetSize(),
+		};
+		std::vector<wgpu::BindGroupEntry> bindGroupEntries = {
+			transformBindGroupEntry,
+			instancesBindGroupEntry,
 		};
+		if (_quantizedVertices) {
+			bindGroupEntries.push_back(wgpu::BindGroupEntry{
+				.binding = 1,
+				.buffer = vertexQuantizationBuffer,
+				.size = vertexQuantizationBuffer.GetSize(),
+			});
+			bindGroupEntries.push_back(wgpu::BindGroupEntry{
+				.binding = 2,
+				.buffer = vertexQuantizationIndexBuffer,
+				.size = vertexQuantizationIndexBuffer.GetSize(),
+			});
+		}
 		const wgpu::BindGroupDescriptor bindGroupDescriptor = {
 			.label = "shadow transform render group",
 			.layout = _transformBindGroupLayout,
@@ -185,13 +342,13 @@ namespace render {
 		_transformBindGroup = _wgpuContext->device.CreateBindGroup(&bindGroupDescriptor);
 	}
 
-	void ShadowMap::insertLightBindGroup(
-		const wgpu::Buffer& lightBuffer
+	void ShadowMap::createLightBindGroup(
+		const wgpu::Buffer& lightUniformBuffer
 	) {
 		const wgpu::BindGroupEntry lightBindGroupEntry = {
 			.binding = 0,
-			.buffer = lightBuffer,
-			.size = lightBuffer.GetSize(),
+			.buffer = lightUniformBuffer,
+			.size = sizeof(structs::Light),
 		};
 		std::array<wgpu::BindGroupEntry, 1> bindGroupEntries = {
 			lightBindGroupEntry
@@ -202,7 +359,25 @@ namespace render {
 			.entryCount = bindGroupEntries.size(),
 			.entries = bindGroupEntries.data(),
 		};
-		_lightBindGroups.emplace_back(_wgpuContext->device.CreateBindGroup(&bindGroupDescriptor));
+		_lightBindGroup = _wgpuContext->device.CreateBindGroup(&bindGroupDescriptor);
 	}
 
+	//Recorded once per shadowed light and replayed every frame over the culled list of that light's view, the pass sets
+	//the viewport of its square since bundles cannot
+	void ShadowMap::insertRenderBundle(const uint32_t lightIndex) {
+		const wgpu::RenderBundleEncoderDescriptor renderBundleEncoderDescriptor = {
+			.label = "shadow render bundle encoder",
+			.depthStencilFormat = constants::DEPTH_FORMAT,
+			.sampleCount = 1,
+		};
+		const wgpu::RenderBundleEncoder renderBundleEncoder = _wgpuContext->device.CreateRenderBundleEncoder(&renderBundleEncoderDescriptor);
+		renderBundleEncoder.SetPipeline(_renderPipeline);
+		renderBundleEncoder.SetBindGroup(0, _transformBindGroup);
+		renderBundleEncoder.SetBindGroup(1, _lightBindGroup, 1, &_sceneResources->lightUniformOffsets[lightIndex]);
+		sceneDraw::drawEach(renderBundleEncoder, _wgpuContext->device, _sceneResources, sceneDraw::getLightView(lightIndex));
+		const wgpu::RenderBundleDescriptor renderBundleDescriptor = {
+			.label = "shadow render bundle",
+		};
+		_renderBundles.push_back(renderBundleEncoder.Finish(&renderBundleDescriptor));
+	}
 }
\ No newline at end of file
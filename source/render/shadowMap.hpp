@@ -5,6 +5,8 @@
 #include "../structs/host.hpp"
 #include "../wgpuContext/wgpuContext.hpp"
 #include "../device/resources.hpp"
+#include "../device/pipelineBatch.hpp"
+#include "frameGraph.hpp"
 
 namespace render {
 	namespace shadowMap {
@@ -16,48 +18,79 @@ namespace render {
 
 			struct DoCommands {
 				wgpu::CommandEncoder& commandEncoder;
-				wgpu::Buffer& vertexBuffer;
-				wgpu::Buffer& indexBuffer;
-				std::vector<structs::host::DrawCall>& drawCalls;
-				std::vector<wgpu::TextureView>& shadowMapTextureViews;
+				wgpu::TextureView& shadowAtlasTextureView;
+				const wgpu::PassTimestampWrites* timestampWrites = nullptr;
 			};
 		}
 	}
 
 	class ShadowMap {
 	public:
-		ShadowMap(WGPUContext* wgpuContext);
+		//quantizedVertices must match how the scene was loaded, see Initial. With cacheShadowMaps a shadow map is only redrawn
+		//once the matrix of its light, SceneResources::geometryVersion or SceneResources::shadowAtlasVersion differs from what
+		//it was drawn with
+		ShadowMap(WGPUContext* wgpuContext, const bool quantizedVertices, const bool cacheShadowMaps);
+		void declareResources(FrameGraph& frameGraph) const;
+		void createPipelineAsync(PipelineBatch& pipelineBatch);
+		//The pipeline batch must have been waited on
 		void generateGpuObjects(const DeviceResources* deviceResources);
 		void doCommands(const render::shadowMap::descriptor::DoCommands* descriptor);
 
 	private:
 		const wgpu::StringView VERTEX_SHADER_LABEL = "shadow render vertex shader";
 		const std::string VERTEX_SHADER_PATH = "shaders/shadowMap_v.spv";
+		const std::string QUANTIZED_VERTEX_SHADER_PATH = "shaders/shadowMapQuantized_v.wgsl";
 
 		const wgpu::StringView FRAGMENT_SHADER_LABEL = "shadow render fragment shader";
 		const std::string FRAGMENT_SHADER_PATH = "shaders/shadowMap_f.spv";
 
+		const wgpu::StringView CLEAR_SHADER_LABEL = "shadow clear vertex shader";
+		const std::string CLEAR_SHADER_PATH = "shaders/shadowMapClear_v.wgsl";
+
+		//What a square of the atlas was last drawn with
+		struct CachedShadowMap {
+			bool valid = false;
+			glm::f32mat4x4 lightSpaceMatrix;
+			uint64_t geometryVersion = 0;
+		};
+
 		WGPUContext* _wgpuContext;
-		uint32_t _shadowMapCount = 0;
+		bool _quantizedVertices;
+		bool _cacheShadowMaps;
+		std::vector<CachedShadowMap> _cachedShadowMaps; //one per SceneResources::shadowAtlasRects
+		uint64_t _shadowAtlasVersion = 0; //the SceneResources::shadowAtlasVersion _cachedShadowMaps and _renderBundles are for
+		std::vector<uint32_t> _staleShadowMaps; //indices of the shadow maps redrawn this frame
 
 		wgpu::RenderPipeline _renderPipeline;
+		wgpu::RenderPipeline _clearPipeline; //writes the far plane over the viewport, the pass only clears the whole atlas
 		wgpu::BindGroupLayout _transformBindGroupLayout;
 		wgpu::BindGroupLayout _lightBindGroupLayout;
 		wgpu::BindGroup _transformBindGroup;
-		std::vector<wgpu::BindGroup> _lightBindGroups;
+		wgpu::BindGroup _lightBindGroup; //bound at the dynamic offset of each light
+		const SceneResources* _sceneResources = nullptr;
+		std::vector<wgpu::RenderBundle> _renderBundles; //every draw of each shadow map, empty when the pass multi draws instead
 
 		wgpu::ShaderModule _vertexShaderModule;
 		wgpu::ShaderModule _fragmentShaderModule;
+		wgpu::ShaderModule _clearShaderModule;
 
 		wgpu::PipelineLayout getPipelineLayout();
 		void createTransformBindGroupLayout();
 		void createLightBindGroupLayout();
-		void createPipeline();
+		void createPipeline(PipelineBatch& pipelineBatch);
+		void createClearPipeline(PipelineBatch& pipelineBatch);
+		bool isStale(const uint32_t rectIndex) const;
+		void resetShadowMaps();
+		//The vertex quantization buffers are only bound with quantized vertices
 		void createTransformBindGroup(
-			const wgpu::Buffer& transformBuffer
+			const wgpu::Buffer& transformBuffer,
+			const wgpu::Buffer& instanceBuffer,
+			const wgpu::Buffer& vertexQuantizationBuffer,
+			const wgpu::Buffer& vertexQuantizationIndexBuffer
 		);
-		void insertLightBindGroup(
-			const wgpu::Buffer& lightBuffer
+		void createLightBindGroup(
+			const wgpu::Buffer& lightUniformBuffer
 		);
+		void insertRenderBundle(const uint32_t lightIndex);
 	};
 }
\ No newline at end of file
@@ -12,10 +12,21 @@ namespace render {
 		_fragmentShaderModule = device::createShaderModule(_wgpuContext->device, FRAGMENT_SHADER_LABEL, FRAGMENT_SHADER_PATH);
 	};
 
+	void ToSurface::declareResources(FrameGraph& frameGraph) const {
+		frameGraph.addPass({
+			.pass = enums::GpuPass::TO_SURFACE,
+			.reads = { enums::FrameResource::ULTIMATE },
+			.writes = { enums::FrameResource::SURFACE },
+		});
+	}
+
+	void ToSurface::createPipelineAsync(PipelineBatch& pipelineBatch, const wgpu::TextureFormat surfaceTextureFormat) {
+		createBindGroupLayout();
+		createPipeline(pipelineBatch, surfaceTextureFormat);
+	}
+
 	void ToSurface::generateGpuObjects(const render::toSurface::descriptor::GenerateGpuObjects* descriptor) {
 		createSampler();
-		createBindGroupLayout();
-		createPipeline(descriptor->surfaceTextureFormat);
 		createBindGroup(
 			descriptor->ultimateTextureView
 		);
@@ -34,6 +45,7 @@ namespace render {
 			.label = "toSurface render pass",
 			.colorAttachmentCount = 1,
 			.colorAttachments = &surfaceAttachment,
+			.timestampWrites = descriptor->timestampWrites,
 		};
 
 		wgpu::RenderPassEncoder renderPassEncoder = descriptor->commandEncoder.BeginRenderPass(&renderPassDescriptor);
@@ -43,7 +55,7 @@ namespace render {
 		renderPassEncoder.End();
 	}
 
-	void ToSurface::createPipeline(wgpu::TextureFormat surfaceTextureFormat) {
+	void ToSurface::createPipeline(PipelineBatch& pipelineBatch, wgpu::TextureFormat surfaceTextureFormat) {
 		const wgpu::PipelineLayout pipelineLayout = getPipelineLayout();
 		wgpu::VertexState vertexState = {
 			.module = _vertexShaderModule,
@@ -67,7 +79,7 @@ namespace render {
 			.vertex = vertexState,
 			.fragment = &fragmentState,
 		};
-		_renderPipeline = _wgpuContext->device.CreateRenderPipeline(&renderPipelineDescriptor);
+		pipelineBatch.createRenderPipeline(renderPipelineDescriptor, _renderPipeline);
 	}
 
 	void ToSurface::createBindGroup(
@@ -8,24 +8,29 @@
 #include "../structs/host.hpp"
 #include "../wgpuContext/wgpuContext.hpp"
 #include "../device/resources.hpp"
+#include "../device/pipelineBatch.hpp"
+#include "frameGraph.hpp"
 
 namespace render {
 	namespace toSurface::descriptor {
 
 		struct GenerateGpuObjects {
 			wgpu::TextureView& ultimateTextureView;
-			wgpu::TextureFormat surfaceTextureFormat;
 		};
 
 		struct DoCommands {
 			wgpu::CommandEncoder& commandEncoder;
 			wgpu::TextureView& surfaceTextureView;
+			const wgpu::PassTimestampWrites* timestampWrites = nullptr;
 		};
 	}
 
 	class ToSurface {
 	public:
 		ToSurface(WGPUContext* wgpuContext);
+		void declareResources(FrameGraph& frameGraph) const;
+		void createPipelineAsync(PipelineBatch& pipelineBatch, const wgpu::TextureFormat surfaceTextureFormat);
+		//The pipeline batch must have been waited on
 		void generateGpuObjects(const render::toSurface::descriptor::GenerateGpuObjects* descriptor);
 		void doCommands(const render::toSurface::descriptor::DoCommands* descriptor);
 
@@ -50,7 +55,7 @@ namespace render {
 
 		wgpu::PipelineLayout getPipelineLayout();
 		void createBindGroupLayout();
-		void createPipeline(wgpu::TextureFormat surfaceTextureFormat);
+		void createPipeline(PipelineBatch& pipelineBatch, wgpu::TextureFormat surfaceTextureFormat);
 		void createBindGroup(
 			wgpu::TextureView& baseColorTextureView
 		//	wgpu::TextureView& shadowMapTextureView
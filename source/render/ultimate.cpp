@@ -4,44 +4,58 @@
 #include "../device/device.hpp"
 #include "../enums.hpp"
 #include <dawn/webgpu_cpp.h>
+#include "dispatch.hpp"
 
 namespace render {
 	Ultimate::Ultimate(WGPUContext* wgpuContext) : _wgpuContext(wgpuContext) {
 		_computeShaderModule = device::createWGSLShaderModule(wgpuContext->device, ULTIMATE_SHADER_LABEL, ULTIMATE_SHADER_PATH);
 	};
 
-	void Ultimate::generateGpuObjects(const DeviceResources* deviceResources) {
+	void Ultimate::declareResources(FrameGraph& frameGraph) const {
+		frameGraph.addPass({
+			.pass = enums::GpuPass::ULTIMATE,
+			.reads = { enums::FrameResource::BASE_COLOR, enums::FrameResource::LIGHTING },
+			.writes = { enums::FrameResource::ULTIMATE },
+		});
+	}
+
+	void Ultimate::createPipelineAsync(PipelineBatch& pipelineBatch, const RenderResources* renderResources) {
 		createBindGroupLayout(
-			deviceResources->render->ultimateTextureFormat,
-			deviceResources->render->baseColorTextureFormat,
-			deviceResources->render->lightingTextureFormat,
-			deviceResources->render->shadowTextureFormat
+			renderResources->ultimateTextureFormat,
+			renderResources->baseColorTextureFormat,
+			renderResources->lightingTextureFormat
 		);
-		createPipeline();
+		createPipeline(pipelineBatch);
+	}
+
+	void Ultimate::generateGpuObjects(const DeviceResources* deviceResources) {
 		createBindGroup(
 			deviceResources->render->ultimateTextureView,
 			deviceResources->render->baseColorTextureView,
-			deviceResources->render->lightingTextureView,
-			deviceResources->render->shadowTextureView
+			deviceResources->render->lightingTextureView
 		);
 	};
 
 	void Ultimate::doCommands(const render::ultimate::descriptor::DoCommands* descriptor) {
 		wgpu::ComputePassDescriptor computePassDescriptor = {
 			.label = "ultimate compute pass",
+			.timestampWrites = descriptor->timestampWrites,
 		};
 		wgpu::ComputePassEncoder computePassEncoder = descriptor->commandEncoder.BeginComputePass(&computePassDescriptor);
 		computePassEncoder.SetPipeline(_computePipeline);
 		computePassEncoder.SetBindGroup(0, _bindGroup);
-		computePassEncoder.DispatchWorkgroups(_wgpuContext->getScreenDimensions().width, _wgpuContext->getScreenDimensions().height);
+		render::dispatch::fullScreen(computePassEncoder, _wgpuContext);
 		computePassEncoder.End();
 	}
 
-	void Ultimate::createPipeline() {
+	void Ultimate::createPipeline(PipelineBatch& pipelineBatch) {
 		const wgpu::PipelineLayout pipelineLayout = getPipelineLayout();
+		const std::array<wgpu::ConstantEntry, 2> workgroupSizeConstants = render::dispatch::getWorkgroupSizeConstants(_wgpuContext);
 		wgpu::ComputeState computeState = {
 			.module = _computeShaderModule,
 			.entryPoint = enums::EntryPoint::COMPUTE,
+			.constantCount = workgroupSizeConstants.size(),
+			.constants = workgroupSizeConstants.data(),
 		};
 
 		const wgpu::ComputePipelineDescriptor computePipelineDescriptor = {
@@ -49,14 +63,13 @@ namespace render {
 			.layout = pipelineLayout,
 			.compute = computeState,
 		};
-		_computePipeline = _wgpuContext->device.CreateComputePipeline(&computePipelineDescriptor);
+		pipelineBatch.createComputePipeline(computePipelineDescriptor, _computePipeline);
 	}
 
 	void Ultimate::createBindGroup(
 		wgpu::TextureView& ultimateTextureView,
 		wgpu::TextureView& baseColorTextureView,
-		wgpu::TextureView& lightingTextureView,
-		wgpu::TextureView& shadowTextureView
+		wgpu::TextureView& lightingTextureView
 	) {
 		const wgpu::BindGroupEntry ultimateBindGroupEntry = {
 			.binding = 0,
@@ -70,16 +83,11 @@ namespace render {
 			.binding = 2,
 			.textureView = lightingTextureView,
 		};
-		const wgpu::BindGroupEntry shadowBindGroupEntry = {
-			.binding = 3,
-			.textureView = shadowTextureView,
-		};
 
-		std::array<wgpu::BindGroupEntry, 4> bindGroupEntries = {
+		std::array<wgpu::BindGroupEntry, 3> bindGroupEntries = {
 			ultimateBindGroupEntry,
 			baseColorBindGroupEntry,
 			lightingBindGroupEntry,
-			shadowBindGroupEntry
 		};
 		const wgpu::BindGroupDescriptor bindGroupDescriptor = {
 			.label = "ultimate bind group",
@@ -93,8 +101,7 @@ namespace render {
 	void Ultimate::createBindGroupLayout(
 		wgpu::TextureFormat ultimateTextureFormat,
 		wgpu::TextureFormat baseColorTextureFormat,
-		wgpu::TextureFormat lightingTextureFormat,
-		wgpu::TextureFormat shadowTextureFormat
+		wgpu::TextureFormat lightingTextureFormat
 	) {
 		const wgpu::BindGroupLayoutEntry ultimateBindGroupLayoutEntry = {
 			.binding = 0,
@@ -126,21 +133,10 @@ namespace render {
 			},
 		};
 
-		const wgpu::BindGroupLayoutEntry shadowBindGroupLayoutEntry = {
-			.binding = 3,
-			.visibility = wgpu::ShaderStage::Compute,
-			.storageTexture = {
-				.access = wgpu::StorageTextureAccess::ReadOnly,
-				.format = shadowTextureFormat,
-				.viewDimension = wgpu::TextureViewDimension::e2D,
-			},
-		};
-
-		std::array<wgpu::BindGroupLayoutEntry, 4> bindGroupLayoutEntries = {
+		std::array<wgpu::BindGroupLayoutEntry, 3> bindGroupLayoutEntries = {
 			ultimateBindGroupLayoutEntry,
 			baseColorBindGroupLayoutEntry,
 			lightingBindGroupLayoutEntry,
-			shadowBindGroupLayoutEntry,
 		};
 
 		const wgpu::BindGroupLayoutDescriptor bindGroupLayoutDescriptor = {
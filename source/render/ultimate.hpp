@@ -8,6 +8,8 @@
 #include "../structs/host.hpp"
 #include "../wgpuContext/wgpuContext.hpp"
 #include "../device/resources.hpp"
+#include "../device/pipelineBatch.hpp"
+#include "frameGraph.hpp"
 
 namespace render {
 	namespace ultimate::descriptor {
@@ -17,18 +19,20 @@ namespace render {
 			wgpu::TextureView& baseColorTextureView;
 			wgpu::TextureFormat lightingTextureFormat;
 			wgpu::TextureView& lightingTextureView;
-			wgpu::TextureFormat shadowTextureFormat;
-			wgpu::TextureView& shadowTextureView;
 		};
 
 		struct DoCommands {
 			wgpu::CommandEncoder& commandEncoder;
+			const wgpu::PassTimestampWrites* timestampWrites = nullptr;
 		};
 	}
 
 	class Ultimate {
 	public:
 		Ultimate(WGPUContext* wgpuContext);
+		void declareResources(FrameGraph& frameGraph) const;
+		void createPipelineAsync(PipelineBatch& pipelineBatch, const RenderResources* renderResources);
+		//The pipeline batch must have been waited on
 		void generateGpuObjects(const DeviceResources* deviceResources);
 		void doCommands(const render::ultimate::descriptor::DoCommands* descriptor);
 
@@ -49,15 +53,13 @@ namespace render {
 		void createBindGroupLayout(
 			wgpu::TextureFormat ultimateTextureFormat,
 			wgpu::TextureFormat baseColorTextureFormat,
-			wgpu::TextureFormat lightingTextureFormat,
-			wgpu::TextureFormat shadowTextureFormat
+			wgpu::TextureFormat lightingTextureFormat
 		);
-		void createPipeline();
+		void createPipeline(PipelineBatch& pipelineBatch);
 		void createBindGroup(
 			wgpu::TextureView& ultimateTextureView,
 			wgpu::TextureView& baseColorTextureView,
-			wgpu::TextureView& lightingTextureView,
-			wgpu::TextureView& shadowTextureView
+			wgpu::TextureView& lightingTextureView
 		);
 	};
 }
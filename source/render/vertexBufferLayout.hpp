@@ -24,6 +24,27 @@ namespace {
 		normalAttribute,
 		texcoordAttribute
 	};
+
+	constexpr wgpu::VertexAttribute quantizedPositionAttribute = {
+		.format = wgpu::VertexFormat::Unorm16x4,
+		.offset = offsetof(structs::QuantizedVBO, vertex),
+		.shaderLocation = 0,
+	};
+	constexpr wgpu::VertexAttribute quantizedNormalAttribute = {
+		.format = wgpu::VertexFormat::Snorm16x2,
+		.offset = offsetof(structs::QuantizedVBO, normal),
+		.shaderLocation = 1,
+	};
+	constexpr wgpu::VertexAttribute quantizedTexcoordAttribute = {
+		.format = wgpu::VertexFormat::Unorm16x2,
+		.offset = offsetof(structs::QuantizedVBO, texcoord),
+		.shaderLocation = 2,
+	};
+	constexpr auto quantizedVertexAttributes = std::array<wgpu::VertexAttribute, 3>{
+		quantizedPositionAttribute,
+		quantizedNormalAttribute,
+		quantizedTexcoordAttribute
+	};
 }
 
 namespace render {
@@ -32,4 +53,11 @@ namespace render {
 		.attributeCount = vertexAttributes.size(),
 		.attributes = vertexAttributes.data(),
 	};
+
+	//Dequantized by the quantized vertex shaders with SceneResources::vertexQuantizations
+	static constexpr wgpu::VertexBufferLayout quantizedVertexBufferLayout = {
+		.arrayStride = sizeof(structs::QuantizedVBO),
+		.attributeCount = quantizedVertexAttributes.size(),
+		.attributes = quantizedVertexAttributes.data(),
+	};
 }
@@ -19,6 +19,22 @@ namespace structs {
 			uint32_t firstInstance; //requires indirect-first-instance feature
 		};
 
+		//Where a scene image is in SceneResources::textureArrays
+		struct TextureLayer {
+			uint32_t arrayIndex;
+			uint32_t layer;
+		};
+
+		//The square of a light's shadow map in the shadow atlas, in texels
+		struct ShadowAtlasRect {
+			uint32_t lightIndex;
+			uint32_t x;
+			uint32_t y;
+			uint32_t size;
+
+			bool operator==(const ShadowAtlasRect&) const = default;
+		};
+
 
 	}
 }
\ No newline at end of file
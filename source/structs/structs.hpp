@@ -1,6 +1,8 @@
 #pragma once
 #include "glm/glm.hpp"
+#include <array>
 #include <dawn/webgpu_cpp.h>
+#include "../constants.hpp"
 
 namespace structs {
 	struct VBO {
@@ -9,10 +11,27 @@ namespace structs {
 		glm::f32vec2 texcoord;
 	};
 
+	//16 byte VBO of quantized scenes, see VertexQuantization
+	struct QuantizedVBO {
+		glm::u16vec4 vertex; //unorm16 within the mesh's position bounds, w is unused
+		glm::i16vec2 normal; //snorm16 octahedral encoding
+		glm::u16vec2 texcoord; //unorm16 within the mesh's texcoord bounds
+	};
+
+	//Turns the unorm16 of a QuantizedVBO back into positions and texcoords, one per mesh shared by all its instances
+	struct VertexQuantization {
+		glm::f32vec3 positionMin;
+		uint32_t PAD0;
+		glm::f32vec3 positionScale;
+		uint32_t PAD1;
+		glm::f32vec2 texcoordMin;
+		glm::f32vec2 texcoordScale;
+	};
+
 	struct Light { //glm version of fastgltf::Light
 		glm::f32mat4x4 lightSpaceMatrix;
 		glm::f32vec3 position;
-		uint32_t PAD0;
+		uint32_t shadowViewIndex; //into SceneResources::shadowViews, constants::NO_SHADOW_VIEW without a shadow map. Set by SceneResources
 		glm::f32vec3 rotation; //TODO: check to see if alignas will do the trick
 		uint32_t PAD1;
 		glm::f32vec3 color;
@@ -23,6 +42,50 @@ namespace structs {
 		glm::f32 outerConeAngle;
 	};
 
+	//A light with a shadow map as lighting_c.wgsl reads it
+	struct ShadowView {
+		glm::f32mat4x4 lightSpaceMatrix;
+		glm::f32vec4 atlasRect; //uv offset in xy and uv scale in zw of the shadow map in the atlas, a zero scale is no view
+	};
+
+	//Lights that reach one screen tile, written by the light culling pass
+	struct TileLights {
+		uint32_t count;
+		std::array<uint32_t, constants::MAX_LIGHTS_PER_TILE> indices;
+	};
+
+	//Counted by the light culling pass each frame, a tile keeps the first MAX_LIGHTS_PER_TILE lights that reach it
+	struct TileLightOverflow {
+		uint32_t tileCount; //tiles reached by more lights than they can hold
+		uint32_t droppedLightCount; //summed over those tiles
+	};
+
+	//World space axis aligned box around every instance of one DrawCall, tested by the culling pass
+	struct DrawBounds {
+		glm::f32vec3 center;
+		uint32_t PAD0;
+		glm::f32vec3 extent; //half size
+		uint32_t PAD1;
+	};
+
+	//What an instance of a DrawCall reads, at its instance index. The primitives of a mesh share its transforms
+	struct Instance {
+		uint32_t transformIndex;
+		uint32_t materialIndex;
+	};
+
+	//Uniforms of the culling pass
+	struct CullingParams {
+		uint32_t drawCount;
+		uint32_t viewCount;
+		uint32_t occlusionCulling; //0 until a Hi-Z of a previous frame exists
+		uint32_t hiZMipCount;
+		uint32_t uint16DrawCount; //draws before it are counted and compacted apart from the rest, see SceneResources
+		uint32_t PAD0;
+		uint32_t PAD1;
+		uint32_t PAD2;
+	};
+
 	struct SamplerTexturePair {
 		uint32_t samplerIndex;
 		uint32_t textureIndex;
@@ -51,11 +114,12 @@ namespace structs {
 		uint32_t PAD1;
 	};
 
-	struct InputInfo {
-		uint32_t stpIndex;
-		uint32_t PAD0;
-		uint32_t PAD1;
-		uint32_t PAD2;
+	//Where a SamplerTexturePair lives in the scene texture array
+	struct TextureArrayLookup {
+		uint32_t layer; //UINT32_MAX if the pair is not resolved by this pass
+		uint32_t useNearestFilter;
+		uint32_t useMipmaps; //0 samples level 0 only, as glTF samplers without a mipmap min filter ask for
+		uint32_t arrayIndex; //which of SceneResources::textureArrays holds layer
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,150 @@
+#pragma once
+#include "ktx2.hpp"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "absl/log/log.h"
+#include "vkFormat.hpp"
+
+namespace {
+	//libktx initializes the Basis transcoder tables on the first transcode without a lock, so the first transcode
+	//runs alone and every later one is free to run in parallel
+	std::once_flag transcoderInitialized;
+
+	KTX_error_code transcode(ktxTexture2* texture, const ktx_transcode_fmt_e transcodeFormat) {
+		KTX_error_code result = KTX_SUCCESS;
+		bool transcoded = false;
+		std::call_once(transcoderInitialized, [&]() {
+			result = ktxTexture2_TranscodeBasis(texture, transcodeFormat, 0);
+			transcoded = true;
+		});
+		if (!transcoded) {
+			result = ktxTexture2_TranscodeBasis(texture, transcodeFormat, 0);
+		}
+		return result;
+	}
+
+	texture::ktx2::TranscodeTarget getCompressedTarget(const ktx_transcode_fmt_e transcodeFormat, const vkFormat::VkFormat unorm, const vkFormat::VkFormat srgb) {
+		return texture::ktx2::TranscodeTarget{
+			.transcodeFormat = transcodeFormat,
+			.vkFormat = unorm,
+			.vkFormatSrgb = srgb,
+			.textureFormat = vkFormat::WebGpuImageFormat(unorm),
+			.blockSize = 4,
+			.bytesPerBlock = 16,
+		};
+	}
+
+	//BC7, then ASTC 4x4, then ETC2, the ones the device has a compression feature for, and RGBA8 last
+	std::vector<texture::ktx2::TranscodeTarget> getDeviceTargets(const wgpu::Device& device) {
+		std::vector<texture::ktx2::TranscodeTarget> targets;
+		if (device.HasFeature(wgpu::FeatureName::TextureCompressionBC)) {
+			targets.push_back(getCompressedTarget(KTX_TTF_BC7_RGBA, vkFormat::VK_FORMAT_BC7_UNORM_BLOCK, vkFormat::VK_FORMAT_BC7_SRGB_BLOCK));
+		}
+		if (device.HasFeature(wgpu::FeatureName::TextureCompressionASTC)) {
+			targets.push_back(getCompressedTarget(KTX_TTF_ASTC_4x4_RGBA, vkFormat::VK_FORMAT_ASTC_4x4_UNORM_BLOCK, vkFormat::VK_FORMAT_ASTC_4x4_SRGB_BLOCK));
+		}
+		if (device.HasFeature(wgpu::FeatureName::TextureCompressionETC2)) {
+			targets.push_back(getCompressedTarget(KTX_TTF_ETC2_RGBA, vkFormat::VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, vkFormat::VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK));
+		}
+		targets.push_back(texture::ktx2::getRGBA8Target());
+		return targets;
+	}
+
+	ktxTexture2* createTexture(const std::string& filePath, const ktxTextureCreateFlags createFlags) {
+		ktxTexture2* texture = nullptr;
+		const KTX_error_code result = ktxTexture2_CreateFromNamedFile(filePath.c_str(), createFlags, &texture);
+		if (result != KTX_SUCCESS) {
+			throw std::runtime_error("failed to load ktx2 file " + filePath + ": " + ktxErrorString(result));
+		}
+		return texture;
+	}
+}
+
+namespace texture::ktx2 {
+	TranscodeTarget getRGBA8Target() {
+		return TranscodeTarget{
+			.transcodeFormat = KTX_TTF_RGBA32,
+			.vkFormat = vkFormat::VK_FORMAT_R8G8B8A8_UNORM,
+			.vkFormatSrgb = vkFormat::VK_FORMAT_R8G8B8A8_SRGB,
+			.textureFormat = vkFormat::WebGpuImageFormat(vkFormat::VK_FORMAT_R8G8B8A8_UNORM),
+			.blockSize = 1,
+			.bytesPerBlock = 4,
+		};
+	}
+
+	//Unorm rather than sRGB views so compressed layers sample the same as the RGBA8Unorm layers decoded by stb
+	TranscodeTarget selectTranscodeTarget(const wgpu::Device& device) {
+		return getDeviceTargets(device).front();
+	}
+
+	bool findTarget(const wgpu::Device& device, const uint32_t vkFormat, TranscodeTarget& outTarget) {
+		for (const TranscodeTarget& target : getDeviceTargets(device)) {
+			if (target.vkFormat == vkFormat || target.vkFormatSrgb == vkFormat) {
+				outTarget = target;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool isCompressed(const TranscodeTarget& target) {
+		return target.blockSize > 1;
+	}
+
+	bool isKtx2(const std::string& filePath) {
+		std::string extension = std::filesystem::path(filePath).extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return extension == ".ktx2";
+	}
+
+	void getDimensions(const std::string& filePath, uint32_t& outWidth, uint32_t& outHeight, uint32_t& outLevelCount, uint32_t& outVkFormat) {
+		ktxTexture2* texture = createTexture(filePath, KTX_TEXTURE_CREATE_NO_FLAGS);
+		outWidth = texture->baseWidth;
+		outHeight = texture->baseHeight;
+		outLevelCount = texture->numLevels;
+		outVkFormat = ktxTexture2_NeedsTranscoding(texture) ? static_cast<uint32_t>(vkFormat::VK_FORMAT_UNDEFINED) : texture->vkFormat;
+		ktxTexture_Destroy(ktxTexture(texture));
+	}
+
+	std::vector<std::vector<unsigned char>> loadLevels(const std::string& filePath, const TranscodeTarget& target, const uint32_t levelCount, uint32_t& outWidth, uint32_t& outHeight) {
+		ktxTexture2* texture = createTexture(filePath, KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT);
+
+		if (ktxTexture2_NeedsTranscoding(texture)) {
+			const KTX_error_code result = transcode(texture, target.transcodeFormat);
+			if (result != KTX_SUCCESS) {
+				ktxTexture_Destroy(ktxTexture(texture));
+				throw std::runtime_error("failed to transcode " + filePath + ": " + ktxErrorString(result));
+			}
+		}
+		else if (texture->vkFormat != target.vkFormat && texture->vkFormat != target.vkFormatSrgb) {
+			const uint32_t fileVkFormat = texture->vkFormat;
+			ktxTexture_Destroy(ktxTexture(texture));
+			throw std::runtime_error("ktx2 file " + filePath + " has vkFormat " + std::to_string(fileVkFormat) + " which cannot be converted to the texture array format");
+		}
+
+		if (levelCount > texture->numLevels) {
+			const uint32_t fileLevelCount = texture->numLevels;
+			ktxTexture_Destroy(ktxTexture(texture));
+			throw std::runtime_error("ktx2 file " + filePath + " has " + std::to_string(fileLevelCount) + " mip levels, " + std::to_string(levelCount) + " were requested");
+		}
+
+		outWidth = texture->baseWidth;
+		outHeight = texture->baseHeight;
+		std::vector<std::vector<unsigned char>> levels;
+		levels.reserve(levelCount);
+		for (uint32_t level = 0; level < levelCount; ++level) {
+			ktx_size_t offset = 0;
+			ktxTexture_GetImageOffset(ktxTexture(texture), level, 0, 0, &offset);
+			const ktx_size_t size = ktxTexture_GetImageSize(ktxTexture(texture), level);
+			const ktx_uint8_t* data = ktxTexture_GetData(ktxTexture(texture)) + offset;
+			levels.emplace_back(data, data + size);
+		}
+
+		ktxTexture_Destroy(ktxTexture(texture));
+		return levels;
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <ktx.h>
+#include <dawn/webgpu_cpp.h>
+
+namespace texture::ktx2 {
+	//What Basis Universal textures are transcoded to
+	struct TranscodeTarget {
+		ktx_transcode_fmt_e transcodeFormat;
+		uint32_t vkFormat; //vkFormat::VkFormat
+		uint32_t vkFormatSrgb; //the same blocks tagged sRGB, accepted for KTX2 files that need no transcoding
+		wgpu::TextureFormat textureFormat;
+		uint32_t blockSize; //texels along each edge of a block
+		uint32_t bytesPerBlock;
+	};
+
+	//Uncompressed RGBA8, always available
+	TranscodeTarget getRGBA8Target();
+	//BC7, then ASTC 4x4, then ETC2, whichever compression feature the device has first. RGBA8 if none
+	TranscodeTarget selectTranscodeTarget(const wgpu::Device& device);
+	//The target that holds the blocks of vkFormat as they are, false if the device cannot sample them
+	bool findTarget(const wgpu::Device& device, const uint32_t vkFormat, TranscodeTarget& outTarget);
+	bool isCompressed(const TranscodeTarget& target);
+
+	bool isKtx2(const std::string& filePath);
+	//Only reads the header. outVkFormat is vkFormat::VK_FORMAT_UNDEFINED for Basis Universal data, which is transcoded
+	void getDimensions(const std::string& filePath, uint32_t& outWidth, uint32_t& outHeight, uint32_t& outLevelCount, uint32_t& outVkFormat);
+	//The first levelCount mip levels of the file in the target format, transcoding Basis Universal data when needed. Thread safe
+	std::vector<std::vector<unsigned char>> loadLevels(const std::string& filePath, const TranscodeTarget& target, const uint32_t levelCount, uint32_t& outWidth, uint32_t& outHeight);
+}
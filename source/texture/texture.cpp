@@ -1,7 +1,58 @@
 #pragma once
 #include "texture.hpp"
+#include "../threading/threadPool.hpp"
+#include "ktx2.hpp"
+#include "../device/device.hpp"
+#include "../constants.hpp"
+#include "../enums.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <format>
+#include <future>
+#include <map>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <glm/gtc/packing.hpp>
+#include <webgpu/webgpu_cpp_print.h>
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include "stb_image_resize2.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+namespace {
+	const wgpu::StringView MIPMAP_SHADER_LABEL = "mipmap compute shader";
+	const std::string MIPMAP_SHADER_PATH = "shaders/mipmap_c.wgsl";
+	//Matches the default WORKGROUP_SIZE_X and WORKGROUP_SIZE_Y of the shader
+	constexpr uint32_t MIPMAP_WORKGROUP_SIZE = 8;
+
+	//The source format of images stb decodes, KTX2 images use the vkFormat they are stored in
+	constexpr uint32_t DECODED_FORMAT = UINT32_MAX;
+	//The vkFormat of KTX2 Basis Universal data, which is transcoded to whatever the device samples best
+	constexpr uint32_t BASIS_FORMAT = 0;
+
+	struct ImageInfo {
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t ktx2LevelCount = UINT32_MAX; //UINT32_MAX unless KTX2
+		uint32_t sourceFormat = DECODED_FORMAT;
+	};
+
+	//One array of getTextureArrays, layer i holds the image imageIndices[i]
+	struct ArrayLayout {
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<uint32_t> imageIndices;
+		bool uniformSize = true; //false when some images are resized to the array's size
+		bool compressed = false;
+		texture::ktx2::TranscodeTarget target = {};
+		uint32_t mipLevelCount = 1;
+	};
+}
 
 namespace texture {
 	void createTextureView(const descriptor::CreateTextureView* descriptor) {
@@ -16,7 +67,11 @@ namespace texture {
 					},
 					.format = descriptor->textureFormat,
 		};
-		wgpu::Texture texture = descriptor->device->CreateTexture(&textureDescriptor);
+		wgpu::Texture texture = descriptor->wgpuContext->device.CreateTexture(&textureDescriptor);
+		//Only a texture the caller keeps can be untracked again
+		if (descriptor->outputTexture != nullptr) {
+			descriptor->wgpuContext->getMemoryRegistry().track(texture, descriptor->label, descriptor->memoryCategory);
+		}
 		const wgpu::TextureViewDescriptor textureViewDescriptor = {
 			.label = wgpu::StringView(std::string(descriptor->label) + std::string(" texture view")),
 			.format = textureDescriptor.format,
@@ -27,68 +82,461 @@ namespace texture {
 			.usage = textureDescriptor.usage,
 		};
 		descriptor->outputTextureView = texture.CreateView(&textureViewDescriptor);
+		if (descriptor->outputTexture != nullptr) {
+			*descriptor->outputTexture = texture;
+		}
 	}
 
-	void getTexture(const WGPUContext& wgpuContext, const std::string& filePath, wgpu::Texture& outTexture, wgpu::TextureView& outTextureView)
-	{
+	void getTextureArrays(
+		WGPUContext& wgpuContext,
+		StagingBelt& stagingBelt,
+		ThreadPool& threadPool,
+		const std::vector<std::string>& filePaths,
+		std::vector<wgpu::Texture>& outTextures,
+		std::vector<wgpu::TextureView>& outTextureViews,
+		std::vector<structs::host::TextureLayer>& outTextureLayers
+	) {
 		constexpr int REQUESTED_CHANNELS = 4;
-		int x = 0;
-		int y = 0;
-		int c = 0;
-		unsigned char* data = stbi_load(filePath.c_str(), &x, &y, &c, REQUESTED_CHANNELS);
-		const uint32_t width = static_cast<uint32_t>(x);
-		const uint32_t height = static_cast<uint32_t>(y);
 		const uint32_t channels = static_cast<uint32_t>(REQUESTED_CHANNELS);
 
-		const wgpu::TextureDescriptor textureDescriptor = {
-			.label = wgpu::StringView(std::string("texture: " + filePath)),
-			.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst,
-			.dimension = wgpu::TextureDimension::e2D,
-			.size = wgpu::Extent3D {
-				.width = width,
-				.height = height,
-			},
-			.format = [channels]() {
-				switch (channels) {
-				case 1:
-					return wgpu::TextureFormat::R32Float;
-				case 2:
-					return wgpu::TextureFormat::RG32Float;
-				default:
-					return wgpu::TextureFormat::RGBA8Unorm;
+		wgpu::Limits limits;
+		wgpuContext.device.GetLimits(&limits);
+
+		std::vector<ImageInfo> imageInfos(filePaths.size());
+		for (uint32_t i = 0; i < filePaths.size(); ++i) {
+			ImageInfo& imageInfo = imageInfos[i];
+			if (ktx2::isKtx2(filePaths[i])) {
+				ktx2::getDimensions(filePaths[i], imageInfo.width, imageInfo.height, imageInfo.ktx2LevelCount, imageInfo.sourceFormat);
+			}
+			else {
+				int stbX = 0;
+				int stbY = 0;
+				int c = 0;
+				if (!stbi_info(filePaths[i].c_str(), &stbX, &stbY, &c)) {
+					throw std::runtime_error("failed to read image info: " + filePaths[i]);
 				}
-			}(),
-			.mipLevelCount = 1,
+				imageInfo.width = static_cast<uint32_t>(stbX);
+				imageInfo.height = static_cast<uint32_t>(stbY);
+			}
+		}
+
+		//Images of the same size and source format share an array, larger than the device allows they are resized down to the limit
+		std::map<std::tuple<uint32_t, uint32_t, uint32_t>, std::vector<uint32_t>> sizeGroups;
+		for (uint32_t i = 0; i < imageInfos.size(); ++i) {
+			sizeGroups[{ std::min(imageInfos[i].width, limits.maxTextureDimension2D), std::min(imageInfos[i].height, limits.maxTextureDimension2D), imageInfos[i].sourceFormat }].push_back(i);
+		}
+		std::vector<ArrayLayout> layouts;
+		for (const auto& [group, imageIndices] : sizeGroups) {
+			for (size_t first = 0; first < imageIndices.size(); first += limits.maxTextureArrayLayers) {
+				const size_t last = std::min<size_t>(first + limits.maxTextureArrayLayers, imageIndices.size());
+				layouts.push_back(ArrayLayout{
+					.width = std::get<0>(group),
+					.height = std::get<1>(group),
+					.imageIndices = std::vector<uint32_t>(imageIndices.begin() + first, imageIndices.begin() + last),
+				});
+			}
+		}
+		//Only so many arrays can be bound, the images of the arrays with the fewest layers are resized into one more
+		if (layouts.size() > constants::MAX_TEXTURE_ARRAYS) {
+			std::stable_sort(layouts.begin(), layouts.end(), [](const ArrayLayout& a, const ArrayLayout& b) {
+				return a.imageIndices.size() > b.imageIndices.size();
+			});
+			ArrayLayout merged = { .uniformSize = false };
+			for (size_t i = constants::MAX_TEXTURE_ARRAYS - 1; i < layouts.size(); ++i) {
+				merged.width = std::max(merged.width, layouts[i].width);
+				merged.height = std::max(merged.height, layouts[i].height);
+				merged.imageIndices.insert(merged.imageIndices.end(), layouts[i].imageIndices.begin(), layouts[i].imageIndices.end());
+			}
+			if (merged.imageIndices.size() > limits.maxTextureArrayLayers) {
+				throw std::runtime_error(std::format("{} resized textures exceed the {} texture array layer limit", merged.imageIndices.size(), limits.maxTextureArrayLayers));
+			}
+			LOG(WARNING) << "textures come in " << layouts.size() << " sizes but only " << constants::MAX_TEXTURE_ARRAYS << " arrays can be bound, "
+				<< merged.imageIndices.size() << " are resized to " << merged.width << "x" << merged.height;
+			layouts.resize(constants::MAX_TEXTURE_ARRAYS - 1);
+			layouts.push_back(std::move(merged));
+		}
+		//An empty scene still gets one white layer so the bind group is valid
+		if (layouts.empty()) {
+			layouts.push_back(ArrayLayout{ .width = 1, .height = 1 });
+		}
+
+		//Compressed blocks cannot be resized, so an array is only compressed when its layers are all KTX2 of one format and
+		//all have its block aligned size. Basis data is transcoded to the device's preferred block format, other KTX2 data is
+		//uploaded in the format it is stored in
+		const ktx2::TranscodeTarget compressedTarget = ktx2::selectTranscodeTarget(wgpuContext.device);
+		outTextures.resize(layouts.size());
+		outTextureViews.resize(layouts.size());
+		outTextureLayers.resize(filePaths.size());
+		for (uint32_t arrayIndex = 0; arrayIndex < layouts.size(); ++arrayIndex) {
+			ArrayLayout& layout = layouts[arrayIndex];
+			uint32_t ktx2LevelCount = UINT32_MAX;
+			const uint32_t sourceFormat = layout.imageIndices.empty() ? DECODED_FORMAT : imageInfos[layout.imageIndices.front()].sourceFormat;
+			bool singleFormat = true;
+			for (uint32_t layer = 0; layer < layout.imageIndices.size(); ++layer) {
+				const ImageInfo& imageInfo = imageInfos[layout.imageIndices[layer]];
+				layout.uniformSize = layout.uniformSize && imageInfo.width == layout.width && imageInfo.height == layout.height;
+				singleFormat = singleFormat && imageInfo.sourceFormat == sourceFormat;
+				ktx2LevelCount = std::min(ktx2LevelCount, imageInfo.ktx2LevelCount);
+				outTextureLayers[layout.imageIndices[layer]] = structs::host::TextureLayer{ .arrayIndex = arrayIndex, .layer = layer };
+			}
+
+			ktx2::TranscodeTarget target = ktx2::getRGBA8Target();
+			if (singleFormat && sourceFormat == BASIS_FORMAT) {
+				target = compressedTarget;
+			}
+			else if (singleFormat && sourceFormat != DECODED_FORMAT && !ktx2::findTarget(wgpuContext.device, sourceFormat, target)) {
+				throw std::runtime_error(std::format("KTX2 textures of texture array {} are stored as vkFormat {}, which the device cannot sample", arrayIndex, sourceFormat));
+			}
+			layout.compressed = ktx2::isCompressed(target) && layout.uniformSize &&
+				layout.width % target.blockSize == 0 && layout.height % target.blockSize == 0;
+			if (ktx2::isCompressed(target) && !layout.compressed) {
+				if (sourceFormat != BASIS_FORMAT) {
+					throw std::runtime_error(std::format("KTX2 textures of texture array {} are stored compressed but differ in size or are not block aligned", arrayIndex));
+				}
+				LOG(WARNING) << "KTX2 textures of texture array " << arrayIndex << " differ in size or are not block aligned, transcoding to RGBA8";
+			}
+			layout.target = layout.compressed ? target : ktx2::getRGBA8Target();
+
+			//Compressed levels cannot be rendered to, so they come from the files and the chain is as long as the shortest file's.
+			//Uncompressed arrays get the full chain built from level 0 on the GPU
+			const uint32_t fullMipLevelCount = static_cast<uint32_t>(std::bit_width(std::max(layout.width, layout.height)));
+			layout.mipLevelCount = layout.compressed ? std::min(ktx2LevelCount, fullMipLevelCount) : fullMipLevelCount;
+			if (layout.compressed && layout.mipLevelCount < fullMipLevelCount) {
+				LOG(WARNING) << "KTX2 textures of texture array " << arrayIndex << " only contain " << layout.mipLevelCount << " of " << fullMipLevelCount << " mip levels, minified textures will alias";
+			}
+
+			const std::string label = std::format("texture array {}", arrayIndex);
+			const wgpu::TextureDescriptor textureDescriptor = {
+				.label = wgpu::StringView(label),
+				.usage = layout.compressed
+					? wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst
+					: wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst | wgpu::TextureUsage::StorageBinding,
+				.dimension = wgpu::TextureDimension::e2D,
+				.size = wgpu::Extent3D {
+					.width = layout.width,
+					.height = layout.height,
+					.depthOrArrayLayers = std::max<uint32_t>(static_cast<uint32_t>(layout.imageIndices.size()), 1),
+				},
+				.format = layout.target.textureFormat,
+				.mipLevelCount = layout.mipLevelCount,
+			};
+			outTextures[arrayIndex] = wgpuContext.device.CreateTexture(&textureDescriptor);
+			wgpuContext.getMemoryRegistry().track(outTextures[arrayIndex], label, enums::MemoryCategory::SCENE);
+		}
+
+		//Rows are rows of blocks, a block is a single texel when uncompressed. Copies of compressed levels smaller than a
+		//block cover the whole block
+		const auto writeLevel = [&](const structs::host::TextureLayer textureLayer, const uint32_t level, const std::vector<unsigned char>& data) {
+			const ArrayLayout& layout = layouts[textureLayer.arrayIndex];
+			const uint32_t blocksWide = (std::max(layout.width >> level, 1u) + layout.target.blockSize - 1) / layout.target.blockSize;
+			const uint32_t blocksHigh = (std::max(layout.height >> level, 1u) + layout.target.blockSize - 1) / layout.target.blockSize;
+			const wgpu::TexelCopyTextureInfo texelCopyTextureInfo = {
+				.texture = outTextures[textureLayer.arrayIndex],
+				.mipLevel = level,
+				.origin = { .z = textureLayer.layer },
+			};
+			const wgpu::TexelCopyBufferLayout texelCopyBufferLayout = {
+				.bytesPerRow = blocksWide * layout.target.bytesPerBlock,
+				.rowsPerImage = blocksHigh,
+			};
+			const wgpu::Extent3D levelSize = {
+				.width = blocksWide * layout.target.blockSize,
+				.height = blocksHigh * layout.target.blockSize,
+			};
+			stagingBelt.writeTexture(texelCopyTextureInfo, data.data(), texelCopyBufferLayout, levelSize);
+		};
+		if (filePaths.empty()) {
+			writeLevel(structs::host::TextureLayer{ .arrayIndex = 0, .layer = 0 }, 0, std::vector<unsigned char>(channels, UINT8_MAX));
+		}
+
+		//Decoding, transcoding and resizing run on the pool, layers are uploaded in order as they become ready
+		std::vector<std::future<std::vector<std::vector<unsigned char>>>> decodedLayers;
+		decodedLayers.reserve(filePaths.size());
+		for (uint32_t i = 0; i < filePaths.size(); ++i) {
+			const ArrayLayout& layout = layouts[outTextureLayers[i].arrayIndex];
+			decodedLayers.push_back(threadPool.submit([&filePath = filePaths[i], width = layout.width, height = layout.height, channels, target = layout.target, mipLevelCount = layout.mipLevelCount]() {
+				uint32_t x = 0;
+				uint32_t y = 0;
+				unsigned char* stbData = nullptr;
+				std::vector<unsigned char> ktxData;
+				if (ktx2::isKtx2(filePath)) {
+					if (ktx2::isCompressed(target)) {
+						return ktx2::loadLevels(filePath, target, mipLevelCount, x, y);
+					}
+					ktxData = std::move(ktx2::loadLevels(filePath, target, 1, x, y).front());
+					if (x == width && y == height) {
+						return std::vector<std::vector<unsigned char>>{ std::move(ktxData) };
+					}
+				}
+				else {
+					int stbX = 0;
+					int stbY = 0;
+					int c = 0;
+					stbData = stbi_load(filePath.c_str(), &stbX, &stbY, &c, REQUESTED_CHANNELS);
+					if (stbData == nullptr) {
+						throw std::runtime_error("failed to load image: " + filePath);
+					}
+					x = static_cast<uint32_t>(stbX);
+					y = static_cast<uint32_t>(stbY);
+				}
+				const unsigned char* data = stbData != nullptr ? stbData : ktxData.data();
+
+				std::vector<unsigned char> decodedLayer(width * height * channels);
+				if (x != width || y != height) {
+					stbir_resize_uint8_linear(data, static_cast<int>(x), static_cast<int>(y), 0, decodedLayer.data(), static_cast<int>(width), static_cast<int>(height), 0, STBIR_RGBA);
+				}
+				else {
+					std::memcpy(decodedLayer.data(), data, decodedLayer.size());
+				}
+				if (stbData != nullptr) {
+					stbi_image_free(stbData);
+				}
+				return std::vector<std::vector<unsigned char>>{ std::move(decodedLayer) };
+			}));
+		}
+
+		try {
+			for (uint32_t i = 0; i < decodedLayers.size(); ++i) {
+				const std::vector<std::vector<unsigned char>> decodedLevels = decodedLayers[i].get();
+				//The belt submits and reuses its chunks on its own once they are full, so the whole array is never staged at once
+				for (uint32_t level = 0; level < decodedLevels.size(); ++level) {
+					writeLevel(outTextureLayers[i], level, decodedLevels[level]);
+				}
+			}
+		}
+		catch (...) {
+			//The pool outlives this call, the remaining decodes read filePaths
+			ThreadPool::waitForAll(decodedLayers);
+			throw;
+		}
+		//Mipmaps are built from level 0, which has to be copied first
+		stagingBelt.submit();
+		for (uint32_t arrayIndex = 0; arrayIndex < layouts.size(); ++arrayIndex) {
+			const ArrayLayout& layout = layouts[arrayIndex];
+			const wgpu::Texture& texture = outTextures[arrayIndex];
+			if (!layout.compressed) {
+				generateMipmaps(wgpuContext, texture);
+			}
+			LOG(INFO) << "Texture array " << arrayIndex << ": " << texture.GetDepthOrArrayLayers() << " layers of " << layout.width << "x" << layout.height << " "
+				<< layout.target.textureFormat << " with " << layout.mipLevelCount << " mip levels";
+
+			const wgpu::TextureViewDescriptor textureViewDescriptor = {
+				.label = "texture array view",
+				.format = texture.GetFormat(),
+				.dimension = wgpu::TextureViewDimension::e2DArray,
+				.mipLevelCount = texture.GetMipLevelCount(),
+				.arrayLayerCount = texture.GetDepthOrArrayLayers(),
+				.usage = texture.GetUsage(),
+			};
+			outTextureViews[arrayIndex] = texture.CreateView(&textureViewDescriptor);
+		}
+	}
+
+	void generateMipmaps(WGPUContext& wgpuContext, const wgpu::Texture& texture)
+	{
+		if (texture.GetMipLevelCount() <= 1) {
+			return;
+		}
+		if (texture.GetFormat() != wgpu::TextureFormat::RGBA8Unorm) {
+			throw std::runtime_error("generateMipmaps only supports RGBA8Unorm textures");
+		}
+
+		const wgpu::ShaderModule shaderModule = device::createWGSLShaderModule(wgpuContext.device, MIPMAP_SHADER_LABEL, MIPMAP_SHADER_PATH);
+		const wgpu::BindGroupLayoutEntry sourceBindGroupLayoutEntry = {
+			.binding = 0,
+			.visibility = wgpu::ShaderStage::Compute,
+			.texture = {
+				.sampleType = wgpu::TextureSampleType::Float,
+				.viewDimension = wgpu::TextureViewDimension::e2DArray,
+			},
+		};
+		const wgpu::BindGroupLayoutEntry destinationBindGroupLayoutEntry = {
+			.binding = 1,
+			.visibility = wgpu::ShaderStage::Compute,
+			.storageTexture = {
+				.access = wgpu::StorageTextureAccess::WriteOnly,
+				.format = wgpu::TextureFormat::RGBA8Unorm,
+				.viewDimension = wgpu::TextureViewDimension::e2DArray,
+			},
+		};
+		std::array<wgpu::BindGroupLayoutEntry, 2> bindGroupLayoutEntries = {
+			sourceBindGroupLayoutEntry,
+			destinationBindGroupLayoutEntry,
+		};
+		const wgpu::BindGroupLayoutDescriptor bindGroupLayoutDescriptor = {
+			.label = "mipmap bind group layout",
+			.entryCount = bindGroupLayoutEntries.size(),
+			.entries = bindGroupLayoutEntries.data(),
+		};
+		const wgpu::BindGroupLayout bindGroupLayout = wgpuContext.device.CreateBindGroupLayout(&bindGroupLayoutDescriptor);
+		const wgpu::PipelineLayoutDescriptor pipelineLayoutDescriptor = {
+			.label = "mipmap pipeline layout",
+			.bindGroupLayoutCount = 1,
+			.bindGroupLayouts = &bindGroupLayout,
 		};
-		outTexture = wgpuContext.device.CreateTexture(&textureDescriptor);
+		const wgpu::ComputePipelineDescriptor computePipelineDescriptor = {
+			.label = "mipmap compute pipeline",
+			.layout = wgpuContext.device.CreatePipelineLayout(&pipelineLayoutDescriptor),
+			.compute = {
+				.module = shaderModule,
+				.entryPoint = enums::EntryPoint::COMPUTE,
+			},
+		};
+		const wgpu::ComputePipeline computePipeline = wgpuContext.device.CreateComputePipeline(&computePipelineDescriptor);
+
+		//Each level reads the one above it, dispatches in a pass are ordered so one pass covers the whole chain
+		const wgpu::CommandEncoder commandEncoder = wgpuContext.device.CreateCommandEncoder();
+		const wgpu::ComputePassDescriptor computePassDescriptor = {
+			.label = "mipmap compute pass",
+		};
+		const wgpu::ComputePassEncoder computePassEncoder = commandEncoder.BeginComputePass(&computePassDescriptor);
+		computePassEncoder.SetPipeline(computePipeline);
+		for (uint32_t level = 1; level < texture.GetMipLevelCount(); ++level) {
+			const wgpu::TextureViewDescriptor sourceViewDescriptor = {
+				.label = "mipmap source view",
+				.dimension = wgpu::TextureViewDimension::e2DArray,
+				.baseMipLevel = level - 1,
+				.mipLevelCount = 1,
+				.arrayLayerCount = texture.GetDepthOrArrayLayers(),
+				.usage = wgpu::TextureUsage::TextureBinding,
+			};
+			const wgpu::TextureViewDescriptor destinationViewDescriptor = {
+				.label = "mipmap destination view",
+				.dimension = wgpu::TextureViewDimension::e2DArray,
+				.baseMipLevel = level,
+				.mipLevelCount = 1,
+				.arrayLayerCount = texture.GetDepthOrArrayLayers(),
+				.usage = wgpu::TextureUsage::StorageBinding,
+			};
+			std::array<wgpu::BindGroupEntry, 2> bindGroupEntries = {
+				wgpu::BindGroupEntry{
+					.binding = 0,
+					.textureView = texture.CreateView(&sourceViewDescriptor),
+				},
+				wgpu::BindGroupEntry{
+					.binding = 1,
+					.textureView = texture.CreateView(&destinationViewDescriptor),
+				},
+			};
+			const wgpu::BindGroupDescriptor bindGroupDescriptor = {
+				.label = "mipmap bind group",
+				.layout = bindGroupLayout,
+				.entryCount = bindGroupEntries.size(),
+				.entries = bindGroupEntries.data(),
+			};
+			computePassEncoder.SetBindGroup(0, wgpuContext.device.CreateBindGroup(&bindGroupDescriptor));
+
+			const uint32_t levelWidth = std::max(texture.GetWidth() >> level, 1u);
+			const uint32_t levelHeight = std::max(texture.GetHeight() >> level, 1u);
+			computePassEncoder.DispatchWorkgroups(
+				(levelWidth + MIPMAP_WORKGROUP_SIZE - 1) / MIPMAP_WORKGROUP_SIZE,
+				(levelHeight + MIPMAP_WORKGROUP_SIZE - 1) / MIPMAP_WORKGROUP_SIZE,
+				texture.GetDepthOrArrayLayers()
+			);
+		}
+		computePassEncoder.End();
+		const wgpu::CommandBuffer commandBuffer = commandEncoder.Finish();
+		wgpuContext.queue.Submit(1, &commandBuffer);
+	}
+
+	void writePng(WGPUContext& wgpuContext, const wgpu::Texture& texture, const std::string& filePath)
+	{
+		constexpr uint32_t OUTPUT_CHANNELS = 4;
+		const wgpu::TextureFormat format = texture.GetFormat();
+		uint32_t bytesPerTexel = 0;
+		switch (format) {
+		case wgpu::TextureFormat::RGBA8Unorm:
+		case wgpu::TextureFormat::BGRA8Unorm:
+			bytesPerTexel = 4;
+			break;
+		case wgpu::TextureFormat::RGBA16Float:
+			bytesPerTexel = 8;
+			break;
+		default:
+			throw std::runtime_error("writePng does not support the texture format of " + filePath);
+		}
+
+		const uint32_t width = texture.GetWidth();
+		const uint32_t height = texture.GetHeight();
+		//Buffer rows of a texture copy must be 256 byte aligned
+		constexpr uint32_t ROW_ALIGNMENT = 256;
+		const uint32_t bytesPerRow = (width * bytesPerTexel + ROW_ALIGNMENT - 1) / ROW_ALIGNMENT * ROW_ALIGNMENT;
+
+		const wgpu::BufferDescriptor readbackBufferDescriptor = {
+			.label = "png readback buffer",
+			.usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst,
+			.size = static_cast<uint64_t>(bytesPerRow) * height,
+		};
+		const wgpu::Buffer readbackBuffer = wgpuContext.device.CreateBuffer(&readbackBufferDescriptor);
+		wgpuContext.getMemoryRegistry().track(readbackBuffer, "png readback", enums::MemoryCategory::STAGING);
 
 		const wgpu::TexelCopyTextureInfo texelCopyTextureInfo = {
-			.texture = outTexture,
-			.mipLevel = 0,
+			.texture = texture,
 		};
-		const wgpu::TexelCopyBufferLayout texelCopyBufferLayout = {
-				.bytesPerRow = width * channels * sizeof(char),
+		const wgpu::TexelCopyBufferInfo texelCopyBufferInfo = {
+			.layout = {
+				.bytesPerRow = bytesPerRow,
 				.rowsPerImage = height,
+			},
+			.buffer = readbackBuffer,
+		};
+		const wgpu::Extent3D copySize = {
+			.width = width,
+			.height = height,
 		};
+		const wgpu::CommandEncoder commandEncoder = wgpuContext.device.CreateCommandEncoder();
+		commandEncoder.CopyTextureToBuffer(&texelCopyTextureInfo, &texelCopyBufferInfo, &copySize);
+		const wgpu::CommandBuffer commandBuffer = commandEncoder.Finish();
+		wgpuContext.queue.Submit(1, &commandBuffer);
 
-		wgpuContext.queue.WriteTexture(
-			&texelCopyTextureInfo,
-			data,
-			width * height * channels * sizeof(char),
-			&texelCopyBufferLayout,
-			&textureDescriptor.size
-		);
+		bool mapped = false;
+		wgpuContext.instance.WaitAny(readbackBuffer.MapAsync(
+			wgpu::MapMode::Read,
+			0,
+			readbackBufferDescriptor.size,
+			wgpu::CallbackMode::WaitAnyOnly,
+			[&](wgpu::MapAsyncStatus status, wgpu::StringView message) {
+				if (status != wgpu::MapAsyncStatus::Success) {
+					LOG(ERROR) << message;
+					return;
+				}
+				mapped = true;
+			}),
+			UINT64_MAX);
+		if (!mapped) {
+			throw std::runtime_error("failed to read back texture for " + filePath);
+		}
 
-		stbi_image_free(data);
-		const wgpu::TextureViewDescriptor textureViewDescriptor = {
-			.label = "Textures",
-			.format = textureDescriptor.format,
-			.dimension = wgpu::TextureViewDimension::e2D,
-			.mipLevelCount = textureDescriptor.mipLevelCount,
-			.arrayLayerCount = textureDescriptor.size.depthOrArrayLayers,
-			.usage = textureDescriptor.usage,
-		};
+		const uint8_t* data = static_cast<const uint8_t*>(readbackBuffer.GetConstMappedRange(0, readbackBufferDescriptor.size));
+		std::vector<uint8_t> pixels(width * height * OUTPUT_CHANNELS);
+		for (uint32_t y = 0; y < height; ++y) {
+			const uint8_t* row = data + static_cast<size_t>(y) * bytesPerRow;
+			uint8_t* outRow = pixels.data() + static_cast<size_t>(y) * width * OUTPUT_CHANNELS;
+			for (uint32_t x = 0; x < width; ++x) {
+				const uint8_t* texel = row + x * bytesPerTexel;
+				uint8_t* outTexel = outRow + x * OUTPUT_CHANNELS;
+				if (format == wgpu::TextureFormat::RGBA16Float) {
+					uint16_t halfs[OUTPUT_CHANNELS];
+					std::memcpy(halfs, texel, sizeof(halfs));
+					for (uint32_t c = 0; c < OUTPUT_CHANNELS; ++c) {
+						const float value = std::clamp(glm::unpackHalf1x16(halfs[c]), 0.0f, 1.0f);
+						outTexel[c] = static_cast<uint8_t>(value * 255.0f + 0.5f);
+					}
+				}
+				else {
+					std::memcpy(outTexel, texel, OUTPUT_CHANNELS);
+					if (format == wgpu::TextureFormat::BGRA8Unorm) {
+						std::swap(outTexel[0], outTexel[2]);
+					}
+				}
+			}
+		}
+		readbackBuffer.Unmap();
+		wgpuContext.getMemoryRegistry().untrack(readbackBuffer);
 
-		outTextureView = outTexture.CreateView(&textureViewDescriptor);
+		if (!stbi_write_png(filePath.c_str(), static_cast<int>(width), static_cast<int>(height), OUTPUT_CHANNELS, pixels.data(), static_cast<int>(width * OUTPUT_CHANNELS))) {
+			throw std::runtime_error("failed to write png: " + filePath);
+		}
+		LOG(INFO) << "Wrote " << filePath;
 	}
 }
\ No newline at end of file
@@ -1,22 +1,47 @@
 #pragma once
 #include <string>
+#include <vector>
 #include <ktx.h>
 #include <dawn/webgpu_cpp.h>
 #include <absl/log/log.h>
 #include "../wgpuContext/wgpuContext.hpp"	
+#include "../enums.hpp"
+#include "../structs/host.hpp"
+#include "../device/stagingBelt.hpp"
+#include "../threading/threadPool.hpp"
 
 namespace texture {
 	namespace descriptor {
 		struct CreateTextureView {
 			std::string label;
-			wgpu::Device* device;
+			WGPUContext* wgpuContext;
 			wgpu::TextureUsage textureUsage;
 			wgpu::Extent2D textureDimensions;
 			wgpu::TextureFormat textureFormat;
 			wgpu::TextureView& outputTextureView;
+			wgpu::Texture* outputTexture = nullptr; //only needed when the texture itself is used, e.g. as a copy source. Only then is it tracked
+			enums::MemoryCategory memoryCategory = enums::MemoryCategory::OTHER;
 		};
 	}
 
 	void createTextureView(const descriptor::CreateTextureView* descriptor);
-	void getTexture(const WGPUContext& wgpuContext, const std::string& filePath, wgpu::Texture& outTexture, wgpu::TextureView& outTextureView);
+	//Every image becomes one layer of a texture array holding the images of its size and source format, outTextureLayers says
+	//where each image went. Past constants::MAX_TEXTURE_ARRAYS arrays the rarest ones are resized into one RGBA8 array. Each
+	//array picks its own format: Basis KTX2 is transcoded to the device's block format, other KTX2 keeps the format it is
+	//stored in and decoded images are RGBA8. Arrays have a full mip chain, except compressed arrays which only have the
+	//levels stored in their files. Images are decoded on threadPool and
+	//their levels uploaded through stagingBelt, which is submitted before this returns
+	void getTextureArrays(
+		WGPUContext& wgpuContext,
+		StagingBelt& stagingBelt,
+		ThreadPool& threadPool,
+		const std::vector<std::string>& filePaths,
+		std::vector<wgpu::Texture>& outTextures,
+		std::vector<wgpu::TextureView>& outTextureViews,
+		std::vector<structs::host::TextureLayer>& outTextureLayers
+	);
+	//Fills mip levels 1 and up of an RGBA8Unorm texture array from level 0 with a 2x2 box filter on the GPU, the texture needs StorageBinding usage
+	void generateMipmaps(WGPUContext& wgpuContext, const wgpu::Texture& texture);
+	//Blocks until the texture is read back. RGBA8Unorm, BGRA8Unorm and RGBA16Float are supported, float channels are clamped to [0, 1]
+	void writePng(WGPUContext& wgpuContext, const wgpu::Texture& texture, const std::string& filePath);
 }
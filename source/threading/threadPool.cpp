@@ -0,0 +1,43 @@
+#pragma once
+#include "threadPool.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool(const uint32_t threadCount) {
+	const uint32_t count = threadCount > 0 ? threadCount : std::max(std::thread::hardware_concurrency(), 1u);
+	_threads.reserve(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		_threads.emplace_back(&ThreadPool::work, this);
+	}
+}
+
+//Runs the tasks already queued before joining
+ThreadPool::~ThreadPool() {
+	{
+		const std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_condition.notify_all();
+	for (std::thread& thread : _threads) {
+		thread.join();
+	}
+}
+
+uint32_t ThreadPool::getThreadCount() const {
+	return static_cast<uint32_t>(_threads.size());
+}
+
+void ThreadPool::work() {
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_condition.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+			if (_tasks.empty()) {
+				return;
+			}
+			task = std::move(_tasks.front());
+			_tasks.pop();
+		}
+		task();
+	}
+}
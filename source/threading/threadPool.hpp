@@ -0,0 +1,57 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+//Fixed set of worker threads running submitted tasks in submission order. Results and exceptions come back through
+//the returned std::future, so callers decide the order results are merged in
+class ThreadPool {
+public:
+	//0 uses every hardware thread
+	ThreadPool(const uint32_t threadCount = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	uint32_t getThreadCount() const;
+	//Waits for every task without rethrowing. Called before get() so a failed task never leaves the others running
+	//on state the exception unwinds
+	template <typename Result>
+	static void waitForAll(std::vector<std::future<Result>>& futures) {
+		for (std::future<Result>& future : futures) {
+			if (future.valid()) {
+				future.wait();
+			}
+		}
+	}
+
+	template <typename Task>
+	std::future<std::invoke_result_t<Task>> submit(Task&& task) {
+		using Result = std::invoke_result_t<Task>;
+		//std::function must be copyable, std::packaged_task is not
+		auto packagedTask = std::make_shared<std::packaged_task<Result()>>(std::forward<Task>(task));
+		std::future<Result> future = packagedTask->get_future();
+		{
+			const std::lock_guard<std::mutex> lock(_mutex);
+			_tasks.push([packagedTask]() { (*packagedTask)(); });
+		}
+		_condition.notify_one();
+		return future;
+	}
+
+private:
+	std::vector<std::thread> _threads;
+	std::queue<std::function<void()>> _tasks;
+	std::mutex _mutex;
+	std::condition_variable _condition;
+	bool _stopping = false;
+
+	void work();
+};
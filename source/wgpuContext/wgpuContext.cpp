@@ -1,5 +1,8 @@
 #pragma once
+#include <format>
 #include <string>
+#include <string_view>
+#include <vector>
 #define SDL_MAIN_HANDLED
 #include "../sdl3webgpu.hpp"
 #include "SDL3/SDL.h"
@@ -11,18 +14,22 @@
 #include "wgpuContext.hpp"
 #include <dawn/webgpu_cpp.h>
 
-WGPUContext::WGPUContext() {
+WGPUContext::WGPUContext(const wgpuContext::descriptor::Create& descriptor)
+	: _headless(descriptor.headless), _memoryRegistry(std::make_unique<MemoryRegistry>(descriptor.memoryBudget)), _screenDimensions(descriptor.screenDimensions) {
 	absl::SetStderrThreshold(LOG_LEVEL);
 	absl::InitializeLog();
 
-	SDL_Init(SDL_INIT_VIDEO);
-	SDL_Window* p_sdl_window = SDL_CreateWindow(
-		WINDOW_TITLE.c_str(), 
-		static_cast<int>(_screenDimensions.width),
-		static_cast<int>(_screenDimensions.height),
-	0);
+	SDL_Window* p_sdl_window = nullptr;
+	if (!_headless) {
+		SDL_Init(SDL_INIT_VIDEO);
+		p_sdl_window = SDL_CreateWindow(
+			WINDOW_TITLE.c_str(), 
+			static_cast<int>(_screenDimensions.width),
+			static_cast<int>(_screenDimensions.height),
+		0);
 
-	CHECK(p_sdl_window);
+		CHECK(p_sdl_window);
+	}
 
 	constexpr wgpu::InstanceDescriptor instanceDescriptor = {
 		.capabilities = {
@@ -32,8 +39,10 @@ WGPUContext::WGPUContext() {
 	this->instance = wgpu::CreateInstance(&instanceDescriptor);
 	CHECK(instance);
 
-	this->surface = wgpu::Surface(SDL_GetWGPUSurface(this->instance, p_sdl_window));
-	CHECK(surface);
+	if (!_headless) {
+		this->surface = wgpu::Surface(SDL_GetWGPUSurface(this->instance, p_sdl_window));
+		CHECK(surface);
+	}
 
 //	const char* useDxcToggle = "use_dxc"; //this works if you drop the dxil and dxcompiler dlls at the exe path
 //	wgpu::DawnTogglesDescriptor dawnTogglesDescriptor = {};
@@ -42,7 +51,9 @@ WGPUContext::WGPUContext() {
 	const wgpu::RequestAdapterOptions requestAdapterOptions = {
 //		.nextInChain = &dawnTogglesDescriptor,
 		.powerPreference = wgpu::PowerPreference::HighPerformance,
-//		.backendType = wgpu::BackendType::Vulkan,
+		.forceFallbackAdapter = descriptor.forceFallbackAdapter,
+		.backendType = descriptor.backendType,
+		.compatibleSurface = this->surface,
 	};
 	this->instance.WaitAny(this->instance.RequestAdapter(
 		&requestAdapterOptions,
@@ -61,7 +72,20 @@ WGPUContext::WGPUContext() {
 	print::adapter::GetInfo(this->adapter);
 	print::adapter::GetLimits(this->adapter);
 
-	constexpr std::array<wgpu::FeatureName, 0> requiredFeatures = {};
+	std::vector<wgpu::FeatureName> requiredFeatures;
+	//Timestamps for GpuProfiler, compressed formats as KTX2 transcode targets, indirect draws for render::sceneDraw
+	for (const wgpu::FeatureName optionalFeature : {
+		wgpu::FeatureName::TimestampQuery,
+		wgpu::FeatureName::IndirectFirstInstance,
+		wgpu::FeatureName::MultiDrawIndirect,
+		wgpu::FeatureName::TextureCompressionBC,
+		wgpu::FeatureName::TextureCompressionASTC,
+		wgpu::FeatureName::TextureCompressionETC2,
+	}) {
+		if (adapter.HasFeature(optionalFeature)) {
+			requiredFeatures.push_back(optionalFeature);
+		}
+	}
 	constexpr wgpu::Limits requiredLimits = {
 			.maxColorAttachmentBytesPerSample = 64
 	};
@@ -74,23 +98,75 @@ WGPUContext::WGPUContext() {
 	deviceDescriptor.SetUncapturedErrorCallback(device::callback::uncapturedError);
 	deviceDescriptor.SetDeviceLostCallback(wgpu::CallbackMode::AllowSpontaneous, device::callback::deviceLost);
 
+	//Dawn keys the entries on everything that goes into a compile, the isolation key additionally keeps adapters and
+	//driver versions that share the directory apart
+	wgpu::DawnCacheDeviceDescriptor cacheDeviceDescriptor = {};
+	if (!descriptor.pipelineCacheDirectory.empty()) {
+		wgpu::AdapterInfo adapterInfo{};
+		adapter.GetInfo(&adapterInfo);
+		_pipelineCacheIsolationKey = std::format(
+			"{:x}:{:x}:{}:{}:{}",
+			adapterInfo.vendorID,
+			adapterInfo.deviceID,
+			static_cast<uint32_t>(adapterInfo.backendType),
+			std::string_view(adapterInfo.device),
+			std::string_view(adapterInfo.description)
+		);
+		_pipelineCache = std::make_unique<PipelineCache>(descriptor.pipelineCacheDirectory);
+		cacheDeviceDescriptor = _pipelineCache->getDeviceDescriptor(_pipelineCacheIsolationKey);
+		deviceDescriptor.nextInChain = &cacheDeviceDescriptor;
+	}
+
 	device = adapter.CreateDevice(&deviceDescriptor);
 	device.SetLoggingCallback(device::callback::logging);
 	queue = device.GetQueue();
 
-	const wgpu::SurfaceConfiguration surfaceConfiguration = {
-		.device = device,
-		.format = this->surfaceFormat,
-		.usage = wgpu::TextureUsage::RenderAttachment,
-		.width = _screenDimensions.width,
-		.height = _screenDimensions.height,
-		.alphaMode = wgpu::CompositeAlphaMode::Auto,
-		.presentMode = wgpu::PresentMode::Immediate,
-		};
-
-	surface.Configure(&surfaceConfiguration);
+	if (_headless) {
+		createOffscreenTexture();
+	}
+	else {
+		const wgpu::SurfaceConfiguration surfaceConfiguration = {
+			.device = device,
+			.format = this->surfaceFormat,
+			.usage = wgpu::TextureUsage::RenderAttachment,
+			.width = _screenDimensions.width,
+			.height = _screenDimensions.height,
+			.alphaMode = wgpu::CompositeAlphaMode::Auto,
+			.presentMode = wgpu::PresentMode::Immediate,
+			};
+
+		surface.Configure(&surfaceConfiguration);
+	}
 
 	setScreenDimensions(_screenDimensions);
+	selectComputeTileSize();
+}
+
+//The registry is destroyed before the device and reports whatever the rest of the engine did not untrack
+WGPUContext::~WGPUContext()
+{
+	_memoryRegistry->untrack(_screenDimensionsBuffer);
+	_memoryRegistry->untrack(offscreenTexture);
+}
+
+const PipelineCache* WGPUContext::getPipelineCache() const
+{
+	return _pipelineCache.get();
+}
+
+MemoryRegistry& WGPUContext::getMemoryRegistry()
+{
+	return *_memoryRegistry;
+}
+
+const MemoryRegistry& WGPUContext::getMemoryRegistry() const
+{
+	return *_memoryRegistry;
+}
+
+bool WGPUContext::isHeadless()
+{
+	return _headless;
 }
 
 wgpu::Extent2D WGPUContext::getScreenDimensions()
@@ -103,6 +179,11 @@ wgpu::Buffer& WGPUContext::getScreenDimensionsBuffer()
 	return _screenDimensionsBuffer;
 }
 
+wgpu::Extent2D WGPUContext::getComputeTileSize()
+{
+	return _computeTileSize;
+}
+
 void WGPUContext::setScreenDimensions(wgpu::Extent2D screenDimensions)
 {
 	_screenDimensions = screenDimensions;
@@ -111,6 +192,55 @@ void WGPUContext::setScreenDimensions(wgpu::Extent2D screenDimensions)
 		.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::Uniform,
 		.size = sizeof(_screenDimensions),
 	};
+	_memoryRegistry->untrack(_screenDimensionsBuffer);
 	_screenDimensionsBuffer = device.CreateBuffer(&bufferDescriptor);
+	_memoryRegistry->track(_screenDimensionsBuffer, "screen dimensions", enums::MemoryCategory::OTHER);
 	queue.WriteBuffer(_screenDimensionsBuffer, 0, &_screenDimensions, sizeof(_screenDimensions));
 }
+
+//8x8 keeps a full screen pass occupied on GPUs, CPU adapters (SwiftShader) prefer fewer and larger workgroups
+void WGPUContext::selectComputeTileSize()
+{
+	wgpu::AdapterInfo adapterInfo{};
+	adapter.GetInfo(&adapterInfo);
+	wgpu::Limits limits{};
+	device.GetLimits(&limits);
+
+	uint32_t tileEdge = adapterInfo.adapterType == wgpu::AdapterType::CPU ? 16 : 8;
+	while (tileEdge > 1 && (
+		tileEdge * tileEdge > limits.maxComputeInvocationsPerWorkgroup ||
+		tileEdge > limits.maxComputeWorkgroupSizeX ||
+		tileEdge > limits.maxComputeWorkgroupSizeY)) {
+		tileEdge /= 2;
+	}
+	_computeTileSize = { tileEdge, tileEdge };
+	LOG(INFO) << "Compute tile size: " << tileEdge << "x" << tileEdge;
+}
+
+//Same format and size as the surface would have, CopySrc so a frame can be read back
+void WGPUContext::createOffscreenTexture()
+{
+	const wgpu::TextureDescriptor textureDescriptor = {
+		.label = "offscreen texture",
+		.usage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::CopySrc,
+		.dimension = wgpu::TextureDimension::e2D,
+		.size = {
+			.width = _screenDimensions.width,
+			.height = _screenDimensions.height,
+		},
+		.format = this->surfaceFormat,
+	};
+	offscreenTexture = device.CreateTexture(&textureDescriptor);
+	_memoryRegistry->track(offscreenTexture, "offscreen", enums::MemoryCategory::GBUFFER);
+
+	const wgpu::TextureViewDescriptor textureViewDescriptor = {
+		.label = "offscreen texture view",
+		.format = textureDescriptor.format,
+		.dimension = wgpu::TextureViewDimension::e2D,
+		.mipLevelCount = 1,
+		.arrayLayerCount = 1,
+		.aspect = wgpu::TextureAspect::All,
+		.usage = wgpu::TextureUsage::RenderAttachment,
+	};
+	offscreenTextureView = offscreenTexture.CreateView(&textureViewDescriptor);
+}
@@ -1,12 +1,27 @@
 #pragma once
+#include <memory>
+#include <string>
 #include <absl/base/log_severity.h>
 #include <dawn/webgpu_cpp.h>
+#include "../device/memoryRegistry.hpp"
+#include "../device/pipelineCache.hpp"
 
 namespace {
 	constexpr absl::LogSeverityAtLeast LOG_LEVEL = absl::LogSeverityAtLeast::kInfo;
 	const std::string WINDOW_TITLE = "Dawn WebGPU Engine";
 }
 
+namespace wgpuContext::descriptor {
+	struct Create {
+		bool headless = false; //no window or surface, frames are rendered into WGPUContext::offscreenTexture
+		wgpu::BackendType backendType = wgpu::BackendType::Undefined; //Undefined lets dawn pick
+		bool forceFallbackAdapter = false; //dawn's CPU adapter (SwiftShader), for machines without a GPU
+		wgpu::Extent2D screenDimensions = { 1280, 720 };
+		std::string pipelineCacheDirectory; //compiled shaders and pipelines persist here between runs when set
+		uint64_t memoryBudget = 0; //bytes of buffers and textures before the MemoryRegistry warns, 0 never warns
+	};
+}
+
 class WGPUContext {
 public:
 	wgpu::Instance instance;
@@ -17,14 +32,36 @@ public:
 	wgpu::Surface surface;
 	wgpu::TextureFormat surfaceFormat = wgpu::TextureFormat::BGRA8Unorm;
 
-	WGPUContext();
+	//Stands in for the surface texture when headless
+	wgpu::Texture offscreenTexture;
+	wgpu::TextureView offscreenTextureView;
+
+	WGPUContext(const wgpuContext::descriptor::Create& descriptor = {});
+	~WGPUContext();
+	WGPUContext(const WGPUContext&) = delete;
+	WGPUContext& operator=(const WGPUContext&) = delete;
+	bool isHeadless();
 	wgpu::Extent2D getScreenDimensions();
 	wgpu::Buffer& getScreenDimensionsBuffer();
 	void setScreenDimensions(wgpu::Extent2D ScreenDimensions);
+	wgpu::Extent2D getComputeTileSize();
+	//nullptr when the pipeline cache is disabled
+	const PipelineCache* getPipelineCache() const;
+	//Every buffer and texture the engine creates is tracked here
+	MemoryRegistry& getMemoryRegistry();
+	const MemoryRegistry& getMemoryRegistry() const;
 
 private:
-	wgpu::Extent2D _screenDimensions = { 1280, 720 };
+	bool _headless = false;
+	std::unique_ptr<PipelineCache> _pipelineCache;
+	std::unique_ptr<MemoryRegistry> _memoryRegistry;
+	std::string _pipelineCacheIsolationKey;
+	wgpu::Extent2D _screenDimensions;
 	wgpu::Buffer _screenDimensionsBuffer;
+	wgpu::Extent2D _computeTileSize = { 8, 8 };
+
+	void selectComputeTileSize();
+	void createOffscreenTexture();
 
 };
 